@@ -0,0 +1,684 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Radio driver that records and replays pcap captures.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/packetbuf.h"
+#include "net/netstack.h"
+#include "net/mac/framer/frame802154.h"
+#include "dev/radio.h"
+#include "pcap-radio.h"
+#include "shm-radio.h"
+#include "virtual-time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+/*---------------------------------------------------------------------------*/
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "PCAP radio"
+#define LOG_LEVEL LOG_LEVEL_INFO
+/*---------------------------------------------------------------------------*/
+#if NATIVE_PCAP_RADIO
+/*---------------------------------------------------------------------------*/
+#define PCAP_MAGIC_US  0xa1b2c3d4
+#define PCAP_MAGIC_NS  0xa1b23c4d
+
+#define LINKTYPE_IEEE802_15_4_WITHFCS 195
+#define LINKTYPE_IEEE802_15_4_NOFCS   230
+#define LINKTYPE_IEEE802_15_4_TAP     283
+
+/* TLV types of the 802.15.4 TAP header */
+#define TAP_FCS_TYPE 0
+#define TAP_RSS      1
+#define TAP_CHANNEL  3
+#define TAP_LQI      10
+
+#define FILE_HEADER_LEN   24
+#define RECORD_HEADER_LEN 16
+#define TAP_HEADER_LEN    (4 + 8 + 8 + 8 + 8)
+
+/* Timestamps before this (2000-01-01) count from the node's start */
+#define EPOCH_LIMIT 946684800UL
+
+#define FRAME_MAX 127
+#define FCS_LEN 2
+
+extern const struct radio_driver PCAP_RADIO_LOWER;
+
+static FILE *record_file;
+static struct timespec start_ts;
+
+/* The replayed capture, read into memory at once */
+static uint8_t *trace;
+static size_t trace_len;
+static size_t trace_pos;
+static int trace_swapped;
+static int trace_nsec;
+static uint32_t trace_linktype;
+static uint64_t trace_base;
+static uint8_t replay_fast;
+static uint8_t replay_exit;
+
+/* The frame due next, handed out by read() */
+static uint8_t frame[FRAME_MAX];
+static int frame_len;
+static uint64_t frame_time;
+static int16_t frame_rssi;
+static uint8_t frame_lqi;
+static uint8_t frame_channel;
+static uint8_t frame_ready;
+
+/* Link quality of the last frame read from the trace */
+static uint8_t last_from_trace;
+static int16_t last_rssi;
+static uint8_t last_lqi;
+
+static uint8_t channel = IEEE802154_DEFAULT_CHANNEL;
+
+static unsigned long replayed;
+static unsigned long skipped;
+static struct timespec replay_ts;
+
+PROCESS(pcap_radio_process, "PCAP radio process");
+/*---------------------------------------------------------------------------*/
+int
+pcap_radio_node(void)
+{
+  const char *node = getenv(PCAP_RADIO_ENV_NODE);
+
+  return node != NULL ? atoi(node) : 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+env_flag(const char *name)
+{
+  const char *value = getenv(name);
+
+  return value != NULL && atoi(value) != 0;
+}
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_us(void)
+{
+#if NATIVE_VIRTUAL_TIME
+  return virtual_time_now();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)(ts.tv_sec - start_ts.tv_sec) * 1000000 +
+    (ts.tv_nsec - start_ts.tv_nsec) / 1000;
+#endif
+}
+/*---------------------------------------------------------------------------*/
+static void
+put16(uint8_t *p, uint16_t v)
+{
+  p[0] = v & 0xff;
+  p[1] = v >> 8;
+}
+/*---------------------------------------------------------------------------*/
+static void
+put32(uint8_t *p, uint32_t v)
+{
+  put16(p, v & 0xffff);
+  put16(p + 2, v >> 16);
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+get16(const uint8_t *p)
+{
+  return p[0] | p[1] << 8;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+get32(const uint8_t *p)
+{
+  return get16(p) | (uint32_t)get16(p + 2) << 16;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+trace32(const uint8_t *p)
+{
+  uint32_t v = get32(p);
+
+  if(trace_swapped) {
+    v = (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+  }
+  return v;
+}
+/*---------------------------------------------------------------------------*/
+static void
+record_open(const char *path)
+{
+  uint8_t header[FILE_HEADER_LEN];
+  char name[256];
+  const char *node;
+
+  /* Each simulated node writes a file of its own */
+  node = strstr(path, "%u");
+  if(node != NULL) {
+    int number = pcap_radio_node();
+#if NATIVE_SHM_RADIO
+    if(number == 0) {
+      number = shm_radio_node_index() + 1;
+    }
+#endif /* NATIVE_SHM_RADIO */
+    snprintf(name, sizeof(name), "%.*s%u%s",
+             (int)(node - path), path, number, node + 2);
+    path = name;
+  }
+
+  record_file = fopen(path, "wb");
+  if(record_file == NULL) {
+    LOG_ERR("cannot create %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+
+  put32(header, PCAP_MAGIC_US);
+  put16(header + 4, 2);
+  put16(header + 6, 4);
+  put32(header + 8, 0);
+  put32(header + 12, 0);
+  put32(header + 16, FRAME_MAX + TAP_HEADER_LEN);
+  put32(header + 20, LINKTYPE_IEEE802_15_4_TAP);
+  fwrite(header, 1, sizeof(header), record_file);
+  fflush(record_file);
+}
+/*---------------------------------------------------------------------------*/
+static void
+record_frame(const uint8_t *data, int len, int has_rssi, int16_t rssi,
+             int has_lqi, uint8_t lqi, int has_channel, uint8_t ch)
+{
+  uint8_t header[RECORD_HEADER_LEN + TAP_HEADER_LEN];
+  uint8_t *tap = header + RECORD_HEADER_LEN;
+  uint64_t t = now_us();
+  float rss = rssi;
+  int tap_len = 4;
+
+  memset(header, 0, sizeof(header));
+
+  /* The FCS is not part of the frames the driver hands out */
+  put16(tap + tap_len, TAP_FCS_TYPE);
+  put16(tap + tap_len + 2, 1);
+  tap_len += 8;
+  if(has_rssi) {
+    put16(tap + tap_len, TAP_RSS);
+    put16(tap + tap_len + 2, 4);
+    memcpy(tap + tap_len + 4, &rss, 4);
+    tap_len += 8;
+  }
+  if(has_channel) {
+    put16(tap + tap_len, TAP_CHANNEL);
+    put16(tap + tap_len + 2, 3);
+    put16(tap + tap_len + 4, ch);
+    tap_len += 8;
+  }
+  if(has_lqi) {
+    put16(tap + tap_len, TAP_LQI);
+    put16(tap + tap_len + 2, 1);
+    tap[tap_len + 4] = lqi;
+    tap_len += 8;
+  }
+  put16(tap + 2, tap_len);
+
+  put32(header, t / 1000000);
+  put32(header + 4, t % 1000000);
+  put32(header + 8, tap_len + len);
+  put32(header + 12, tap_len + len);
+
+  fwrite(header, 1, RECORD_HEADER_LEN + tap_len, record_file);
+  fwrite(data, 1, len, record_file);
+  /* Keep the trace intact if the node crashes */
+  fflush(record_file);
+}
+/*---------------------------------------------------------------------------*/
+static void
+replay_open(const char *path)
+{
+  FILE *f;
+  long size;
+  uint32_t magic;
+
+  f = fopen(path, "rb");
+  if(f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0) {
+    LOG_ERR("cannot read %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+  rewind(f);
+  trace = malloc(size > 0 ? size : 1);
+  if(trace == NULL || fread(trace, 1, size, f) != (size_t)size) {
+    LOG_ERR("cannot read %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+  fclose(f);
+  trace_len = size;
+
+  if(trace_len < FILE_HEADER_LEN) {
+    LOG_ERR("%s: not a pcap file\n", path);
+    exit(EXIT_FAILURE);
+  }
+  magic = get32(trace);
+  trace_swapped = 0;
+  trace_nsec = 0;
+  if(magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS) {
+    trace_nsec = magic == PCAP_MAGIC_NS;
+  } else {
+    trace_swapped = 1;
+    magic = trace32(trace);
+    if(magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS) {
+      LOG_ERR("%s: not a pcap file\n", path);
+      exit(EXIT_FAILURE);
+    }
+    trace_nsec = magic == PCAP_MAGIC_NS;
+  }
+
+  trace_linktype = trace32(trace + 20) & 0xffff;
+  if(trace_linktype != LINKTYPE_IEEE802_15_4_WITHFCS &&
+     trace_linktype != LINKTYPE_IEEE802_15_4_NOFCS &&
+     trace_linktype != LINKTYPE_IEEE802_15_4_TAP) {
+    LOG_ERR("%s: unsupported link type %lu\n", path,
+            (unsigned long)trace_linktype);
+    exit(EXIT_FAILURE);
+  }
+  trace_pos = FILE_HEADER_LEN;
+  trace_base = VIRTUAL_TIME_NEVER;
+}
+/*---------------------------------------------------------------------------*/
+/* Parses the TAP header in front of a frame, returns its length or -1 */
+static int
+parse_tap(const uint8_t *p, int len, int *fcs_len)
+{
+  int tap_len, pos;
+  float rss;
+
+  if(len < 4 || p[0] != 0) {
+    return -1;
+  }
+  tap_len = get16(p + 2);
+  if(tap_len < 4 || tap_len > len) {
+    return -1;
+  }
+
+  for(pos = 4; pos + 4 <= tap_len;) {
+    int type = get16(p + pos);
+    int tlv_len = get16(p + pos + 2);
+
+    if(pos + 4 + tlv_len > tap_len) {
+      return -1;
+    }
+    switch(type) {
+    case TAP_FCS_TYPE:
+      if(tlv_len >= 1) {
+        *fcs_len = p[pos + 4] == 0 ? 0 : p[pos + 4] == 1 ? 2 : 4;
+      }
+      break;
+    case TAP_RSS:
+      if(tlv_len >= 4) {
+        memcpy(&rss, p + pos + 4, 4);
+        frame_rssi = (int16_t)rss;
+      }
+      break;
+    case TAP_CHANNEL:
+      if(tlv_len >= 2) {
+        frame_channel = get16(p + pos + 4);
+      }
+      break;
+    case TAP_LQI:
+      if(tlv_len >= 1) {
+        frame_lqi = p[pos + 4];
+      }
+      break;
+    }
+    /* Values are padded to a multiple of four bytes */
+    pos += 4 + ((tlv_len + 3) & ~3);
+  }
+  return tap_len;
+}
+/*---------------------------------------------------------------------------*/
+/* Loads the next usable frame of the trace, returns 0 at the end */
+static int
+replay_next(void)
+{
+  while(trace_pos + RECORD_HEADER_LEN <= trace_len) {
+    const uint8_t *rec = trace + trace_pos;
+    uint32_t caplen = trace32(rec + 8);
+    uint32_t origlen = trace32(rec + 12);
+    uint64_t sec = trace32(rec);
+    uint64_t frac = trace32(rec + 4);
+    const uint8_t *data = rec + RECORD_HEADER_LEN;
+    int len = caplen;
+    int fcs_len = trace_linktype == LINKTYPE_IEEE802_15_4_WITHFCS ? FCS_LEN : 0;
+
+    if(trace_pos + RECORD_HEADER_LEN + caplen > trace_len) {
+      break;
+    }
+    trace_pos += RECORD_HEADER_LEN + caplen;
+
+    frame_time = sec * 1000000 + (trace_nsec ? frac / 1000 : frac);
+    if(trace_base == VIRTUAL_TIME_NEVER) {
+      trace_base = sec < EPOCH_LIMIT ? 0 : frame_time;
+    }
+    frame_time = frame_time >= trace_base ? frame_time - trace_base : 0;
+
+    frame_rssi = 0;
+    frame_lqi = 0;
+    frame_channel = 0;
+    if(trace_linktype == LINKTYPE_IEEE802_15_4_TAP) {
+      int tap_len = parse_tap(data, len, &fcs_len);
+      if(tap_len < 0) {
+        skipped++;
+        continue;
+      }
+      data += tap_len;
+      len -= tap_len;
+      origlen -= tap_len;
+    }
+
+    /* Truncated captures and frames on other channels are not received */
+    if(len != (int)origlen || len <= fcs_len || len - fcs_len > FRAME_MAX ||
+       (frame_channel != 0 && frame_channel != channel)) {
+      skipped++;
+      continue;
+    }
+    frame_len = len - fcs_len;
+    memcpy(frame, data, frame_len);
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+replay_done(void)
+{
+  struct timespec ts;
+  double elapsed;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  elapsed = (ts.tv_sec - replay_ts.tv_sec) +
+    (ts.tv_nsec - replay_ts.tv_nsec) / 1e9;
+  LOG_INFO("replayed %lu frames, skipped %lu, in %.3f s (%.0f frames/s)\n",
+           replayed, skipped, elapsed, elapsed > 0 ? replayed / elapsed : 0);
+
+  free(trace);
+  trace = NULL;
+  if(replay_exit) {
+    exit(EXIT_SUCCESS);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(pcap_radio_process, ev, data)
+{
+  static struct etimer et;
+  static clock_time_t start;
+  clock_time_t due;
+  int len;
+
+  PROCESS_BEGIN();
+
+  start = clock_time();
+  clock_gettime(CLOCK_MONOTONIC, &replay_ts);
+
+  while(replay_next()) {
+    if(replay_fast) {
+      /* Let the stack run between frames */
+      process_poll(&pcap_radio_process);
+      PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+    } else {
+      due = start + frame_time * CLOCK_SECOND / 1000000;
+      if((long)(due - clock_time()) > 0) {
+        etimer_set(&et, due - clock_time());
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+      }
+    }
+
+    frame_ready = 1;
+    packetbuf_clear();
+    len = NETSTACK_RADIO.read(packetbuf_dataptr(), PACKETBUF_SIZE);
+    if(len > 0) {
+      packetbuf_set_datalen(len);
+      replayed++;
+      NETSTACK_MAC.input();
+    }
+  }
+
+  replay_done();
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+static int
+init(void)
+{
+  const char *path;
+
+  clock_gettime(CLOCK_MONOTONIC, &start_ts);
+  PCAP_RADIO_LOWER.init();
+
+  path = getenv(PCAP_RADIO_ENV_RECORD);
+  if(path != NULL && *path != '\0') {
+    record_open(path);
+  }
+
+  path = getenv(PCAP_RADIO_ENV_REPLAY);
+  if(path != NULL && *path != '\0') {
+    replay_open(path);
+    replay_fast = env_flag(PCAP_RADIO_ENV_FAST);
+    replay_exit = env_flag(PCAP_RADIO_ENV_EXIT);
+    process_start(&pcap_radio_process, NULL);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+prepare(const void *payload, unsigned short payload_len)
+{
+  return PCAP_RADIO_LOWER.prepare(payload, payload_len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+transmit(unsigned short transmit_len)
+{
+  return PCAP_RADIO_LOWER.transmit(transmit_len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+send(const void *payload, unsigned short payload_len)
+{
+  return PCAP_RADIO_LOWER.send(payload, payload_len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_read(void *buf, unsigned short buf_len)
+{
+  radio_value_t value;
+  int has_rssi, has_lqi, has_channel;
+  int len;
+
+  if(frame_ready) {
+    frame_ready = 0;
+    if(frame_len > buf_len) {
+      return 0;
+    }
+    memcpy(buf, frame, frame_len);
+    len = frame_len;
+    last_from_trace = 1;
+    last_rssi = frame_rssi;
+    last_lqi = frame_lqi;
+    packetbuf_set_attr(PACKETBUF_ATTR_RSSI, last_rssi);
+    packetbuf_set_attr(PACKETBUF_ATTR_LINK_QUALITY, last_lqi);
+    if(record_file != NULL) {
+      record_frame(buf, len, 1, last_rssi, 1, last_lqi, 1, channel);
+    }
+    return len;
+  }
+
+  len = PCAP_RADIO_LOWER.read(buf, buf_len);
+  last_from_trace = 0;
+  if(len > 0 && record_file != NULL) {
+    has_rssi = PCAP_RADIO_LOWER.get_value(RADIO_PARAM_LAST_RSSI, &value)
+      == RADIO_RESULT_OK;
+    last_rssi = value;
+    has_lqi = PCAP_RADIO_LOWER.get_value(RADIO_PARAM_LAST_LINK_QUALITY, &value)
+      == RADIO_RESULT_OK;
+    last_lqi = value;
+    has_channel = PCAP_RADIO_LOWER.get_value(RADIO_PARAM_CHANNEL, &value)
+      == RADIO_RESULT_OK;
+    record_frame(buf, len, has_rssi, last_rssi, has_lqi, last_lqi,
+                 has_channel, has_channel ? value : channel);
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+channel_clear(void)
+{
+  return PCAP_RADIO_LOWER.channel_clear();
+}
+/*---------------------------------------------------------------------------*/
+static int
+receiving_packet(void)
+{
+  return PCAP_RADIO_LOWER.receiving_packet();
+}
+/*---------------------------------------------------------------------------*/
+static int
+pending_packet(void)
+{
+  return frame_ready || PCAP_RADIO_LOWER.pending_packet();
+}
+/*---------------------------------------------------------------------------*/
+static int
+on(void)
+{
+  return PCAP_RADIO_LOWER.on();
+}
+/*---------------------------------------------------------------------------*/
+static int
+off(void)
+{
+  return PCAP_RADIO_LOWER.off();
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_value(radio_param_t param, radio_value_t *value)
+{
+  radio_result_t result;
+
+  if(!value) {
+    return RADIO_RESULT_INVALID_VALUE;
+  }
+
+  switch(param) {
+  case RADIO_PARAM_LAST_RSSI:
+    if(last_from_trace) {
+      *value = last_rssi;
+      return RADIO_RESULT_OK;
+    }
+    break;
+  case RADIO_PARAM_LAST_LINK_QUALITY:
+    if(last_from_trace) {
+      *value = last_lqi;
+      return RADIO_RESULT_OK;
+    }
+    break;
+  case RADIO_PARAM_CHANNEL:
+    result = PCAP_RADIO_LOWER.get_value(param, value);
+    if(result == RADIO_RESULT_NOT_SUPPORTED) {
+      *value = channel;
+      return RADIO_RESULT_OK;
+    }
+    return result;
+  default:
+    break;
+  }
+  return PCAP_RADIO_LOWER.get_value(param, value);
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_value(radio_param_t param, radio_value_t value)
+{
+  radio_result_t result;
+
+  if(param == RADIO_PARAM_CHANNEL && (value < 11 || value > 26)) {
+    return RADIO_RESULT_INVALID_VALUE;
+  }
+  result = PCAP_RADIO_LOWER.set_value(param, value);
+  if(param == RADIO_PARAM_CHANNEL) {
+    /* Replayed frames follow the channel even without a lower radio */
+    if(result == RADIO_RESULT_OK || result == RADIO_RESULT_NOT_SUPPORTED) {
+      channel = value;
+      return RADIO_RESULT_OK;
+    }
+  }
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_object(radio_param_t param, void *dest, size_t size)
+{
+  return PCAP_RADIO_LOWER.get_object(param, dest, size);
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_object(radio_param_t param, const void *src, size_t size)
+{
+  return PCAP_RADIO_LOWER.set_object(param, src, size);
+}
+/*---------------------------------------------------------------------------*/
+const struct radio_driver pcap_radio_driver =
+  {
+    init,
+    prepare,
+    transmit,
+    send,
+    radio_read,
+    channel_clear,
+    receiving_packet,
+    pending_packet,
+    on,
+    off,
+    get_value,
+    set_value,
+    get_object,
+    set_object
+  };
+/*---------------------------------------------------------------------------*/
+#endif /* NATIVE_PCAP_RADIO */
+/*---------------------------------------------------------------------------*/
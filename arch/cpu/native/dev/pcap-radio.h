@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Radio driver that records received frames to a pcap file and
+ *         replays pcap captures as radio input.
+ *
+ *         The driver sits on top of another radio driver
+ *         (PCAP_RADIO_CONF_LOWER) and is configured from the environment:
+ *
+ *         PCAP_RADIO_RECORD  append every frame returned by read() to this
+ *                            file, with timestamp, RSSI, LQI and channel.
+ *                            "%u" is replaced by the node number.
+ *         PCAP_RADIO_REPLAY  feed the frames of this capture to the MAC
+ *                            layer, as if the radio had received them.
+ *         PCAP_RADIO_FAST    if set to 1, replay frames back to back
+ *                            instead of with their original timing.
+ *         PCAP_RADIO_EXIT    if set to 1, exit once the replay is done.
+ *         PCAP_RADIO_NODE    the node number to take the link-layer
+ *                            address of, for replaying a node's trace.
+ *
+ *         Recordings use LINKTYPE_IEEE802_15_4_TAP. Replay also accepts
+ *         plain 802.15.4 captures with or without FCS, as written by
+ *         sensniff or Wireshark. Timestamps before the year 2000 are taken
+ *         as time since the node started, which is what recordings hold;
+ *         later ones are replayed relative to the first frame.
+ *
+ *         Built with VIRTUAL_TIME=1, the replay is deterministic: the
+ *         node sees the same frames at the same clock times on every run.
+ */
+/*---------------------------------------------------------------------------*/
+#ifndef PCAP_RADIO_H_
+#define PCAP_RADIO_H_
+/*---------------------------------------------------------------------------*/
+#include "dev/radio.h"
+/*---------------------------------------------------------------------------*/
+#ifdef NATIVE_CONF_PCAP_RADIO
+#define NATIVE_PCAP_RADIO NATIVE_CONF_PCAP_RADIO
+#else
+#define NATIVE_PCAP_RADIO 0
+#endif
+
+/* The radio to record from and to transmit with */
+#ifdef PCAP_RADIO_CONF_LOWER
+#define PCAP_RADIO_LOWER PCAP_RADIO_CONF_LOWER
+#elif NATIVE_CONF_SHM_RADIO
+#define PCAP_RADIO_LOWER shm_radio_driver
+#else
+#define PCAP_RADIO_LOWER nullradio_driver
+#endif
+
+#define PCAP_RADIO_ENV_RECORD "PCAP_RADIO_RECORD"
+#define PCAP_RADIO_ENV_REPLAY "PCAP_RADIO_REPLAY"
+#define PCAP_RADIO_ENV_FAST   "PCAP_RADIO_FAST"
+#define PCAP_RADIO_ENV_EXIT   "PCAP_RADIO_EXIT"
+#define PCAP_RADIO_ENV_NODE   "PCAP_RADIO_NODE"
+/*---------------------------------------------------------------------------*/
+extern const struct radio_driver pcap_radio_driver;
+
+/**
+ * \brief The node number given in PCAP_RADIO_NODE
+ * \return The number, or 0 if none was given
+ */
+int pcap_radio_node(void);
+/*---------------------------------------------------------------------------*/
+#endif /* PCAP_RADIO_H_ */
+/*---------------------------------------------------------------------------*/
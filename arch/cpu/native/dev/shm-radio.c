@@ -0,0 +1,602 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Shared-memory radio medium for native nodes in virtual time.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/packetbuf.h"
+#include "net/netstack.h"
+#include "net/mac/framer/frame802154.h"
+#include "dev/radio.h"
+#include "shm-radio.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+/*---------------------------------------------------------------------------*/
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "SHM radio"
+#define LOG_LEVEL LOG_LEVEL_NONE
+/*---------------------------------------------------------------------------*/
+#if NATIVE_SHM_RADIO
+/*---------------------------------------------------------------------------*/
+/* The largest frame handed to the MAC layer, without the FCS */
+#define MAX_PAYLOAD_LEN 125
+
+#define ACK_LEN 3
+#define LAST_RSSI -60
+#define LAST_LQI 105
+
+static struct shm_radio_medium *medium;
+static struct shm_radio_node *self;
+static int self_index = -1;
+
+static const void *pending_data;
+static uint8_t ack_pending;
+static uint8_t ack_seqno;
+static uint32_t rng_state;
+
+PROCESS(shm_radio_process, "SHM radio process");
+/*---------------------------------------------------------------------------*/
+static void
+lock(void)
+{
+  if(pthread_mutex_lock(&medium->lock) == EOWNERDEAD) {
+    /* A node died holding the lock; the medium itself is still sane */
+    pthread_mutex_consistent(&medium->lock);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+unlock(void)
+{
+  pthread_mutex_unlock(&medium->lock);
+}
+/*---------------------------------------------------------------------------*/
+static int
+attach(void)
+{
+  const char *path;
+  const char *index;
+  struct stat st;
+  int fd;
+
+  path = getenv(SHM_RADIO_ENV_PATH);
+  index = getenv(SHM_RADIO_ENV_NODE);
+  if(path == NULL || index == NULL) {
+    return 0;
+  }
+  fd = shm_open(path, O_RDWR, 0);
+  if(fd < 0 || fstat(fd, &st) < 0) {
+    perror("shm-radio: shm_open");
+    exit(EXIT_FAILURE);
+  }
+  medium = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if(medium == MAP_FAILED || st.st_size < sizeof(*medium) ||
+     medium->magic != SHM_RADIO_MAGIC ||
+     st.st_size < shm_radio_size(medium->nodes)) {
+    fprintf(stderr, "shm-radio: %s is not a radio medium\n", path);
+    exit(EXIT_FAILURE);
+  }
+  self_index = atoi(index);
+  if(self_index < 0 || self_index >= medium->nodes) {
+    fprintf(stderr, "shm-radio: node %d out of range\n", self_index);
+    exit(EXIT_FAILURE);
+  }
+  self = shm_radio_node(medium, self_index);
+  rng_state = medium->seed ^ ((self_index + 1) * 0x9e3779b9);
+  if(rng_state == 0) {
+    rng_state = 1;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+shm_radio_node_index(void)
+{
+  if(medium == NULL) {
+    attach();
+  }
+  return self_index;
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+random_next(void)
+{
+  /* xorshift32, so that losses only depend on the seed and node */
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Synchronization. A node's key is its current time while it runs and
+ * the time it waits for while idle; it sends no frame before its key.
+ * A node may thus advance to T once T is within one latency of the keys
+ * of all other nodes.
+ */
+static virtual_time_t
+add_latency(virtual_time_t t)
+{
+  return t > VIRTUAL_TIME_NEVER - medium->latency ?
+    VIRTUAL_TIME_NEVER : t + medium->latency;
+}
+/*---------------------------------------------------------------------------*/
+/* The lowest key of all nodes but skip, plus the latency */
+static virtual_time_t
+bound(int skip)
+{
+  virtual_time_t min;
+
+  if(shm_radio_heap(medium)[0] != skip) {
+    return add_latency(shm_radio_heap_key(medium, 0));
+  }
+  min = VIRTUAL_TIME_NEVER;
+  if(medium->nodes > 1) {
+    min = shm_radio_heap_key(medium, 1);
+  }
+  if(medium->nodes > 2 && shm_radio_heap_key(medium, 2) < min) {
+    min = shm_radio_heap_key(medium, 2);
+  }
+  return add_latency(min);
+}
+/*---------------------------------------------------------------------------*/
+/* Signals waiting nodes below heap position pos with keys up to limit */
+static void
+wake_from(uint32_t pos, virtual_time_t limit)
+{
+  struct shm_radio_node *n;
+
+  if(pos >= medium->nodes || shm_radio_heap_key(medium, pos) > limit) {
+    return;
+  }
+  n = shm_radio_node(medium, shm_radio_heap(medium)[pos]);
+  if(n->state == SHM_RADIO_WAITING) {
+    pthread_cond_signal(&n->cond);
+  }
+  wake_from(2 * pos + 1, limit);
+  wake_from(2 * pos + 2, limit);
+}
+/*---------------------------------------------------------------------------*/
+/* Wakes up waiting nodes that may have become free to advance */
+static void
+wake_waiting(void)
+{
+  struct shm_radio_node *root;
+
+  root = shm_radio_node(medium, shm_radio_heap(medium)[0]);
+  if(root->state == SHM_RADIO_WAITING &&
+     root->key <= bound(shm_radio_heap(medium)[0])) {
+    pthread_cond_signal(&root->cond);
+  }
+  wake_from(1, add_latency(root->key));
+  wake_from(2, add_latency(root->key));
+}
+/*---------------------------------------------------------------------------*/
+/* The arrival time of the earliest frame in our queue */
+static virtual_time_t
+next_arrival(void)
+{
+  virtual_time_t t = VIRTUAL_TIME_NEVER;
+  int i;
+
+  for(i = 0; i < SHM_RADIO_RX_QUEUE; i++) {
+    if(self->rx[i].len > 0 && self->rx[i].arrival < t) {
+      t = self->rx[i].arrival;
+    }
+  }
+  return t;
+}
+/*---------------------------------------------------------------------------*/
+static void
+leave(void)
+{
+  if(self != NULL && self->state != SHM_RADIO_DONE) {
+    lock();
+    self->state = SHM_RADIO_DONE;
+    shm_radio_set_key(medium, self_index, VIRTUAL_TIME_NEVER);
+    wake_waiting();
+    unlock();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+sync_init(void)
+{
+  if(self == NULL) {
+    fprintf(stderr, "shm-radio: not started by native-sim\n");
+    exit(EXIT_FAILURE);
+  }
+  atexit(leave);
+}
+/*---------------------------------------------------------------------------*/
+static virtual_time_t
+sync_advance(virtual_time_t now, virtual_time_t next)
+{
+  virtual_time_t t;
+  virtual_time_t arrival;
+
+  lock();
+  self->state = SHM_RADIO_WAITING;
+  while(1) {
+    arrival = next_arrival();
+    t = arrival < next ? arrival : next;
+    if(t < now) {
+      t = now;
+    }
+    shm_radio_set_key(medium, self_index, t);
+    /* Our key may have grown, which can release others */
+    wake_waiting();
+    if(t <= bound(self_index)) {
+      break;
+    }
+    pthread_cond_wait(&self->cond, &medium->lock);
+  }
+
+  if(t == VIRTUAL_TIME_NEVER || t >= medium->stop) {
+    /* Either nothing can ever happen again or the run is over */
+    self->state = SHM_RADIO_DONE;
+    shm_radio_set_key(medium, self_index, VIRTUAL_TIME_NEVER);
+    wake_waiting();
+    unlock();
+    exit(EXIT_SUCCESS);
+  }
+  self->state = SHM_RADIO_RUNNING;
+  unlock();
+
+  if(arrival <= t) {
+    process_poll(&shm_radio_process);
+  }
+  return t;
+}
+/*---------------------------------------------------------------------------*/
+const struct virtual_time_sync shm_radio_sync = {
+  sync_init,
+  sync_advance
+};
+/*---------------------------------------------------------------------------*/
+static int
+deliver(int index, const uint8_t *data, int len)
+{
+  struct shm_radio_node *n = shm_radio_node(medium, index);
+  int i;
+
+  for(i = 0; i < SHM_RADIO_RX_QUEUE; i++) {
+    if(n->rx[i].len == 0) {
+      n->rx[i].arrival = add_latency(virtual_time_now());
+      n->rx[i].len = len;
+      memcpy(n->rx[i].data, data, len);
+      if(n->state == SHM_RADIO_WAITING && n->rx[i].arrival < n->key) {
+        shm_radio_set_key(medium, index, n->rx[i].arrival);
+        pthread_cond_signal(&n->cond);
+      }
+      return 1;
+    }
+  }
+  n->rx_dropped++;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_send(const void *payload, unsigned short payload_len)
+{
+  frame802154_t frame;
+  uint8_t buf[SHM_RADIO_FRAME_SIZE];
+  struct shm_radio_node *n;
+  int unicast;
+  int i;
+
+  if(payload_len == 0 || payload_len > MAX_PAYLOAD_LEN) {
+    return RADIO_TX_ERR;
+  }
+  memcpy(buf, payload, payload_len);
+  unicast = 0;
+  if(frame802154_parse(buf, payload_len, &frame) &&
+     frame.fcf.dest_addr_mode != FRAME802154_NOADDR &&
+     !frame802154_is_broadcast_addr(frame.fcf.dest_addr_mode,
+                                    frame.dest_addr)) {
+    unicast = 1;
+  }
+
+  ack_pending = 0;
+  lock();
+  for(i = 0; i < medium->nodes; i++) {
+    n = shm_radio_node(medium, i);
+    if(i == self_index || n->state == SHM_RADIO_DONE || !n->on ||
+       n->channel != self->channel ||
+       random_next() % 100 >= *shm_radio_prr(medium, self_index, i)) {
+      continue;
+    }
+    if(deliver(i, payload, payload_len) && unicast &&
+       frame.fcf.ack_required &&
+       memcmp(frame.dest_addr, n->addr, LINKADDR_SIZE) == 0) {
+      /* The receiver acknowledges right away */
+      ack_pending = 1;
+      ack_seqno = frame.seq;
+    }
+  }
+  unlock();
+
+  LOG_DBG("sent %u bytes%s\n", payload_len, ack_pending ? ", acked" : "");
+  return RADIO_TX_OK;
+}
+/*---------------------------------------------------------------------------*/
+static int
+prepare(const void *payload, unsigned short payload_len)
+{
+  pending_data = payload;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+transmit(unsigned short transmit_len)
+{
+  if(pending_data == NULL) {
+    return RADIO_TX_ERR;
+  }
+  return radio_send(pending_data, transmit_len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+send(const void *payload, unsigned short payload_len)
+{
+  prepare(payload, payload_len);
+  return transmit(payload_len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_read(void *buf, unsigned short buf_len)
+{
+  struct shm_radio_frame *f = NULL;
+  int len;
+  int i;
+
+  if(ack_pending) {
+    ack_pending = 0;
+    if(buf_len < ACK_LEN) {
+      return 0;
+    }
+    ((uint8_t *)buf)[0] = FRAME802154_ACKFRAME;
+    ((uint8_t *)buf)[1] = 0;
+    ((uint8_t *)buf)[2] = ack_seqno;
+    return ACK_LEN;
+  }
+
+  lock();
+  for(i = 0; i < SHM_RADIO_RX_QUEUE; i++) {
+    if(self->rx[i].len > 0 && self->rx[i].arrival <= virtual_time_now() &&
+       (f == NULL || self->rx[i].arrival < f->arrival)) {
+      f = &self->rx[i];
+    }
+  }
+  len = 0;
+  if(f != NULL) {
+    if(f->len <= buf_len) {
+      len = f->len;
+      memcpy(buf, f->data, len);
+    }
+    f->len = 0;
+  }
+  unlock();
+
+  if(len > 0) {
+    packetbuf_set_attr(PACKETBUF_ATTR_RSSI, LAST_RSSI);
+    packetbuf_set_attr(PACKETBUF_ATTR_LINK_QUALITY, LAST_LQI);
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static int
+channel_clear(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+receiving_packet(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+pending_packet(void)
+{
+  virtual_time_t t;
+
+  if(ack_pending) {
+    return 1;
+  }
+  lock();
+  t = next_arrival();
+  unlock();
+  return t <= virtual_time_now();
+}
+/*---------------------------------------------------------------------------*/
+static int
+on(void)
+{
+  self->on = 1;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+off(void)
+{
+  self->on = 0;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(shm_radio_process, ev, data)
+{
+  int len;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+
+    while(pending_packet()) {
+      packetbuf_clear();
+      /* Through NETSTACK_RADIO, so that pcap-radio can record it */
+      len = NETSTACK_RADIO.read(packetbuf_dataptr(), PACKETBUF_SIZE);
+      if(len > 0) {
+        packetbuf_set_datalen(len);
+        NETSTACK_MAC.input();
+      }
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+static int
+init(void)
+{
+  if(shm_radio_node_index() < 0) {
+    fprintf(stderr, "shm-radio: not started by native-sim\n");
+    exit(EXIT_FAILURE);
+  }
+  lock();
+  memcpy(self->addr, &linkaddr_node_addr, LINKADDR_SIZE);
+  self->channel = IEEE802154_DEFAULT_CHANNEL;
+  unlock();
+  process_start(&shm_radio_process, NULL);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_value(radio_param_t param, radio_value_t *value)
+{
+  if(!value) {
+    return RADIO_RESULT_INVALID_VALUE;
+  }
+
+  switch(param) {
+  case RADIO_PARAM_POWER_MODE:
+    *value = self->on ? RADIO_POWER_MODE_ON : RADIO_POWER_MODE_OFF;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_CHANNEL:
+    *value = self->channel;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_RX_MODE:
+  case RADIO_PARAM_TX_MODE:
+    *value = 0;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_LAST_RSSI:
+    *value = LAST_RSSI;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_LAST_LINK_QUALITY:
+    *value = LAST_LQI;
+    return RADIO_RESULT_OK;
+  case RADIO_CONST_CHANNEL_MIN:
+    *value = 11;
+    return RADIO_RESULT_OK;
+  case RADIO_CONST_CHANNEL_MAX:
+    *value = 26;
+    return RADIO_RESULT_OK;
+  case RADIO_CONST_MAX_PAYLOAD_LEN:
+    *value = (radio_value_t)MAX_PAYLOAD_LEN;
+    return RADIO_RESULT_OK;
+  default:
+    return RADIO_RESULT_NOT_SUPPORTED;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_value(radio_param_t param, radio_value_t value)
+{
+  switch(param) {
+  case RADIO_PARAM_POWER_MODE:
+    if(value == RADIO_POWER_MODE_ON) {
+      on();
+    } else if(value == RADIO_POWER_MODE_OFF) {
+      off();
+    } else {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_CHANNEL:
+    if(value < 11 || value > 26) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    self->channel = value;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_RX_MODE:
+  case RADIO_PARAM_TX_MODE:
+    return RADIO_RESULT_OK;
+  default:
+    return RADIO_RESULT_NOT_SUPPORTED;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_object(radio_param_t param, void *dest, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_object(radio_param_t param, const void *src, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+const struct radio_driver shm_radio_driver =
+  {
+    init,
+    prepare,
+    transmit,
+    send,
+    radio_read,
+    channel_clear,
+    receiving_packet,
+    pending_packet,
+    on,
+    off,
+    get_value,
+    set_value,
+    get_object,
+    set_object
+  };
+/*---------------------------------------------------------------------------*/
+#endif /* NATIVE_SHM_RADIO */
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Shared-memory radio medium for native nodes in virtual time.
+ *
+ *         Every node is a process of its own, started by the native-sim
+ *         launcher (tools/native-sim) with the segment name and its index
+ *         in SHM_RADIO_PATH and SHM_RADIO_NODE. Frames are copied into
+ *         the receive queues of all nodes in range, subject to a per-link
+ *         packet reception ratio, and arrive after a fixed latency.
+ *
+ *         The medium also keeps the virtual clocks of the nodes in step:
+ *         a node only advances to time T once no other node can still
+ *         send it a frame arriving before T. The latency is the lookahead
+ *         that lets nodes within one latency of each other run in
+ *         parallel.
+ *
+ *         This header describes the segment layout and is shared with the
+ *         launcher.
+ */
+/*---------------------------------------------------------------------------*/
+#ifndef SHM_RADIO_H_
+#define SHM_RADIO_H_
+/*---------------------------------------------------------------------------*/
+#include "virtual-time.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+#ifdef NATIVE_CONF_SHM_RADIO
+#define NATIVE_SHM_RADIO NATIVE_CONF_SHM_RADIO
+#else
+#define NATIVE_SHM_RADIO 0
+#endif
+
+/* Frames a node can have waiting for reception */
+#ifdef SHM_RADIO_CONF_RX_QUEUE
+#define SHM_RADIO_RX_QUEUE SHM_RADIO_CONF_RX_QUEUE
+#else
+#define SHM_RADIO_RX_QUEUE 16
+#endif
+
+#define SHM_RADIO_MAGIC      0x53524d31 /* "SRM1" */
+#define SHM_RADIO_FRAME_SIZE 127
+#define SHM_RADIO_ADDR_SIZE  8
+
+#define SHM_RADIO_ENV_PATH   "SHM_RADIO_PATH"
+#define SHM_RADIO_ENV_NODE   "SHM_RADIO_NODE"
+
+enum {
+  SHM_RADIO_RUNNING, /* processing events at time key */
+  SHM_RADIO_WAITING, /* idle until time key */
+  SHM_RADIO_DONE,    /* exited */
+};
+/*---------------------------------------------------------------------------*/
+struct shm_radio_frame {
+  virtual_time_t arrival;
+  uint8_t len; /* 0 for a free slot */
+  uint8_t data[SHM_RADIO_FRAME_SIZE];
+};
+
+struct shm_radio_node {
+  pthread_cond_t cond;
+  virtual_time_t key;
+  uint32_t heap_pos;
+  uint8_t state;
+  uint8_t on;
+  uint8_t channel;
+  uint8_t addr[SHM_RADIO_ADDR_SIZE];
+  uint32_t rx_dropped;
+  struct shm_radio_frame rx[SHM_RADIO_RX_QUEUE];
+};
+
+struct shm_radio_medium {
+  uint32_t magic;
+  uint32_t nodes;
+  /* Microseconds from transmission to reception, at least 1 */
+  uint32_t latency;
+  uint32_t seed;
+  /* Virtual time at which all nodes exit */
+  virtual_time_t stop;
+  pthread_mutex_t lock;
+  /* Followed by the nodes, a min-heap of node indices ordered by key,
+     then a nodes x nodes table of packet reception ratios in percent,
+     indexed [sender][receiver] */
+};
+/*---------------------------------------------------------------------------*/
+static inline struct shm_radio_node *
+shm_radio_node(struct shm_radio_medium *m, int i)
+{
+  return (struct shm_radio_node *)(m + 1) + i;
+}
+/*---------------------------------------------------------------------------*/
+static inline uint32_t *
+shm_radio_heap(struct shm_radio_medium *m)
+{
+  return (uint32_t *)shm_radio_node(m, m->nodes);
+}
+/*---------------------------------------------------------------------------*/
+static inline uint8_t *
+shm_radio_prr(struct shm_radio_medium *m, int from, int to)
+{
+  return (uint8_t *)(shm_radio_heap(m) + m->nodes) + from * m->nodes + to;
+}
+/*---------------------------------------------------------------------------*/
+static inline size_t
+shm_radio_size(int nodes)
+{
+  return sizeof(struct shm_radio_medium) +
+    nodes * (sizeof(struct shm_radio_node) + sizeof(uint32_t)) +
+    nodes * nodes;
+}
+/*---------------------------------------------------------------------------*/
+/* The key at position pos of the heap */
+static inline virtual_time_t
+shm_radio_heap_key(struct shm_radio_medium *m, uint32_t pos)
+{
+  return shm_radio_node(m, shm_radio_heap(m)[pos])->key;
+}
+/*---------------------------------------------------------------------------*/
+static inline void
+shm_radio_heap_swap(struct shm_radio_medium *m, uint32_t a, uint32_t b)
+{
+  uint32_t *heap = shm_radio_heap(m);
+  uint32_t tmp = heap[a];
+
+  heap[a] = heap[b];
+  heap[b] = tmp;
+  shm_radio_node(m, heap[a])->heap_pos = a;
+  shm_radio_node(m, heap[b])->heap_pos = b;
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Changes the key of node i, keeping the heap in order. Exited
+ * nodes get VIRTUAL_TIME_NEVER. Call with the lock held.
+ */
+static inline void
+shm_radio_set_key(struct shm_radio_medium *m, int i, virtual_time_t key)
+{
+  uint32_t pos = shm_radio_node(m, i)->heap_pos;
+  uint32_t child;
+
+  shm_radio_node(m, i)->key = key;
+  while(pos > 0 &&
+        shm_radio_heap_key(m, (pos - 1) / 2) > shm_radio_heap_key(m, pos)) {
+    shm_radio_heap_swap(m, pos, (pos - 1) / 2);
+    pos = (pos - 1) / 2;
+  }
+  while((child = 2 * pos + 1) < m->nodes) {
+    if(child + 1 < m->nodes &&
+       shm_radio_heap_key(m, child + 1) < shm_radio_heap_key(m, child)) {
+      child++;
+    }
+    if(shm_radio_heap_key(m, child) >= shm_radio_heap_key(m, pos)) {
+      break;
+    }
+    shm_radio_heap_swap(m, pos, child);
+    pos = child;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief The index of this node in the medium, or -1 when the node was
+ * not started by the launcher
+ */
+int shm_radio_node_index(void);
+/*---------------------------------------------------------------------------*/
+#endif /* SHM_RADIO_H_ */
+/*---------------------------------------------------------------------------*/
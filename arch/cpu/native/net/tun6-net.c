@@ -65,6 +65,17 @@
 #include "net/netstack.h"
 #include "net/packetbuf.h"
 
+/*
+ * Maximum number of packets read from the tun device per main loop
+ * wakeup. Host traffic tends to arrive in bursts; draining it in one go
+ * avoids a main loop round trip per packet.
+ */
+#ifdef TUN6_NET_CONF_READ_BATCH
+#define READ_BATCH TUN6_NET_CONF_READ_BATCH
+#else
+#define READ_BATCH 16
+#endif
+
 static const char *config_ipaddr = "fd00::1/64";
 /* Allocate some bytes in RAM and copy the string */
 static char config_tundev[IFNAMSIZ + 1] = "tun0";
@@ -219,6 +230,11 @@ tun_init()
 
   LOG_INFO("Tun open:%d\n", tunfd);
 
+  /* Non-blocking, so that a batched read stops when the queue is empty */
+  if(fcntl(tunfd, F_SETFL, fcntl(tunfd, F_GETFL) | O_NONBLOCK) == -1) {
+    err(1, "tun_init: fcntl");
+  }
+
   select_set_callback(tunfd, &tun_select_callback);
 
   fprintf(stderr, "opened %s device ``/dev/%s''\n",
@@ -254,6 +270,9 @@ tun_input(unsigned char *data, int maxlen)
   }
 
   if((size = read(tunfd, data, maxlen)) == -1) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      return 0;
+    }
     err(1, "tun_input: read");
   }
   return size;
@@ -290,6 +309,7 @@ static void
 handle_fd(fd_set *rset, fd_set *wset)
 {
   int size;
+  int i;
 
   if(tunfd == -1) {
     /* tun is not open */
@@ -299,10 +319,16 @@ handle_fd(fd_set *rset, fd_set *wset)
   LOG_INFO("Tun6-handle FD\n");
 
   if(FD_ISSET(tunfd, rset)) {
-    size = tun_input(uip_buf, sizeof(uip_buf));
-    LOG_DBG("TUN data incoming read:%d\n", size);
-    uip_len = size;
-    tcpip_input();
+    /* tcpip_input() is done with uip_buf when it returns */
+    for(i = 0; i < READ_BATCH; i++) {
+      size = tun_input(uip_buf, sizeof(uip_buf));
+      LOG_DBG("TUN data incoming read:%d\n", size);
+      if(size <= 0) {
+        break;
+      }
+      uip_len = size;
+      tcpip_input();
+    }
   }
 }
 #endif /*  __CYGWIN_ */
@@ -46,6 +46,15 @@
 #include "sys/rtimer.h"
 #include "sys/clock.h"
 
+#if RTIMER_ARCH_TIMERFD && !NATIVE_VIRTUAL_TIME
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#endif /* NATIVE_VIRTUAL_TIME */
+
 #define DEBUG 0
 #if DEBUG
 #include <stdio.h>
@@ -54,6 +63,103 @@
 #define PRINTF(...)
 #endif
 
+#if NATIVE_VIRTUAL_TIME
+/*---------------------------------------------------------------------------*/
+rtimer_clock_t
+rtimer_arch_now(void)
+{
+  return (rtimer_clock_t)virtual_time_now();
+}
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_schedule(rtimer_clock_t t)
+{
+  int32_t c;
+
+  c = RTIMER_CLOCK_DIFF(t, rtimer_arch_now());
+  PRINTF("rtimer_arch_schedule time %"PRIu32 " in %"PRId32 " us\n", t, c);
+  virtual_time_set_alarm(virtual_time_now() + (c > 0 ? c : 0));
+}
+/*---------------------------------------------------------------------------*/
+#elif RTIMER_ARCH_TIMERFD
+static int timer_fd = -1;
+/*---------------------------------------------------------------------------*/
+rtimer_clock_t
+rtimer_arch_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (rtimer_clock_t)((uint64_t)ts.tv_sec * RTIMER_ARCH_SECOND +
+                          ts.tv_nsec / (1000000000UL / RTIMER_ARCH_SECOND));
+}
+/*---------------------------------------------------------------------------*/
+static int
+set_fd(fd_set *rset, fd_set *wset)
+{
+  FD_SET(timer_fd, rset);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_fd(fd_set *rset, fd_set *wset)
+{
+  uint64_t expirations;
+
+  if(FD_ISSET(timer_fd, rset)) {
+    /* The timer is one-shot: a successful read means it has expired */
+    if(read(timer_fd, &expirations, sizeof(expirations)) ==
+       sizeof(expirations)) {
+      rtimer_run_next();
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static const struct select_callback timer_callback = { set_fd, handle_fd };
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_init(void)
+{
+  timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if(timer_fd < 0) {
+    perror("timerfd_create");
+    exit(EXIT_FAILURE);
+  }
+  if(select_set_callback(timer_fd, &timer_callback) == 0) {
+    fprintf(stderr, "rtimer: timerfd %d exceeds SELECT_MAX\n", timer_fd);
+    exit(EXIT_FAILURE);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_schedule(rtimer_clock_t t)
+{
+  struct itimerspec val = { { 0, 0 }, { 0, 0 } };
+  int32_t c;
+
+  c = RTIMER_CLOCK_DIFF(t, rtimer_arch_now());
+  if(c > 0) {
+    val.it_value.tv_sec = c / RTIMER_ARCH_SECOND;
+    val.it_value.tv_nsec = (c % RTIMER_ARCH_SECOND) *
+      (1000000000UL / RTIMER_ARCH_SECOND);
+  }
+  /* An all-zero value would disarm the timer; expire right away instead */
+  if(val.it_value.tv_sec == 0 && val.it_value.tv_nsec == 0) {
+    val.it_value.tv_nsec = 1;
+  }
+
+  PRINTF("rtimer_arch_schedule time %"PRIu32 " in %ld.%09ld seconds\n",
+         t, (long)val.it_value.tv_sec, (long)val.it_value.tv_nsec);
+
+  timerfd_settime(timer_fd, 0, &val, NULL);
+}
+/*---------------------------------------------------------------------------*/
+#else /* RTIMER_ARCH_TIMERFD */
 /*---------------------------------------------------------------------------*/
 static void
 interrupt(int sig)
@@ -78,9 +184,13 @@ rtimer_arch_schedule(rtimer_clock_t t)
   rtimer_clock_t c;
 
   c = t - clock_time();
-  
+  if(RTIMER_CLOCK_LT(t, clock_time()) || c == 0) {
+    /* A zero value would disarm the timer */
+    c = 1;
+  }
+
   val.it_value.tv_sec = c / CLOCK_SECOND;
-  val.it_value.tv_usec = (c % CLOCK_SECOND) * CLOCK_SECOND;
+  val.it_value.tv_usec = (c % CLOCK_SECOND) * (1000000 / CLOCK_SECOND);
 
   PRINTF("rtimer_arch_schedule time %"PRIu32 " %"PRIu32 " in %ld.%ld seconds\n",
          t, c, (long)val.it_value.tv_sec, (long)val.it_value.tv_usec);
@@ -90,3 +200,4 @@ rtimer_arch_schedule(rtimer_clock_t t)
 #endif /* !_WIN32 */
 }
 /*---------------------------------------------------------------------------*/
+#endif /* RTIMER_ARCH_TIMERFD */
@@ -41,9 +41,44 @@
 #define RTIMER_ARCH_H_
 
 #include "contiki.h"
+#include "virtual-time.h"
 
+/*
+ * On Linux, rtimers are driven by a CLOCK_MONOTONIC timerfd that is
+ * serviced from the main loop, giving microsecond resolution. Otherwise
+ * fall back to SIGALRM with clock_time() resolution.
+ */
+#ifdef RTIMER_ARCH_CONF_TIMERFD
+#define RTIMER_ARCH_TIMERFD RTIMER_ARCH_CONF_TIMERFD
+#elif defined(__linux__)
+#define RTIMER_ARCH_TIMERFD 1
+#else
+#define RTIMER_ARCH_TIMERFD 0
+#endif
+
+#if NATIVE_VIRTUAL_TIME || RTIMER_ARCH_TIMERFD
+/* Virtual time keeps the microsecond resolution of the timerfd backend */
+#define RTIMER_ARCH_SECOND 1000000UL
+
+#if NATIVE_VIRTUAL_TIME
+/* Virtual time stands still while busy, so busy waits move it along */
+#define RTIMER_BUSYWAIT_UNTIL_ABS(cond, t0, max_time) \
+  ({                                                                \
+    bool c;                                                         \
+    while(!(c = cond) &&                                            \
+          RTIMER_CLOCK_LT(RTIMER_NOW(), (t0) + (max_time))) {       \
+      virtual_time_busywait(RTIMER_CLOCK_DIFF((t0) + (max_time),    \
+                                              RTIMER_NOW()));       \
+    }                                                               \
+    c;                                                              \
+  })
+#endif /* NATIVE_VIRTUAL_TIME */
+
+rtimer_clock_t rtimer_arch_now(void);
+#else /* NATIVE_VIRTUAL_TIME || RTIMER_ARCH_TIMERFD */
 #define RTIMER_ARCH_SECOND CLOCK_CONF_SECOND
 
 #define rtimer_arch_now() clock_time()
+#endif /* NATIVE_VIRTUAL_TIME || RTIMER_ARCH_TIMERFD */
 
 #endif /* RTIMER_ARCH_H_ */
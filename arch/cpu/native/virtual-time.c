@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Discrete-event virtual time for the native platform.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "sys/rtimer.h"
+#include "virtual-time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+/*---------------------------------------------------------------------------*/
+#if NATIVE_VIRTUAL_TIME
+/*---------------------------------------------------------------------------*/
+#ifdef VIRTUAL_TIME_CONF_SYNC
+#define VIRTUAL_TIME_SYNC VIRTUAL_TIME_CONF_SYNC
+extern const struct virtual_time_sync VIRTUAL_TIME_SYNC;
+#endif
+
+#define US_PER_TICK (VIRTUAL_TIME_SECOND / CLOCK_SECOND)
+
+static virtual_time_t now;
+static virtual_time_t alarm_time = VIRTUAL_TIME_NEVER;
+/*---------------------------------------------------------------------------*/
+virtual_time_t
+virtual_time_now(void)
+{
+  return now;
+}
+/*---------------------------------------------------------------------------*/
+void
+virtual_time_set_alarm(virtual_time_t t)
+{
+  alarm_time = t;
+}
+/*---------------------------------------------------------------------------*/
+int
+virtual_time_pending(void)
+{
+#ifdef VIRTUAL_TIME_SYNC
+  /* Other nodes may have input for us even when we have no timers */
+  return 1;
+#else
+  return alarm_time != VIRTUAL_TIME_NEVER || etimer_pending();
+#endif
+}
+/*---------------------------------------------------------------------------*/
+void
+virtual_time_init(void)
+{
+#ifdef VIRTUAL_TIME_SYNC
+  VIRTUAL_TIME_SYNC.init();
+#endif
+}
+/*---------------------------------------------------------------------------*/
+void
+virtual_time_advance(void)
+{
+  virtual_time_t next;
+  virtual_time_t t;
+
+  next = alarm_time;
+  if(etimer_pending()) {
+    t = (virtual_time_t)etimer_next_expiration_time() * US_PER_TICK;
+    if(t < next) {
+      next = t;
+    }
+  }
+#ifdef VIRTUAL_TIME_SYNC
+  next = VIRTUAL_TIME_SYNC.advance(now, next);
+#endif
+  if(next == VIRTUAL_TIME_NEVER) {
+    return;
+  }
+  if(next > now) {
+    now = next;
+  }
+
+#if VIRTUAL_TIME_STOP
+  if(now >= VIRTUAL_TIME_STOP * VIRTUAL_TIME_SECOND) {
+    fprintf(stderr, "virtual time: stopping after %lu s\n",
+            (unsigned long)VIRTUAL_TIME_STOP);
+    exit(EXIT_SUCCESS);
+  }
+#endif /* VIRTUAL_TIME_STOP */
+
+  if(alarm_time <= now) {
+    alarm_time = VIRTUAL_TIME_NEVER;
+    rtimer_run_next();
+  }
+  etimer_request_poll();
+}
+/*---------------------------------------------------------------------------*/
+void
+virtual_time_busywait(uint32_t us)
+{
+  virtual_time_t next = now + us;
+
+#ifdef VIRTUAL_TIME_SYNC
+  next = VIRTUAL_TIME_SYNC.advance(now, next);
+#endif
+  if(next > now) {
+    now = next;
+  }
+}
+/*---------------------------------------------------------------------------*/
+#endif /* NATIVE_VIRTUAL_TIME */
+/*---------------------------------------------------------------------------*/
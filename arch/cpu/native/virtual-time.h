@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+/**
+ * \file
+ *         Discrete-event virtual time for the native platform.
+ *
+ *         With NATIVE_CONF_VIRTUAL_TIME (make VIRTUAL_TIME=1), clock_time()
+ *         and rtimers run on a simulated microsecond clock. Whenever the
+ *         main loop has nothing left to do, the clock jumps straight to
+ *         the next etimer or rtimer deadline instead of sleeping.
+ */
+/*---------------------------------------------------------------------------*/
+#ifndef VIRTUAL_TIME_H_
+#define VIRTUAL_TIME_H_
+/*---------------------------------------------------------------------------*/
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+#ifdef NATIVE_CONF_VIRTUAL_TIME
+#define NATIVE_VIRTUAL_TIME NATIVE_CONF_VIRTUAL_TIME
+#else
+#define NATIVE_VIRTUAL_TIME 0
+#endif
+
+/* Stop the node once this many virtual seconds have passed, 0 = never */
+#ifdef VIRTUAL_TIME_CONF_STOP
+#define VIRTUAL_TIME_STOP VIRTUAL_TIME_CONF_STOP
+#else
+#define VIRTUAL_TIME_STOP 0
+#endif
+/*---------------------------------------------------------------------------*/
+/** Virtual time in microseconds since the node started */
+typedef uint64_t virtual_time_t;
+
+#define VIRTUAL_TIME_SECOND 1000000ULL
+#define VIRTUAL_TIME_NEVER  UINT64_MAX
+
+/**
+ * \brief Synchronizes the virtual clocks of cooperating nodes
+ *
+ * Set VIRTUAL_TIME_CONF_SYNC to the name of an instance. Without it the
+ * node runs alone and jumps to its next deadline right away.
+ */
+struct virtual_time_sync {
+  /** Called once before the main loop starts */
+  void (*init)(void);
+  /**
+   * Called when the node is idle until \a next (VIRTUAL_TIME_NEVER if
+   * nothing is scheduled). Returns the time to advance to: \a next, or
+   * an earlier time at which input for this node became due.
+   */
+  virtual_time_t (*advance)(virtual_time_t now, virtual_time_t next);
+};
+/*---------------------------------------------------------------------------*/
+/** \brief The current virtual time */
+virtual_time_t virtual_time_now(void);
+
+/** \brief Sets the virtual time at which rtimer_run_next() is due */
+void virtual_time_set_alarm(virtual_time_t t);
+
+/** \brief Whether an etimer or rtimer deadline lies ahead */
+int virtual_time_pending(void);
+
+/** \brief Initializes the sync module, see VIRTUAL_TIME_CONF_SYNC */
+void virtual_time_init(void);
+
+/**
+ * \brief Advances the clock to the next deadline and runs what is due
+ *
+ * Called by the main loop when no process has events pending and no
+ * file descriptor was ready.
+ */
+void virtual_time_advance(void);
+
+/**
+ * \brief Lets up to \a us microseconds pass inside a busy wait
+ *
+ * Timers are not run, but input from other nodes may end the wait
+ * early.
+ */
+void virtual_time_busywait(uint32_t us);
+/*---------------------------------------------------------------------------*/
+#endif /* VIRTUAL_TIME_H_ */
+/*---------------------------------------------------------------------------*/
@@ -38,10 +38,25 @@
  */
 
 #include "sys/clock.h"
+#include "virtual-time.h"
 #include <time.h>
 #include <sys/time.h>
 
 /*---------------------------------------------------------------------------*/
+#if NATIVE_VIRTUAL_TIME
+clock_time_t
+clock_time(void)
+{
+  return virtual_time_now() / (VIRTUAL_TIME_SECOND / CLOCK_SECOND);
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+clock_seconds(void)
+{
+  return virtual_time_now() / VIRTUAL_TIME_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+#else /* NATIVE_VIRTUAL_TIME */
 typedef struct clock_timespec_s {
   time_t  tv_sec;
   long  tv_nsec;
@@ -87,6 +102,8 @@ clock_seconds(void)
   return ts.tv_sec;
 }
 /*---------------------------------------------------------------------------*/
+#endif /* NATIVE_VIRTUAL_TIME */
+/*---------------------------------------------------------------------------*/
 void
 clock_delay(unsigned int d)
 {
@@ -66,6 +66,27 @@ typedef unsigned int uip_stats_t;
 #define UIP_CONF_BYTE_ORDER      UIP_LITTLE_ENDIAN
 #endif
 
+#if NATIVE_CONF_PCAP_RADIO
+/* Frames are recorded from, or replayed into, the MAC layer */
+#ifndef NETSTACK_CONF_RADIO
+#define NETSTACK_CONF_RADIO pcap_radio_driver
+#endif /* NETSTACK_CONF_RADIO */
+#if NETSTACK_CONF_WITH_IPV6 && !defined(NETSTACK_CONF_NETWORK)
+#define NETSTACK_CONF_NETWORK sicslowpan_driver
+#endif
+#endif /* NATIVE_CONF_PCAP_RADIO */
+
+#if NATIVE_CONF_SHM_RADIO
+/* Nodes started by tools/native-sim, on the shared-memory medium */
+#ifndef NETSTACK_CONF_RADIO
+#define NETSTACK_CONF_RADIO shm_radio_driver
+#endif /* NETSTACK_CONF_RADIO */
+#if NETSTACK_CONF_WITH_IPV6 && !defined(NETSTACK_CONF_NETWORK)
+#define NETSTACK_CONF_NETWORK sicslowpan_driver
+#endif
+#define VIRTUAL_TIME_CONF_SYNC shm_radio_sync
+#endif /* NATIVE_CONF_SHM_RADIO */
+
 #if NETSTACK_CONF_WITH_IPV6
 
 #ifndef NETSTACK_CONF_NETWORK
@@ -43,6 +43,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/select.h>
@@ -63,6 +64,9 @@
 #include "net/ipv6/uip.h"
 #include "net/ipv6/uip-debug.h"
 #include "net/queuebuf.h"
+#include "virtual-time.h"
+#include "shm-radio.h"
+#include "pcap-radio.h"
 
 #if NETSTACK_CONF_WITH_IPV6
 #include "net/ipv6/uip-ds6.h"
@@ -108,18 +112,140 @@
 #else
 #define SELECT_STDIN 1
 #endif
+
+/*
+ * Waits for file descriptors with epoll instead of select. The descriptors
+ * are registered once and only the ready ones are handed to their callback.
+ */
+#ifdef SELECT_CONF_EPOLL
+#define SELECT_EPOLL SELECT_CONF_EPOLL
+#elif defined(__linux__)
+#define SELECT_EPOLL 1
+#else
+#define SELECT_EPOLL 0
+#endif
 /** @} */
 /*---------------------------------------------------------------------------*/
 
+#if SELECT_EPOLL
+#include <sys/epoll.h>
+#endif /* SELECT_EPOLL */
+
 static const struct select_callback *select_callback[SELECT_MAX];
 static int select_max = 0;
 
+#if SELECT_EPOLL
+static int epoll_fd = -1;
+/* The events each descriptor is currently registered for */
+static uint32_t epoll_events[SELECT_MAX];
+/* Regular files cannot be polled, like select they are always ready */
+static uint8_t epoll_always_ready[SELECT_MAX];
+#endif /* SELECT_EPOLL */
+
 #ifdef PLATFORM_CONF_MAC_ADDR
 static uint8_t mac_addr[] = PLATFORM_CONF_MAC_ADDR;
 #else /* PLATFORM_CONF_MAC_ADDR */
 static uint8_t mac_addr[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
 #endif /* PLATFORM_CONF_MAC_ADDR */
 
+/*---------------------------------------------------------------------------*/
+#if SELECT_EPOLL
+static void
+epoll_update(int fd, uint32_t events)
+{
+  struct epoll_event ev;
+  int op;
+
+  if(events == epoll_events[fd]) {
+    return;
+  }
+  if(epoll_events[fd] == 0) {
+    op = EPOLL_CTL_ADD;
+  } else if(events == 0) {
+    op = EPOLL_CTL_DEL;
+  } else {
+    op = EPOLL_CTL_MOD;
+  }
+  epoll_events[fd] = events;
+  if(epoll_always_ready[fd]) {
+    epoll_always_ready[fd] = events != 0;
+    return;
+  }
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.fd = fd;
+  if(epoll_ctl(epoll_fd, op, fd, &ev) < 0) {
+    if(op == EPOLL_CTL_ADD && errno == EPERM) {
+      epoll_always_ready[fd] = 1;
+    } else if(op != EPOLL_CTL_DEL) {
+      /* The descriptor may already be closed when it is removed */
+      perror("epoll_ctl");
+      epoll_events[fd] = 0;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Asks the callback of fd which events it currently waits for */
+static uint32_t
+callback_events(int fd)
+{
+  fd_set fdr;
+  fd_set fdw;
+  uint32_t events = 0;
+
+  FD_ZERO(&fdr);
+  FD_ZERO(&fdw);
+  if(select_callback[fd]->set_fd(&fdr, &fdw)) {
+    if(FD_ISSET(fd, &fdr)) {
+      events |= EPOLLIN;
+    }
+    if(FD_ISSET(fd, &fdw)) {
+      events |= EPOLLOUT;
+    }
+  }
+  return events;
+}
+#endif /* SELECT_EPOLL */
+/*---------------------------------------------------------------------------*/
+/* Milliseconds to wait for file descriptors: none if processes have events
+   pending or a descriptor is always ready, else until the next etimer
+   expires, at most SELECT_TIMEOUT */
+static int
+wait_timeout(int events_pending)
+{
+  clock_time_t now;
+  clock_time_t next;
+  unsigned long ms;
+#if SELECT_EPOLL
+  int fd;
+#endif /* SELECT_EPOLL */
+
+  if(events_pending) {
+    return 0;
+  }
+#if SELECT_EPOLL
+  /* select would return at once for these, so must epoll_wait */
+  for(fd = 0; fd <= select_max; fd++) {
+    if(epoll_always_ready[fd] && select_callback[fd] != NULL) {
+      return 0;
+    }
+  }
+#endif /* SELECT_EPOLL */
+#if NATIVE_VIRTUAL_TIME
+  /* Only poll, time is advanced by the main loop once idle */
+  return virtual_time_pending() ? 0 : SELECT_TIMEOUT;
+#endif /* NATIVE_VIRTUAL_TIME */
+  if(!etimer_pending()) {
+    return SELECT_TIMEOUT;
+  }
+  now = clock_time();
+  next = etimer_next_expiration_time();
+  if(next <= now) {
+    return 0;
+  }
+  ms = ((unsigned long)(next - now) * 1000 + CLOCK_SECOND - 1) / CLOCK_SECOND;
+  return ms < SELECT_TIMEOUT ? (int)ms : SELECT_TIMEOUT;
+}
 /*---------------------------------------------------------------------------*/
 int
 select_set_callback(int fd, const struct select_callback *callback)
@@ -133,6 +259,11 @@ select_set_callback(int fd, const struct select_callback *callback)
     }
 
     select_callback[fd] = callback;
+#if SELECT_EPOLL
+    if(callback == NULL && epoll_fd >= 0) {
+      epoll_update(fd, 0);
+    }
+#endif /* SELECT_EPOLL */
 
     /* Update fd max */
     if(callback != NULL) {
@@ -171,9 +302,14 @@ static void
 stdin_handle_fd(fd_set *rset, fd_set *wset)
 {
   char c;
+  int n;
   if(FD_ISSET(STDIN_FILENO, rset)) {
-    if(read(STDIN_FILENO, &c, 1) > 0) {
+    n = read(STDIN_FILENO, &c, 1);
+    if(n > 0) {
       input_handler(c);
+    } else if(n == 0) {
+      /* End of file, stop polling a descriptor that is always ready */
+      select_set_callback(STDIN_FILENO, NULL);
     }
   }
 }
@@ -188,6 +324,20 @@ set_lladdr(void)
   linkaddr_t addr;
 
   memset(&addr, 0, sizeof(linkaddr_t));
+#if NATIVE_SHM_RADIO
+  /* Simulated nodes are numbered from 1 in the order they were started */
+  if(shm_radio_node_index() >= 0) {
+    mac_addr[sizeof(mac_addr) - 2] = (shm_radio_node_index() + 1) >> 8;
+    mac_addr[sizeof(mac_addr) - 1] = (shm_radio_node_index() + 1) & 0xff;
+  }
+#endif /* NATIVE_SHM_RADIO */
+#if NATIVE_PCAP_RADIO
+  /* A replayed trace is addressed to the node that recorded it */
+  if(pcap_radio_node() > 0) {
+    mac_addr[sizeof(mac_addr) - 2] = pcap_radio_node() >> 8;
+    mac_addr[sizeof(mac_addr) - 1] = pcap_radio_node() & 0xff;
+  }
+#endif /* NATIVE_PCAP_RADIO */
 #if NETSTACK_CONF_WITH_IPV6
   memcpy(addr.u8, mac_addr, sizeof(addr.u8));
 #else
@@ -199,7 +349,7 @@ set_lladdr(void)
   linkaddr_set_node_addr(&addr);
 }
 /*---------------------------------------------------------------------------*/
-#if NETSTACK_CONF_WITH_IPV6
+#if NETSTACK_CONF_WITH_IPV6 && !NATIVE_SHM_RADIO && !NATIVE_PCAP_RADIO
 static void
 set_global_address(void)
 {
@@ -278,7 +428,10 @@ platform_init_stage_three()
   process_start(&wpcap_process, NULL);
 #endif
 
+#if !NATIVE_SHM_RADIO && !NATIVE_PCAP_RADIO
+  /* Simulated nodes get their addresses from the routing protocol */
   set_global_address();
+#endif /* !NATIVE_SHM_RADIO && !NATIVE_PCAP_RADIO */
 
 #endif /* NETSTACK_CONF_WITH_IPV6 */
 
@@ -292,18 +445,80 @@ platform_main_loop()
 #if SELECT_STDIN
   select_set_callback(STDIN_FILENO, &stdin_fd);
 #endif /* SELECT_STDIN */
+#if SELECT_EPOLL
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if(epoll_fd < 0) {
+    perror("epoll_create1");
+    exit(EXIT_FAILURE);
+  }
+#endif /* SELECT_EPOLL */
+#if NATIVE_VIRTUAL_TIME
+  virtual_time_init();
+#endif /* NATIVE_VIRTUAL_TIME */
   while(1) {
     fd_set fdr;
     fd_set fdw;
-    int maxfd;
     int i;
     int retval;
+    int timeout;
+#if SELECT_EPOLL
+    struct epoll_event events[SELECT_MAX];
+    int fd;
+
+    retval = process_run();
+
+    /* Registrations only change when a callback's interest does */
+    for(i = 0; i <= select_max; i++) {
+      if(select_callback[i] != NULL) {
+        epoll_update(i, callback_events(i));
+      }
+    }
+    timeout = wait_timeout(retval);
+
+    retval = epoll_wait(epoll_fd, events, SELECT_MAX, timeout);
+    if(retval < 0) {
+      if(errno != EINTR) {
+        perror("epoll_wait");
+      }
+    }
+    for(i = 0; i < retval; i++) {
+      fd = events[i].data.fd;
+      if(select_callback[fd] == NULL) {
+        continue;
+      }
+      FD_ZERO(&fdr);
+      FD_ZERO(&fdw);
+      /* Errors and hangups are reported as readable, as select does */
+      if(events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        FD_SET(fd, &fdr);
+      }
+      if(events[i].events & EPOLLOUT) {
+        FD_SET(fd, &fdw);
+      }
+      select_callback[fd]->handle_fd(&fdr, &fdw);
+    }
+    for(fd = 0; fd <= select_max; fd++) {
+      if(epoll_always_ready[fd] && select_callback[fd] != NULL) {
+        FD_ZERO(&fdr);
+        FD_ZERO(&fdw);
+        if(epoll_events[fd] & EPOLLIN) {
+          FD_SET(fd, &fdr);
+        }
+        if(epoll_events[fd] & EPOLLOUT) {
+          FD_SET(fd, &fdw);
+        }
+        select_callback[fd]->handle_fd(&fdr, &fdw);
+      }
+    }
+#else /* SELECT_EPOLL */
+    int maxfd;
     struct timeval tv;
 
     retval = process_run();
+    timeout = wait_timeout(retval);
 
-    tv.tv_sec = retval ? 0 : SELECT_TIMEOUT / 1000;
-    tv.tv_usec = retval ? 1 : (SELECT_TIMEOUT * 1000) % 1000000;
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout * 1000) % 1000000;
 
     FD_ZERO(&fdr);
     FD_ZERO(&fdw);
@@ -327,6 +542,14 @@ platform_main_loop()
         }
       }
     }
+#endif /* SELECT_EPOLL */
+
+#if NATIVE_VIRTUAL_TIME
+    /* Nothing ran and no input arrived: jump to the next deadline */
+    if(retval <= 0 && process_nevents() == 0) {
+      virtual_time_advance();
+    }
+#endif /* NATIVE_VIRTUAL_TIME */
 
     etimer_request_poll();
   }
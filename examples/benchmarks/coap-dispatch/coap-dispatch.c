@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+
+/**
+ * \file
+ *         CoAP resource dispatch benchmark.
+ *
+ *         Activates a set of LwM2M-style resources ("<object>/<instance>/
+ *         <resource>", plus parent resources for some objects) and looks
+ *         up a mix of request paths, both through the engine's path index
+ *         and through a linear walk over the resource list, which is how
+ *         requests used to be dispatched. Prints lookups per second for
+ *         both.
+ */
+
+#include "contiki.h"
+#include "coap-engine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+/*---------------------------------------------------------------------------*/
+#define OBJECTS     16
+#define INSTANCES   2
+#define RESOURCES   4
+#define LEAVES      (OBJECTS * INSTANCES * RESOURCES)
+#define PARENTS     (OBJECTS / 4)
+#define REQUESTS    64
+#define ROUNDS      20000
+
+#define PATH_LEN    24
+/*---------------------------------------------------------------------------*/
+static coap_resource_t resources[LEAVES + PARENTS];
+static char paths[LEAVES + PARENTS][PATH_LEN];
+static char requests[REQUESTS][PATH_LEN];
+static size_t request_lens[REQUESTS];
+
+PROCESS(coap_dispatch_process, "CoAP dispatch benchmark");
+AUTOSTART_PROCESSES(&coap_dispatch_process);
+/*---------------------------------------------------------------------------*/
+static void
+get_handler(coap_message_t *request, coap_message_t *response,
+            uint8_t *buffer, uint16_t preferred_size, int32_t *offset)
+{
+}
+/*---------------------------------------------------------------------------*/
+/* The matching rule invoke_coap_resource_service() used to apply */
+static coap_resource_t *
+linear_lookup(const char *url, size_t url_len)
+{
+  coap_resource_t *resource;
+  size_t res_url_len;
+
+  for(resource = coap_get_first_resource(); resource;
+      resource = coap_get_next_resource(resource)) {
+    res_url_len = strlen(resource->url);
+    if((url_len == res_url_len
+        || (url_len > res_url_len
+            && (resource->flags & HAS_SUB_RESOURCES)
+            && url[res_url_len] == '/'))
+       && strncmp(resource->url, url, res_url_len) == 0) {
+      return resource;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+static double
+run(coap_resource_t *(*lookup)(const char *, size_t), unsigned long *hits)
+{
+  double start = now();
+  int round, i;
+
+  *hits = 0;
+  for(round = 0; round < ROUNDS; round++) {
+    for(i = 0; i < REQUESTS; i++) {
+      if(lookup(requests[i], request_lens[i]) != NULL) {
+        (*hits)++;
+      }
+    }
+  }
+  return (double)ROUNDS * REQUESTS / (now() - start);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_dispatch_process, ev, data)
+{
+  unsigned long hits, linear_hits;
+  double rate, linear_rate;
+  int i, n;
+
+  PROCESS_BEGIN();
+
+  coap_engine_init();
+
+  n = 0;
+  for(i = 0; i < LEAVES; i++, n++) {
+    snprintf(paths[n], PATH_LEN, "%u/%u/%u", 3300 + i / (INSTANCES * RESOURCES),
+             (i / RESOURCES) % INSTANCES, 5700 + i % RESOURCES);
+    resources[n].flags = IS_OBSERVABLE;
+    resources[n].get_handler = get_handler;
+    coap_activate_resource(&resources[n], paths[n]);
+  }
+  /* Parents activated last only receive paths that no leaf handles */
+  for(i = 0; i < PARENTS; i++, n++) {
+    snprintf(paths[n], PATH_LEN, "%u", 3300 + i * 4);
+    resources[n].flags = HAS_SUB_RESOURCES;
+    resources[n].get_handler = get_handler;
+    coap_activate_resource(&resources[n], paths[n]);
+  }
+
+  /* Exact hits, sub-resource hits and misses, spread over all objects */
+  srand(1);
+  for(i = 0; i < REQUESTS; i++) {
+    int object = 3300 + rand() % (OBJECTS + 4);
+    switch(i % 4) {
+    case 0:
+    case 1:
+      snprintf(requests[i], PATH_LEN, "%u/%u/%u", object, rand() % INSTANCES,
+               5700 + rand() % RESOURCES);
+      break;
+    case 2:
+      snprintf(requests[i], PATH_LEN, "%u/%u/%u", object, rand() % INSTANCES,
+               5750);
+      break;
+    default:
+      snprintf(requests[i], PATH_LEN, "%u/9", object);
+      break;
+    }
+    request_lens[i] = strlen(requests[i]);
+  }
+
+  for(i = 0; i < REQUESTS; i++) {
+    if(coap_get_resource_by_path(requests[i], request_lens[i]) !=
+       linear_lookup(requests[i], request_lens[i])) {
+      printf("coap-dispatch: lookups disagree on /%s\n", requests[i]);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  printf("coap-dispatch: %d resources, %d request paths, %d rounds\n",
+         n + 1, REQUESTS, ROUNDS);
+
+  linear_rate = run(linear_lookup, &linear_hits);
+  rate = run(coap_get_resource_by_path, &hits);
+
+  printf("coap-dispatch: linear walk %.0f lookups/s (%lu hits)\n",
+         linear_rate, linear_hits);
+  printf("coap-dispatch: path index  %.0f lookups/s (%lu hits)\n",
+         rate, hits);
+  exit(EXIT_SUCCESS);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+
+/**
+ * \file
+ *         CoAP transaction matching load test.
+ *
+ *         Keeps COAP_MAX_OPEN_TRANSACTIONS confirmable exchanges with a
+ *         set of peers open and feeds ACKs and RSTs for them, in random
+ *         order, through coap_receive(). Each answered exchange is
+ *         replaced by a new one, as on a gateway under steady load.
+ *         Prints the answers matched per second. Build with
+ *         DEFINES=COAP_CONF_TRANSACTION_BUCKETS=1 to compare against a
+ *         plain list walk.
+ */
+
+#include "contiki.h"
+#include "coap-engine.h"
+#include "coap-transactions.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+/*---------------------------------------------------------------------------*/
+#define EXCHANGES   COAP_MAX_OPEN_TRANSACTIONS
+#define PEERS       16
+#define ANSWERS     500000
+/*---------------------------------------------------------------------------*/
+static coap_endpoint_t peers[PEERS];
+static uint16_t open_mids[EXCHANGES];
+
+PROCESS(coap_exchanges_process, "CoAP exchanges load test");
+AUTOSTART_PROCESSES(&coap_exchanges_process);
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+static int
+open_exchange(int i)
+{
+  coap_message_t request[1];
+  coap_transaction_t *t;
+  uint16_t mid = coap_get_mid();
+
+  t = coap_new_transaction(mid, &peers[i % PEERS]);
+  if(t == NULL) {
+    return 0;
+  }
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, mid);
+  coap_set_header_uri_path(request, "sensors/temp");
+  t->message_len = coap_serialize_message(request, t->message);
+  /* Kept in flight without sending, only the matching is measured */
+  open_mids[i] = mid;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+answer_exchange(int i, int reset)
+{
+  uint8_t answer[4];
+
+  /* Empty ACK or RST, as sent by the peer */
+  answer[0] = 0x40 | ((reset ? COAP_TYPE_RST : COAP_TYPE_ACK) << 4);
+  answer[1] = 0;
+  answer[2] = open_mids[i] >> 8;
+  answer[3] = open_mids[i] & 0xff;
+  coap_receive(&peers[i % PEERS], answer, sizeof(answer));
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(coap_exchanges_process, ev, data)
+{
+  char uri[40];
+  double start, elapsed;
+  long n;
+  int i;
+
+  PROCESS_BEGIN();
+
+  coap_engine_init();
+
+  for(i = 0; i < PEERS; i++) {
+    snprintf(uri, sizeof(uri), "coap://[fd00::%x]", i + 1);
+    coap_endpoint_parse(uri, strlen(uri), &peers[i]);
+  }
+  for(i = 0; i < EXCHANGES; i++) {
+    if(!open_exchange(i)) {
+      printf("coap-exchanges: could only open %d exchanges\n", i);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  printf("coap-exchanges: %d exchanges with %d peers, %d answers\n",
+         EXCHANGES, PEERS, ANSWERS);
+
+  srand(1);
+  start = now();
+  for(n = 0; n < ANSWERS; n++) {
+    i = rand() % EXCHANGES;
+    answer_exchange(i, n % 8 == 0);
+    if(!open_exchange(i)) {
+      printf("coap-exchanges: answer %ld did not free its exchange\n", n);
+      exit(EXIT_FAILURE);
+    }
+  }
+  elapsed = now() - start;
+
+  for(i = 0; i < EXCHANGES; i++) {
+    if(coap_get_transaction_by_mid(open_mids[i]) == NULL) {
+      printf("coap-exchanges: exchange %u went missing\n", open_mids[i]);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  printf("coap-exchanges: %.0f answers/s\n", ANSWERS / elapsed);
+  exit(EXIT_SUCCESS);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
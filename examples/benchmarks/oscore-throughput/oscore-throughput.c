@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+
+/**
+ * \file
+ *         OSCORE exchange throughput test.
+ *
+ *         Derives CONTEXTS pairs of client and server security contexts
+ *         and runs protected GET exchanges through the OSCORE code of the
+ *         CoAP library: the client protects a batch of requests, the
+ *         server verifies and answers them and the client verifies the
+ *         answers. Prints the exchanges per second with one peer and with
+ *         all of them. Build with DEFINES=OSCORE_CONTEXT_BUCKETS=1 to
+ *         compare against a plain context walk and with
+ *         DEFINES=AES_128_CONF_KEY_SCHEDULES=1 to expand the sender and
+ *         recipient keys again on every message.
+ */
+
+#include "contiki.h"
+#include "coap-engine.h"
+#include "oscore-context.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+/*---------------------------------------------------------------------------*/
+#define CONTEXTS    512
+#define BATCH       16
+#define EXCHANGES   50000
+/*---------------------------------------------------------------------------*/
+static const uint8_t master_secret[16] = {
+  0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+  0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10
+};
+static const uint8_t master_salt[8] = {
+  0x9e, 0x7c, 0xa9, 0x22, 0x23, 0x78, 0x63, 0x40
+};
+
+/* Client IDs start with 1, server IDs with 2 */
+static uint8_t client_ids[CONTEXTS][3];
+static uint8_t server_ids[CONTEXTS][3];
+static oscore_ctx_t clients[CONTEXTS];
+static oscore_ctx_t servers[CONTEXTS];
+
+static uint8_t requests[BATCH][COAP_MAX_PACKET_SIZE];
+static uint8_t responses[BATCH][COAP_MAX_PACKET_SIZE];
+static size_t request_lens[BATCH];
+static size_t response_lens[BATCH];
+static uint32_t token;
+
+PROCESS(oscore_throughput_process, "OSCORE throughput test");
+AUTOSTART_PROCESSES(&oscore_throughput_process);
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+static void
+fail(const char *step, int i)
+{
+  printf("oscore-throughput: %s failed for message %d\n", step, i);
+  exit(EXIT_FAILURE);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_batch(int peers)
+{
+  coap_message_t message[1];
+  uint8_t *payload;
+  int i;
+
+  /* Client */
+  for(i = 0; i < BATCH; i++) {
+    token++;
+    coap_init_message(message, COAP_TYPE_CON, COAP_GET, token & 0xffff);
+    coap_set_token(message, (uint8_t *)&token, sizeof(token));
+    coap_set_header_uri_path(message, "sensors/temp");
+    coap_set_oscore(message, &clients[rand() % peers]);
+    request_lens[i] = coap_serialize_message(message, requests[i]);
+    if(request_lens[i] == 0 || request_lens[i] > COAP_MAX_PACKET_SIZE) {
+      fail("protecting request", i);
+    }
+  }
+
+  /* Server */
+  for(i = 0; i < BATCH; i++) {
+    oscore_ctx_t *ctx;
+    uint8_t request_token[COAP_TOKEN_LEN];
+    uint8_t request_token_len;
+    uint16_t mid;
+
+    if(coap_parse_message(message, requests[i], request_lens[i])
+       != NO_ERROR) {
+      fail("verifying request", i);
+    }
+    ctx = message->security_context;
+    mid = message->mid;
+    request_token_len = message->token_len;
+    memcpy(request_token, message->token, request_token_len);
+
+    coap_init_message(message, COAP_TYPE_ACK, CONTENT_2_05, mid);
+    coap_set_token(message, request_token, request_token_len);
+    coap_set_oscore(message, ctx);
+    coap_set_payload(message, "21.5", 4);
+    response_lens[i] = coap_serialize_message(message, responses[i]);
+    if(response_lens[i] == 0 || response_lens[i] > COAP_MAX_PACKET_SIZE) {
+      fail("protecting response", i);
+    }
+  }
+
+  /* Client */
+  for(i = 0; i < BATCH; i++) {
+    if(coap_parse_message(message, responses[i], response_lens[i])
+       != NO_ERROR || message->code != CONTENT_2_05
+       || coap_get_payload(message, (const uint8_t **)&payload) != 4
+       || memcmp(payload, "21.5", 4) != 0) {
+      fail("verifying response", i);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+measure(int peers)
+{
+  double start, elapsed;
+  long n;
+
+  start = now();
+  for(n = 0; n < EXCHANGES; n += BATCH) {
+    run_batch(peers);
+  }
+  elapsed = now() - start;
+
+  printf("oscore-throughput: %d peers, %.0f exchanges/s\n",
+         peers, n / elapsed);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(oscore_throughput_process, ev, data)
+{
+  int i;
+
+  PROCESS_BEGIN();
+
+  coap_engine_init();
+
+  for(i = 0; i < CONTEXTS; i++) {
+    client_ids[i][0] = 1;
+    client_ids[i][1] = server_ids[i][1] = i >> 8;
+    client_ids[i][2] = server_ids[i][2] = i & 0xff;
+    server_ids[i][0] = 2;
+    oscore_derive_ctx(&clients[i], master_secret, sizeof(master_secret),
+                      master_salt, sizeof(master_salt), 10,
+                      client_ids[i], 3, server_ids[i], 3, NULL, 0);
+    oscore_derive_ctx(&servers[i], master_secret, sizeof(master_secret),
+                      master_salt, sizeof(master_salt), 10,
+                      server_ids[i], 3, client_ids[i], 3, NULL, 0);
+  }
+
+  printf("oscore-throughput: %d contexts, %d exchanges in batches of %d\n",
+         CONTEXTS, EXCHANGES, BATCH);
+
+  srand(1);
+  measure(1);
+  measure(CONTEXTS);
+
+  exit(EXIT_SUCCESS);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*---------------------------------------------------------------------------*/
+
+/**
+ * \file
+ *      Reads all meters with one group request every 30 seconds and
+ *      prints the reading of each meter that answers.
+ */
+
+#include "contiki.h"
+#include "coap-engine.h"
+#include "coap-callback-api.h"
+#include <string.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "App"
+#define LOG_LEVEL  LOG_LEVEL_APP
+
+/* All CoAP Nodes on the link, ff05::fd reaches the meters further away
+   when a multicast engine is configured */
+#define GROUP_URI "coap://[ff02::fd]"
+#define READ_INTERVAL (30 * CLOCK_SECOND)
+/* Twice the leisure of the meters */
+#define READ_TIMEOUT (2 * COAP_MULTICAST_LEISURE)
+
+static coap_endpoint_t group;
+static coap_message_t request[1];
+static coap_callback_group_state_t group_state;
+static struct etimer read_timer;
+
+PROCESS(meter_reader, "Meter reader");
+AUTOSTART_PROCESSES(&meter_reader);
+
+static void
+reading_callback(coap_callback_group_state_t *group_state)
+{
+  coap_request_state_t *state = &group_state->state;
+  const uint8_t *reading;
+  int length;
+
+  if(state->status == COAP_REQUEST_STATUS_RESPONSE) {
+    length = coap_get_payload(state->response, &reading);
+    LOG_INFO("Meter ");
+    LOG_INFO_COAP_EP(state->remote_endpoint);
+    LOG_INFO_(": %.*s Wh\n", length, (const char *)reading);
+  } else if(state->status == COAP_REQUEST_STATUS_FINISHED) {
+    LOG_INFO("%u meters answered\n", group_state->responses);
+  }
+}
+
+PROCESS_THREAD(meter_reader, ev, data)
+{
+  PROCESS_BEGIN();
+
+  coap_endpoint_parse(GROUP_URI, strlen(GROUP_URI), &group);
+
+  etimer_set(&read_timer, READ_INTERVAL);
+
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&read_timer));
+
+    LOG_INFO("Reading all meters\n");
+    coap_init_message(request, COAP_TYPE_NON, COAP_GET, 0);
+    coap_set_header_uri_path(request, "meter");
+    if(!coap_send_group_request(&group_state, &group, request,
+                                READ_TIMEOUT, reading_callback)) {
+      LOG_WARN("No transaction for the group request\n");
+    }
+
+    etimer_reset(&read_timer);
+  }
+
+  PROCESS_END();
+}
@@ -33,7 +33,7 @@
 /*---------------------------------------------------------------------------*/
 #define UIP_CONF_ROUTER                 0
 
-#define CMD_CONF_OUTPUT slip_write
+#define CMD_CONF_OUTPUT slip_radio_write
 
 /* Default CMD handlers if the target did not specify them */
 #ifndef CMD_CONF_HANDLERS
@@ -32,6 +32,7 @@
 #include "net/ipv6/uip.h"
 #include "net/packetbuf.h"
 #include "dev/slip.h"
+#include "slip-radio.h"
 #include "os/sys/log.h"
 
 #include <stdio.h>
@@ -73,7 +74,7 @@ slipnet_input(void)
   }
   LOG_DBG_("\n");
 
-  slip_write(uip_buf, uip_len);
+  slip_radio_write(uip_buf, uip_len);
 }
 /*---------------------------------------------------------------------------*/
 static uint8_t
@@ -41,6 +41,8 @@
 #include <string.h>
 #include "net/netstack.h"
 #include "net/packetbuf.h"
+#include "net/queuebuf.h"
+#include "lib/crc16.h"
 
 #include "cmd.h"
 #include "slip-radio.h"
@@ -52,6 +54,11 @@
 #define LOG_MODULE "slip-radio"
 #define LOG_LEVEL LOG_LEVEL_NONE
 /*---------------------------------------------------------------------------*/
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+/*---------------------------------------------------------------------------*/
 #ifdef SLIP_RADIO_CONF_SENSORS
 extern const struct slip_radio_sensors SLIP_RADIO_CONF_SENSORS;
 #endif
@@ -60,6 +67,30 @@ extern const struct slip_radio_sensors SLIP_RADIO_CONF_SENSORS;
 uint8_t packet_ids[16];
 int packet_pos;
 
+/* Frames the host may have in flight, advertised in answer to ?F */
+#ifdef SLIP_RADIO_CONF_TX_CREDITS
+#define TX_CREDITS SLIP_RADIO_CONF_TX_CREDITS
+#else
+#define TX_CREDITS MIN(QUEUEBUF_NUM, sizeof(packet_ids))
+#endif
+
+/* Max TX status reports sent in one !B frame */
+#ifdef SLIP_RADIO_CONF_REPORT_BATCH
+#define REPORT_BATCH SLIP_RADIO_CONF_REPORT_BATCH
+#else
+#define REPORT_BATCH 8
+#endif
+
+/* The host asked for credits and understands batched reports */
+static uint8_t host_fc;
+/* Frames carry a CRC-16 trailer, see SLIP_RADIO_FLAG_CRC */
+static uint8_t crc_enabled;
+static int inflight;
+static uint8_t reports[3 + 3 * REPORT_BATCH];
+static int report_count;
+
+PROCESS_NAME(slip_radio_process);
+
 static int slip_radio_cmd_handler(const uint8_t *data, int len);
 
 int cmd_handler_cc2420(const uint8_t *data, int len);
@@ -110,6 +141,51 @@ parse_frame(void)
 }
 /*---------------------------------------------------------------------------*/
 static void
+slip_writeb_escaped(uint8_t c)
+{
+  if(c == SLIP_END) {
+    slip_arch_writeb(SLIP_ESC);
+    c = SLIP_ESC_END;
+  } else if(c == SLIP_ESC) {
+    slip_arch_writeb(SLIP_ESC);
+    c = SLIP_ESC_ESC;
+  }
+  slip_arch_writeb(c);
+}
+/*---------------------------------------------------------------------------*/
+void
+slip_radio_write(const uint8_t *p, int len)
+{
+  uint16_t crc;
+  int i;
+
+  if(!crc_enabled) {
+    slip_write(p, len);
+    return;
+  }
+  crc = crc16_data(p, len, 0);
+  slip_arch_writeb(SLIP_END);
+  for(i = 0; i < len; i++) {
+    slip_writeb_escaped(p[i]);
+  }
+  slip_writeb_escaped(crc & 0xff);
+  slip_writeb_escaped(crc >> 8);
+  slip_arch_writeb(SLIP_END);
+}
+/*---------------------------------------------------------------------------*/
+static void
+flush_reports(void)
+{
+  if(report_count > 0) {
+    reports[0] = '!';
+    reports[1] = 'B';
+    reports[2] = report_count;
+    cmd_send(reports, 3 + 3 * report_count);
+    report_count = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
 packet_sent(void *ptr, int status, int transmissions)
 {
   uint8_t buf[20];
@@ -120,6 +196,22 @@ packet_sent(void *ptr, int status, int transmissions)
           sid, status, transmissions);
   /* packet callback from lower layers */
   /*  neighbor_info_packet_sent(status, transmissions); */
+  if(inflight > 0) {
+    inflight--;
+  }
+  if(host_fc) {
+    /* Collect reports and send them together once the MAC is done */
+    pos = 3 + 3 * report_count;
+    reports[pos++] = sid;
+    reports[pos++] = status;
+    reports[pos++] = transmissions;
+    if(++report_count == REPORT_BATCH) {
+      flush_reports();
+    } else {
+      process_poll(&slip_radio_process);
+    }
+    return;
+  }
   pos = 0;
   buf[pos++] = '!';
   buf[pos++] = 'R';
@@ -159,6 +251,7 @@ slip_radio_cmd_handler(const uint8_t *data, int len)
 
       /* parse frame before sending to get addresses, etc. */
       parse_frame();
+      inflight++;
       NETSTACK_MAC.send(packet_sent, &packet_ids[packet_pos]);
 
       packet_pos++;
@@ -186,6 +279,25 @@ slip_radio_cmd_handler(const uint8_t *data, int len)
         NETSTACK_RADIO.set_value(param, value);
       }
       return 1;
+    } else if(data[1] == 'M' && len >= 2 + UIP_LLADDR_LEN) {
+      /* Take the host's address, e.g. when it drives several radios */
+      memcpy(uip_lladdr.addr, &data[2], UIP_LLADDR_LEN);
+      linkaddr_set_node_addr((linkaddr_t *)uip_lladdr.addr);
+      NETSTACK_RADIO.set_object(RADIO_PARAM_64BIT_ADDR, &data[2],
+                                UIP_LLADDR_LEN);
+      NETSTACK_RADIO.set_value(RADIO_PARAM_16BIT_ADDR,
+                               (data[UIP_LLADDR_LEN] << 8) |
+                               data[UIP_LLADDR_LEN + 1]);
+      return 1;
+    } else if(data[1] == 'F' && len >= 3) {
+      /* Acknowledge without CRC, then use it from the next frame on */
+      uip_buf[0] = '!';
+      uip_buf[1] = 'F';
+      uip_buf[2] = TX_CREDITS > inflight ? TX_CREDITS - inflight : 0;
+      uip_buf[3] = data[2] & SLIP_RADIO_FLAG_CRC;
+      cmd_send(uip_buf, 4);
+      crc_enabled = (data[2] & SLIP_RADIO_FLAG_CRC) != 0;
+      return 1;
     }
   } else if(data[0] == '?') {
     LOG_DBG("Got request message of type %c\n", data[1]);
@@ -199,6 +311,15 @@ slip_radio_cmd_handler(const uint8_t *data, int len)
       uip_len = 10;
       cmd_send(uip_buf, uip_len);
       return 1;
+    } else if(data[1] == 'F') {
+      /* Advertise free queue slots and the supported framing flags */
+      host_fc = 1;
+      uip_buf[0] = '!';
+      uip_buf[1] = 'F';
+      uip_buf[2] = TX_CREDITS > inflight ? TX_CREDITS - inflight : 0;
+      uip_buf[3] = SLIP_RADIO_FLAG_CRC;
+      cmd_send(uip_buf, 4);
+      return 1;
     } else if(data[1] == 'V') {
       /* ask the radio about the specific parameter and send it back... */
       int type = ((uint16_t)data[2] << 8) | data[3];
@@ -227,6 +348,15 @@ static void
 slip_input_callback(void)
 {
   LOG_DBG("SR-SIN: %u '%c%c'\n", uip_len, uip_buf[0], uip_buf[1]);
+  if(crc_enabled) {
+    if(uip_len < 3 || crc16_data(uip_buf, uip_len - 2, 0) !=
+       (uip_buf[uip_len - 2] | (uip_buf[uip_len - 1] << 8))) {
+      LOG_WARN("dropping frame with bad CRC\n");
+      uipbuf_clear();
+      return;
+    }
+    uip_len -= 2;
+  }
   if(!cmd_input(uip_buf, uip_len)) {
     cmd_send((uint8_t *)"EUnknown command", 16);
   }
@@ -261,6 +391,10 @@ PROCESS_THREAD(slip_radio_process, ev, data)
   while(1) {
     PROCESS_YIELD();
 
+    if(ev == PROCESS_EVENT_POLL) {
+      flush_reports();
+    }
+
     if(etimer_expired(&et)) {
       etimer_reset(&et);
 #ifdef SLIP_RADIO_CONF_SENSORS
@@ -38,4 +38,10 @@ struct slip_radio_sensors {
   void (*send)(void);
 };
 
+/**
+ * \brief Writes a SLIP frame to the host, adding the CRC-16 trailer
+ * when CRC framing has been enabled with !F.
+ */
+void slip_radio_write(const uint8_t *ptr, int len);
+
 #endif /* SLIP_RADIO_H_ */
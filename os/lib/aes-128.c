@@ -64,7 +64,21 @@ static const uint8_t sbox[256] =   {
 0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
 0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16 };
 
-static uint8_t round_keys[11][AES_128_KEY_LENGTH];
+/*
+ * Expanded keys. Setting a key that is still expanded skips the key
+ * expansion, more than one schedule keeps keys that are used in turn,
+ * e.g. the sender and recipient keys of an OSCORE context.
+ */
+#ifdef AES_128_CONF_KEY_SCHEDULES
+#define KEY_SCHEDULES AES_128_CONF_KEY_SCHEDULES
+#else /* AES_128_CONF_KEY_SCHEDULES */
+#define KEY_SCHEDULES 1
+#endif /* AES_128_CONF_KEY_SCHEDULES */
+
+static uint8_t schedules[KEY_SCHEDULES][11][AES_128_KEY_LENGTH];
+static uint8_t schedules_used;
+static uint8_t next_schedule;
+static uint8_t (*round_keys)[AES_128_KEY_LENGTH] = schedules[0];
 
 /*---------------------------------------------------------------------------*/
 /* multiplies by 2 in GF(2) */
@@ -81,6 +95,18 @@ set_key(const uint8_t *key)
   uint8_t i;
   uint8_t j;
   uint8_t rcon;
+
+  for(i = 0; i < schedules_used; i++) {
+    if(memcmp(schedules[i][0], key, AES_128_KEY_LENGTH) == 0) {
+      round_keys = schedules[i];
+      return;
+    }
+  }
+  round_keys = schedules[next_schedule];
+  if(schedules_used < KEY_SCHEDULES) {
+    schedules_used++;
+  }
+  next_schedule = (next_schedule + 1) % KEY_SCHEDULES;
   
   rcon = 0x01;
   memcpy(round_keys[0], key, AES_128_KEY_LENGTH);
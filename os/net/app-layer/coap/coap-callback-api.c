@@ -46,6 +46,8 @@
 #include "coap-callback-api.h"
 #include "coap-transactions.h"
 #include "sys/cc.h"
+#include "lib/list.h"
+#include "lib/random.h"
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
@@ -63,6 +65,213 @@
 
 static void coap_request_callback(void *callback_data, coap_message_t *response);
 
+/* Group requests that are collecting responses */
+LIST(group_requests);
+
+/*---------------------------------------------------------------------------*/
+#if COAP_BLOCK2_WINDOW > 1
+
+#define SLOT_FREE      0
+#define SLOT_REQUESTED 1
+#define SLOT_RECEIVED  2
+
+static void block2_callback(void *callback_data, coap_message_t *response);
+
+/*---------------------------------------------------------------------------*/
+static int
+request_block(coap_block2_slot_t *slot, uint32_t num)
+{
+  coap_request_state_t *state = &slot->owner->state;
+  coap_message_t *request = state->request;
+  coap_transaction_t *t;
+
+  request->mid = coap_get_mid();
+  if((t = coap_new_transaction(request->mid, state->remote_endpoint)) == NULL) {
+    return 0;
+  }
+  t->callback = block2_callback;
+  t->callback_data = slot;
+
+  coap_set_header_block2(request, num, 0, COAP_MAX_CHUNK_SIZE);
+  t->message_len = coap_serialize_message(request, t->message);
+
+  slot->transaction = t;
+  slot->num = num;
+  slot->state = SLOT_REQUESTED;
+  coap_send_transaction(t);
+  LOG_DBG("Requested #%"PRIu32" (MID %u)\n", num, request->mid);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+finish_window(coap_callback_request_state_t *callback_state,
+              coap_request_status_t status)
+{
+  coap_block2_slot_t *slot;
+
+  for(slot = callback_state->window;
+      slot < &callback_state->window[COAP_BLOCK2_WINDOW]; slot++) {
+    if(slot->state == SLOT_REQUESTED) {
+      coap_clear_transaction(slot->transaction);
+    }
+    slot->state = SLOT_FREE;
+  }
+  callback_state->state.status = status;
+  callback_state->state.response = NULL;
+  callback_state->callback(callback_state);
+}
+/*---------------------------------------------------------------------------*/
+static void
+fill_window(coap_callback_request_state_t *callback_state)
+{
+  coap_block2_slot_t *slot;
+  int in_flight = 0;
+
+  for(slot = callback_state->window;
+      slot < &callback_state->window[COAP_BLOCK2_WINDOW]; slot++) {
+    if(slot->state == SLOT_FREE
+       && callback_state->next_block <= callback_state->last_block
+       && request_block(slot, callback_state->next_block)) {
+      callback_state->next_block++;
+    }
+    in_flight += slot->state == SLOT_REQUESTED;
+  }
+
+  /* the rest follows as responses free their transactions */
+  if(in_flight == 0) {
+    LOG_WARN("Could not allocate transaction buffer\n");
+    finish_window(callback_state, COAP_REQUEST_STATUS_BLOCK_ERROR);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Hands the next block to the callback, returns 0 once the transfer ended */
+static int
+deliver_block(coap_callback_request_state_t *callback_state,
+              coap_message_t *response)
+{
+  coap_request_state_t *state = &callback_state->state;
+
+  state->response = response;
+  state->res_block = state->block_num;
+  state->more = 0;
+  coap_get_header_block2(response, NULL, &state->more, NULL, NULL);
+  state->status = state->more ? COAP_REQUEST_STATUS_MORE
+    : COAP_REQUEST_STATUS_RESPONSE;
+  callback_state->callback(callback_state);
+  ++(state->block_num);
+
+  if(!state->more) {
+    finish_window(callback_state, COAP_REQUEST_STATUS_FINISHED);
+    return 0;
+  }
+  if(state->block_num > callback_state->last_block) {
+    /* an error response was taken for the end of the resource */
+    callback_state->last_block = UINT32_MAX;
+    callback_state->next_block = state->block_num;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+keep_response(coap_block2_slot_t *slot, const coap_message_t *response)
+{
+  memcpy(&slot->response, response, sizeof(coap_message_t));
+  slot->response.payload_len = MIN(response->payload_len,
+                                   sizeof(slot->payload));
+  memcpy(slot->payload, response->payload, slot->response.payload_len);
+  slot->response.payload = slot->payload;
+
+  /* the packet buffer these point into is reused */
+  slot->response.buffer = NULL;
+  slot->response.proxy_uri_len = slot->response.proxy_scheme_len = 0;
+  slot->response.uri_host_len = slot->response.location_path_len = 0;
+  slot->response.location_query_len = slot->response.uri_path_len = 0;
+  slot->response.uri_query_len = 0;
+  slot->response.proxy_uri = slot->response.proxy_scheme = NULL;
+  slot->response.uri_host = slot->response.location_path = NULL;
+  slot->response.location_query = slot->response.uri_path = NULL;
+  slot->response.uri_query = NULL;
+  slot->state = SLOT_RECEIVED;
+}
+/*---------------------------------------------------------------------------*/
+static void
+block2_callback(void *callback_data, coap_message_t *response)
+{
+  coap_block2_slot_t *slot = callback_data;
+  coap_callback_request_state_t *callback_state = slot->owner;
+  coap_request_state_t *state = &callback_state->state;
+  coap_block2_slot_t *s;
+  uint32_t num;
+  uint8_t more;
+
+  /* the transaction is freed by now */
+  slot->transaction = NULL;
+  slot->state = SLOT_FREE;
+
+  if(response == NULL) {
+    LOG_WARN("Server not responding giving up...\n");
+    finish_window(callback_state, COAP_REQUEST_STATUS_TIMEOUT);
+    return;
+  }
+
+  if(coap_get_header_block2(response, &num, &more, NULL, NULL)) {
+    if(num != slot->num) {
+      LOG_WARN("WRONG BLOCK %"PRIu32"/%"PRIu32"\n", num, slot->num);
+      if(++(state->block_error) >= COAP_MAX_ATTEMPTS
+         || !request_block(slot, slot->num)) {
+        finish_window(callback_state, COAP_REQUEST_STATUS_BLOCK_ERROR);
+      }
+      return;
+    }
+    if(!more) {
+      callback_state->last_block = MIN(callback_state->last_block, num);
+    }
+  } else if(slot->num != state->block_num) {
+    /* most likely requested past the end, the blocks before tell */
+    LOG_DBG("No block #%"PRIu32" (%u)\n", slot->num, response->code);
+    callback_state->last_block = MIN(callback_state->last_block,
+                                     slot->num - 1);
+    return;
+  }
+
+  if(slot->num != state->block_num) {
+    keep_response(slot, response);
+    return;
+  }
+
+  if(!deliver_block(callback_state, response)) {
+    return;
+  }
+  /* blocks that arrived early are now in turn */
+  s = callback_state->window;
+  while(s < &callback_state->window[COAP_BLOCK2_WINDOW]) {
+    if(s->state == SLOT_RECEIVED && s->num == state->block_num) {
+      s->state = SLOT_FREE;
+      if(!deliver_block(callback_state, &s->response)) {
+        return;
+      }
+      s = callback_state->window;
+    } else {
+      s++;
+    }
+  }
+  fill_window(callback_state);
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_window(coap_callback_request_state_t *callback_state)
+{
+  int i;
+
+  for(i = 0; i < COAP_BLOCK2_WINDOW; i++) {
+    callback_state->window[i].owner = callback_state;
+    callback_state->window[i].state = SLOT_FREE;
+  }
+  callback_state->next_block = callback_state->state.block_num;
+  callback_state->last_block = UINT32_MAX;
+  fill_window(callback_state);
+}
+#endif /* COAP_BLOCK2_WINDOW > 1 */
 /*---------------------------------------------------------------------------*/
 
 static int
@@ -136,6 +345,13 @@ coap_request_callback(void *callback_data, coap_message_t *response)
 
   if(state->more) {
     if((state->block_error) < COAP_MAX_ATTEMPTS) {
+#if COAP_BLOCK2_WINDOW > 1
+      if(state->block_num > 0) {
+        /* the rest of the resource is fetched in parallel */
+        start_window(callback_state);
+        return;
+      }
+#endif /* COAP_BLOCK2_WINDOW > 1 */
       progress_request(callback_state);
     } else {
       /* failure - now we give up and notify the callback */
@@ -186,5 +402,112 @@ coap_send_request(coap_callback_request_state_t *callback_state, coap_endpoint_t
 
   return progress_request(callback_state);
 }
+/*- Group requests ----------------------------------------------------------*/
+/*---------------------------------------------------------------------------*/
+static void
+group_timeout(coap_timer_t *timer)
+{
+  coap_callback_group_state_t *group_state = coap_timer_get_user_data(timer);
+
+  LOG_DBG("Group request done, %u responses\n", group_state->responses);
+  list_remove(group_requests, group_state);
+  group_state->state.status = COAP_REQUEST_STATUS_FINISHED;
+  group_state->state.response = NULL;
+  group_state->state.remote_endpoint = NULL;
+  group_state->callback(group_state);
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_send_group_request(coap_callback_group_state_t *group_state,
+                        coap_endpoint_t *group, coap_message_t *request,
+                        uint32_t timeout,
+                        void (*callback)(coap_callback_group_state_t *group_state))
+{
+  coap_request_state_t *state = &group_state->state;
+  coap_transaction_t *t;
+  int i;
+
+  /* responses can only be told apart by their token */
+  for(i = 0; i < sizeof(group_state->token); i++) {
+    group_state->token[i] = random_rand() & 0xff;
+  }
+  group_state->token_len = sizeof(group_state->token);
+  group_state->responses = 0;
+  group_state->callback = callback;
+
+  state->transaction = NULL;
+  state->response = NULL;
+  state->request = request;
+  state->remote_endpoint = NULL;
+  state->block_num = 0;
+  state->more = 0;
+
+  request->type = COAP_TYPE_NON;
+  request->mid = coap_get_mid();
+  coap_set_token(request, group_state->token, group_state->token_len);
+
+  if((t = coap_new_transaction(request->mid, group)) == NULL) {
+    return 0;
+  }
+  t->message_len = coap_serialize_message(request, t->message);
+
+  coap_cancel_group_request(group_state);
+  list_add(group_requests, group_state);
+  coap_timer_set_callback(&group_state->timer, group_timeout);
+  coap_timer_set_user_data(&group_state->timer, group_state);
+  coap_timer_set(&group_state->timer, timeout);
+
+  /* NON, so the transaction is freed once sent */
+  coap_send_transaction(t);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_cancel_group_request(coap_callback_group_state_t *group_state)
+{
+  list_remove(group_requests, group_state);
+  coap_timer_stop(&group_state->timer);
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_handle_group_response(const coap_endpoint_t *src,
+                           coap_message_t *response)
+{
+  coap_callback_group_state_t *group_state;
+  uint16_t i;
+
+  for(group_state = list_head(group_requests); group_state != NULL;
+      group_state = group_state->next) {
+    if(group_state->token_len == response->token_len
+       && memcmp(group_state->token, response->token,
+                 response->token_len) == 0) {
+      break;
+    }
+  }
+  if(group_state == NULL) {
+    return 0;
+  }
+
+  /* one response per responder, repeated datagrams are dropped */
+  for(i = 0; i < MIN(group_state->responses, COAP_GROUP_RESPONDERS); i++) {
+    if(coap_endpoint_cmp(&group_state->responders[i], src)) {
+      LOG_DBG("Group response repeated by ");
+      LOG_DBG_COAP_EP(src);
+      LOG_DBG_("\n");
+      return 1;
+    }
+  }
+  if(i < COAP_GROUP_RESPONDERS) {
+    coap_endpoint_copy(&group_state->responders[i], src);
+  }
+  group_state->responses++;
+
+  coap_endpoint_copy(&group_state->responder, src);
+  group_state->state.remote_endpoint = &group_state->responder;
+  group_state->state.response = response;
+  group_state->state.status = COAP_REQUEST_STATUS_RESPONSE;
+  group_state->callback(group_state);
+  return 1;
+}
 /*---------------------------------------------------------------------------*/
 /** @} */
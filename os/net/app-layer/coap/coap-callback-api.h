@@ -54,13 +54,38 @@
 /*---------------------------------------------------------------------------*/
 typedef struct coap_callback_request_state coap_callback_request_state_t;
 
+#if COAP_BLOCK2_WINDOW > 1
+/* A pipelined Block2 request, and its response while blocks before it
+   are still missing */
+typedef struct coap_block2_slot {
+  coap_callback_request_state_t *owner;
+  coap_transaction_t *transaction;
+  uint32_t num;
+  uint8_t state;
+  coap_message_t response;
+  uint8_t payload[COAP_MAX_CHUNK_SIZE];
+} coap_block2_slot_t;
+#endif /* COAP_BLOCK2_WINDOW > 1 */
+
 struct coap_callback_request_state {
   coap_request_state_t state;
   void (*callback)(coap_callback_request_state_t *state);
+#if COAP_BLOCK2_WINDOW > 1
+  coap_block2_slot_t window[COAP_BLOCK2_WINDOW];
+  uint32_t next_block;
+  uint32_t last_block;
+#endif /* COAP_BLOCK2_WINDOW > 1 */
 };
 
 /**
  * \brief Send a CoAP request to a remote endpoint
+ *
+ * Block-wise responses are fetched block by block, with up to
+ * COAP_BLOCK2_WINDOW requests in flight once the first block has
+ * arrived. The callback still sees the blocks in order. Blocks that
+ * arrived ahead of their turn only keep their payload and the options
+ * parsed into integers.
+ *
  * \param callback_state The callback state to handle the CoAP request
  * \param endpoint The destination endpoint
  * \param request The request to be sent
@@ -71,5 +96,55 @@ int coap_send_request(coap_callback_request_state_t *callback_state, coap_endpoi
                        coap_message_t *request,
                        void (*callback)(coap_callback_request_state_t *callback_state));
 
+/*---------------------------------------------------------------------------*/
+typedef struct coap_callback_group_state coap_callback_group_state_t;
+
+struct coap_callback_group_state {
+  coap_callback_group_state_t *next;
+  coap_request_state_t state;
+  void (*callback)(coap_callback_group_state_t *group_state);
+  coap_timer_t timer;
+  uint8_t token[COAP_TOKEN_LEN];
+  uint8_t token_len;
+  uint16_t responses;
+  /* remote_endpoint of the state points here for each response */
+  coap_endpoint_t responder;
+  coap_endpoint_t responders[COAP_GROUP_RESPONDERS];
+};
+
+/**
+ * \brief Send a CoAP request to a multicast group and collect the responses
+ *
+ * The request is sent as non-confirmable with a fresh token. The
+ * callback sees each response with COAP_REQUEST_STATUS_RESPONSE and the
+ * responder as remote_endpoint of the state. A responder that answers
+ * again is ignored, for up to COAP_GROUP_RESPONDERS responders. Once
+ * the timeout expires the callback sees COAP_REQUEST_STATUS_FINISHED,
+ * and the number of responses is in group_state->responses. Group
+ * members answer within their leisure period, COAP_MULTICAST_LEISURE,
+ * so the timeout should be longer than that.
+ *
+ * \param group_state The state to handle the group request
+ * \param group The multicast endpoint, e.g. coap://[ff05::fd]
+ * \param request The request to be sent
+ * \param timeout Milliseconds to wait for responses
+ * \param callback callback to execute for each response and at the timeout
+ * \return 1 if there is a transaction available to send, 0 otherwise
+ */
+int coap_send_group_request(coap_callback_group_state_t *group_state,
+                            coap_endpoint_t *group, coap_message_t *request,
+                            uint32_t timeout,
+                            void (*callback)(coap_callback_group_state_t *group_state));
+
+/**
+ * \brief Stop collecting responses, the callback is not called again
+ * \param group_state The state of a group request
+ */
+void coap_cancel_group_request(coap_callback_group_state_t *group_state);
+
+/* Called by the engine for responses no transaction waits for */
+int coap_handle_group_response(const coap_endpoint_t *src,
+                               coap_message_t *response);
+
 #endif /* COAP_CALLBACK_API_H_ */
 /** @} */
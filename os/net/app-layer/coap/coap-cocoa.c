@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *      CoCoA congestion control for CoAP.
+ */
+
+/**
+ * \addtogroup coap
+ * @{
+ */
+
+#include "coap-cocoa.h"
+#include "coap-timer.h"
+#include "sys/cc.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "coap"
+#define LOG_LEVEL  LOG_LEVEL_COAP
+
+/* All times in milliseconds */
+#define RTO_INIT        2000
+#define RTO_MIN         100
+#define RTO_MAX         60000
+
+#define STRONG          0
+#define WEAK            1
+/*---------------------------------------------------------------------------*/
+typedef struct {
+  coap_endpoint_t endpoint;
+  uint64_t last_used;
+  uint64_t updated;
+  uint32_t rto;
+  uint32_t srtt[2];
+  uint32_t rttvar[2];
+  uint8_t has_sample[2];
+  uint8_t in_use;
+} cocoa_entry_t;
+
+static cocoa_entry_t entries[COAP_CC_ENDPOINTS];
+/*---------------------------------------------------------------------------*/
+static void
+age(cocoa_entry_t *e, uint64_t now)
+{
+  /* Small RTOs that have not been confirmed for a while are doubled,
+     large ones pulled back towards the default */
+  while(e->rto < 1000 && now - e->updated >= 16 * (uint64_t)e->rto) {
+    e->updated += 16 * (uint64_t)e->rto;
+    e->rto *= 2;
+  }
+  while(e->rto > 3000 && now - e->updated >= 4 * (uint64_t)e->rto) {
+    e->updated += 4 * (uint64_t)e->rto;
+    e->rto = (RTO_INIT + e->rto) / 2;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static cocoa_entry_t *
+lookup(const coap_endpoint_t *ep, int create)
+{
+  cocoa_entry_t *e, *lru = NULL;
+  uint64_t now = coap_timer_uptime();
+
+  for(e = entries; e < &entries[COAP_CC_ENDPOINTS]; e++) {
+    if(e->in_use && coap_endpoint_cmp(&e->endpoint, ep)) {
+      e->last_used = now;
+      age(e, now);
+      return e;
+    }
+    if(lru == NULL || !e->in_use ||
+       (lru->in_use && e->last_used < lru->last_used)) {
+      lru = e;
+    }
+  }
+  if(!create) {
+    return NULL;
+  }
+
+  memset(lru, 0, sizeof(*lru));
+  coap_endpoint_copy(&lru->endpoint, ep);
+  lru->in_use = 1;
+  lru->rto = RTO_INIT;
+  lru->last_used = lru->updated = now;
+  return lru;
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+coap_cocoa_rto(const coap_endpoint_t *ep)
+{
+  cocoa_entry_t *e = lookup(ep, 0);
+
+  return e ? e->rto : RTO_INIT;
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+coap_cocoa_initial_interval(const coap_endpoint_t *ep)
+{
+  uint32_t rto = coap_cocoa_rto(ep);
+
+  return rto + rand() % (rto / 2 + 1);
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+coap_cocoa_next_interval(const coap_endpoint_t *ep, uint32_t interval)
+{
+  uint32_t rto = coap_cocoa_rto(ep);
+
+  /* Variable backoff factor: back off faster from short RTOs, slower
+     from long ones */
+  if(rto < 1000) {
+    interval *= 3;
+  } else if(rto > 3000) {
+    interval += interval / 2;
+  } else {
+    interval *= 2;
+  }
+  return MIN(interval, RTO_MAX);
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_cocoa_rtt_sample(const coap_endpoint_t *ep, uint32_t rtt,
+                      uint8_t retransmissions)
+{
+  cocoa_entry_t *e;
+  uint32_t est, diff;
+  int i;
+
+  if(retransmissions > 2) {
+    /* Too ambiguous to tell which transmission was answered */
+    return;
+  }
+
+  e = lookup(ep, 1);
+  i = retransmissions == 0 ? STRONG : WEAK;
+
+  if(!e->has_sample[i]) {
+    e->srtt[i] = rtt;
+    e->rttvar[i] = rtt / 2;
+    e->has_sample[i] = 1;
+  } else {
+    diff = e->srtt[i] > rtt ? e->srtt[i] - rtt : rtt - e->srtt[i];
+    e->rttvar[i] = e->rttvar[i] - e->rttvar[i] / 4 + diff / 4;
+    e->srtt[i] = e->srtt[i] - e->srtt[i] / 8 + rtt / 8;
+  }
+
+  /* K is 4 for the strong and 1 for the weak estimator, which then
+     weighs less in the overall RTO */
+  if(i == STRONG) {
+    est = e->srtt[i] + 4 * e->rttvar[i];
+    est = MAX(MIN(est, RTO_MAX), RTO_MIN);
+    e->rto = e->rto / 2 + est / 2;
+  } else {
+    est = e->srtt[i] + e->rttvar[i];
+    est = MAX(MIN(est, RTO_MAX), RTO_MIN);
+    e->rto = e->rto - e->rto / 4 + est / 4;
+  }
+  e->updated = coap_timer_uptime();
+
+  LOG_DBG("RTT %lu ms (%u retransmissions), RTO %lu ms\n",
+          (unsigned long)rtt, retransmissions, (unsigned long)e->rto);
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *      CoCoA congestion control for CoAP (draft-ietf-core-cocoa).
+ *
+ *      Keeps a strong and a weak RTT estimator per endpoint. Exchanges
+ *      answered without retransmission feed the strong one, those
+ *      answered after one or two retransmissions the weak one, timed
+ *      from the first transmission. Both are blended into the RTO from
+ *      which the transaction layer draws its retransmission intervals.
+ */
+
+/**
+ * \addtogroup coap
+ * @{
+ */
+
+#ifndef COAP_COCOA_H_
+#define COAP_COCOA_H_
+
+#include "coap-endpoint.h"
+#include "coap-conf.h"
+
+/**
+ * \brief      The interval before the first retransmission
+ * \param ep   The endpoint the exchange is sent to
+ * \return     The RTO for \a ep scaled by a random factor of [1, 1.5),
+ *             in milliseconds
+ */
+uint32_t coap_cocoa_initial_interval(const coap_endpoint_t *ep);
+
+/**
+ * \brief          The interval before the next retransmission
+ * \param ep       The endpoint the exchange is sent to
+ * \param interval The interval that just expired, in milliseconds
+ * \return         \a interval scaled by the variable backoff factor
+ */
+uint32_t coap_cocoa_next_interval(const coap_endpoint_t *ep,
+                                  uint32_t interval);
+
+/**
+ * \brief                 Updates the estimators of an endpoint
+ * \param ep              The endpoint that answered
+ * \param rtt             Milliseconds since the first transmission
+ * \param retransmissions Retransmissions before the answer arrived
+ */
+void coap_cocoa_rtt_sample(const coap_endpoint_t *ep, uint32_t rtt,
+                           uint8_t retransmissions);
+
+/**
+ * \brief      The current retransmission timeout of an endpoint
+ * \param ep   The endpoint
+ * \return     The RTO in milliseconds, 2 s for unknown endpoints
+ */
+uint32_t coap_cocoa_rto(const coap_endpoint_t *ep);
+
+#endif /* COAP_COCOA_H_ */
+/** @} */
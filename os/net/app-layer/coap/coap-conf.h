@@ -73,6 +73,20 @@
 #define COAP_PROXY_OPTION_PROCESSING   0
 #endif /* COAP_PROXY_OPTION_PROCESSING */
 
+/* CoAP over TCP (RFC 8323) for coap+tcp:// endpoints, needs UIP_CONF_TCP */
+#ifdef COAP_CONF_WITH_TCP
+#define COAP_WITH_TCP COAP_CONF_WITH_TCP
+#else
+#define COAP_WITH_TCP 0
+#endif /* COAP_WITH_TCP */
+
+/* TCP connections, incoming and outgoing, that can be open at once */
+#ifdef COAP_CONF_TCP_CONNECTIONS
+#define COAP_TCP_CONNECTIONS COAP_CONF_TCP_CONNECTIONS
+#else
+#define COAP_TCP_CONNECTIONS 2
+#endif /* COAP_TCP_CONNECTIONS */
+
 /* Listening port for the CoAP REST Engine */
 #ifndef COAP_SERVER_PORT
 #define COAP_SERVER_PORT               COAP_DEFAULT_PORT
@@ -83,6 +97,66 @@
 #define COAP_MAX_OPEN_TRANSACTIONS     4
 #endif /* COAP_MAX_OPEN_TRANSACTIONS */
 
+/* Confirmable exchanges outstanding at once per endpoint, further ones
+   wait in the transaction layer. RFC 7252 suggests 1, 0 = no limit. */
+#ifdef COAP_CONF_NSTART
+#define COAP_NSTART COAP_CONF_NSTART
+#else
+#define COAP_NSTART 0
+#endif /* COAP_NSTART */
+
+/* Adapt retransmission timeouts to measured round-trip times (CoCoA)
+   instead of the fixed COAP_RESPONSE_TIMEOUT */
+#ifdef COAP_CONF_CONGESTION_CONTROL
+#define COAP_CONGESTION_CONTROL COAP_CONF_CONGESTION_CONTROL
+#else
+#define COAP_CONGESTION_CONTROL 0
+#endif /* COAP_CONGESTION_CONTROL */
+
+/* Endpoints with their own RTT estimate, the least recently used one
+   is replaced */
+#ifdef COAP_CONF_CC_ENDPOINTS
+#define COAP_CC_ENDPOINTS COAP_CONF_CC_ENDPOINTS
+#else
+#define COAP_CC_ENDPOINTS 4
+#endif /* COAP_CC_ENDPOINTS */
+
+/* Block2 requests the callback API keeps in flight during a block-wise
+   download, 1 = stop-and-wait. Each takes a transaction and a buffer of
+   COAP_MAX_CHUNK_SIZE for blocks that arrive ahead of their turn.
+   Blocks are requested one per message also over coap+tcp, BERT is not
+   supported (see coap-tcp.h). */
+#ifdef COAP_CONF_BLOCK2_WINDOW
+#define COAP_BLOCK2_WINDOW COAP_CONF_BLOCK2_WINDOW
+#else
+#define COAP_BLOCK2_WINDOW 1
+#endif /* COAP_BLOCK2_WINDOW */
+
+/* Responses to multicast requests wait a random time of up to this many
+   milliseconds so that the group members do not answer at once
+   (RFC 7252, Section 8.2) */
+#ifdef COAP_CONF_MULTICAST_LEISURE
+#define COAP_MULTICAST_LEISURE COAP_CONF_MULTICAST_LEISURE
+#else
+#define COAP_MULTICAST_LEISURE 5000
+#endif /* COAP_MULTICAST_LEISURE */
+
+/* Join the All CoAP Nodes groups ff02::fd and ff05::fd, each takes one
+   of the multicast address slots of uIP */
+#ifdef COAP_CONF_ALL_COAP_NODES
+#define COAP_ALL_COAP_NODES COAP_CONF_ALL_COAP_NODES
+#else
+#define COAP_ALL_COAP_NODES 0
+#endif /* COAP_ALL_COAP_NODES */
+
+/* Responders a group request remembers, to pass on one response from
+   each. Further responders are passed on without this check. */
+#ifdef COAP_CONF_GROUP_RESPONDERS
+#define COAP_GROUP_RESPONDERS COAP_CONF_GROUP_RESPONDERS
+#else
+#define COAP_GROUP_RESPONDERS 8
+#endif /* COAP_GROUP_RESPONDERS */
+
 /* Maximum number of failed request attempts before action */
 #ifndef COAP_MAX_ATTEMPTS
 #define COAP_MAX_ATTEMPTS              4
@@ -93,6 +167,13 @@
 #define COAP_MAX_HEADER_SIZE           (4 + COAP_TOKEN_LEN + 3 + 1 + COAP_ETAG_LEN + 4 + 4 + 30)  /* 65 */
 #endif /* COAP_MAX_HEADER_SIZE */
 
+/* Buckets of the resource index, hashed by the first URI path segment */
+#ifdef COAP_CONF_RESOURCE_BUCKETS
+#define COAP_RESOURCE_BUCKETS COAP_CONF_RESOURCE_BUCKETS
+#else
+#define COAP_RESOURCE_BUCKETS 8
+#endif /* COAP_RESOURCE_BUCKETS */
+
 /* Number of observer slots (each takes abot xxx bytes) */
 #ifndef COAP_MAX_OBSERVERS
 #define COAP_MAX_OBSERVERS    COAP_MAX_OPEN_TRANSACTIONS - 1
@@ -105,6 +186,43 @@
 #define COAP_OBSERVE_REFRESH_INTERVAL  20
 #endif /* COAP_OBSERVE_REFRESH_INTERVAL */
 
+/* Buckets of the MID indexes that match ACKs and RSTs to transactions and
+   observers, by default one per transaction */
+#ifdef COAP_CONF_TRANSACTION_BUCKETS
+#define COAP_TRANSACTION_BUCKETS COAP_CONF_TRANSACTION_BUCKETS
+#else
+#define COAP_TRANSACTION_BUCKETS COAP_MAX_OPEN_TRANSACTIONS
+#endif /* COAP_TRANSACTION_BUCKETS */
+
+/* Buckets of the observer index, hashed like the resource index */
+#ifdef COAP_CONF_OBSERVER_BUCKETS
+#define COAP_OBSERVER_BUCKETS COAP_CONF_OBSERVER_BUCKETS
+#else
+#define COAP_OBSERVER_BUCKETS 4
+#endif /* COAP_OBSERVER_BUCKETS */
+
+/* Notification rounds, one per notified URL, that can wait for free
+   transactions at the same time */
+#ifdef COAP_CONF_MAX_NOTIFICATIONS
+#define COAP_MAX_NOTIFICATIONS COAP_CONF_MAX_NOTIFICATIONS
+#else
+#define COAP_MAX_NOTIFICATIONS 2
+#endif /* COAP_MAX_NOTIFICATIONS */
+
+/* Number of notifications sent back to back before pausing for
+   COAP_OBSERVE_PACING milliseconds */
+#ifdef COAP_CONF_OBSERVE_BURST
+#define COAP_OBSERVE_BURST COAP_CONF_OBSERVE_BURST
+#else
+#define COAP_OBSERVE_BURST 4
+#endif /* COAP_OBSERVE_BURST */
+
+#ifdef COAP_CONF_OBSERVE_PACING
+#define COAP_OBSERVE_PACING COAP_CONF_OBSERVE_PACING
+#else
+#define COAP_OBSERVE_PACING 20
+#endif /* COAP_OBSERVE_PACING */
+
 /* Maximal length of observable URL */
 #ifdef COAP_CONF_OBSERVER_URL_LEN
 #define COAP_OBSERVER_URL_LEN COAP_CONF_OBSERVER_URL_LEN
@@ -42,8 +42,10 @@
  */
 
 #include "coap-engine.h"
+#include "coap-callback-api.h"
 #include "sys/cc.h"
 #include "lib/list.h"
+#include "lib/random.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
@@ -75,7 +77,11 @@ static int invoke_coap_resource_service(coap_message_t *request,
 /*---------------------------------------------------------------------------*/
 LIST(coap_handlers);
 LIST(coap_resource_services);
+/* Resources by the hash of their first path segment, in activation order */
+static coap_resource_t *resource_buckets[COAP_RESOURCE_BUCKETS];
 static uint8_t is_initialized = 0;
+/* the message in coap_receive() was sent to a group */
+static uint8_t multicast_input;
 
 /*---------------------------------------------------------------------------*/
 /*- CoAP service handlers---------------------------------------------------*/
@@ -125,6 +131,14 @@ call_service(coap_message_t *request, coap_message_t *response,
   if(status != COAP_HANDLER_STATUS_CONTINUE) {
     return status;
   }
+#if COAP_PROXY_OPTION_PROCESSING
+  /* no proxy handler took the request */
+  if(coap_is_option(request, COAP_OPTION_PROXY_URI)
+     || coap_is_option(request, COAP_OPTION_PROXY_SCHEME)) {
+    coap_set_status_code(response, PROXYING_NOT_SUPPORTED_5_05);
+    return COAP_HANDLER_STATUS_CONTINUE;
+  }
+#endif /* COAP_PROXY_OPTION_PROCESSING */
   status = invoke_coap_resource_service(request, response, buffer, buffer_size, offset);
   if(status != COAP_HANDLER_STATUS_CONTINUE) {
     return status;
@@ -151,6 +165,20 @@ extern void oscore_missing_security_context(const coap_endpoint_t *src)
   __attribute__ ((weak, alias ("oscore_missing_security_context_default")));
 #endif
 
+#if COAP_PROXY_OPTION_PROCESSING
+/* replaced by the proxy service, when it is built in */
+static int
+coap_proxy_handle_response_default(const coap_endpoint_t *src,
+                                   coap_message_t *response)
+{
+  return 0;
+}
+
+extern int coap_proxy_handle_response(const coap_endpoint_t *src,
+                                      coap_message_t *response)
+  __attribute__ ((weak, alias ("coap_proxy_handle_response_default")));
+#endif /* COAP_PROXY_OPTION_PROCESSING */
+
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -167,6 +195,13 @@ coap_receive(const coap_endpoint_t *src,
   coap_status_code = coap_parse_message(message, payload, payload_length);
   coap_set_src_endpoint(message, src);
 
+  if(multicast_input
+     && (coap_status_code != NO_ERROR || message->type != COAP_TYPE_NON)) {
+    /* group requests are NON and never answered with errors */
+    LOG_DBG("Ignoring multicast message\n");
+    return coap_status_code;
+  }
+
   if(coap_status_code == NO_ERROR) {
 
     /*TODO duplicates suppression, if required by application */
@@ -334,12 +369,22 @@ coap_receive(const coap_endpoint_t *src,
         coap_resource_response_handler_t callback = transaction->callback;
         void *callback_data = transaction->callback_data;
 
+        if(message->type == COAP_TYPE_ACK || message->type == COAP_TYPE_RST) {
+          coap_transaction_answered(transaction);
+        }
         coap_clear_transaction(transaction);
 
         /* check if someone registered for the response */
         if(callback) {
           callback(callback_data, message);
         }
+      } else if(message->code != 0 && message->token_len > 0
+                && !coap_handle_group_response(src, message)) {
+        /* responses to group requests are only matched by their token,
+           and so are separate responses to proxied requests */
+#if COAP_PROXY_OPTION_PROCESSING
+        coap_proxy_handle_response(src, message);
+#endif /* COAP_PROXY_OPTION_PROCESSING */
       }
       /* if(ACKed transaction) */
       transaction = NULL;
@@ -357,7 +402,15 @@ coap_receive(const coap_endpoint_t *src,
 
     /* if(parsed correctly) */
   if(coap_status_code == NO_ERROR) {
-    if(transaction) {
+    if(transaction && multicast_input) {
+      if(response->code >= BAD_REQUEST_4_00) {
+        /* members that cannot serve the request stay silent */
+        coap_clear_transaction(transaction);
+      } else {
+        coap_send_transaction_later(transaction,
+                                    random_rand() % (COAP_MULTICAST_LEISURE + 1));
+      }
+    } else if(transaction) {
       coap_send_transaction(transaction);
     }
   } else if(coap_status_code == MANUAL_RESPONSE) {
@@ -399,6 +452,10 @@ coap_receive(const coap_endpoint_t *src,
     LOG_WARN("ERROR %u: %s\n", coap_status_code, coap_error_message);
     coap_clear_transaction(transaction);
 
+    if(multicast_input) {
+      return coap_status_code;
+    }
+
     if(coap_status_code == PING_RESPONSE) {
       coap_status_code = 0;
       reply_type = COAP_TYPE_RST;
@@ -426,6 +483,18 @@ coap_receive(const coap_endpoint_t *src,
   return coap_status_code;
 }
 /*---------------------------------------------------------------------------*/
+int
+coap_receive_multicast(const coap_endpoint_t *src,
+                       uint8_t *payload, uint16_t payload_length)
+{
+  int status;
+
+  multicast_input = 1;
+  status = coap_receive(src, payload, payload_length);
+  multicast_input = 0;
+  return status;
+}
+/*---------------------------------------------------------------------------*/
 void
 coap_engine_init(void)
 {
@@ -439,6 +508,7 @@ coap_engine_init(void)
 
   list_init(coap_handlers);
   list_init(coap_resource_services);
+  memset(resource_buckets, 0, sizeof(resource_buckets));
 
   coap_activate_resource(&res_well_known_core, ".well-known/core");
 
@@ -463,9 +533,31 @@ void
 coap_activate_resource(coap_resource_t *resource, const char *path)
 {
   coap_periodic_resource_t *periodic;
+  coap_resource_t **r;
+
+  /* Remove an earlier activation from the index */
+  if(resource->url != NULL) {
+    for(r = &resource_buckets[coap_path_hash(resource->url, resource->url_len)
+                              % COAP_RESOURCE_BUCKETS];
+        *r != NULL; r = &(*r)->bucket_next) {
+      if(*r == resource) {
+        *r = resource->bucket_next;
+        break;
+      }
+    }
+  }
+
   resource->url = path;
+  resource->url_len = strlen(path);
   list_add(coap_resource_services, resource);
 
+  /* Append, so that the first activated resource still wins */
+  resource->bucket_next = NULL;
+  for(r = &resource_buckets[coap_path_hash(path, resource->url_len)
+                            % COAP_RESOURCE_BUCKETS];
+      *r != NULL; r = &(*r)->bucket_next);
+  *r = resource;
+
   LOG_INFO("Activating: %s\n", resource->url);
 
   /* Only add periodic resources with a periodic_handler and a period > 0. */
@@ -496,6 +588,25 @@ coap_get_next_resource(coap_resource_t *resource)
   return list_item_next(resource);
 }
 /*---------------------------------------------------------------------------*/
+coap_resource_t *
+coap_get_resource_by_path(const char *path, size_t len)
+{
+  coap_resource_t *resource;
+
+  for(resource = resource_buckets[coap_path_hash(path, len)
+                                  % COAP_RESOURCE_BUCKETS];
+      resource; resource = resource->bucket_next) {
+    if((len == resource->url_len
+        || (len > resource->url_len
+            && (resource->flags & HAS_SUB_RESOURCES)
+            && path[resource->url_len] == '/'))
+       && memcmp(resource->url, path, resource->url_len) == 0) {
+      return resource;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
 static int
 invoke_coap_resource_service(coap_message_t *request, coap_message_t *response,
                              uint8_t *buffer, uint16_t buffer_size,
@@ -506,44 +617,36 @@ invoke_coap_resource_service(coap_message_t *request, coap_message_t *response,
 
   coap_resource_t *resource = NULL;
   const char *url = NULL;
-  int url_len, res_url_len;
+  int url_len;
 
   url_len = coap_get_header_uri_path(request, &url);
-  for(resource = list_head(coap_resource_services);
-      resource; resource = resource->next) {
-
-    /* if the web service handles that kind of requests and urls matches */
-    res_url_len = strlen(resource->url);
-    if((url_len == res_url_len
-        || (url_len > res_url_len
-            && (resource->flags & HAS_SUB_RESOURCES)
-            && url[res_url_len] == '/'))
-       && strncmp(resource->url, url, res_url_len) == 0) {
-      coap_resource_flags_t method = coap_get_method_type(request);
-      found = 1;
-
-      LOG_INFO("/%s, method %u, resource->flags %u\n", resource->url,
-               (uint16_t)method, resource->flags);
-
-      if((method & METHOD_GET) && resource->get_handler != NULL) {
-        /* call handler function */
-        resource->get_handler(request, response, buffer, buffer_size, offset);
-      } else if((method & METHOD_POST) && resource->post_handler != NULL) {
-        /* call handler function */
-        resource->post_handler(request, response, buffer, buffer_size,
+  resource = coap_get_resource_by_path(url, url_len);
+
+  /* if the web service handles that kind of requests and urls matches */
+  if(resource != NULL) {
+    coap_resource_flags_t method = coap_get_method_type(request);
+    found = 1;
+
+    LOG_INFO("/%s, method %u, resource->flags %u\n", resource->url,
+             (uint16_t)method, resource->flags);
+
+    if((method & METHOD_GET) && resource->get_handler != NULL) {
+      /* call handler function */
+      resource->get_handler(request, response, buffer, buffer_size, offset);
+    } else if((method & METHOD_POST) && resource->post_handler != NULL) {
+      /* call handler function */
+      resource->post_handler(request, response, buffer, buffer_size,
+                             offset);
+    } else if((method & METHOD_PUT) && resource->put_handler != NULL) {
+      /* call handler function */
+      resource->put_handler(request, response, buffer, buffer_size, offset);
+    } else if((method & METHOD_DELETE) && resource->delete_handler != NULL) {
+      /* call handler function */
+      resource->delete_handler(request, response, buffer, buffer_size,
                                offset);
-      } else if((method & METHOD_PUT) && resource->put_handler != NULL) {
-        /* call handler function */
-        resource->put_handler(request, response, buffer, buffer_size, offset);
-      } else if((method & METHOD_DELETE) && resource->delete_handler != NULL) {
-        /* call handler function */
-        resource->delete_handler(request, response, buffer, buffer_size,
-                                 offset);
-      } else {
-        allowed = 0;
-        coap_set_status_code(response, METHOD_NOT_ALLOWED_4_05);
-      }
-      break;
+    } else {
+      allowed = 0;
+      coap_set_status_code(response, METHOD_NOT_ALLOWED_4_05);
     }
   }
   if(!found) {
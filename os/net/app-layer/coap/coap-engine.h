@@ -80,6 +80,9 @@ void coap_engine_init(void);
 
 int coap_receive(const coap_endpoint_t *src,
                  uint8_t *payload, uint16_t payload_length);
+/* For messages sent to a multicast group */
+int coap_receive_multicast(const coap_endpoint_t *src,
+                           uint8_t *payload, uint16_t payload_length);
 
 coap_handler_status_t coap_call_handlers(coap_message_t *request,
                                          coap_message_t *response,
@@ -116,6 +119,8 @@ struct coap_resource_s {
 #ifdef WITH_OSCORE
   bool oscore_protected;
 #endif /* WITH_OSCORE */
+  coap_resource_t *bucket_next;     /* for the path index, set on activation */
+  uint16_t url_len;
 };
 
 struct coap_periodic_resource_s {
@@ -160,6 +165,34 @@ struct coap_periodic_resource_s {
  */
 void coap_activate_resource(coap_resource_t *resource, const char *path);
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief      Looks up the resource that handles a URI path.
+ * \param path The URI path, not necessarily null-terminated
+ * \param len  The length of the path
+ * \return     The first activated resource whose URL is the path, or a
+ *             parent of it when the resource has HAS_SUB_RESOURCES set.
+ *             NULL if there is none.
+ */
+coap_resource_t *coap_get_resource_by_path(const char *path, size_t len);
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief      Hashes the first segment of a URI path.
+ *
+ *             A resource or observer URL and every path below it share
+ *             the first segment, so indexing by it keeps prefix matches
+ *             within one bucket.
+ */
+static inline unsigned
+coap_path_hash(const char *path, size_t len)
+{
+  unsigned hash = 0;
+
+  while(len-- > 0 && *path != '/') {
+    hash = hash * 31 + (uint8_t)*path++;
+  }
+  return hash;
+}
+/*---------------------------------------------------------------------------*/
 /**
  * \brief      Returns the first of registered CoAP resources.
  * \return     The first registered CoAP resource or NULL if none exists.
@@ -54,11 +54,63 @@
 #define LOG_LEVEL  LOG_LEVEL_COAP
 
 /*---------------------------------------------------------------------------*/
+/* Keep a transaction free for responses to incoming requests */
+#define RESERVED_TRANSACTIONS (COAP_MAX_OPEN_TRANSACTIONS > 1 ? 1 : 0)
+
+/* A representation rendered once and then sent to each observer of the
+   URL, with the observer's token, MID and Observe value */
+typedef struct coap_notification {
+  struct coap_notification *next;       /* for LIST */
+
+  char url[COAP_OBSERVER_URL_LEN];
+  coap_message_t message[1];
+  uint16_t pending;                     /* observers not yet notified */
+  uint8_t buffer[COAP_MAX_CHUNK_SIZE + 1];
+} coap_notification_t;
+
 MEMB(observers_memb, coap_observer_t, COAP_MAX_OBSERVERS);
 LIST(observers_list);
+/* Observers by the hash of the first segment of their URL */
+static coap_observer_t *observer_buckets[COAP_OBSERVER_BUCKETS];
+/* Observers by the MID of their last notification, for matching RSTs */
+static coap_observer_t *mid_buckets[COAP_TRANSACTION_BUCKETS];
+MEMB(notifications_memb, coap_notification_t, COAP_MAX_NOTIFICATIONS);
+LIST(notifications_list);
+
+static coap_timer_t pacing_timer;
+static uint8_t waiting_for_transaction;
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+static coap_observer_t **
+observer_bucket(const char *url, size_t len)
+{
+  return &observer_buckets[coap_path_hash(url, len) % COAP_OBSERVER_BUCKETS];
+}
+/*---------------------------------------------------------------------------*/
+static void
+link_mid(coap_observer_t *o)
+{
+  coap_observer_t **b = &mid_buckets[o->last_mid % COAP_TRANSACTION_BUCKETS];
+
+  o->mid_next = *b;
+  *b = o;
+}
+/*---------------------------------------------------------------------------*/
+static void
+unlink_mid(coap_observer_t *o)
+{
+  coap_observer_t **b;
+
+  for(b = &mid_buckets[o->last_mid % COAP_TRANSACTION_BUCKETS]; *b != NULL;
+      b = &(*b)->mid_next) {
+    if(*b == o) {
+      *b = o->mid_next;
+      break;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 static coap_observer_t *
 add_observer(const coap_endpoint_t *endpoint, const uint8_t *token,
              size_t token_len, const char *uri, int uri_len)
@@ -75,28 +127,60 @@ add_observer(const coap_endpoint_t *endpoint, const uint8_t *token,
     }
     memcpy(o->url, uri, max);
     o->url[max] = 0;
+    o->url_len = max;
     coap_endpoint_copy(&o->endpoint, endpoint);
     o->token_len = token_len;
     memcpy(o->token, token, token_len);
     o->last_mid = 0;
+    o->notification = NULL;
 
     LOG_INFO("Adding observer (%u/%u) for /%s [0x%02X%02X]\n",
              list_length(observers_list) + 1, COAP_MAX_OBSERVERS,
              o->url, o->token[0], o->token[1]);
     list_add(observers_list, o);
+    o->bucket_next = *observer_bucket(o->url, o->url_len);
+    *observer_bucket(o->url, o->url_len) = o;
+    link_mid(o);
   }
 
   return o;
 }
 /*---------------------------------------------------------------------------*/
+static void
+detach_notification(coap_observer_t *o)
+{
+  coap_notification_t *n = o->notification;
+
+  if(n != NULL) {
+    o->notification = NULL;
+    if(--n->pending == 0) {
+      list_remove(notifications_list, n);
+      memb_free(&notifications_memb, n);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 /*- Removal -----------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 void
 coap_remove_observer(coap_observer_t *o)
 {
+  coap_observer_t **b;
+
   LOG_INFO("Removing observer for /%s [0x%02X%02X]\n", o->url, o->token[0],
            o->token[1]);
 
+  detach_notification(o);
+
+  for(b = observer_bucket(o->url, o->url_len); *b != NULL;
+      b = &(*b)->bucket_next) {
+    if(*b == o) {
+      *b = o->bucket_next;
+      break;
+    }
+  }
+  unlink_mid(o);
+
   memb_free(&observers_memb, o);
   list_remove(observers_list, o);
 }
@@ -164,10 +248,10 @@ int
 coap_remove_observer_by_mid(const coap_endpoint_t *endpoint, uint16_t mid)
 {
   int removed = 0;
-  coap_observer_t *obs = NULL;
+  coap_observer_t *obs, *next;
 
-  for(obs = (coap_observer_t *)list_head(observers_list); obs;
-      obs = obs->next) {
+  for(obs = mid_buckets[mid % COAP_TRANSACTION_BUCKETS]; obs; obs = next) {
+    next = obs->mid_next;
     LOG_DBG("Remove check MID %u\n", mid);
     if(coap_endpoint_cmp(&obs->endpoint, endpoint)
        && obs->last_mid == mid) {
@@ -185,18 +269,119 @@ coap_notify_observers(coap_resource_t *resource)
 {
   coap_notify_observers_sub(resource, NULL);
 }
+/*---------------------------------------------------------------------------*/
+static int
+notify_observer(coap_observer_t *obs)
+{
+  coap_message_t notification[1]; /* this way the message can be treated as pointer as usual */
+  coap_transaction_t *transaction;
+
+  if((transaction = coap_new_transaction(coap_get_mid(), &obs->endpoint)) == NULL) {
+    return 0;
+  }
+
+  /* the rendered message is shared, only the header differs per observer;
+     its payload still points into the shared buffer, so the notification
+     is only detached once it has been serialized */
+  memcpy(notification, obs->notification->message, sizeof(coap_message_t));
+
+  /* if COAP_OBSERVE_REFRESH_INTERVAL is zero, never send observations as confirmable messages */
+  if(COAP_OBSERVE_REFRESH_INTERVAL != 0
+     && (obs->obs_counter % COAP_OBSERVE_REFRESH_INTERVAL == 0)) {
+    LOG_DBG("           Force Confirmable for\n");
+    notification->type = COAP_TYPE_CON;
+  }
+
+  LOG_DBG("           Observer ");
+  LOG_DBG_COAP_EP(&obs->endpoint);
+  LOG_DBG_("\n");
+
+  /* update last MID for RST matching */
+  unlink_mid(obs);
+  obs->last_mid = transaction->mid;
+  link_mid(obs);
+  notification->mid = transaction->mid;
+
+  if(notification->code < BAD_REQUEST_4_00) {
+    coap_set_header_observe(notification, (obs->obs_counter)++);
+    /* mask out to keep the CoAP observe option length <= 3 bytes */
+    obs->obs_counter &= 0xffffff;
+  }
+  coap_set_token(notification, obs->token, obs->token_len);
+
+  transaction->message_len =
+    coap_serialize_message(notification, transaction->message);
+  detach_notification(obs);
+
+  coap_send_transaction(transaction);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Sends notifications in bursts, as long as transactions are available */
+static void
+send_notifications(coap_timer_t *timer)
+{
+  coap_observer_t *obs;
+  coap_observer_t *next;
+  int burst = 0;
+
+  waiting_for_transaction = 0;
+  for(obs = (coap_observer_t *)list_head(observers_list); obs; obs = next) {
+    next = obs->next;
+    if(obs->notification == NULL) {
+      continue;
+    }
+    if(burst == COAP_OBSERVE_BURST) {
+      coap_timer_set(&pacing_timer, COAP_OBSERVE_PACING);
+      return;
+    }
+    if(coap_transactions_available() <= RESERVED_TRANSACTIONS
+       || !notify_observer(obs)) {
+      /* resumed by coap_observe_transaction_freed() */
+      LOG_DBG("Notifications wait for a free transaction\n");
+      waiting_for_transaction = 1;
+      coap_timer_stop(&pacing_timer);
+      return;
+    }
+    burst++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_observe_transaction_freed(void)
+{
+  if(waiting_for_transaction) {
+    waiting_for_transaction = 0;
+    /* not right away, the transaction layer may still be sending */
+    coap_timer_set_callback(&pacing_timer, send_notifications);
+    coap_timer_set(&pacing_timer, 0);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Parent/sub-resource match, so that it is possible to do parent-node
+   observe */
+static int
+observer_matches(const coap_observer_t *obs, const char *url, int url_len,
+                 uint8_t sub_ok)
+{
+  return (obs->url_len == url_len
+          || (obs->url_len > url_len && sub_ok && obs->url[url_len] == '/'))
+    && strncmp(url, obs->url, url_len) == 0;
+}
+/*---------------------------------------------------------------------------*/
 /* Can be used either for sub - or when there is not resource - just
    a handler */
 void
 coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
 {
-  /* build notification */
-  coap_message_t notification[1]; /* this way the message can be treated as pointer as usual */
   coap_message_t request[1]; /* this way the message can be treated as pointer as usual */
+  coap_message_t *notification;
+  coap_notification_t *n;
   coap_observer_t *obs = NULL;
-  int url_len, obs_url_len;
+  int url_len;
   char url[COAP_OBSERVER_URL_LEN];
   uint8_t sub_ok = 0;
+  int32_t new_offset = 0;
 
   if(resource != NULL) {
     url_len = strlen(resource->url);
@@ -216,94 +401,91 @@ coap_notify_observers_sub(coap_resource_t *resource, const char *subpath)
   /* url now contains the notify URL that needs to match the observer */
   LOG_INFO("Notification from %s\n", url);
 
-  coap_init_message(notification, COAP_TYPE_NON, CONTENT_2_05, 0);
-  /* create a "fake" request for the URI */
-  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
-  coap_set_header_uri_path(request, url);
-
-  /* iterate over observers */
   url_len = strlen(url);
   /* Assumes lazy evaluation... */
   sub_ok = (resource == NULL) || (resource->flags & HAS_SUB_RESOURCES);
-  for(obs = (coap_observer_t *)list_head(observers_list); obs;
-      obs = obs->next) {
-    obs_url_len = strlen(obs->url);
-
-    /* Do a match based on the parent/sub-resource match so that it is
-       possible to do parent-node observe */
-
-    /***** TODO fix here so that we handle the notofication correctly ******/
-    /* All the new-style ... is assuming that the URL might be within */
-    if((obs_url_len == url_len
-        || (obs_url_len > url_len
-            && sub_ok
-            && obs->url[url_len] == '/'))
-       && strncmp(url, obs->url, url_len) == 0) {
-      coap_transaction_t *transaction = NULL;
-
-      /*TODO implement special transaction for CON, sharing the same buffer to allow for more observers */
-
-      if((transaction = coap_new_transaction(coap_get_mid(), &obs->endpoint))) {
-        /* if COAP_OBSERVE_REFRESH_INTERVAL is zero, never send observations as confirmable messages */
-        if(COAP_OBSERVE_REFRESH_INTERVAL != 0
-            && (obs->obs_counter % COAP_OBSERVE_REFRESH_INTERVAL == 0)) {
-          LOG_DBG("           Force Confirmable for\n");
-          notification->type = COAP_TYPE_CON;
-        }
 
-        LOG_DBG("           Observer ");
-        LOG_DBG_COAP_EP(&obs->endpoint);
-        LOG_DBG_("\n");
+  /* Nothing to render when nobody observes the URL */
+  for(obs = *observer_bucket(url, url_len); obs; obs = obs->bucket_next) {
+    if(observer_matches(obs, url, url_len, sub_ok)) {
+      break;
+    }
+  }
+  if(obs == NULL) {
+    return;
+  }
 
-        /* update last MID for RST matching */
-        obs->last_mid = transaction->mid;
+  /* Observers still waiting for the previous round get the new
+     representation instead */
+  for(n = (coap_notification_t *)list_head(notifications_list); n;
+      n = n->next) {
+    if(strcmp(n->url, url) == 0) {
+      break;
+    }
+  }
+  if(n == NULL) {
+    if((n = memb_alloc(&notifications_memb)) == NULL) {
+      LOG_WARN("No free notification for %s\n", url);
+      return;
+    }
+    memcpy(n->url, url, sizeof(url));
+    n->pending = 0;
+    list_add(notifications_list, n);
+  }
 
-        /* prepare response */
-        notification->mid = transaction->mid;
+  notification = n->message;
+  coap_init_message(notification, COAP_TYPE_NON, CONTENT_2_05, 0);
+  /* create a "fake" request for the URI */
+  coap_init_message(request, COAP_TYPE_CON, COAP_GET, 0);
+  coap_set_header_uri_path(request, url);
 
-	int32_t new_offset = 0;
+  /* render the representation once for all observers */
+  /* Either old style get_handler or the full handler */
+  if(coap_call_handlers(request, notification, n->buffer,
+                        COAP_MAX_CHUNK_SIZE, &new_offset) > 0) {
+    LOG_DBG("Notification on new handlers\n");
+  } else {
+    if(resource != NULL) {
+      resource->get_handler(request, notification, n->buffer,
+                            COAP_MAX_CHUNK_SIZE, &new_offset);
+    } else {
+      /* What to do here? */
+      notification->code = BAD_REQUEST_4_00;
+    }
+  }
 
-        /* Either old style get_handler or the full handler */
-        if(coap_call_handlers(request, notification, transaction->message +
-                              COAP_MAX_HEADER_SIZE, COAP_MAX_CHUNK_SIZE,
-                              &new_offset) > 0) {
-          LOG_DBG("Notification on new handlers\n");
-        } else {
-          if(resource != NULL) {
-            resource->get_handler(request, notification,
-                                  transaction->message + COAP_MAX_HEADER_SIZE,
-                                  COAP_MAX_CHUNK_SIZE, &new_offset);
-          } else {
-            /* What to do here? */
-            notification->code = BAD_REQUEST_4_00;
-          }
-        }
+  if(new_offset != 0) {
+    coap_set_header_block2(notification,
+                           0,
+                           new_offset != -1,
+                           COAP_MAX_BLOCK_SIZE);
+    coap_set_payload(notification,
+                     notification->payload,
+                     MIN(notification->payload_len,
+                         COAP_MAX_BLOCK_SIZE));
+  }
 
-        if(notification->code < BAD_REQUEST_4_00) {
-          coap_set_header_observe(notification, (obs->obs_counter)++);
-          /* mask out to keep the CoAP observe option length <= 3 bytes */
-          obs->obs_counter &= 0xffffff;
-        }
-        coap_set_token(notification, obs->token, obs->token_len);
-
-	if(new_offset != 0) {
-	  coap_set_header_block2(notification,
-				 0,
-				 new_offset != -1,
-				 COAP_MAX_BLOCK_SIZE);
-	  coap_set_payload(notification,
-			   notification->payload,
-			   MIN(notification->payload_len,
-			       COAP_MAX_BLOCK_SIZE));
-	}
-
-        transaction->message_len =
-          coap_serialize_message(notification, transaction->message);
-
-        coap_send_transaction(transaction);
-      }
+  /* iterate over observers */
+  for(obs = *observer_bucket(url, url_len); obs; obs = obs->bucket_next) {
+    if(observer_matches(obs, url, url_len, sub_ok)
+       && obs->notification != n) {
+      detach_notification(obs);
+      obs->notification = n;
+      n->pending++;
     }
   }
+
+  if(n->pending == 0) {
+    list_remove(notifications_list, n);
+    memb_free(&notifications_memb, n);
+    return;
+  }
+
+  /* Start sending, unless a paced burst or a free transaction is awaited */
+  if(!waiting_for_transaction && coap_timer_expired(&pacing_timer)) {
+    coap_timer_set_callback(&pacing_timer, send_notifications);
+    send_notifications(&pacing_timer);
+  }
 }
 /*---------------------------------------------------------------------------*/
 void
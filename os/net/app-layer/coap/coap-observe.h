@@ -50,8 +50,11 @@
 
 typedef struct coap_observer {
   struct coap_observer *next;   /* for LIST */
+  struct coap_observer *bucket_next; /* for the URL index */
+  struct coap_observer *mid_next; /* for the MID index */
 
   char url[COAP_OBSERVER_URL_LEN];
+  uint16_t url_len;
   coap_endpoint_t endpoint;
   uint8_t token_len;
   uint8_t token[COAP_TOKEN_LEN];
@@ -59,6 +62,9 @@ typedef struct coap_observer {
 
   int32_t obs_counter;
 
+  /* notification round this observer still has to be sent */
+  struct coap_notification *notification;
+
   coap_timer_t retrans_timer;
   uint8_t retrans_counter;
 } coap_observer_t;
@@ -75,6 +81,8 @@ int coap_remove_observer_by_mid(const coap_endpoint_t *ep,
 void coap_notify_observers(coap_resource_t *resource);
 void coap_notify_observers_sub(coap_resource_t *resource, const char *subpath);
 
+void coap_observe_transaction_freed(void);
+
 void coap_observe_handler(coap_resource_t *resource, coap_message_t *request,
                           coap_message_t *response);
 
@@ -0,0 +1,502 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *      CoAP over TCP (RFC 8323).
+ */
+
+/**
+ * \addtogroup coap
+ * @{
+ */
+
+#include "coap-tcp.h"
+#include "coap.h"
+#include "coap-engine.h"
+#include "coap-transactions.h"
+#include "sys/cc.h"
+#include <string.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "coap"
+#define LOG_LEVEL  LOG_LEVEL_COAP
+
+#if COAP_WITH_TCP
+
+#include "net/ipv6/tcp-socket.h"
+
+#if !UIP_CONF_TCP
+#error "COAP_CONF_WITH_TCP needs UIP_CONF_TCP"
+#endif
+
+/* Len/TKL byte, up to four bytes of extended length and the code */
+#define TCP_HEADER_MAX      6
+/* A UDP-format message trades its four header bytes for these */
+#define FRAME_MAX           (COAP_MAX_PACKET_SIZE + TCP_HEADER_MAX - 4)
+#define INPUT_CHUNK         32
+
+/* Default until the peer's CSM says otherwise */
+#define BASE_MESSAGE_SIZE   1152
+
+#define SIGNAL_CSM          0xE1 /* 7.01 */
+#define SIGNAL_PING         0xE2
+#define SIGNAL_PONG         0xE3
+#define SIGNAL_RELEASE      0xE4
+#define SIGNAL_ABORT        0xE5
+
+#define OPTION_MAX_MESSAGE_SIZE 2
+
+typedef enum {
+  CONN_IDLE,       /* listening for incoming connections */
+  CONN_CONNECTING,
+  CONN_OPEN
+} coap_tcp_conn_state_t;
+
+typedef struct {
+  struct tcp_socket socket;
+  coap_endpoint_t endpoint;
+  uint8_t state;
+  uint16_t peer_max_size;
+  uint16_t frame_len;
+  uint8_t inbuf[INPUT_CHUNK];
+  uint8_t outbuf[2 * FRAME_MAX];
+  uint8_t frame[FRAME_MAX];
+} coap_tcp_conn_t;
+
+static coap_tcp_conn_t conns[COAP_TCP_CONNECTIONS];
+
+/* The UDP-format message handed to the engine */
+static uint8_t message[COAP_MAX_PACKET_SIZE];
+/*---------------------------------------------------------------------------*/
+static uint8_t
+extended_length_size(uint8_t len_nibble)
+{
+  switch(len_nibble) {
+  case 13:
+    return 1;
+  case 14:
+    return 2;
+  case 15:
+    return 4;
+  default:
+    return 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The full length of the frame, or 0 while its length is incomplete */
+static uint32_t
+frame_length(const uint8_t *frame, uint16_t have)
+{
+  uint8_t ext;
+  uint32_t len;
+
+  if(have == 0) {
+    return 0;
+  }
+  ext = extended_length_size(frame[0] >> 4);
+  if(have < 1 + ext) {
+    return 0;
+  }
+  switch(ext) {
+  case 1:
+    len = frame[1] + 13;
+    break;
+  case 2:
+    len = ((uint32_t)frame[1] << 8 | frame[2]) + 269;
+    break;
+  case 4:
+    len = ((uint32_t)frame[1] << 24 | (uint32_t)frame[2] << 16 |
+           (uint32_t)frame[3] << 8 | frame[4]) + 65805;
+    break;
+  default:
+    len = frame[0] >> 4;
+  }
+  return 1 + ext + 1 + (frame[0] & 0x0F) + len;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+write_header(uint8_t *buf, uint16_t len, uint8_t tkl, uint8_t code)
+{
+  if(len < 13) {
+    buf[0] = len << 4 | tkl;
+    buf[1] = code;
+    return 2;
+  }
+  if(len < 269) {
+    buf[0] = 13 << 4 | tkl;
+    buf[1] = len - 13;
+    buf[2] = code;
+    return 3;
+  }
+  len -= 269;
+  buf[0] = 14 << 4 | tkl;
+  buf[1] = len >> 8;
+  buf[2] = len;
+  buf[3] = code;
+  return 4;
+}
+/*---------------------------------------------------------------------------*/
+static int
+send_frame(coap_tcp_conn_t *c, uint8_t code, const uint8_t *token,
+           uint8_t tkl, const uint8_t *body, uint16_t len)
+{
+  uint8_t header[TCP_HEADER_MAX];
+  uint8_t header_len;
+
+  header_len = write_header(header, len, tkl, code);
+  if(header_len + tkl + len > c->peer_max_size) {
+    LOG_WARN("message of %u bytes exceeds the peer's limit of %u\n",
+             header_len + tkl + len, c->peer_max_size);
+    return -1;
+  }
+  if(tcp_socket_max_sendlen(&c->socket) < header_len + tkl + len) {
+    LOG_WARN("TCP send buffer full - dropping message\n");
+    return -1;
+  }
+  tcp_socket_send(&c->socket, header, header_len);
+  tcp_socket_send(&c->socket, token, tkl);
+  tcp_socket_send(&c->socket, body, len);
+  return header_len + tkl + len;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_csm(coap_tcp_conn_t *c)
+{
+  uint8_t option[3];
+
+  option[0] = OPTION_MAX_MESSAGE_SIZE << 4 | 2;
+  option[1] = FRAME_MAX >> 8;
+  option[2] = FRAME_MAX & 0xFF;
+  send_frame(c, SIGNAL_CSM, NULL, 0, option, sizeof(option));
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset(coap_tcp_conn_t *c)
+{
+  c->state = CONN_IDLE;
+  c->frame_len = 0;
+  c->peer_max_size = BASE_MESSAGE_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+close_conn(coap_tcp_conn_t *c)
+{
+  tcp_socket_close(&c->socket);
+  reset(c);
+}
+/*---------------------------------------------------------------------------*/
+/* Decodes the extended form of an option delta or length nibble at *opt,
+   returns -1 if it is reserved or truncated */
+static int32_t
+option_nibble(uint8_t nibble, const uint8_t **opt, const uint8_t *end)
+{
+  const uint8_t *p = *opt;
+
+  if(nibble == 13) {
+    if(end - p < 1) {
+      return -1;
+    }
+    *opt = p + 1;
+    return p[0] + 13;
+  }
+  if(nibble == 14) {
+    if(end - p < 2) {
+      return -1;
+    }
+    *opt = p + 2;
+    return (p[0] << 8 | p[1]) + 269;
+  }
+  return nibble == 15 ? -1 : nibble;
+}
+/*---------------------------------------------------------------------------*/
+/* Reads the Max-Message-Size option of a CSM, returns 0 if the options
+   are malformed or truncated */
+static int
+handle_csm(coap_tcp_conn_t *c, const uint8_t *opt, const uint8_t *end)
+{
+  uint32_t number = 0;
+  int32_t delta;
+  int32_t len;
+  uint32_t value;
+  uint8_t first;
+
+  while(opt < end && *opt != 0xFF) {
+    first = *opt++;
+    delta = option_nibble(first >> 4, &opt, end);
+    len = delta < 0 ? -1 : option_nibble(first & 0x0F, &opt, end);
+    if(len < 0 || len > end - opt) {
+      return 0;
+    }
+    number += delta;
+    if(number == OPTION_MAX_MESSAGE_SIZE && len <= 4) {
+      for(value = 0; len > 0; len--) {
+        value = value << 8 | *opt++;
+      }
+      c->peer_max_size = MIN(value, 0xFFFF);
+      LOG_DBG("peer Max-Message-Size %u\n", c->peer_max_size);
+    }
+    opt += len;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_frame(coap_tcp_conn_t *c, uint16_t length)
+{
+  const uint8_t *frame = c->frame;
+  const uint8_t *token;
+  coap_transaction_t *t;
+  uint16_t body_len;
+  uint16_t mid;
+  uint8_t pos;
+  uint8_t tkl;
+  uint8_t type;
+  uint8_t code;
+
+  pos = 1 + extended_length_size(frame[0] >> 4);
+  code = frame[pos++];
+  tkl = frame[0] & 0x0F;
+  token = &frame[pos];
+  pos += tkl;
+  body_len = length - pos;
+
+  if(tkl > COAP_TOKEN_LEN) {
+    LOG_WARN("token too long - aborting connection\n");
+    send_frame(c, SIGNAL_ABORT, NULL, 0, NULL, 0);
+    close_conn(c);
+    return;
+  }
+
+  switch(code) {
+  case 0:
+    /* empty messages are ignored */
+    return;
+  case SIGNAL_CSM:
+    if(!handle_csm(c, &frame[pos], &frame[length])) {
+      LOG_WARN("malformed CSM - aborting connection\n");
+      send_frame(c, SIGNAL_ABORT, NULL, 0, NULL, 0);
+      close_conn(c);
+    }
+    return;
+  case SIGNAL_PING:
+    send_frame(c, SIGNAL_PONG, token, tkl, NULL, 0);
+    return;
+  case SIGNAL_RELEASE:
+  case SIGNAL_ABORT:
+    LOG_INFO("peer closed the connection (%u.%02u)\n", code >> 5, code & 0x1F);
+    close_conn(c);
+    return;
+  default:
+    if((code >> 5) == 7) {
+      /* other signals, including Pong */
+      return;
+    }
+  }
+
+  if((code >> 5) == 0) {
+    type = COAP_TYPE_CON;
+    mid = coap_get_mid();
+  } else if((t = coap_get_transaction_by_token(&c->endpoint,
+                                               token, tkl)) != NULL) {
+    type = COAP_TYPE_ACK;
+    mid = t->mid;
+  } else {
+    type = COAP_TYPE_NON;
+    mid = coap_get_mid();
+  }
+
+  if(COAP_HEADER_LEN + tkl + body_len > sizeof(message)) {
+    LOG_WARN("message of %u bytes too large - dropping\n", body_len);
+    return;
+  }
+
+  message[0] = COAP_HEADER_VERSION_MASK & 1 << COAP_HEADER_VERSION_POSITION;
+  message[0] |= type << COAP_HEADER_TYPE_POSITION | tkl;
+  message[1] = code;
+  message[2] = mid >> 8;
+  message[3] = mid;
+  memcpy(&message[COAP_HEADER_LEN], token, tkl + body_len);
+
+  coap_receive(&c->endpoint, message, COAP_HEADER_LEN + tkl + body_len);
+}
+/*---------------------------------------------------------------------------*/
+/* Reassembles frames, which may be split across and share segments */
+static int
+input(struct tcp_socket *s, void *ptr, const uint8_t *data, int len)
+{
+  coap_tcp_conn_t *c = ptr;
+  uint32_t total;
+  uint16_t n;
+
+  while(len > 0 && c->state == CONN_OPEN) {
+    total = frame_length(c->frame, c->frame_len);
+    if(total == 0) {
+      c->frame[c->frame_len++] = *data++;
+      len--;
+      continue;
+    }
+    if(total > sizeof(c->frame)) {
+      LOG_WARN("frame of %lu bytes too large - aborting connection\n",
+               (unsigned long)total);
+      send_frame(c, SIGNAL_ABORT, NULL, 0, NULL, 0);
+      close_conn(c);
+      break;
+    }
+    n = MIN(total - c->frame_len, len);
+    memcpy(&c->frame[c->frame_len], data, n);
+    c->frame_len += n;
+    data += n;
+    len -= n;
+    if(c->frame_len == total) {
+      c->frame_len = 0;
+      handle_frame(c, total);
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+event(struct tcp_socket *s, void *ptr, tcp_socket_event_t ev)
+{
+  coap_tcp_conn_t *c = ptr;
+
+  switch(ev) {
+  case TCP_SOCKET_CONNECTED:
+    if(c->state == CONN_IDLE) {
+      /* accepted on the listening socket */
+      uip_ipaddr_copy(&c->endpoint.ipaddr, &s->c->ripaddr);
+      c->endpoint.port = s->c->rport;
+      c->endpoint.secure = 0;
+      c->endpoint.tcp = 1;
+      c->state = CONN_OPEN;
+      send_csm(c);
+    } else {
+      c->state = CONN_OPEN;
+    }
+    LOG_INFO("connected to ");
+    LOG_INFO_COAP_EP(&c->endpoint);
+    LOG_INFO_("\n");
+    break;
+  case TCP_SOCKET_CLOSED:
+  case TCP_SOCKET_TIMEDOUT:
+  case TCP_SOCKET_ABORTED:
+    if(c->state != CONN_IDLE) {
+      LOG_INFO("connection to ");
+      LOG_INFO_COAP_EP(&c->endpoint);
+      LOG_INFO_(" closed\n");
+    }
+    reset(c);
+    break;
+  default:
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static coap_tcp_conn_t *
+get_conn(const coap_endpoint_t *ep)
+{
+  coap_tcp_conn_t *idle = NULL;
+  int i;
+
+  for(i = 0; i < COAP_TCP_CONNECTIONS; i++) {
+    if(conns[i].state == CONN_IDLE) {
+      if(idle == NULL) {
+        idle = &conns[i];
+      }
+    } else if(coap_endpoint_cmp(&conns[i].endpoint, ep)) {
+      return &conns[i];
+    }
+  }
+  if(idle == NULL) {
+    LOG_WARN("no free TCP connection\n");
+    return NULL;
+  }
+
+  /* take the socket out of the listening pool */
+  idle->socket.flags &= ~TCP_SOCKET_FLAGS_LISTENING;
+  if(tcp_socket_connect(&idle->socket, &ep->ipaddr,
+                        uip_ntohs(ep->port)) < 0) {
+    LOG_WARN("could not connect\n");
+    idle->socket.flags |= TCP_SOCKET_FLAGS_LISTENING;
+    return NULL;
+  }
+  coap_endpoint_copy(&idle->endpoint, ep);
+  idle->state = CONN_CONNECTING;
+  /* queued until the connection is up */
+  send_csm(idle);
+  return idle;
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_tcp_sendto(const coap_endpoint_t *ep, const uint8_t *data,
+                uint16_t length)
+{
+  coap_tcp_conn_t *c;
+  uint8_t tkl;
+
+  if(length < COAP_HEADER_LEN || data[1] == 0) {
+    /* no empty ACKs, RSTs or pings on reliable transports */
+    return 0;
+  }
+  tkl = data[0] & COAP_HEADER_TOKEN_LEN_MASK;
+  if(length < COAP_HEADER_LEN + tkl) {
+    return -1;
+  }
+
+  c = get_conn(ep);
+  if(c == NULL) {
+    return -1;
+  }
+  return send_frame(c, data[1], &data[COAP_HEADER_LEN], tkl,
+                    &data[COAP_HEADER_LEN + tkl],
+                    length - COAP_HEADER_LEN - tkl);
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_tcp_init(void)
+{
+  int i;
+
+  for(i = 0; i < COAP_TCP_CONNECTIONS; i++) {
+    reset(&conns[i]);
+    tcp_socket_register(&conns[i].socket, &conns[i],
+                        conns[i].inbuf, sizeof(conns[i].inbuf),
+                        conns[i].outbuf, sizeof(conns[i].outbuf),
+                        input, event);
+    tcp_socket_listen(&conns[i].socket, COAP_SERVER_PORT);
+  }
+  LOG_INFO("TCP listening on port %u\n", COAP_SERVER_PORT);
+}
+/*---------------------------------------------------------------------------*/
+#endif /* COAP_WITH_TCP */
+/** @} */
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *      CoAP over TCP (RFC 8323).
+ *
+ *      Messages are handed to and from the engine in the UDP format.
+ *      On the way out the type and Message ID are dropped and the
+ *      length is moved into the header, on the way in requests are
+ *      given a fresh Message ID as CON and responses take the Message
+ *      ID of the request with the same token as ACK, so the engine and
+ *      the transaction layer match them as usual. The transaction
+ *      layer does not retransmit on reliable endpoints.
+ *
+ *      Block-wise transfers with BERT (SZX 7) are not supported: the
+ *      engine never asks for BERT, as messages are bounded by
+ *      COAP_MAX_PACKET_SIZE anyway, and BERT blocks from a peer are
+ *      answered with plain 1024-byte blocks, which RFC 8323 permits.
+ */
+
+/**
+ * \addtogroup coap
+ * @{
+ */
+
+#ifndef COAP_TCP_H_
+#define COAP_TCP_H_
+
+#include "coap-endpoint.h"
+
+/**
+ * \brief      Listens for incoming connections on the CoAP port
+ */
+void coap_tcp_init(void);
+
+/**
+ * \brief        Sends a message over the connection to an endpoint
+ * \param ep     The coap+tcp endpoint, connected to if needed
+ * \param data   The message in the UDP format
+ * \param length The length of the message
+ * \return       The number of bytes queued, 0 for empty messages, which
+ *               have no meaning on TCP, or -1 on error
+ */
+int coap_tcp_sendto(const coap_endpoint_t *ep, const uint8_t *data,
+                    uint16_t length);
+
+#endif /* COAP_TCP_H_ */
+/** @} */
@@ -43,10 +43,12 @@
 
 #include "coap-transactions.h"
 #include "coap-observe.h"
+#include "coap-cocoa.h"
 #include "coap-timer.h"
 #include "lib/memb.h"
 #include "lib/list.h"
 #include <stdlib.h>
+#include <string.h>
 
 /* Log configuration */
 #include "coap-log.h"
@@ -55,8 +57,45 @@
 
 /*---------------------------------------------------------------------------*/
 MEMB(transactions_memb, coap_transaction_t, COAP_MAX_OPEN_TRANSACTIONS);
-LIST(transactions_list);
+/* Transactions by MID, which the engine matches every ACK and RST against */
+static coap_transaction_t *transaction_buckets[COAP_TRANSACTION_BUCKETS];
+/* Confirmable transactions waiting for COAP_NSTART, oldest first */
+LIST(queued_list);
 
+#define MID_BUCKET(mid) (&transaction_buckets[(mid) % COAP_TRANSACTION_BUCKETS])
+
+/*---------------------------------------------------------------------------*/
+static int
+pending_for(const coap_endpoint_t *ep)
+{
+  coap_transaction_t *t;
+  int i, pending = 0;
+
+  for(i = 0; i < COAP_TRANSACTION_BUCKETS; i++) {
+    for(t = transaction_buckets[i]; t; t = t->bucket_next) {
+      if(t->state == COAP_TRANSACTION_PENDING &&
+         coap_endpoint_cmp(&t->endpoint, ep)) {
+        pending++;
+      }
+    }
+  }
+  return pending;
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_queued(const coap_endpoint_t *ep)
+{
+  coap_transaction_t *t;
+
+  for(t = (coap_transaction_t *)list_head(queued_list); t; t = t->next) {
+    if(coap_endpoint_cmp(&t->endpoint, ep)) {
+      LOG_DBG("Starting queued transaction %u\n", t->mid);
+      list_remove(queued_list, t);
+      coap_send_transaction(t);
+      return;
+    }
+  }
+}
 /*---------------------------------------------------------------------------*/
 static void
 coap_retransmit_transaction(coap_timer_t *nt)
@@ -71,6 +110,37 @@ coap_retransmit_transaction(coap_timer_t *nt)
   coap_send_transaction(t);
 }
 /*---------------------------------------------------------------------------*/
+static void
+send_deferred(coap_timer_t *nt)
+{
+  coap_send_transaction(coap_timer_get_user_data(nt));
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_request(const coap_transaction_t *t)
+{
+  /* codes 0.01 to 0.31 */
+  return t->message[1] != 0 && (t->message[1] >> 5) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_reliable(coap_transaction_t *t)
+{
+  /* the transport delivers the message, only requests wait for a response */
+  coap_sendto(&t->endpoint, t->message, t->message_len);
+  if(!is_request(t)) {
+    coap_clear_transaction(t);
+    return;
+  }
+
+  coap_timer_set_callback(&t->retrans_timer, coap_retransmit_transaction);
+  coap_timer_set_user_data(&t->retrans_timer, t);
+  /* time out once the last retransmission would have, without sending any */
+  t->retrans_counter = COAP_MAX_RETRANSMIT;
+  t->retrans_interval = COAP_RESPONSE_TIMEOUT_TICKS << COAP_MAX_RETRANSMIT;
+  coap_timer_set(&t->retrans_timer, t->retrans_interval);
+}
+/*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
@@ -83,11 +153,13 @@ coap_new_transaction(uint16_t mid, const coap_endpoint_t *endpoint)
   if(t) {
     t->mid = mid;
     t->retrans_counter = 0;
+    t->state = COAP_TRANSACTION_NEW;
 
     /* save client address */
     coap_endpoint_copy(&t->endpoint, endpoint);
 
-    list_add(transactions_list, t); /* list itself makes sure same element is not added twice */
+    t->bucket_next = *MID_BUCKET(mid);
+    *MID_BUCKET(mid) = t;
   }
 
   return t;
@@ -100,6 +172,20 @@ coap_send_transaction(coap_transaction_t *t)
 
   if(COAP_TYPE_CON ==
      ((COAP_HEADER_TYPE_MASK & t->message[0]) >> COAP_HEADER_TYPE_POSITION)) {
+    if(t->retrans_counter == 0 && coap_endpoint_is_reliable(&t->endpoint)) {
+      send_reliable(t);
+      return;
+    }
+
+    if(t->retrans_counter == 0 && COAP_NSTART > 0 &&
+       pending_for(&t->endpoint) >= COAP_NSTART) {
+      /* started once a pending exchange with the endpoint completes */
+      LOG_DBG("Queueing transaction %u\n", t->mid);
+      t->state = COAP_TRANSACTION_QUEUED;
+      list_add(queued_list, t);
+      return;
+    }
+
     if(t->retrans_counter <= COAP_MAX_RETRANSMIT) {
       /* not timed out yet */
       coap_sendto(&t->endpoint, t->message, t->message_len);
@@ -108,15 +194,26 @@ coap_send_transaction(coap_transaction_t *t)
       if(t->retrans_counter == 0) {
         coap_timer_set_callback(&t->retrans_timer, coap_retransmit_transaction);
         coap_timer_set_user_data(&t->retrans_timer, t);
+        t->state = COAP_TRANSACTION_PENDING;
+        t->start_time = (uint32_t)coap_timer_uptime();
+#if COAP_CONGESTION_CONTROL
+        t->retrans_interval = coap_cocoa_initial_interval(&t->endpoint);
+#else
         t->retrans_interval =
           COAP_RESPONSE_TIMEOUT_TICKS + (rand() %
                                          COAP_RESPONSE_TIMEOUT_BACKOFF_MASK);
+#endif /* COAP_CONGESTION_CONTROL */
         LOG_DBG("Initial interval %lu msec\n",
                 (unsigned long)t->retrans_interval);
       } else {
+#if COAP_CONGESTION_CONTROL
+        t->retrans_interval =
+          coap_cocoa_next_interval(&t->endpoint, t->retrans_interval);
+#else
         t->retrans_interval <<= 1;  /* double */
-        LOG_DBG("Doubled (%u) interval %lu s\n", t->retrans_counter,
-                (unsigned long)(t->retrans_interval / 1000));
+#endif /* COAP_CONGESTION_CONTROL */
+        LOG_DBG("Backed off (%u) interval %lu msec\n", t->retrans_counter,
+                (unsigned long)t->retrans_interval);
       }
 
       /* interval updated above */
@@ -143,14 +240,44 @@ coap_send_transaction(coap_transaction_t *t)
 }
 /*---------------------------------------------------------------------------*/
 void
+coap_send_transaction_later(coap_transaction_t *t, uint32_t delay)
+{
+  LOG_DBG("Sending transaction %u in %lu msec\n", t->mid,
+          (unsigned long)delay);
+  coap_timer_set_callback(&t->retrans_timer, send_deferred);
+  coap_timer_set_user_data(&t->retrans_timer, t);
+  coap_timer_set(&t->retrans_timer, delay);
+}
+/*---------------------------------------------------------------------------*/
+void
 coap_clear_transaction(coap_transaction_t *t)
 {
   if(t) {
+    coap_transaction_t **b;
+    coap_endpoint_t endpoint;
+    uint8_t was_pending = t->state == COAP_TRANSACTION_PENDING;
+
     LOG_DBG("Freeing transaction %u: %p\n", t->mid, t);
 
+    coap_endpoint_copy(&endpoint, &t->endpoint);
     coap_timer_stop(&t->retrans_timer);
-    list_remove(transactions_list, t);
+    for(b = MID_BUCKET(t->mid); *b != NULL; b = &(*b)->bucket_next) {
+      if(*b == t) {
+        *b = t->bucket_next;
+        break;
+      }
+    }
+    if(t->state == COAP_TRANSACTION_QUEUED) {
+      list_remove(queued_list, t);
+    }
     memb_free(&transactions_memb, t);
+
+    if(COAP_NSTART > 0 && was_pending) {
+      start_queued(&endpoint);
+    }
+
+    /* notifications may be waiting for a free transaction */
+    coap_observe_transaction_freed();
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -159,7 +286,7 @@ coap_get_transaction_by_mid(uint16_t mid)
 {
   coap_transaction_t *t = NULL;
 
-  for(t = (coap_transaction_t *)list_head(transactions_list); t; t = t->next) {
+  for(t = *MID_BUCKET(mid); t; t = t->bucket_next) {
     if(t->mid == mid) {
       LOG_DBG("Found transaction for MID %u: %p\n", t->mid, t);
       return t;
@@ -168,4 +295,43 @@ coap_get_transaction_by_mid(uint16_t mid)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
+coap_transaction_t *
+coap_get_transaction_by_token(const coap_endpoint_t *ep,
+                              const uint8_t *token, uint8_t token_len)
+{
+  coap_transaction_t *t;
+  int i;
+
+  /* only needed without MIDs, i.e., on reliable transports */
+  for(i = 0; i < COAP_TRANSACTION_BUCKETS; i++) {
+    for(t = transaction_buckets[i]; t; t = t->bucket_next) {
+      if(is_request(t)
+         && (t->message[0] & COAP_HEADER_TOKEN_LEN_MASK) == token_len
+         && memcmp(&t->message[COAP_HEADER_LEN], token, token_len) == 0
+         && coap_endpoint_cmp(&t->endpoint, ep)) {
+        return t;
+      }
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_transaction_answered(coap_transaction_t *t)
+{
+#if COAP_CONGESTION_CONTROL
+  if(t->state == COAP_TRANSACTION_PENDING) {
+    coap_cocoa_rtt_sample(&t->endpoint,
+                          (uint32_t)coap_timer_uptime() - t->start_time,
+                          t->retrans_counter);
+  }
+#endif /* COAP_CONGESTION_CONTROL */
+}
+/*---------------------------------------------------------------------------*/
+int
+coap_transactions_available(void)
+{
+  return memb_numfree(&transactions_memb);
+}
+/*---------------------------------------------------------------------------*/
 /** @} */
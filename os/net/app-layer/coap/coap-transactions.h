@@ -55,14 +55,24 @@
 #define COAP_RESPONSE_TIMEOUT_TICKS         (1000 * COAP_RESPONSE_TIMEOUT)
 #define COAP_RESPONSE_TIMEOUT_BACKOFF_MASK  (uint32_t)(((1000 * COAP_RESPONSE_TIMEOUT * ((float)COAP_RESPONSE_RANDOM_FACTOR - 1.0)) + 0.5) + 1)
 
+/* confirmable transactions wait while their endpoint has COAP_NSTART pending */
+typedef enum {
+  COAP_TRANSACTION_NEW,
+  COAP_TRANSACTION_QUEUED,
+  COAP_TRANSACTION_PENDING
+} coap_transaction_state_t;
+
 /* container for transactions with message buffer and retransmission info */
 typedef struct coap_transaction {
-  struct coap_transaction *next;        /* for LIST */
+  struct coap_transaction *next;        /* for the NSTART queue */
+  struct coap_transaction *bucket_next; /* for the MID index */
 
   uint16_t mid;
   coap_timer_t retrans_timer;
   uint32_t retrans_interval;
+  uint32_t start_time;                  /* of the first transmission, for RTT samples */
   uint8_t retrans_counter;
+  uint8_t state;
 
   coap_endpoint_t endpoint;
 
@@ -76,8 +86,14 @@ typedef struct coap_transaction {
 
 coap_transaction_t *coap_new_transaction(uint16_t mid, const coap_endpoint_t *ep);
 void coap_send_transaction(coap_transaction_t *t);
+void coap_send_transaction_later(coap_transaction_t *t, uint32_t delay);
 void coap_clear_transaction(coap_transaction_t *t);
 coap_transaction_t *coap_get_transaction_by_mid(uint16_t mid);
+coap_transaction_t *coap_get_transaction_by_token(const coap_endpoint_t *ep,
+                                                  const uint8_t *token,
+                                                  uint8_t token_len);
+void coap_transaction_answered(coap_transaction_t *t);
+int coap_transactions_available(void);
 
 #endif /* COAP_TRANSACTIONS_H_ */
 /** @} */
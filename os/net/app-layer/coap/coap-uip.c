@@ -49,6 +49,7 @@
 #include "contiki.h"
 #include "net/ipv6/uip-udp-packet.h"
 #include "net/ipv6/uiplib.h"
+#include "net/ipv6/uip-ds6.h"
 #include "net/routing/routing.h"
 #include "coap.h"
 #include "coap-engine.h"
@@ -58,6 +59,7 @@
 #include "coap-constants.h"
 #include "coap-keystore.h"
 #include "coap-keystore-simple.h"
+#include "coap-tcp.h"
 
 /* Log configuration */
 #include "coap-log.h"
@@ -89,6 +91,16 @@ PROCESS(coap_engine, "CoAP Engine");
 
 static struct uip_udp_conn *udp_conn = NULL;
 
+#ifdef WITH_DTLS
+/* Established DTLS sessions, so that a new peer takes the place of the
+   least recently used one instead of failing its handshake */
+static struct {
+  coap_endpoint_t ep;
+  clock_time_t last_used;
+  uint8_t in_use;
+} sessions[COAP_DTLS_SESSIONS];
+#endif /* WITH_DTLS */
+
 /*---------------------------------------------------------------------------*/
 void
 coap_endpoint_log(const coap_endpoint_t *ep)
@@ -99,6 +111,8 @@ coap_endpoint_log(const coap_endpoint_t *ep)
   }
   if(ep->secure) {
     LOG_OUTPUT("coaps://[");
+  } else if(ep->tcp) {
+    LOG_OUTPUT("coap+tcp://[");
   } else {
     LOG_OUTPUT("coap://[");
   }
@@ -115,6 +129,8 @@ coap_endpoint_print(const coap_endpoint_t *ep)
   }
   if(ep->secure) {
     printf("coaps://[");
+  } else if(ep->tcp) {
+    printf("coap+tcp://[");
   } else {
     printf("coap://[");
   }
@@ -134,6 +150,8 @@ coap_endpoint_snprint(char *buf, size_t size, const coap_endpoint_t *ep)
   } else {
     if(ep->secure) {
       n = snprintf(buf, size - 1, "coaps://[");
+    } else if(ep->tcp) {
+      n = snprintf(buf, size - 1, "coap+tcp://[");
     } else {
       n = snprintf(buf, size - 1, "coap://[");
     }
@@ -157,6 +175,7 @@ coap_endpoint_copy(coap_endpoint_t *destination,
   uip_ipaddr_copy(&destination->ipaddr, &from->ipaddr);
   destination->port = from->port;
   destination->secure = from->secure;
+  destination->tcp = from->tcp;
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -165,7 +184,8 @@ coap_endpoint_cmp(const coap_endpoint_t *e1, const coap_endpoint_t *e2)
   if(!uip_ipaddr_cmp(&e1->ipaddr, &e2->ipaddr)) {
     return 0;
   }
-  return e1->port == e2->port && e1->secure == e2->secure;
+  return e1->port == e2->port && e1->secure == e2->secure
+    && e1->tcp == e2->tcp;
 }
 /*---------------------------------------------------------------------------*/
 static int
@@ -206,6 +226,11 @@ coap_endpoint_parse(const char *text, size_t size, coap_endpoint_t *ep)
   uint32_t port;
 
   ep->secure = strncmp(text, "coaps:", 6) == 0;
+  ep->tcp = strncmp(text, "coap+tcp:", 9) == 0;
+  if(strncmp(text, "coaps+tcp:", 10) == 0) {
+    /* no TLS */
+    return 0;
+  }
   if(start >= 0 && end > start &&
      uiplib_ipaddrconv(&text[start], &ep->ipaddr)) {
     if(text[end + 1] == ':' &&
@@ -236,6 +261,7 @@ get_src_endpoint(coap_endpoint_t* src, uint8_t secure)
   uip_ipaddr_copy(&src->ipaddr, &UIP_IP_BUF->srcipaddr);
   src->port = UIP_UDP_BUF->srcport;
   src->secure = secure;
+  src->tcp = 0;
   return src;
 }
 /*---------------------------------------------------------------------------*/
@@ -246,6 +272,129 @@ coap_endpoint_is_secure(const coap_endpoint_t *ep)
 }
 /*---------------------------------------------------------------------------*/
 int
+coap_endpoint_is_reliable(const coap_endpoint_t *ep)
+{
+  return ep->tcp;
+}
+#ifdef WITH_DTLS
+/*---------------------------------------------------------------------------*/
+static int
+find_session(const coap_endpoint_t *ep)
+{
+  int i;
+
+  for(i = 0; i < COAP_DTLS_SESSIONS; i++) {
+    if(sessions[i].in_use && coap_endpoint_cmp(&sessions[i].ep, ep)) {
+      return i;
+    }
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+touch_session(const coap_endpoint_t *ep)
+{
+  int i = find_session(ep);
+
+  if(i >= 0) {
+    sessions[i].last_used = clock_time();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+forget_session(const coap_endpoint_t *ep)
+{
+  int i = find_session(ep);
+
+  if(i >= 0) {
+    sessions[i].in_use = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_session(const coap_endpoint_t *ep)
+{
+  int i;
+
+  i = find_session(ep);
+  if(i < 0) {
+    for(i = 0; i < COAP_DTLS_SESSIONS; i++) {
+      if(!sessions[i].in_use) {
+        break;
+      }
+    }
+    if(i == COAP_DTLS_SESSIONS) {
+      /* More handshakes ran at once than make_room() made room for */
+      LOG_WARN("DTLS session cache full, not tracking ");
+      LOG_WARN_COAP_EP(ep);
+      LOG_WARN_("\n");
+      return;
+    }
+    coap_endpoint_copy(&sessions[i].ep, ep);
+    sessions[i].in_use = 1;
+  }
+  sessions[i].last_used = clock_time();
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Closes the least recently used session if the cache is full, before a
+ * handshake with a new peer starts. Sessions are only closed when the
+ * room is needed, and never from within a tinyDTLS callback.
+ */
+static void
+make_room(const coap_endpoint_t *ep)
+{
+  clock_time_t now = clock_time();
+  dtls_peer_t *peer;
+  int i, oldest;
+
+  if(dtls_get_peer(dtls_context, ep) != NULL) {
+    return;
+  }
+  oldest = 0;
+  for(i = 0; i < COAP_DTLS_SESSIONS; i++) {
+    if(!sessions[i].in_use) {
+      return;
+    }
+    if(now - sessions[i].last_used > now - sessions[oldest].last_used) {
+      oldest = i;
+    }
+  }
+  sessions[oldest].in_use = 0;
+  peer = dtls_get_peer(dtls_context, &sessions[oldest].ep);
+  /* A peer that is handshaking again is not the session we tracked */
+  if(peer != NULL && dtls_peer_is_connected(peer)) {
+    LOG_INFO("DTLS session cache full, closing ");
+    LOG_INFO_COAP_EP(&sessions[oldest].ep);
+    LOG_INFO_("\n");
+    dtls_reset_peer(dtls_context, peer);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Tells if a datagram starts with a ClientHello carrying a cookie, which
+ * starts a handshake that takes a peer. ClientHellos without a cookie
+ * are answered statelessly, so they cannot make us close a session from
+ * a spoofed address.
+ */
+static int
+is_client_hello_with_cookie(const uint8_t *data, uint16_t len)
+{
+  /* Record header (13 bytes), handshake header (12 bytes), then
+     client_version (2) and random (32) */
+  uint16_t pos = 13 + 12 + 2 + 32;
+
+  if(len <= pos || data[0] != 22 /* handshake */ ||
+     data[13] != 1 /* client_hello */) {
+    return 0;
+  }
+  /* Skip the session ID */
+  pos += 1 + data[pos];
+  return pos < len && data[pos] > 0;
+}
+#endif /* WITH_DTLS */
+/*---------------------------------------------------------------------------*/
+int
 coap_endpoint_is_connected(const coap_endpoint_t *ep)
 {
 #ifndef CONTIKI_TARGET_NATIVE
@@ -299,6 +448,7 @@ coap_endpoint_connect(coap_endpoint_t *ep)
 
   /* setup all address info here... should be done to connect */
   if(dtls_context) {
+    make_room(ep);
     dtls_connect(dtls_context, ep);
     return 1;
   }
@@ -312,6 +462,7 @@ coap_endpoint_disconnect(coap_endpoint_t *ep)
 {
 #ifdef WITH_DTLS
   if(ep && ep->secure && dtls_context) {
+    forget_session(ep);
     dtls_close(dtls_context, ep);
   }
 #endif /* WITH_DTLS */
@@ -335,6 +486,9 @@ coap_transport_init(void)
 #endif /* COAP_DTLS_KEYSTORE_CONF_WITH_SIMPLE */
 
 #endif /* WITH_DTLS */
+#if COAP_WITH_TCP
+  coap_tcp_init();
+#endif /* COAP_WITH_TCP */
 }
 /*---------------------------------------------------------------------------*/
 #ifdef WITH_DTLS
@@ -348,8 +502,11 @@ process_secure_data(void)
 
   if(dtls_context) {
     coap_endpoint_t src;
-    dtls_handle_message(dtls_context, (coap_endpoint_t *)get_src_endpoint(&src, 1),
-                        uip_appdata, uip_datalen());
+    get_src_endpoint(&src, 1);
+    if(is_client_hello_with_cookie(uip_appdata, uip_datalen())) {
+      make_room(&src);
+    }
+    dtls_handle_message(dtls_context, &src, uip_appdata, uip_datalen());
   }
 }
 #endif /* WITH_DTLS */
@@ -363,7 +520,12 @@ process_data(void)
   LOG_INFO("  Length: %u\n", uip_datalen());
 
   coap_endpoint_t src;
-  coap_receive(get_src_endpoint(&src, 0), uip_appdata, uip_datalen());
+  if(uip_is_addr_mcast(&UIP_IP_BUF->destipaddr)) {
+    coap_receive_multicast(get_src_endpoint(&src, 0), uip_appdata,
+                           uip_datalen());
+  } else {
+    coap_receive(get_src_endpoint(&src, 0), uip_appdata, uip_datalen());
+  }
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -381,6 +543,15 @@ coap_sendto(const coap_endpoint_t *ep, const uint8_t *data, uint16_t length)
     return -1;
   }
 
+  if(ep->tcp) {
+#if COAP_WITH_TCP
+    return coap_tcp_sendto(ep, data, length);
+#else /* COAP_WITH_TCP */
+    LOG_WARN("CoAP over TCP not enabled - dropping packet\n");
+    return -1;
+#endif /* COAP_WITH_TCP */
+  }
+
 #ifdef WITH_DTLS
   if(coap_endpoint_is_secure(ep)) {
     if(dtls_context) {
@@ -393,6 +564,7 @@ coap_sendto(const coap_endpoint_t *ep, const uint8_t *data, uint16_t length)
         LOG_INFO_(" - error %d\n", ret);
       } else {
         LOG_INFO_(" %d/%u bytes\n", ret, length);
+        touch_session(ep);
       }
       return ret;
     } else {
@@ -418,6 +590,22 @@ PROCESS_THREAD(coap_engine, ev, data)
   udp_bind(udp_conn, SERVER_LISTEN_PORT);
   LOG_INFO("Listening on port %u\n", uip_ntohs(udp_conn->lport));
 
+#if COAP_ALL_COAP_NODES
+  {
+    uip_ipaddr_t group;
+
+    /* All CoAP Nodes, link-local and site-local (RFC 7252, 12.8) */
+    uip_ip6addr(&group, 0xff02, 0, 0, 0, 0, 0, 0, 0xfd);
+    if(uip_ds6_maddr_add(&group) == NULL) {
+      LOG_WARN("cannot join ff02::fd\n");
+    }
+    uip_ip6addr(&group, 0xff05, 0, 0, 0, 0, 0, 0, 0xfd);
+    if(uip_ds6_maddr_add(&group) == NULL) {
+      LOG_WARN("cannot join ff05::fd\n");
+    }
+  }
+#endif /* COAP_ALL_COAP_NODES */
+
 #ifdef WITH_DTLS
   /* create new context with app-data */
   dtls_conn = udp_new(NULL, 0, NULL);
@@ -480,6 +668,7 @@ input_from_peer(struct dtls_context_t *ctx,
   /* Ensure that the endpoint is tagged as secure */
   session->secure = 1;
 
+  touch_session(session);
   coap_receive(session, data, len);
 
   return 0;
@@ -499,6 +688,20 @@ output_to_peer(struct dtls_context_t *ctx,
   return len;
 }
 
+/* Keeps the session cache in step with the peers of tinyDTLS */
+static int
+handle_event(struct dtls_context_t *ctx, session_t *session,
+             dtls_alert_level_t level, unsigned short code)
+{
+  if(level == 0 && code == DTLS_EVENT_CONNECTED) {
+    add_session(session);
+  } else if(level == DTLS_ALERT_LEVEL_FATAL
+            || code == DTLS_ALERT_CLOSE_NOTIFY) {
+    forget_session(session);
+  }
+  return 0;
+}
+
 /* This defines the key-store set API since we hookup DTLS here */
 void
 coap_set_keystore(const coap_keystore_t *keystore)
@@ -583,7 +786,7 @@ get_psk_info(struct dtls_context_t *ctx,
 static dtls_handler_t cb = {
   .write = output_to_peer,
   .read  = input_from_peer,
-  .event = NULL,
+  .event = handle_event,
 #ifdef DTLS_PSK
   .get_psk_info = get_psk_info,
 #endif /* DTLS_PSK */
@@ -99,6 +99,16 @@ coap_parse_int_option(uint8_t *bytes, size_t length)
   return var;
 }
 /*---------------------------------------------------------------------------*/
+/* SZX of a Block1/Block2 option value. SZX 7 is BERT (RFC 8323), which
+ * numbers blocks in units of 1024 bytes just like SZX 6. BERT is not
+ * supported, so it is parsed as SZX 6 and answered with blocks of at most
+ * 1024 bytes, which BERT peers accept. */
+static uint8_t
+coap_parse_block_szx(uint32_t value)
+{
+  return MIN(value & 0x07, 6);
+}
+/*---------------------------------------------------------------------------*/
 static uint8_t
 coap_option_nibble(unsigned int value)
 {
@@ -627,25 +637,28 @@ coap_parse_message(coap_message_t *coap_pkt, uint8_t *data, uint16_t data_len)
 #if COAP_PROXY_OPTION_PROCESSING
       coap_pkt->proxy_uri = (char *)current_option;
       coap_pkt->proxy_uri_len = option_length;
-#endif /* COAP_PROXY_OPTION_PROCESSING */
-      LOG_DBG_("Proxy-Uri NOT IMPLEMENTED [");
+      LOG_DBG_("Proxy-Uri [");
       LOG_DBG_COAP_STRING(coap_pkt->proxy_uri, coap_pkt->proxy_uri_len);
       LOG_DBG_("]\n");
-
+      break;
+#else /* COAP_PROXY_OPTION_PROCESSING */
+      LOG_DBG_("Proxy-Uri NOT IMPLEMENTED\n");
       coap_error_message = "This is a constrained server (Contiki)";
       return PROXYING_NOT_SUPPORTED_5_05;
-      break;
+#endif /* COAP_PROXY_OPTION_PROCESSING */
     case COAP_OPTION_PROXY_SCHEME:
 #if COAP_PROXY_OPTION_PROCESSING
       coap_pkt->proxy_scheme = (char *)current_option;
       coap_pkt->proxy_scheme_len = option_length;
-#endif
-      LOG_DBG_("Proxy-Scheme NOT IMPLEMENTED [");
+      LOG_DBG_("Proxy-Scheme [");
       LOG_DBG_COAP_STRING(coap_pkt->proxy_scheme, coap_pkt->proxy_scheme_len);
       LOG_DBG_("]\n");
+      break;
+#else /* COAP_PROXY_OPTION_PROCESSING */
+      LOG_DBG_("Proxy-Scheme NOT IMPLEMENTED\n");
       coap_error_message = "This is a constrained server (Contiki)";
       return PROXYING_NOT_SUPPORTED_5_05;
-      break;
+#endif /* COAP_PROXY_OPTION_PROCESSING */
 
     case COAP_OPTION_URI_HOST:
       coap_pkt->uri_host = (char *)current_option;
@@ -720,9 +733,9 @@ coap_parse_message(coap_message_t *coap_pkt, uint8_t *data, uint16_t data_len)
       coap_pkt->block2_num = coap_parse_int_option(current_option,
                                                    option_length);
       coap_pkt->block2_more = (coap_pkt->block2_num & 0x08) >> 3;
-      coap_pkt->block2_size = 16 << (coap_pkt->block2_num & 0x07);
+      coap_pkt->block2_size = 16 << coap_parse_block_szx(coap_pkt->block2_num);
       coap_pkt->block2_offset = (coap_pkt->block2_num & ~0x0000000F)
-        << (coap_pkt->block2_num & 0x07);
+        << coap_parse_block_szx(coap_pkt->block2_num);
       coap_pkt->block2_num >>= 4;
       LOG_DBG_("Block2 [%lu%s (%u B/blk)]\n",
                (unsigned long)coap_pkt->block2_num,
@@ -732,9 +745,9 @@ coap_parse_message(coap_message_t *coap_pkt, uint8_t *data, uint16_t data_len)
       coap_pkt->block1_num = coap_parse_int_option(current_option,
                                                    option_length);
       coap_pkt->block1_more = (coap_pkt->block1_num & 0x08) >> 3;
-      coap_pkt->block1_size = 16 << (coap_pkt->block1_num & 0x07);
+      coap_pkt->block1_size = 16 << coap_parse_block_szx(coap_pkt->block1_num);
       coap_pkt->block1_offset = (coap_pkt->block1_num & ~0x0000000F)
-        << (coap_pkt->block1_num & 0x07);
+        << coap_parse_block_szx(coap_pkt->block1_num);
       coap_pkt->block1_num >>= 4;
       LOG_DBG_("Block1 [%lu%s (%u B/blk)]\n",
                (unsigned long)coap_pkt->block1_num,
@@ -938,6 +951,25 @@ coap_set_header_proxy_uri(coap_message_t *coap_pkt, const char *uri)
 }
 /*---------------------------------------------------------------------------*/
 int
+coap_get_header_proxy_scheme(coap_message_t *coap_pkt, const char **scheme)
+{
+  if(!coap_is_option(coap_pkt, COAP_OPTION_PROXY_SCHEME)) {
+    return 0;
+  }
+  *scheme = coap_pkt->proxy_scheme;
+  return coap_pkt->proxy_scheme_len;
+}
+int
+coap_set_header_proxy_scheme(coap_message_t *coap_pkt, const char *scheme)
+{
+  coap_pkt->proxy_scheme = scheme;
+  coap_pkt->proxy_scheme_len = strlen(scheme);
+
+  coap_set_option(coap_pkt, COAP_OPTION_PROXY_SCHEME);
+  return coap_pkt->proxy_scheme_len;
+}
+/*---------------------------------------------------------------------------*/
+int
 coap_get_header_uri_host(coap_message_t *coap_pkt, const char **host)
 {
   if(!coap_is_option(coap_pkt, COAP_OPTION_URI_HOST)) {
@@ -1609,9 +1641,9 @@ coap_status_t oscore_parser(coap_message_t *coap_pkt, uint8_t *data,
       coap_pkt->block2_num = coap_parse_int_option(current_option,
                                                    option_length);
       coap_pkt->block2_more = (coap_pkt->block2_num & 0x08) >> 3;
-      coap_pkt->block2_size = 16 << (coap_pkt->block2_num & 0x07);
+      coap_pkt->block2_size = 16 << coap_parse_block_szx(coap_pkt->block2_num);
       coap_pkt->block2_offset = (coap_pkt->block2_num & ~0x0000000F)
-        << (coap_pkt->block2_num & 0x07);
+        << coap_parse_block_szx(coap_pkt->block2_num);
       coap_pkt->block2_num >>= 4;
       LOG_DBG_("Block2 [%lu%s (%u B/blk)]\n",
              (unsigned long)coap_pkt->block2_num,
@@ -1621,9 +1653,9 @@ coap_status_t oscore_parser(coap_message_t *coap_pkt, uint8_t *data,
       coap_pkt->block1_num = coap_parse_int_option(current_option,
                                                    option_length);
       coap_pkt->block1_more = (coap_pkt->block1_num & 0x08) >> 3;
-      coap_pkt->block1_size = 16 << (coap_pkt->block1_num & 0x07);
+      coap_pkt->block1_size = 16 << coap_parse_block_szx(coap_pkt->block1_num);
       coap_pkt->block1_offset = (coap_pkt->block1_num & ~0x0000000F)
-        << (coap_pkt->block1_num & 0x07);
+        << coap_parse_block_szx(coap_pkt->block1_num);
       coap_pkt->block1_num >>= 4;
       LOG_DBG_("Block1 [%lu%s (%u B/blk)]\n",
              (unsigned long)coap_pkt->block1_num,
@@ -66,15 +66,15 @@
  */
 #define COAP_MAX_PACKET_SIZE  (COAP_MAX_HEADER_SIZE + COAP_MAX_CHUNK_SIZE)
 
-/* COAP_MAX_CHUNK_SIZE can be different from 2^x so we need to get next lower 2^x for COAP_MAX_BLOCK_SIZE */
+/* COAP_MAX_CHUNK_SIZE can be different from 2^x so we need to get next lower 2^x for COAP_MAX_BLOCK_SIZE.
+   Blocks are 1024 bytes at most, as SZX 7 is reserved (BERT is not supported) */
 #ifndef COAP_MAX_BLOCK_SIZE
 #define COAP_MAX_BLOCK_SIZE           (COAP_MAX_CHUNK_SIZE < 32 ? 16 : \
                                        (COAP_MAX_CHUNK_SIZE < 64 ? 32 : \
                                         (COAP_MAX_CHUNK_SIZE < 128 ? 64 : \
                                          (COAP_MAX_CHUNK_SIZE < 256 ? 128 : \
                                           (COAP_MAX_CHUNK_SIZE < 512 ? 256 : \
-                                          (COAP_MAX_CHUNK_SIZE < 1024 ? 512 : \
-                                          (COAP_MAX_CHUNK_SIZE < 2048 ? 1024 : 2048)))))))
+                                          (COAP_MAX_CHUNK_SIZE < 1024 ? 512 : 1024))))))
 #endif /* COAP_MAX_BLOCK_SIZE */
 
 /* bitmap for set options */
@@ -151,6 +151,14 @@ coap_set_option(coap_message_t *message, unsigned int opt)
   return 1;
 }
 
+static inline void
+coap_clear_option(coap_message_t *message, unsigned int opt)
+{
+  if(opt <= COAP_OPTION_SIZE1) {
+    message->options[opt / COAP_OPTION_MAP_SIZE] &= ~(1 << (opt % COAP_OPTION_MAP_SIZE));
+  }
+}
+
 static inline int
 coap_is_option(const coap_message_t *message, unsigned int opt)
 {
@@ -193,7 +201,7 @@ coap_is_option(const coap_message_t *message, unsigned int opt)
     LOG_DBG(text " [%lu%s (%u B/blk)]\n", (unsigned long)coap_pkt->field##_num, coap_pkt->field##_more ? "+" : "", coap_pkt->field##_size); \
     uint32_t block = coap_pkt->field##_num << 4; \
     if(coap_pkt->field##_more) { block |= 0x8; } \
-    block |= 0xF & coap_log_2(coap_pkt->field##_size / 16); \
+    block |= 0xF & MIN(coap_log_2(coap_pkt->field##_size / 16), 6); \
     LOG_DBG(text " encoded: 0x%lX\n", (unsigned long)block);		\
     option += coap_serialize_int_option(number, current_number, option, block); \
     current_number = number; \
@@ -40,7 +40,6 @@
 #include "oscore-context.h"
 #include <stddef.h>
 #include "lib/memb.h"
-#include "lib/list.h"
 #include <string.h>
 #include "oscore-crypto.h"
 #include "oscore.h"
@@ -66,8 +65,12 @@
 
 MEMB(exchange_memb, oscore_exchange_t, TOKEN_SEQ_NUM);
 
-LIST(common_context_list);
-LIST(exchange_list);
+/* Contexts hashed by recipient ID and exchanges hashed by token, so that
+   incoming messages do not walk everything that is stored */
+static oscore_ctx_t *context_buckets[OSCORE_CONTEXT_BUCKETS];
+static oscore_exchange_t *exchange_buckets[OSCORE_EXCHANGE_BUCKETS];
+/* Counts stored exchanges, the lowest stamp is the oldest */
+static uint32_t exchange_stamp;
 
 #define INFO_BUFFER_LENGTH ( \
   1 + /* array */ \
@@ -78,10 +81,33 @@ LIST(exchange_list);
   1 /* int, output length */ \
 )
 
+static unsigned
+hash_bytes(const uint8_t *bytes, uint8_t len, unsigned buckets)
+{
+  unsigned hash = 0;
+  while(len--) {
+    hash = hash * 31 + *bytes++;
+  }
+  return hash % buckets;
+}
+
+static oscore_ctx_t **
+context_bucket(const uint8_t *rid, uint8_t rid_len)
+{
+  return &context_buckets[hash_bytes(rid, rid_len, OSCORE_CONTEXT_BUCKETS)];
+}
+
+static oscore_exchange_t **
+exchange_bucket(const uint8_t *token, uint8_t token_len)
+{
+  return &exchange_buckets[hash_bytes(token, token_len,
+                                      OSCORE_EXCHANGE_BUCKETS)];
+}
+
 void
 oscore_ctx_store_init(void)
 {
-  list_init(common_context_list);
+  memset(context_buckets, 0, sizeof(context_buckets));
 }
 
 static uint8_t
@@ -118,6 +144,27 @@ bytes_equal(const uint8_t *a_ptr, uint8_t a_len, const uint8_t *b_ptr, uint8_t b
   return a_len == b_len && memcmp(a_ptr, b_ptr, a_len) == 0;
 }
 
+/* Removes ctx from the index if it is in it. Contexts are derived and
+   freed rarely, so every bucket is searched rather than trusting the
+   recipient ID, which may be unset or about to change. */
+static void
+unlink_ctx(oscore_ctx_t *ctx)
+{
+  oscore_ctx_t **ptr;
+  unsigned i;
+
+  for(i = 0; i < OSCORE_CONTEXT_BUCKETS; i++) {
+    for(ptr = &context_buckets[i]; *ptr != NULL; ptr = &(*ptr)->next) {
+      if(*ptr == ctx) {
+        *ptr = ctx->next;
+        ctx->next = NULL;
+        return;
+      }
+    }
+  }
+  ctx->next = NULL;
+}
+
 void
 oscore_derive_ctx(oscore_ctx_t *common_ctx,
   const uint8_t *master_secret, uint8_t master_secret_len,
@@ -130,6 +177,10 @@ oscore_derive_ctx(oscore_ctx_t *common_ctx,
   uint8_t info_buffer[INFO_BUFFER_LENGTH];
   uint8_t info_len;
 
+  /* Deriving a stored context again moves it to the bucket of its new
+     recipient ID */
+  unlink_ctx(common_ctx);
+
   if (id_context_len > OSCORE_MAX_ID_CONTEXT_LEN)
   {
     LOG_WARN("Please decrease OSCORE_MAX_ID_CONTEXT_LEN to be at maximum %" PRIu8 "\n", id_context_len);
@@ -172,40 +223,42 @@ oscore_derive_ctx(oscore_ctx_t *common_ctx,
 
   oscore_sliding_window_init(&common_ctx->recipient_context.sliding_window);
 
-  list_add(common_context_list, common_ctx);
+  oscore_ctx_t **bucket = context_bucket(rid, rid_len);
+  common_ctx->next = *bucket;
+  *bucket = common_ctx;
 }
 
 void
 oscore_free_ctx(oscore_ctx_t *ctx)
 {
-  list_remove(common_context_list, ctx); 
+  unlink_ctx(ctx);
   memset(ctx, 0, sizeof(*ctx));
 }
 
 oscore_ctx_t *
 oscore_find_ctx_by_rid(const uint8_t *rid, uint8_t rid_len)
 {
-  oscore_ctx_t *ptr = NULL;
-  for(ptr = list_head(common_context_list); ptr != NULL; ptr = list_item_next(ptr)){
+  oscore_ctx_t *ptr;
+  for(ptr = *context_bucket(rid, rid_len); ptr != NULL; ptr = ptr->next) {
     if(bytes_equal(ptr->recipient_context.recipient_id, ptr->recipient_context.recipient_id_len, rid, rid_len)) {
       return ptr;
     }
   }
   return NULL;
-} 
+}
 
 /* Token <=> SEQ association */
 void
 oscore_exchange_store_init(void)
 {
   memb_init(&exchange_memb);
-  list_init(exchange_list);
+  memset(exchange_buckets, 0, sizeof(exchange_buckets));
 }
 
 oscore_exchange_t*
 oscore_get_exchange(const uint8_t *token, uint8_t token_len)
 {
-  for(oscore_exchange_t *ptr = list_head(exchange_list); ptr != NULL; ptr = list_item_next(ptr)) {
+  for(oscore_exchange_t *ptr = *exchange_bucket(token, token_len); ptr != NULL; ptr = ptr->next) {
     if(bytes_equal(ptr->token, ptr->token_len, token, token_len)) {
       return ptr;
     }
@@ -213,6 +266,33 @@ oscore_get_exchange(const uint8_t *token, uint8_t token_len)
   return NULL;
 }
 
+static void
+unlink_exchange(oscore_exchange_t *exchange)
+{
+  oscore_exchange_t **ptr;
+  for(ptr = exchange_bucket(exchange->token, exchange->token_len);
+      *ptr != NULL; ptr = &(*ptr)->next) {
+    if(*ptr == exchange) {
+      *ptr = exchange->next;
+      return;
+    }
+  }
+}
+
+static oscore_exchange_t *
+oldest_exchange(void)
+{
+  oscore_exchange_t *oldest = NULL;
+  for(unsigned i = 0; i < OSCORE_EXCHANGE_BUCKETS; i++) {
+    for(oscore_exchange_t *ptr = exchange_buckets[i]; ptr != NULL; ptr = ptr->next) {
+      if(oldest == NULL || (int32_t)(ptr->stored - oldest->stored) < 0) {
+        oldest = ptr;
+      }
+    }
+  }
+  return oldest;
+}
+
 bool
 oscore_set_exchange(const uint8_t *token, uint8_t token_len, uint64_t seq, oscore_ctx_t *context)
 {
@@ -227,24 +307,26 @@ oscore_set_exchange(const uint8_t *token, uint8_t token_len, uint64_t seq, oscor
     /* If we are at capacity for Endpoint <-> Context associations: */
     LOG_WARN("oscore_set_exchange: out of memory, will try to make room\n");
 
-    /* Remove first element in list, to make space for a new one. */
-    /* The head of the list contains the oldest inserted item,
-     * so most likely to never be coming back to us */
-    new_exchange = list_pop(exchange_list);
+    /* Replace the oldest exchange, the one most likely to never be
+     * coming back to us. Only this path walks all exchanges. */
+    new_exchange = oldest_exchange();
 
     if (new_exchange == NULL) {
       LOG_ERR("oscore_set_exchange: failed to make room\n");
       return false;
     }
+    unlink_exchange(new_exchange);
   }
 
   memcpy(new_exchange->token, token, token_len);
   new_exchange->token_len = token_len;
   new_exchange->seq = seq;
   new_exchange->context = context;
+  new_exchange->stored = exchange_stamp++;
 
-  /* Add to end of the exchange list */
-  list_add(exchange_list, new_exchange);
+  oscore_exchange_t **bucket = exchange_bucket(token, token_len);
+  new_exchange->next = *bucket;
+  *bucket = new_exchange;
 
   return true;
 }
@@ -254,7 +336,7 @@ oscore_remove_exchange(const uint8_t *token, uint8_t token_len)
 {
   oscore_exchange_t *ptr = oscore_get_exchange(token, token_len);
   if (ptr) {
-    list_remove(exchange_list, ptr);
+    unlink_exchange(ptr);
     memb_free(&exchange_memb, ptr);
   }
 }
@@ -54,6 +54,17 @@
 #define TOKEN_SEQ_NUM 30
 #endif
 
+/* Buckets of the index that finds contexts by recipient ID, raise it on
+   gateways that hold many contexts */
+#ifndef OSCORE_CONTEXT_BUCKETS
+#define OSCORE_CONTEXT_BUCKETS 8
+#endif
+
+/* Buckets of the index that finds exchanges by token */
+#ifndef OSCORE_EXCHANGE_BUCKETS
+#define OSCORE_EXCHANGE_BUCKETS 8
+#endif
+
 typedef struct oscore_sender_ctx {
   uint8_t sender_key[CONTEXT_KEY_LEN];
   uint64_t seq;
@@ -71,7 +82,7 @@ typedef struct oscore_recipient_ctx {
 } oscore_recipient_ctx_t;
 
 typedef struct oscore_ctx {
-  struct oscore_ctx *next;
+  struct oscore_ctx *next; /* in the recipient ID bucket */
   const uint8_t *master_secret;
   uint8_t common_iv[CONTEXT_INIT_VECT_LEN];
   uint8_t master_secret_len;
@@ -81,9 +92,10 @@ typedef struct oscore_ctx {
 } oscore_ctx_t;
 
 typedef struct oscore_exchange {
-  struct oscore_exchange *next;
+  struct oscore_exchange *next; /* in the token bucket */
   oscore_ctx_t *context;
   uint64_t seq;
+  uint32_t stored;
   uint8_t token[COAP_TOKEN_LEN];
   uint8_t token_len;
 } oscore_exchange_t;
@@ -48,6 +48,17 @@
 
 typedef coap_endpoint_t session_t;
 
+/* Established sessions kept by the CoAP transport, by default one per
+   tinyDTLS peer (DTLS_PEER_MAX, 1 unless configured). When all are in
+   use, the least recently used one is closed for a new peer. */
+#ifdef COAP_DTLS_CONF_SESSIONS
+#define COAP_DTLS_SESSIONS COAP_DTLS_CONF_SESSIONS
+#elif defined(DTLS_PEER_MAX)
+#define COAP_DTLS_SESSIONS DTLS_PEER_MAX
+#else
+#define COAP_DTLS_SESSIONS 1
+#endif /* COAP_DTLS_SESSIONS */
+
 #include "sys/ctimer.h"
 #include <stdint.h>
 
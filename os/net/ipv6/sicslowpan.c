@@ -237,7 +237,29 @@ static uint16_t my_tag;
 #endif
 
 /* Assuming that the worst growth for uncompression is 38 bytes */
+#if SICSLOWPAN_COAP_RULES > 0
+/* A rule-compressed CoAP header may expand by up to 3 + options bytes */
+#define SICSLOWPAN_FIRST_FRAGMENT_SIZE (SICSLOWPAN_FRAGMENT_SIZE + 38 + \
+                                        3 + SICSLOWPAN_COAP_RULE_OPTIONS_MAX)
+#else /* SICSLOWPAN_COAP_RULES > 0 */
 #define SICSLOWPAN_FIRST_FRAGMENT_SIZE (SICSLOWPAN_FRAGMENT_SIZE + 38)
+#endif /* SICSLOWPAN_COAP_RULES > 0 */
+
+/* Set to 1 to forward fragmented datagrams fragment by fragment, using
+ * virtual reassembly buffers (RFC 8930), rather than reassembling them at
+ * every hop. Only the first fragment goes through the IP layer. */
+#ifdef SICSLOWPAN_CONF_FRAG_FORWARDING
+#define SICSLOWPAN_FRAG_FORWARDING SICSLOWPAN_CONF_FRAG_FORWARDING
+#else
+#define SICSLOWPAN_FRAG_FORWARDING 0
+#endif
+
+/* The number of datagrams that can be forwarded simultaneously */
+#ifdef SICSLOWPAN_CONF_VRB_ENTRIES
+#define SICSLOWPAN_VRB_ENTRIES SICSLOWPAN_CONF_VRB_ENTRIES
+#else
+#define SICSLOWPAN_VRB_ENTRIES 4
+#endif
 
 /* all information needed for reassembly */
 struct sicslowpan_frag_info {
@@ -448,6 +470,196 @@ copy_frags2uip(int context)
 
   return true;
 }
+#if SICSLOWPAN_FRAG_FORWARDING
+/*---------------------------------------------------------------------------*/
+/* A virtual reassembly buffer: switches the fragments of a datagram we
+ * forward to the next hop, without reassembling the datagram */
+struct sicslowpan_vrb {
+  /** The previous hop and tag of the incoming fragments */
+  linkaddr_t in_sender;
+  uint16_t in_tag;
+  /** The next hop and tag of the outgoing fragments */
+  linkaddr_t out_receiver;
+  uint16_t out_tag;
+  /** Datagram size, as received and as sent */
+  uint16_t in_size;
+  uint16_t out_size;
+  /** Number of datagram bytes received so far */
+  uint16_t received_len;
+  /** Offset change, in units of 8 bytes, as forwarding may add or
+   * remove extension headers */
+  int8_t offset_shift;
+  /** Set once the first fragment was sent to the next hop */
+  uint8_t established;
+  uint8_t used;
+  struct timer timer;
+};
+
+static void send_packet(linkaddr_t *dest);
+
+static struct sicslowpan_vrb vrb_table[SICSLOWPAN_VRB_ENTRIES];
+/* The entry of the first fragment currently being forwarded by the IP
+ * layer, along with its reassembly context, source address and length */
+static struct sicslowpan_vrb *vrb_pending;
+static int vrb_pending_context;
+static uip_ipaddr_t vrb_pending_src;
+static uint16_t vrb_pending_len;
+/*---------------------------------------------------------------------------*/
+static struct sicslowpan_vrb *
+vrb_lookup(const linkaddr_t *sender, uint16_t tag)
+{
+  int i;
+
+  for(i = 0; i < SICSLOWPAN_VRB_ENTRIES; i++) {
+    if(vrb_table[i].used && vrb_table[i].established
+       && vrb_table[i].in_tag == tag
+       && linkaddr_cmp(&vrb_table[i].in_sender, sender)) {
+      if(timer_expired(&vrb_table[i].timer)) {
+        vrb_table[i].used = 0;
+        return NULL;
+      }
+      return &vrb_table[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Checks whether the first fragment stored in a reassembly context may be
+ * forwarded, and if so sets up a virtual reassembly buffer and copies the
+ * fragment to uip_buf, with an IP length matching the fragment. The
+ * fragment stays in the reassembly context until output() sends it to a
+ * 6LoWPAN neighbor: if the IP layer does anything else with it, the
+ * datagram is reassembled as usual. */
+static bool
+vrb_start(int context, uint16_t tag, uint16_t size)
+{
+  struct uip_ip_hdr *hdr = (struct uip_ip_hdr *)frag_info[context].first_frag;
+  struct uip_routing_hdr *rh;
+  struct sicslowpan_vrb *vrb = NULL;
+  int i;
+
+  if(frag_info[context].first_frag_len < UIP_IPH_LEN + sizeof(*rh)
+     || uip_is_addr_mcast(&hdr->destipaddr)) {
+    return false;
+  }
+
+  if(uip_ds6_is_my_addr(&hdr->destipaddr)) {
+    /* Addressed to us, unless we are an intermediate hop of a routing header */
+    rh = (struct uip_routing_hdr *)(frag_info[context].first_frag + UIP_IPH_LEN);
+    if(hdr->proto != UIP_PROTO_ROUTING || rh->seg_left == 0) {
+      return false;
+    }
+  }
+
+  for(i = 0; i < SICSLOWPAN_VRB_ENTRIES; i++) {
+    if(!vrb_table[i].used || timer_expired(&vrb_table[i].timer)) {
+      vrb = &vrb_table[i];
+      break;
+    }
+  }
+  if(vrb == NULL) {
+    LOG_WARN("input: no free virtual reassembly buffer, reassembling (tag %d)\n", tag);
+    return false;
+  }
+
+  memset(vrb, 0, sizeof(*vrb));
+  vrb->used = 1;
+  vrb->in_tag = tag;
+  vrb->in_size = size;
+  vrb->received_len = frag_info[context].first_frag_len;
+  linkaddr_copy(&vrb->in_sender, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  timer_set(&vrb->timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND / 16);
+
+  memcpy((uint8_t *)UIP_IP_BUF, frag_info[context].first_frag,
+         frag_info[context].first_frag_len);
+  uipbuf_set_len_field(UIP_IP_BUF, frag_info[context].first_frag_len - UIP_IPH_LEN);
+  uipbuf_set_attr_flag(UIPBUF_ATTR_FLAGS_6LOWPAN_FIRST_FRAGMENT);
+
+  vrb_pending = vrb;
+  vrb_pending_context = context;
+  uip_ipaddr_copy(&vrb_pending_src, &UIP_IP_BUF->srcipaddr);
+  vrb_pending_len = vrb->received_len;
+
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+/* Called once the first fragment went through the IP layer */
+static void
+vrb_end(void)
+{
+  if(vrb_pending == NULL) {
+    return;
+  }
+  if(vrb_pending->established) {
+    /* Subsequent fragments will be switched, nothing to reassemble */
+    clear_fragments(vrb_pending_context);
+  } else {
+    /* The first fragment was not sent to a 6LoWPAN neighbor: keep the
+     * reassembly context, the full datagram goes to the IP layer later */
+    LOG_INFO("input: not forwarding fragments, reassembling (tag %d)\n",
+             vrb_pending->in_tag);
+    vrb_pending->used = 0;
+  }
+  vrb_pending = NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Forwards the subsequent fragment in packetbuf if it belongs to a
+ * datagram we forward. Returns true if the fragment was consumed. */
+static bool
+vrb_forward_fragn(uint16_t tag, uint8_t offset)
+{
+  struct sicslowpan_vrb *vrb;
+  uint16_t len;
+  int out_offset;
+
+  vrb = vrb_lookup(packetbuf_addr(PACKETBUF_ADDR_SENDER), tag);
+  if(vrb == NULL) {
+    return false;
+  }
+
+  len = packetbuf_datalen();
+  out_offset = offset + vrb->offset_shift;
+  if(len < SICSLOWPAN_FRAGN_HDR_LEN || out_offset < 0 || out_offset > 0xff) {
+    LOG_WARN("input: cannot forward fragment (tag %d, offset %d)\n", tag, offset << 3);
+    vrb->used = 0;
+    return true;
+  }
+  vrb->received_len += len - SICSLOWPAN_FRAGN_HDR_LEN;
+
+  /* Rewrite the fragment header with our datagram size, tag and offset */
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+        ((SICSLOWPAN_DISPATCH_FRAGN << 8) | vrb->out_size));
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, vrb->out_tag);
+  PACKETBUF_FRAG_PTR[PACKETBUF_FRAG_OFFSET] = out_offset;
+
+  LOG_INFO("input: forwarding fragment (tag %d -> %d, payload %d, offset %d)\n",
+           tag, vrb->out_tag, len - SICSLOWPAN_FRAGN_HDR_LEN, out_offset << 3);
+
+  /* Move the frame to the start of packetbuf, and reset the attributes
+   * of the received frame */
+  memmove(packetbuf_hdrptr(), packetbuf_dataptr(), len);
+  packetbuf_clear();
+  packetbuf_set_datalen(len);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
+                     uipbuf_get_attr(UIPBUF_ATTR_MAX_MAC_TRANSMISSIONS));
+#if LLSEC802154_USES_AUX_HEADER
+  packetbuf_set_attr(PACKETBUF_ATTR_SECURITY_LEVEL,
+    uipbuf_get_attr(UIPBUF_ATTR_LLSEC_LEVEL));
+#if LLSEC802154_USES_EXPLICIT_KEYS
+  packetbuf_set_attr(PACKETBUF_ATTR_KEY_INDEX,
+    uipbuf_get_attr(UIPBUF_ATTR_LLSEC_KEY_ID));
+#endif /* LLSEC802154_USES_EXPLICIT_KEYS */
+#endif /*  LLSEC802154_USES_AUX_HEADER */
+
+  send_packet(&vrb->out_receiver);
+
+  if(vrb->received_len >= vrb->in_size) {
+    /* Last fragment forwarded */
+    vrb->used = 0;
+  }
+  return true;
+}
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 #endif /* SICSLOWPAN_CONF_FRAG */
 
 /* -------------------------------------------------------------------------- */
@@ -512,6 +724,11 @@ static struct sicslowpan_addr_context
 addr_contexts[SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS];
 #endif
 
+#if SICSLOWPAN_COAP_RULES > 0
+/** CoAP header compression rules, a zero port marks a free slot. */
+static struct sicslowpan_coap_rule coap_rules[SICSLOWPAN_COAP_RULES];
+#endif
+
 /** pointer to an address context. */
 static struct sicslowpan_addr_context *context;
 
@@ -560,6 +777,11 @@ addr_context_lookup_by_prefix(uip_ipaddr_t *ipaddr)
   int i;
   for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
     if((addr_contexts[i].used == 1) &&
+#if UIP_ND6_RA_6CO
+       addr_contexts[i].compress &&
+       (addr_contexts[i].isinfinite ||
+        !stimer_expired(&addr_contexts[i].lifetime)) &&
+#endif /* UIP_ND6_RA_6CO */
        uip_ipaddr_prefixcmp(&addr_contexts[i].prefix, ipaddr, 64)) {
       return &addr_contexts[i];
     }
@@ -585,6 +807,156 @@ addr_context_lookup_by_number(uint8_t number)
   return NULL;
 }
 /*--------------------------------------------------------------------*/
+#if UIP_ND6_RA_6CO
+int
+sicslowpan_context_update(uint8_t number, const uint8_t *prefix,
+                          uint8_t compress, uint32_t lifetime)
+{
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  struct sicslowpan_addr_context *c;
+  int i;
+
+  c = addr_context_lookup_by_number(number);
+  if(lifetime == 0) {
+    if(c != NULL) {
+      LOG_INFO("removing context %u\n", number);
+      c->used = 0;
+    }
+    return 1;
+  }
+  if(c == NULL) {
+    /* Take a free slot, or else one whose lifetime has expired */
+    for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+      if(addr_contexts[i].used == 0 ||
+         (!addr_contexts[i].isinfinite &&
+          stimer_expired(&addr_contexts[i].lifetime))) {
+        c = &addr_contexts[i];
+        break;
+      }
+    }
+    if(c == NULL) {
+      LOG_WARN("no room for context %u\n", number);
+      return 0;
+    }
+  }
+  c->used = 1;
+  c->number = number & 0x0f;
+  memcpy(c->prefix, prefix, sizeof(c->prefix));
+  c->compress = compress;
+  c->isinfinite = lifetime == 0xffffffff;
+  if(!c->isinfinite) {
+    stimer_set(&c->lifetime, lifetime);
+  }
+  LOG_INFO("context %u updated, compress %u lifetime %"PRIu32"\n",
+           number, compress, lifetime);
+  return 1;
+#else /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+  return 0;
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+}
+/*--------------------------------------------------------------------*/
+struct sicslowpan_addr_context *
+sicslowpan_context_get(uint8_t index)
+{
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  if(index < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS &&
+     addr_contexts[index].used == 1) {
+    return &addr_contexts[index];
+  }
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+  return NULL;
+}
+#endif /* UIP_ND6_RA_6CO */
+/*--------------------------------------------------------------------*/
+#if SICSLOWPAN_COAP_RULES > 0
+int
+sicslowpan_coap_rule_add(const struct sicslowpan_coap_rule *rule)
+{
+  struct sicslowpan_coap_rule *free_rule = NULL;
+  int i;
+
+  if(rule->port == 0 || rule->token_len > 8 || rule->type > 3 ||
+     rule->options_len > SICSLOWPAN_COAP_RULE_OPTIONS_MAX) {
+    return 0;
+  }
+  for(i = 0; i < SICSLOWPAN_COAP_RULES; i++) {
+    if(coap_rules[i].port != 0 && coap_rules[i].id == rule->id) {
+      free_rule = &coap_rules[i];
+      break;
+    }
+    if(coap_rules[i].port == 0 && free_rule == NULL) {
+      free_rule = &coap_rules[i];
+    }
+  }
+  if(free_rule == NULL) {
+    return 0;
+  }
+  memcpy(free_rule, rule, sizeof(*rule));
+  return 1;
+}
+/*--------------------------------------------------------------------*/
+void
+sicslowpan_coap_rule_remove(uint8_t id)
+{
+  int i;
+  for(i = 0; i < SICSLOWPAN_COAP_RULES; i++) {
+    if(coap_rules[i].port != 0 && coap_rules[i].id == id) {
+      coap_rules[i].port = 0;
+    }
+  }
+}
+/*--------------------------------------------------------------------*/
+/** \brief find the rule matching the CoAP header of a UDP datagram */
+static const struct sicslowpan_coap_rule *
+coap_rule_match(const struct uip_udp_hdr *udp, const uint8_t *coap,
+                int coap_len)
+{
+  const struct sicslowpan_coap_rule *r;
+  int i;
+
+  if(coap_len < 4) {
+    return NULL;
+  }
+  for(i = 0; i < SICSLOWPAN_COAP_RULES; i++) {
+    r = &coap_rules[i];
+    if(r->port != 0 &&
+       (r->port == UIP_HTONS(udp->destport) ||
+        r->port == UIP_HTONS(udp->srcport)) &&
+       coap[0] == (0x40 | (r->type << 4) | r->token_len) &&
+       coap[1] == r->code &&
+       coap_len >= 4 + r->token_len + r->options_len &&
+       memcmp(coap + 4 + r->token_len, r->options, r->options_len) == 0) {
+      return r;
+    }
+  }
+  return NULL;
+}
+/*--------------------------------------------------------------------*/
+/** \brief find the rule with the given id */
+static const struct sicslowpan_coap_rule *
+coap_rule_lookup(uint8_t id)
+{
+  int i;
+  for(i = 0; i < SICSLOWPAN_COAP_RULES; i++) {
+    if(coap_rules[i].port != 0 && coap_rules[i].id == id) {
+      return &coap_rules[i];
+    }
+  }
+  return NULL;
+}
+#else /* SICSLOWPAN_COAP_RULES > 0 */
+int
+sicslowpan_coap_rule_add(const struct sicslowpan_coap_rule *rule)
+{
+  return 0;
+}
+/*--------------------------------------------------------------------*/
+void
+sicslowpan_coap_rule_remove(uint8_t id)
+{
+}
+#endif /* SICSLOWPAN_COAP_RULES > 0 */
+/*--------------------------------------------------------------------*/
 static uint8_t
 compress_addr_64(uint8_t bitpos, uip_ipaddr_t *ipaddr, uip_lladdr_t *lladdr)
 {
@@ -1019,6 +1391,24 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
       memcpy(iphc_ptr, &udp_buf->udpchksum, 2);
       iphc_ptr += 2;
       uncomp_hdr_len += UIP_UDPH_LEN;
+#if SICSLOWPAN_COAP_RULES > 0
+      {
+        const struct sicslowpan_coap_rule *rule;
+        uint8_t *coap = (uint8_t *)udp_buf + UIP_UDPH_LEN;
+
+        rule = coap_rule_match(udp_buf, coap, uip_len - (coap - uip_buf));
+        if(rule != NULL) {
+          /* Rule id, message ID and token inline, the rest is elided */
+          LOG_DBG("compression: CoAP header with rule %u\n", rule->id);
+          *next_nhc |= SICSLOWPAN_NHC_UDP_COAP_ID;
+          CHECK_BUFFER_SPACE(3 + rule->token_len);
+          *iphc_ptr = rule->id;
+          memcpy(iphc_ptr + 1, coap + 2, 2 + rule->token_len);
+          iphc_ptr += 3 + rule->token_len;
+          uncomp_hdr_len += 4 + rule->token_len + rule->options_len;
+        }
+      }
+#endif /* SICSLOWPAN_COAP_RULES > 0 */
       /* this is the final header. */
       next_hdr = NULL;
       break;
@@ -1320,10 +1710,19 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t buf_size, uint16_t ip_len)
 
   /* The next header is compressed, NHC is following */
   CHECK_READ_SPACE(1);
-  if(nhc && (*iphc_ptr & SICSLOWPAN_NHC_UDP_MASK) == SICSLOWPAN_NHC_UDP_ID) {
+  if(nhc && ((*iphc_ptr & SICSLOWPAN_NHC_UDP_MASK) == SICSLOWPAN_NHC_UDP_ID
+#if SICSLOWPAN_COAP_RULES > 0
+              || (*iphc_ptr & SICSLOWPAN_NHC_UDP_MASK) == SICSLOWPAN_NHC_UDP_COAP_ID
+#endif /* SICSLOWPAN_COAP_RULES > 0 */
+              )) {
     struct uip_udp_hdr *udp_buf;
     uint16_t udp_len;
     uint8_t checksum_compressed;
+    uint16_t coap_len = 0;
+#if SICSLOWPAN_COAP_RULES > 0
+    uint8_t coap_compressed = (*iphc_ptr & SICSLOWPAN_NHC_UDP_MASK) ==
+      SICSLOWPAN_NHC_UDP_COAP_ID;
+#endif /* SICSLOWPAN_COAP_RULES > 0 */
 
     /* Check that there is enough room to write the UDP header. */
     if((ip_payload - buf) + UIP_UDPH_LEN > buf_size) {
@@ -1395,14 +1794,39 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t buf_size, uint16_t ip_len)
       LOG_DBG("uncompression: checksum *NOT* included\n");
     }
 
+#if SICSLOWPAN_COAP_RULES > 0
+    if(coap_compressed) {
+      const struct sicslowpan_coap_rule *rule;
+      uint8_t *coap = ip_payload + UIP_UDPH_LEN;
+
+      CHECK_READ_SPACE(1);
+      rule = coap_rule_lookup(*iphc_ptr);
+      if(rule == NULL) {
+        LOG_WARN("uncompression: unknown CoAP rule %u\n", *iphc_ptr);
+        return false;
+      }
+      CHECK_READ_SPACE(3 + rule->token_len);
+      coap_len = 4 + rule->token_len + rule->options_len;
+      if((ip_payload - buf) + UIP_UDPH_LEN + coap_len > buf_size) {
+        LOG_WARN("uncompression: cannot write CoAP header beyond target buffer\n");
+        return false;
+      }
+      coap[0] = 0x40 | (rule->type << 4) | rule->token_len;
+      coap[1] = rule->code;
+      memcpy(coap + 2, iphc_ptr + 1, 2 + rule->token_len);
+      memcpy(coap + 4 + rule->token_len, rule->options, rule->options_len);
+      iphc_ptr += 3 + rule->token_len;
+    }
+#endif /* SICSLOWPAN_COAP_RULES > 0 */
+
     /* length field in UDP header (8 byte header + payload) */
-    udp_len = 8 + packetbuf_datalen() - (iphc_ptr - packetbuf_ptr);
+    udp_len = 8 + coap_len + packetbuf_datalen() - (iphc_ptr - packetbuf_ptr);
     udp_buf->udplen = UIP_HTONS(ip_len == 0 ? udp_len :
                                 ip_len - UIP_IPH_LEN - ext_hdr_len);
     LOG_DBG("uncompression: UDP length: %u (ext: %u) ip_len: %d udp_len: %d\n",
            UIP_HTONS(udp_buf->udplen), ext_hdr_len, ip_len, udp_len);
 
-    uncomp_hdr_len += UIP_UDPH_LEN;
+    uncomp_hdr_len += UIP_UDPH_LEN + coap_len;
   }
 
   packetbuf_hdr_len = iphc_ptr - packetbuf_ptr;
@@ -1618,6 +2042,14 @@ static uint8_t
 output(const linkaddr_t *localdest)
 {
   int frag_needed;
+#if SICSLOWPAN_CONF_FRAG
+  /* The size of the whole datagram, which uip_buf may only be the start of */
+  uint16_t datagram_size = uip_len;
+#endif /* SICSLOWPAN_CONF_FRAG */
+#if SICSLOWPAN_FRAG_FORWARDING
+  struct sicslowpan_vrb *vrb = NULL;
+  int shift = 0;
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 
   /* The MAC address of the destination of the packet */
   linkaddr_t dest;
@@ -1673,6 +2105,23 @@ output(const linkaddr_t *localdest)
     return 0;
   }
 
+#if SICSLOWPAN_FRAG_FORWARDING
+  if(vrb_pending != NULL
+     && uipbuf_is_attr_flag(UIPBUF_ATTR_FLAGS_6LOWPAN_FIRST_FRAGMENT)
+     && uip_ipaddr_cmp(&UIP_IP_BUF->srcipaddr, &vrb_pending_src)) {
+    /* uip_buf holds the first fragment of a datagram we forward. Headers
+     * may have changed size, which shifts all subsequent fragments. */
+    vrb = vrb_pending;
+    shift = (int)uip_len - (int)vrb_pending_len;
+    if(shift % 8 != 0 || shift / 8 < INT8_MIN || shift / 8 > INT8_MAX) {
+      LOG_WARN("output: cannot forward fragments, header size changed by %d\n", shift);
+      return 0;
+    }
+    datagram_size = vrb->in_size + shift;
+    uipbuf_set_len_field(UIP_IP_BUF, datagram_size - UIP_IPH_LEN);
+  }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
   /* Try to compress the headers */
 #if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6
   compress_hdr_ipv6(&dest);
@@ -1699,6 +2148,10 @@ output(const linkaddr_t *localdest)
   packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &dest);
 
   frag_needed = (int)uip_len - (int)uncomp_hdr_len + (int)packetbuf_hdr_len > mac_max_payload;
+#if SICSLOWPAN_FRAG_FORWARDING
+  /* A forwarded first fragment is sent as fragment(s) in any case */
+  frag_needed = frag_needed || vrb != NULL;
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
   LOG_INFO("output: header len %d -> %d, total len %d -> %d, MAC max payload %d, frag_needed %d\n",
             uncomp_hdr_len, packetbuf_hdr_len,
             uip_len, uip_len - uncomp_hdr_len + packetbuf_hdr_len,
@@ -1723,6 +2176,16 @@ output(const linkaddr_t *localdest)
     int total_payload = (uip_len - uncomp_hdr_len);
     /* IPv6 payload that goes to first fragment */
     int frag1_payload = (mac_max_payload - packetbuf_hdr_len - SICSLOWPAN_FRAG1_HDR_LEN) & 0xfffffff8;
+#if SICSLOWPAN_COAP_RULES > 0
+    /* An elided CoAP header leaves the uncompressed header length unaligned,
+       but the FRAGN offsets must stay multiples of 8 */
+    frag1_payload = ((mac_max_payload - packetbuf_hdr_len - SICSLOWPAN_FRAG1_HDR_LEN
+                      + uncomp_hdr_len) & 0xfffffff8) - uncomp_hdr_len;
+#endif /* SICSLOWPAN_COAP_RULES > 0 */
+#if SICSLOWPAN_FRAG_FORWARDING
+    /* A forwarded first fragment may be shorter than what fits in a frame */
+    frag1_payload = MIN(frag1_payload, total_payload);
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
     /* max IPv6 payload in each FRAGN. Must be multiple of 8 bytes */
     int fragn_max_payload = (mac_max_payload - SICSLOWPAN_FRAGN_HDR_LEN) & 0xfffffff8;
     /* max IPv6 payload in the last fragment. Needs not be multiple of 8 bytes */
@@ -1764,7 +2227,7 @@ output(const linkaddr_t *localdest)
 
     /* Set FRAG1 header */
     SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
-          ((SICSLOWPAN_DISPATCH_FRAG1 << 8) | uip_len));
+          ((SICSLOWPAN_DISPATCH_FRAG1 << 8) | datagram_size));
     SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, frag_tag);
 
     /* Set frag1 payload len. Was already caulcated earlier as frag1_payload */
@@ -1784,7 +2247,7 @@ output(const linkaddr_t *localdest)
     /* FRAGN header: tag was already set at FRAG1. Now set dispatch for all FRAGN */
     packetbuf_hdr_len = SICSLOWPAN_FRAGN_HDR_LEN;
     SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
-          ((SICSLOWPAN_DISPATCH_FRAGN << 8) | uip_len));
+          ((SICSLOWPAN_DISPATCH_FRAGN << 8) | datagram_size));
 
     /* Keep track of the total length of data sent */
     processed_ip_out_len = uncomp_hdr_len + packetbuf_payload_len;
@@ -1815,6 +2278,17 @@ output(const linkaddr_t *localdest)
 
       processed_ip_out_len += packetbuf_payload_len;
     }
+
+#if SICSLOWPAN_FRAG_FORWARDING
+    if(vrb != NULL) {
+      /* Subsequent fragments will be switched directly to the next hop */
+      linkaddr_copy(&vrb->out_receiver, &dest);
+      vrb->out_tag = frag_tag;
+      vrb->out_size = datagram_size;
+      vrb->offset_shift = shift / 8;
+      vrb->established = 1;
+    }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 #else /* SICSLOWPAN_CONF_FRAG */
     LOG_ERR("output: Packet too large to be sent without fragmentation support; dropping packet\n");
     return 0;
@@ -1869,6 +2343,9 @@ input(void)
   uint16_t frag_tag = 0;
   uint8_t first_fragment = 0, last_fragment = 0;
 #endif /*SICSLOWPAN_CONF_FRAG*/
+#if SICSLOWPAN_FRAG_FORWARDING
+  uint8_t forward_fragments = 0;
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 
   /* Update link statistics */
   link_stats_input_callback(packetbuf_addr(PACKETBUF_ADDR_SENDER));
@@ -1938,6 +2415,13 @@ input(void)
       frag_size = GET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE) & 0x07ff;
       packetbuf_hdr_len += SICSLOWPAN_FRAGN_HDR_LEN;
 
+#if SICSLOWPAN_FRAG_FORWARDING
+      /* Fragments of a datagram we forward are sent on right away */
+      if(vrb_forward_fragn(frag_tag, frag_offset)) {
+        return;
+      }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
+
       /* Add the fragment to the fragmentation context (this will also
          copy the payload) */
       frag_context = add_fragment(frag_tag, frag_size, frag_offset);
@@ -2061,6 +2545,10 @@ input(void)
     if(first_fragment != 0) {
       frag_info[frag_context].reassembled_len = uncomp_hdr_len + packetbuf_payload_len;
       frag_info[frag_context].first_frag_len = uncomp_hdr_len + packetbuf_payload_len;
+#if SICSLOWPAN_FRAG_FORWARDING
+      /* Pass the first fragment alone to the IP layer if it is to be forwarded */
+      forward_fragments = vrb_start(frag_context, frag_tag, frag_size);
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
     }
     /* For the last fragment, we are OK if there is extrenous bytes at
        the end of the packet. */
@@ -2077,7 +2565,11 @@ input(void)
    * If we have a full IP packet in sicslowpan_buf, deliver it to
    * the IP stack
    */
+#if SICSLOWPAN_FRAG_FORWARDING
+  if(!is_fragment || last_fragment || forward_fragments) {
+#else /* SICSLOWPAN_FRAG_FORWARDING */
   if(!is_fragment || last_fragment) {
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
     /* packet is in uip already - just set length */
     if(is_fragment != 0 && last_fragment != 0) {
       uip_len = frag_size;
@@ -2120,6 +2612,11 @@ input(void)
 #endif /*  LLSEC802154_USES_AUX_HEADER */
 
     tcpip_input();
+#if SICSLOWPAN_FRAG_FORWARDING
+    if(forward_fragments) {
+      vrb_end();
+    }
+#endif /* SICSLOWPAN_FRAG_FORWARDING */
 #if SICSLOWPAN_CONF_FRAG
   }
 #endif /* SICSLOWPAN_CONF_FRAG */
@@ -2175,6 +2672,17 @@ sicslowpan_init(void)
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 1 */
 
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 && UIP_ND6_RA_6CO
+  {
+    int i;
+    /* Preconfigured contexts are permanent and used for compression */
+    for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+      addr_contexts[i].compress = addr_contexts[i].used;
+      addr_contexts[i].isinfinite = addr_contexts[i].used;
+    }
+  }
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 && UIP_ND6_RA_6CO */
+
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPHC */
 }
 /*--------------------------------------------------------------------*/
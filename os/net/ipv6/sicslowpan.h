@@ -50,6 +50,7 @@
 #define SICSLOWPAN_H_
 
 #include "net/ipv6/uip.h"
+#include "net/ipv6/uip-nd6.h"
 #include "net/mac/mac.h"
 
 /**
@@ -179,6 +180,10 @@
 #define SICSLOWPAN_NHC_UDP_CS_P_01  0xF1 /* source 16bit inline, dest = 0xF0 + 8 bit inline */
 #define SICSLOWPAN_NHC_UDP_CS_P_10  0xF2 /* source = 0xF0 + 8bit inline, dest = 16 bit inline */
 #define SICSLOWPAN_NHC_UDP_CS_P_11  0xF3 /* source & dest = 0xF0B + 4bit inline */
+/* Non-standard: UDP NHC followed by a CoAP header compressed with a rule.
+ * 0xF8-0xFF is unassigned in the IANA LOWPAN_NHC registry, other 6LoWPAN
+ * stacks reject such packets. See SICSLOWPAN_CONF_COAP_RULES. */
+#define SICSLOWPAN_NHC_UDP_COAP_ID                  0xF8
 /** @} */
 
 
@@ -240,8 +245,95 @@ struct sicslowpan_addr_context {
   uint8_t used; /* possibly use as prefix-length */
   uint8_t number;
   uint8_t prefix[8];
+#if UIP_ND6_RA_6CO
+  uint8_t compress; /* 0: valid for decompression only (RFC 6775 C flag) */
+  uint8_t isinfinite;
+  struct stimer lifetime;
+#endif /* UIP_ND6_RA_6CO */
 };
 
+#if UIP_ND6_RA_6CO
+/**
+ * \brief Add, update or remove an address context at runtime, e.g.
+ * from a 6LoWPAN Context Option (RFC 6775) received in an RA.
+ *
+ * Every node that decompresses must know the context, including the
+ * routers that forward packets in a mesh. Routers learn contexts from the
+ * RAs of their default router (their RPL parent) and advertise them in
+ * their own RAs, so runtime contexts reach a multihop network only when
+ * its routers send RAs (UIP_CONF_ND6_SEND_RA, off by default with RPL).
+ * Otherwise, keep them to single-hop networks. A new context should be distributed with compress
+ * cleared first, and only set to compress once it reached every node.
+ *
+ * \param number The context identifier (0-15)
+ * \param prefix The 64-bit context prefix
+ * \param compress Whether the context may be used for compression
+ * \param lifetime The lifetime in seconds, 0 removes the context and
+ * 0xffffffff makes it permanent
+ * \return 1 on success, 0 if the context table is full
+ */
+int sicslowpan_context_update(uint8_t number, const uint8_t *prefix,
+                              uint8_t compress, uint32_t lifetime);
+
+/**
+ * \brief Get an address context by table index, used to advertise
+ * the contexts in RAs.
+ * \param index The index in the context table
+ * \return The context, or NULL if the slot is unused or out of range
+ */
+struct sicslowpan_addr_context *sicslowpan_context_get(uint8_t index);
+#endif /* UIP_ND6_RA_6CO */
+
+/**
+ * \brief The number of CoAP header compression rules.
+ *
+ * Rule-compressed CoAP headers use a UDP NHC encoding of this
+ * implementation (SICSLOWPAN_NHC_UDP_COAP_ID), not a standard one: only
+ * enable rules on networks where every node runs this stack with the same
+ * rules installed.
+ */
+#ifdef SICSLOWPAN_CONF_COAP_RULES
+#define SICSLOWPAN_COAP_RULES SICSLOWPAN_CONF_COAP_RULES
+#else
+#define SICSLOWPAN_COAP_RULES 0
+#endif
+
+/** \brief The maximum length of the elided CoAP options of a rule */
+#ifdef SICSLOWPAN_CONF_COAP_RULE_OPTIONS_MAX
+#define SICSLOWPAN_COAP_RULE_OPTIONS_MAX SICSLOWPAN_CONF_COAP_RULE_OPTIONS_MAX
+#else
+#define SICSLOWPAN_COAP_RULE_OPTIONS_MAX 16
+#endif
+
+/**
+ * \brief A CoAP header compression rule for a known flow.
+ *
+ * A CoAP message to or from the rule's UDP port whose type, code,
+ * token length and encoded options (including the 0xFF payload marker,
+ * if any) are identical to the rule is sent with only the rule id,
+ * message ID and token inline. Both ends must hold the same rules;
+ * this is SCHC-like (RFC 8724 in spirit) but not interoperable with it.
+ */
+struct sicslowpan_coap_rule {
+  uint16_t port;  /* 0: unused slot */
+  uint8_t id;
+  uint8_t type;
+  uint8_t code;
+  uint8_t token_len;
+  uint8_t options_len;
+  uint8_t options[SICSLOWPAN_COAP_RULE_OPTIONS_MAX];
+};
+
+/**
+ * \brief Install a CoAP compression rule, replacing any rule with the
+ * same id.
+ * \return 1 on success, 0 if the rule is invalid or the table is full
+ */
+int sicslowpan_coap_rule_add(const struct sicslowpan_coap_rule *rule);
+
+/** \brief Remove the CoAP compression rule with the given id */
+void sicslowpan_coap_rule_remove(uint8_t id);
+
 /**
  * \name Address compressibility test functions
  * @{
@@ -139,6 +139,18 @@ relisten(struct tcp_socket *s)
 }
 /*---------------------------------------------------------------------------*/
 static void
+disconnected(struct tcp_socket *s)
+{
+  /* Data that was not sent is lost with the connection */
+  if(s != NULL) {
+    s->c = NULL;
+    s->output_data_len = 0;
+    s->output_senddata_len = 0;
+    s->output_data_send_nxt = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
 appcall(void *state)
 {
   struct tcp_socket *s = state;
@@ -163,6 +175,7 @@ appcall(void *state)
 	   s->listen_port == uip_htons(uip_conn->lport)) {
 	  s->flags &= ~TCP_SOCKET_FLAGS_LISTENING;
           s->output_data_max_seg = uip_mss();
+	  s->c = uip_conn;
 	  tcp_markconn(uip_conn, s);
 	  call_event(s, TCP_SOCKET_CONNECTED);
 	  break;
@@ -185,12 +198,14 @@ appcall(void *state)
   }
 
   if(uip_timedout()) {
+    disconnected(s);
     call_event(s, TCP_SOCKET_TIMEDOUT);
     relisten(s);
   }
 
   if(uip_aborted()) {
     tcp_markconn(uip_conn, NULL);
+    disconnected(s);
     call_event(s, TCP_SOCKET_ABORTED);
     relisten(s);
 
@@ -228,7 +243,7 @@ appcall(void *state)
 
   if(uip_closed()) {
     tcp_markconn(uip_conn, NULL);
-    s->c = NULL;
+    disconnected(s);
     call_event(s, TCP_SOCKET_CLOSED);
     relisten(s);
   }
@@ -490,6 +490,20 @@ annotate_transmission(const uip_ipaddr_t *nexthop)
 #endif /* TCPIP_CONF_ANNOTATE_TRANSMISSIONS */
 }
 /*---------------------------------------------------------------------------*/
+/* Checks whether uip_buf holds only the first fragment of a datagram that
+ * 6LoWPAN forwards without reassembling it. Such a packet cannot be looped
+ * back, queued or sent on the fallback interface: we drop it, and 6LoWPAN
+ * reassembles the datagram instead. */
+static bool
+is_first_fragment(void)
+{
+  if(uipbuf_is_attr_flag(UIPBUF_ATTR_FLAGS_6LOWPAN_FIRST_FRAGMENT)) {
+    LOG_INFO("output: not forwarding first fragment, leaving datagram to reassembly\n");
+    return true;
+  }
+  return false;
+}
+/*---------------------------------------------------------------------------*/
 static const uip_ipaddr_t*
 get_nexthop(uip_ipaddr_t *addr)
 {
@@ -517,6 +531,17 @@ get_nexthop(uip_ipaddr_t *addr)
     return &UIP_IP_BUF->destipaddr;
   }
 
+#if UIP_ND6_REGISTRATION
+  /* Addresses registered with us are reachable on link (RFC 6775) */
+  {
+    uip_ds6_nbr_t *nbr = uip_ds6_nbr_lookup(&UIP_IP_BUF->destipaddr);
+    if(nbr != NULL && nbr->state == NBR_REGISTERED) {
+      LOG_INFO("output: destination is registered with us\n");
+      return &UIP_IP_BUF->destipaddr;
+    }
+  }
+#endif /* UIP_ND6_REGISTRATION */
+
   /* Check if we have a route to the destination address. */
   route = uip_ds6_route_lookup(&UIP_IP_BUF->destipaddr);
 
@@ -524,7 +549,9 @@ get_nexthop(uip_ipaddr_t *addr)
   if(route == NULL) {
     nexthop = uip_ds6_defrt_choose();
     if(nexthop == NULL) {
-      output_fallback();
+      if(!is_first_fragment()) {
+        output_fallback();
+      }
     } else {
       LOG_INFO("output: no route found, using default route: ");
       LOG_INFO_6ADDR(nexthop);
@@ -666,6 +693,9 @@ tcpip_ipv6_output(void)
    * loopback interface -- instead, process this directly as incoming. */
   if(uip_ds6_is_my_addr(&UIP_IP_BUF->destipaddr)) {
     LOG_INFO("output: sending to ourself\n");
+    if(is_first_fragment()) {
+      goto exit;
+    }
     packet_input();
     return;
   }
@@ -699,6 +729,9 @@ tcpip_ipv6_output(void)
 #endif /* UIP_ND6_AUTOFILL_NBR_CACHE */
 
   if(nbr == NULL) {
+    if(is_first_fragment()) {
+      goto exit;
+    }
     if(send_nd6_ns(nexthop)) {
       LOG_ERR("output: failed to add neighbor to cache\n");
       goto exit;
@@ -711,6 +744,9 @@ tcpip_ipv6_output(void)
 #if UIP_ND6_SEND_NS
   if(nbr->state == NBR_INCOMPLETE) {
     LOG_ERR("output: nbr cache entry incomplete\n");
+    if(is_first_fragment()) {
+      goto exit;
+    }
     queue_packet(nbr);
     goto exit;
   }
@@ -66,6 +66,7 @@
 #define  NBR_STALE 2
 #define  NBR_DELAY 3
 #define  NBR_PROBE 4
+#define  NBR_REGISTERED 5 /* RFC 6775, not subject to NUD */
 
 /** \brief Set non-zero (1) to enable multiple IPv6 addresses to be
  * associated with a link-layer address */
@@ -115,6 +116,11 @@ typedef struct uip_ds6_nbr {
   struct stimer sendns;
   uint8_t nscount;
 #endif /* UIP_ND6_SEND_NS || UIP_ND6_SEND_RA */
+#if UIP_ND6_REGISTRATION
+  struct stimer reglifetime;
+  uint8_t regtid;
+  uint8_t regpending; /* Waiting for the DAC of the 6LBR */
+#endif /* UIP_ND6_REGISTRATION */
 #if UIP_CONF_IPV6_QUEUE_PKT
   struct uip_packetqueue_handle packethandle;
 #define UIP_DS6_NBR_PACKET_LIFETIME CLOCK_SECOND * 4
@@ -52,7 +52,14 @@
 #else /* UIP_CONF_MAX_ROUTES */
 
 #if ROUTING_CONF_RPL_LITE
+
+#include "net/routing/rpl-lite/rpl-conf.h"
+#if RPL_WITH_PROJECTED_ROUTES
+#define UIP_MAX_ROUTES RPL_PROJECTED_ROUTES_NUM /* Routes installed by P-DAOs */
+#else /* RPL_WITH_PROJECTED_ROUTES */
 #define UIP_MAX_ROUTES 0 /* RPL Lite only supports non-storing, no routes */
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
 #elif ROUTING_CONF_RPL_CLASSIC
 
 #include "net/routing/rpl-classic/rpl-conf.h"
@@ -220,6 +220,10 @@ uip_ds6_periodic(void)
   uip_ds6_neighbor_periodic();
 #endif /* UIP_ND6_SEND_NS */
 
+#if UIP_ND6_REGISTRATION
+  uip_nd6_reg_periodic();
+#endif /* UIP_ND6_REGISTRATION */
+
 #if UIP_CONF_ROUTER && UIP_ND6_SEND_RA
   /* Periodic RA sending */
   if(stimer_expired(&uip_ds6_timer_ra) && (uip_len == 0)) {
@@ -381,6 +385,10 @@ uip_ds6_addr_add(uip_ipaddr_t *ipaddr, unsigned long vlifetime, uint8_t type)
 #else /* UIP_ND6_DEF_MAXDADNS > 0 */
     locaddr->state = ADDR_PREFERRED;
 #endif /* UIP_ND6_DEF_MAXDADNS > 0 */
+#if UIP_ND6_REGISTRATION
+    locaddr->regstate = ADDR_REG_NONE;
+    uip_create_unspecified(&locaddr->regrouter);
+#endif /* UIP_ND6_REGISTRATION */
     uip_create_solicited_node(ipaddr, &loc_fipaddr);
     uip_ds6_maddr_add(&loc_fipaddr);
     return locaddr;
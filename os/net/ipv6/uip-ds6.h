@@ -157,6 +157,11 @@
 #define ADDR_PREFERRED 1
 #define ADDR_DEPRECATED 2
 
+/** \brief Possible registration states of an address (RFC 6775) */
+#define ADDR_REG_NONE 0
+#define ADDR_REG_PENDING 1
+#define ADDR_REG_DONE 2
+
 /** \brief How the address was acquired: Autoconf, DHCP or manually */
 #define  ADDR_ANYTYPE 0
 #define  ADDR_AUTOCONF 1
@@ -213,6 +218,12 @@ typedef struct uip_ds6_addr {
   struct timer dadtimer;
   uint8_t dadnscount;
 #endif /* UIP_ND6_DEF_MAXDADNS > 0 */
+#if UIP_ND6_REGISTRATION
+  uip_ipaddr_t regrouter;
+  struct stimer regtimer;
+  uint8_t regstate;
+  uint8_t regtid;
+#endif /* UIP_ND6_REGISTRATION */
 } uip_ds6_addr_t;
 
 /** \brief Anycast address  */
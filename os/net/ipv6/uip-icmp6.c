@@ -194,6 +194,9 @@ uip_icmp6_error_output(uint8_t type, uint8_t code, uint32_t param)
   UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
   UIP_IP_BUF->ttl = uip_ds6_if.cur_hop_limit;
 
+  /* The error is a packet of its own, even if caused by a fragment */
+  uipbuf_clr_attr_flag(UIPBUF_ATTR_FLAGS_6LOWPAN_FIRST_FRAGMENT);
+
   uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, &UIP_IP_BUF->srcipaddr);
 
   if(uip_is_addr_mcast(&tmp_ipaddr)){
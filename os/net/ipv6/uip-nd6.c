@@ -74,6 +74,12 @@
 #include "net/ipv6/uip-nd6.h"
 #include "net/ipv6/uip-ds6.h"
 #include "net/ipv6/uip-nameserver.h"
+#if UIP_ND6_RA_6CO
+#include "net/ipv6/sicslowpan.h"
+#endif /* UIP_ND6_RA_6CO */
+#if UIP_ND6_REGISTRATION
+#include "net/routing/routing.h"
+#endif /* UIP_ND6_REGISTRATION */
 #include "lib/random.h"
 
 /* Log configuration */
@@ -98,18 +104,27 @@
 #define ND6_OPT_PREFIX_BUF(opt)    ((uip_nd6_opt_prefix_info *)ND6_OPT(opt))
 #define ND6_OPT_MTU_BUF(opt)               ((uip_nd6_opt_mtu *)ND6_OPT(opt))
 #define ND6_OPT_RDNSS_BUF(opt)             ((uip_nd6_opt_dns *)ND6_OPT(opt))
+#define ND6_OPT_6CO_BUF(opt)               ((uip_nd6_opt_6co *)ND6_OPT(opt))
+#define ND6_OPT_ARO_BUF(opt)               ((uip_nd6_opt_aro *)ND6_OPT(opt))
+#define UIP_ND6_DAR_BUF                    ((uip_nd6_dar *)UIP_ICMP_PAYLOAD)
 /** @} */
 
+#if UIP_ND6_REGISTRATION && !UIP_ND6_SEND_NA
+#error "UIP_CONF_ND6_REGISTRATION requires UIP_CONF_ND6_SEND_NA"
+#endif
+
 #if UIP_ND6_SEND_NS || UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
-static uint16_t nd6_opt_offset; /** Offset from the end of the icmpv6 header to the option in uip_buf*/
 static uint8_t *nd6_opt_llao;   /**  Pointer to llao option in uip_buf */
 static uip_ds6_nbr_t *nbr; /**  Pointer to a nbr cache entry*/
 static uip_ds6_addr_t *addr; /**  Pointer to an interface address */
 #endif /* UIP_ND6_SEND_NS || UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER */
+#if UIP_ND6_SEND_NS || UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER || UIP_ND6_RA_6CO
+static uint16_t nd6_opt_offset; /** Offset from the end of the icmpv6 header to the option in uip_buf*/
+#endif /* UIP_ND6_SEND_NS || UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER || UIP_ND6_RA_6CO */
 
-#if UIP_ND6_SEND_NS || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
+#if UIP_ND6_SEND_NS || !UIP_CONF_ROUTER
 static uip_ds6_defrt_t *defrt; /**  Pointer to a router list entry */
-#endif /* UIP_ND6_SEND_NS || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER */
+#endif /* UIP_ND6_SEND_NS || !UIP_CONF_ROUTER */
 
 #if !UIP_CONF_ROUTER            // TBD see if we move it to ra_input
 static uip_nd6_opt_prefix_info *nd6_opt_prefix_info; /**  Pointer to prefix information option in uip_buf */
@@ -119,6 +134,13 @@ static uip_ipaddr_t ipaddr;
 static uip_ds6_prefix_t *prefix; /**  Pointer to a prefix list entry */
 #endif
 
+#if UIP_ND6_REGISTRATION
+static uip_nd6_opt_aro *nd6_opt_aro; /**  Pointer to the EARO option in uip_buf */
+#if UIP_CONF_ROUTER
+static uip_nd6_reg_authority_t reg_authority; /**  Set on the 6LBR */
+#endif /* UIP_CONF_ROUTER */
+#endif /* UIP_ND6_REGISTRATION */
+
 #if UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
 /*------------------------------------------------------------------*/
 /* Copy link-layer address from LLAO option to a word-aligned uip_lladdr_t */
@@ -146,6 +168,457 @@ create_llao(uint8_t *llao, uint8_t type)
          UIP_ND6_OPT_LLAO_LEN - 2 - UIP_LLADDR_LEN);
 }
 #endif /* UIP_ND6_SEND_NA */
+#if UIP_ND6_REGISTRATION
+/*------------------------------------------------------------------*/
+/* The owner of a registration (ROVR) is identified by its link-layer
+   address, padded to 64 bits */
+static void
+create_rovr(uint8_t *rovr, const uip_lladdr_t *lladdr)
+{
+  memset(rovr, 0, 8);
+  memcpy(rovr, lladdr, MIN(UIP_LLADDR_LEN, 8));
+}
+/*------------------------------------------------------------------*/
+static void
+create_aro(uint8_t *buf, uint8_t status, uint8_t tid, uint16_t lifetime,
+           const uint8_t *rovr)
+{
+  uip_nd6_opt_aro *aro = (uip_nd6_opt_aro *)buf;
+
+  aro->type = UIP_ND6_OPT_ARO;
+  aro->len = UIP_ND6_OPT_ARO_LEN >> 3;
+  aro->status = status;
+  aro->opaque = 0;
+  aro->flags = UIP_ND6_ARO_FLAG_R | UIP_ND6_ARO_FLAG_T;
+  aro->tid = tid;
+  aro->lifetime = uip_htons(lifetime);
+  memcpy(aro->rovr, rovr, sizeof(aro->rovr));
+}
+/*------------------------------------------------------------------*/
+/* Registration of one of our addresses: unicast NS with SLLAO and EARO */
+static void
+reg_ns_output(const uip_ipaddr_t *router, const uip_ds6_addr_t *locaddr)
+{
+  uint8_t rovr[8];
+
+  uipbuf_clear();
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->tcflow = 0;
+  UIP_IP_BUF->flow = 0;
+  UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
+  UIP_IP_BUF->ttl = UIP_ND6_HOP_LIMIT;
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, router);
+  uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+  if(uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+    uipbuf_clear();
+    return;
+  }
+
+  UIP_ICMP_BUF->type = ICMP6_NS;
+  UIP_ICMP_BUF->icode = 0;
+  UIP_ND6_NS_BUF->reserved = 0;
+  uip_ipaddr_copy(&UIP_ND6_NS_BUF->tgtipaddr, &locaddr->ipaddr);
+  create_llao(&uip_buf[uip_l3_icmp_hdr_len + UIP_ND6_NS_LEN],
+              UIP_ND6_OPT_SLLAO);
+  create_rovr(rovr, &uip_lladdr);
+  create_aro(&uip_buf[uip_l3_icmp_hdr_len + UIP_ND6_NS_LEN +
+                      UIP_ND6_OPT_LLAO_LEN],
+             UIP_ND6_REG_STATUS_SUCCESS, locaddr->regtid,
+             UIP_ND6_REGISTRATION_LIFETIME, rovr);
+
+  uipbuf_set_len_field(UIP_IP_BUF, UIP_ICMPH_LEN + UIP_ND6_NS_LEN +
+                       UIP_ND6_OPT_LLAO_LEN + UIP_ND6_OPT_ARO_LEN);
+  uip_len = UIP_IPH_LEN + UIP_ICMPH_LEN + UIP_ND6_NS_LEN +
+    UIP_ND6_OPT_LLAO_LEN + UIP_ND6_OPT_ARO_LEN;
+
+  UIP_ICMP_BUF->icmpchksum = 0;
+  UIP_ICMP_BUF->icmpchksum = ~uip_icmp6chksum();
+
+  UIP_STAT(++uip_stat.nd6.sent);
+  LOG_INFO("Sending NS with EARO to ");
+  LOG_INFO_6ADDR(&UIP_IP_BUF->destipaddr);
+  LOG_INFO_(" registering ");
+  LOG_INFO_6ADDR(&locaddr->ipaddr);
+  LOG_INFO_(" tid %u\n", locaddr->regtid);
+}
+/*------------------------------------------------------------------*/
+/* Processes the EARO of a NA, if any, in reply to one of our
+   registrations. Only replies from the router we registered with are
+   accepted. Returns 1 if the NA carried an EARO and was consumed */
+static int
+reg_na_input(void)
+{
+  uip_ds6_addr_t *locaddr;
+  uint16_t lifetime;
+
+  nd6_opt_aro = NULL;
+  for(nd6_opt_offset = UIP_ND6_NA_LEN;
+      uip_l3_icmp_hdr_len + nd6_opt_offset + UIP_ND6_OPT_HDR_LEN < uip_len;
+      nd6_opt_offset += ND6_OPT_HDR_BUF(nd6_opt_offset)->len << 3) {
+    if(ND6_OPT_HDR_BUF(nd6_opt_offset)->len == 0) {
+      return 0;
+    }
+    if(ND6_OPT_HDR_BUF(nd6_opt_offset)->type == UIP_ND6_OPT_ARO &&
+       uip_l3_icmp_hdr_len + nd6_opt_offset + UIP_ND6_OPT_ARO_LEN <= uip_len) {
+      nd6_opt_aro = ND6_OPT_ARO_BUF(nd6_opt_offset);
+    }
+  }
+  if(nd6_opt_aro == NULL) {
+    return 0;
+  }
+
+  /* Checked regardless of UIP_CONF_IPV6_CHECKS, a forged reply could
+     remove our address */
+  if(UIP_IP_BUF->ttl != UIP_ND6_HOP_LIMIT || UIP_ICMP_BUF->icode != 0) {
+    LOG_ERR("NA received is bad\n");
+    return 1;
+  }
+
+  locaddr = uip_ds6_addr_lookup(&UIP_ND6_NA_BUF->tgtipaddr);
+  if(locaddr == NULL || locaddr->regstate != ADDR_REG_PENDING ||
+     nd6_opt_aro->tid != locaddr->regtid ||
+     !uip_ipaddr_cmp(&UIP_IP_BUF->srcipaddr, &locaddr->regrouter)) {
+    LOG_WARN("Unexpected registration reply\n");
+    return 1;
+  }
+
+  switch(nd6_opt_aro->status) {
+  case UIP_ND6_REG_STATUS_SUCCESS:
+    lifetime = uip_ntohs(nd6_opt_aro->lifetime);
+    locaddr->regstate = ADDR_REG_DONE;
+    /* Refresh at three quarters of the granted lifetime */
+    stimer_set(&locaddr->regtimer, (unsigned long)MAX(lifetime, 1) * 45);
+    LOG_INFO("Registered ");
+    LOG_INFO_6ADDR(&locaddr->ipaddr);
+    LOG_INFO_(" for %u min\n", lifetime);
+    break;
+  case UIP_ND6_REG_STATUS_DUPLICATE:
+    LOG_ERR("Registration failed, duplicate address ");
+    LOG_ERR_6ADDR(&locaddr->ipaddr);
+    LOG_ERR_("\n");
+    if(!uip_is_addr_linklocal(&locaddr->ipaddr)) {
+      uip_ds6_addr_rm(locaddr);
+    }
+    break;
+  default:
+    /* Retried when regtimer expires */
+    LOG_WARN("Registration refused, status %u\n", nd6_opt_aro->status);
+    break;
+  }
+  return 1;
+}
+/*------------------------------------------------------------------*/
+void
+uip_nd6_reg_periodic(void)
+{
+  uip_ds6_addr_t *locaddr;
+  const uip_ipaddr_t *router;
+#if UIP_CONF_ROUTER
+  uip_ds6_nbr_t *n;
+  uip_ds6_nbr_t *next;
+
+  /* Registered neighbors are kept until their registration expires */
+  for(n = uip_ds6_nbr_head(); n != NULL; n = next) {
+    next = uip_ds6_nbr_next(n);
+    if(n->state == NBR_REGISTERED && stimer_expired(&n->reglifetime)) {
+      LOG_INFO("Registration of ");
+      LOG_INFO_6ADDR(&n->ipaddr);
+      LOG_INFO_(" expired\n");
+      uip_ds6_nbr_rm(n);
+    }
+  }
+#endif /* UIP_CONF_ROUTER */
+
+  router = uip_ds6_defrt_choose();
+  if(router == NULL || uip_len != 0) {
+    return;
+  }
+  for(locaddr = uip_ds6_if.addr_list;
+      locaddr < uip_ds6_if.addr_list + UIP_DS6_ADDR_NB; locaddr++) {
+    if(!locaddr->isused || locaddr->state != ADDR_PREFERRED) {
+      continue;
+    }
+    if(!uip_ipaddr_cmp(&locaddr->regrouter, router)) {
+      /* New default router, register with it */
+      uip_ipaddr_copy(&locaddr->regrouter, router);
+      locaddr->regstate = ADDR_REG_NONE;
+    }
+    if(locaddr->regstate == ADDR_REG_NONE ||
+       stimer_expired(&locaddr->regtimer)) {
+      locaddr->regstate = ADDR_REG_PENDING;
+      locaddr->regtid++;
+      stimer_set(&locaddr->regtimer, UIP_ND6_REGISTRATION_RETRANS);
+      reg_ns_output(router, locaddr);
+      /* One registration per period, uip_buf now holds the NS */
+      return;
+    }
+  }
+}
+#if UIP_CONF_ROUTER
+/*------------------------------------------------------------------*/
+void
+uip_nd6_reg_set_authority(uip_nd6_reg_authority_t authority)
+{
+  reg_authority = authority;
+}
+/*------------------------------------------------------------------*/
+/* NA with EARO in reply to a registration */
+static void
+reg_na_output(const uip_ipaddr_t *dest, const uip_ipaddr_t *target,
+              uint8_t status, uint8_t tid, uint16_t lifetime,
+              const uint8_t *rovr)
+{
+  uipbuf_clear();
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->tcflow = 0;
+  UIP_IP_BUF->flow = 0;
+  UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
+  UIP_IP_BUF->ttl = UIP_ND6_HOP_LIMIT;
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, dest);
+  uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+
+  UIP_ICMP_BUF->type = ICMP6_NA;
+  UIP_ICMP_BUF->icode = 0;
+  UIP_ND6_NA_BUF->flagsreserved =
+    UIP_ND6_NA_FLAG_SOLICITED | UIP_ND6_NA_FLAG_ROUTER;
+  memset(UIP_ND6_NA_BUF->reserved, 0, sizeof(UIP_ND6_NA_BUF->reserved));
+  uip_ipaddr_copy(&UIP_ND6_NA_BUF->tgtipaddr, target);
+  create_aro(&uip_buf[uip_l3_icmp_hdr_len + UIP_ND6_NA_LEN],
+             status, tid, lifetime, rovr);
+
+  uipbuf_set_len_field(UIP_IP_BUF,
+                       UIP_ICMPH_LEN + UIP_ND6_NA_LEN + UIP_ND6_OPT_ARO_LEN);
+  uip_len = UIP_IPH_LEN + UIP_ICMPH_LEN + UIP_ND6_NA_LEN + UIP_ND6_OPT_ARO_LEN;
+
+  UIP_ICMP_BUF->icmpchksum = 0;
+  UIP_ICMP_BUF->icmpchksum = ~uip_icmp6chksum();
+
+  UIP_STAT(++uip_stat.nd6.sent);
+  LOG_INFO("Sending NA with EARO status %u to ", status);
+  LOG_INFO_6ADDR(dest);
+  LOG_INFO_(" for ");
+  LOG_INFO_6ADDR(target);
+  LOG_INFO_("\n");
+}
+/*------------------------------------------------------------------*/
+/* Duplicate Address Request (to the 6LBR) or Confirmation (from it) */
+static void
+dar_output(uint8_t type, const uip_ipaddr_t *dest, uint8_t status,
+           uint8_t tid, uint16_t lifetime, const uint8_t *rovr,
+           const uip_ipaddr_t *regipaddr)
+{
+  uipbuf_clear();
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->tcflow = 0;
+  UIP_IP_BUF->flow = 0;
+  UIP_IP_BUF->proto = UIP_PROTO_ICMP6;
+  UIP_IP_BUF->ttl = UIP_ND6_MULTIHOP_HOPLIMIT;
+  uip_ipaddr_copy(&UIP_IP_BUF->destipaddr, dest);
+  uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+
+  UIP_ICMP_BUF->type = type;
+  UIP_ICMP_BUF->icode = 0;
+  UIP_ND6_DAR_BUF->status = status;
+  UIP_ND6_DAR_BUF->tid = tid;
+  UIP_ND6_DAR_BUF->lifetime = uip_htons(lifetime);
+  memcpy(UIP_ND6_DAR_BUF->rovr, rovr, sizeof(UIP_ND6_DAR_BUF->rovr));
+  uip_ipaddr_copy(&UIP_ND6_DAR_BUF->regipaddr, regipaddr);
+
+  uipbuf_set_len_field(UIP_IP_BUF, UIP_ICMPH_LEN + UIP_ND6_DAR_LEN);
+  uip_len = UIP_IPH_LEN + UIP_ICMPH_LEN + UIP_ND6_DAR_LEN;
+
+  UIP_ICMP_BUF->icmpchksum = 0;
+  UIP_ICMP_BUF->icmpchksum = ~uip_icmp6chksum();
+
+  UIP_STAT(++uip_stat.nd6.sent);
+  LOG_INFO("Sending %s to ", type == ICMP6_DAR ? "DAR" : "DAC");
+  LOG_INFO_6ADDR(dest);
+  LOG_INFO_(" for ");
+  LOG_INFO_6ADDR(regipaddr);
+  LOG_INFO_(" status %u\n", status);
+}
+/*------------------------------------------------------------------*/
+/* Registers the target of the current NS in the neighbor cache */
+static uint8_t
+reg_update_nbr(const uip_ipaddr_t *target, const uip_lladdr_t *lladdr,
+               uint8_t tid, uint16_t lifetime)
+{
+  uip_ds6_nbr_t *n;
+  const uip_lladdr_t *current;
+
+  n = uip_ds6_nbr_lookup(target);
+  if(n != NULL) {
+    current = uip_ds6_nbr_get_ll(n);
+    if(n->state == NBR_REGISTERED && !stimer_expired(&n->reglifetime) &&
+       current != NULL && memcmp(current, lladdr, UIP_LLADDR_LEN) != 0) {
+      return UIP_ND6_REG_STATUS_DUPLICATE;
+    }
+    if(lifetime == 0) {
+      uip_ds6_nbr_rm(n);
+      return UIP_ND6_REG_STATUS_SUCCESS;
+    }
+    if(current == NULL || memcmp(current, lladdr, UIP_LLADDR_LEN) != 0) {
+      if(uip_ds6_nbr_update_ll(&n, lladdr) < 0) {
+        return UIP_ND6_REG_STATUS_CACHE_FULL;
+      }
+    }
+  } else {
+    if(lifetime == 0) {
+      return UIP_ND6_REG_STATUS_SUCCESS;
+    }
+    n = uip_ds6_nbr_add(target, lladdr, 0, NBR_REGISTERED,
+                        NBR_TABLE_REASON_IPV6_ND, NULL);
+    if(n == NULL) {
+      return UIP_ND6_REG_STATUS_CACHE_FULL;
+    }
+  }
+  n->state = NBR_REGISTERED;
+  n->regtid = tid;
+  n->regpending = 0;
+  stimer_set(&n->reglifetime, (unsigned long)lifetime * 60);
+  return UIP_ND6_REG_STATUS_SUCCESS;
+}
+/*------------------------------------------------------------------*/
+/* Processes a NS carrying an EARO, as a 6LR. Returns 1 if a reply (NA or
+   DAR) was placed in uip_buf */
+static int
+reg_ns_input(void)
+{
+  uip_ipaddr_t target;
+  uip_ipaddr_t host;
+  uip_ipaddr_t root;
+  uip_lladdr_t lladdr;
+  uint8_t rovr[8];
+  uint8_t tid;
+  uint16_t lifetime;
+  uint8_t status;
+  uip_ds6_nbr_t *n;
+
+  if(nd6_opt_llao == NULL ||
+     uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+    LOG_ERR("NS with EARO received is bad\n");
+    return 0;
+  }
+  extract_lladdr_from_llao_aligned(&lladdr);
+  uip_ipaddr_copy(&target, &UIP_ND6_NS_BUF->tgtipaddr);
+  uip_ipaddr_copy(&host, &UIP_IP_BUF->srcipaddr);
+  memcpy(rovr, nd6_opt_aro->rovr, sizeof(rovr));
+  tid = nd6_opt_aro->tid;
+  lifetime = uip_ntohs(nd6_opt_aro->lifetime);
+
+  status = reg_update_nbr(&target, &lladdr, tid, lifetime);
+  if(status == UIP_ND6_REG_STATUS_SUCCESS &&
+     !uip_is_addr_linklocal(&target)) {
+    /* Global addresses must be unique network-wide: multihop DAD */
+    if(reg_authority != NULL) {
+      status = reg_authority(&target, rovr, lifetime);
+    } else if(NETSTACK_ROUTING.get_root_ipaddr(&root) &&
+              !uip_ds6_is_my_addr(&root)) {
+      n = uip_ds6_nbr_lookup(&target);
+      if(n != NULL) {
+        /* The NA is sent once the DAC is in */
+        n->regpending = 1;
+      }
+      dar_output(ICMP6_DAR, &root, UIP_ND6_REG_STATUS_SUCCESS,
+                 tid, lifetime, rovr, &target);
+      return 1;
+    }
+    if(status != UIP_ND6_REG_STATUS_SUCCESS &&
+       (n = uip_ds6_nbr_lookup(&target)) != NULL) {
+      uip_ds6_nbr_rm(n);
+    }
+  }
+
+  reg_na_output(&host, &target, status, tid, lifetime, rovr);
+  return 1;
+}
+/*------------------------------------------------------------------*/
+static void
+dar_input(void)
+{
+  uip_ipaddr_t sender;
+  uip_ipaddr_t regipaddr;
+  uint8_t rovr[8];
+  uint8_t tid;
+  uint16_t lifetime;
+  uint8_t status;
+
+  if(reg_authority == NULL ||
+     uip_len < uip_l3_icmp_hdr_len + UIP_ND6_DAR_LEN) {
+    goto discard;
+  }
+  UIP_STAT(++uip_stat.nd6.recv);
+  uip_ipaddr_copy(&sender, &UIP_IP_BUF->srcipaddr);
+  uip_ipaddr_copy(&regipaddr, &UIP_ND6_DAR_BUF->regipaddr);
+  memcpy(rovr, UIP_ND6_DAR_BUF->rovr, sizeof(rovr));
+  tid = UIP_ND6_DAR_BUF->tid;
+  lifetime = uip_ntohs(UIP_ND6_DAR_BUF->lifetime);
+
+  status = reg_authority(&regipaddr, rovr, lifetime);
+  LOG_INFO("Received DAR from ");
+  LOG_INFO_6ADDR(&sender);
+  LOG_INFO_(" for ");
+  LOG_INFO_6ADDR(&regipaddr);
+  LOG_INFO_(", status %u\n", status);
+  dar_output(ICMP6_DAC, &sender, status, tid, lifetime, rovr, &regipaddr);
+  return;
+
+discard:
+  uipbuf_clear();
+}
+/*------------------------------------------------------------------*/
+static void
+dac_input(void)
+{
+  uip_ipaddr_t host;
+  uip_ipaddr_t regipaddr;
+  uip_lladdr_t lladdr;
+  const uip_lladdr_t *nbr_lladdr;
+  uint8_t rovr[8];
+  uint8_t status;
+  uint8_t tid;
+  uint16_t lifetime;
+  uip_ds6_nbr_t *n;
+
+  if(uip_len < uip_l3_icmp_hdr_len + UIP_ND6_DAR_LEN) {
+    goto discard;
+  }
+  UIP_STAT(++uip_stat.nd6.recv);
+  n = uip_ds6_nbr_lookup(&UIP_ND6_DAR_BUF->regipaddr);
+  if(n == NULL || n->state != NBR_REGISTERED || !n->regpending ||
+     n->regtid != UIP_ND6_DAR_BUF->tid ||
+     (nbr_lladdr = uip_ds6_nbr_get_ll(n)) == NULL) {
+    LOG_WARN("Unexpected DAC\n");
+    goto discard;
+  }
+  n->regpending = 0;
+  tid = n->regtid;
+  status = UIP_ND6_DAR_BUF->status;
+  lifetime = uip_ntohs(UIP_ND6_DAR_BUF->lifetime);
+  memcpy(rovr, UIP_ND6_DAR_BUF->rovr, sizeof(rovr));
+  uip_ipaddr_copy(&regipaddr, &UIP_ND6_DAR_BUF->regipaddr);
+
+  /* The registering node is reached through its link-local address */
+  memcpy(&lladdr, nbr_lladdr, sizeof(lladdr));
+  uip_create_linklocal_prefix(&host);
+  uip_ds6_set_addr_iid(&host, &lladdr);
+  if(status != UIP_ND6_REG_STATUS_SUCCESS) {
+    uip_ds6_nbr_rm(n);
+  }
+  reg_na_output(&host, &regipaddr, status, tid, lifetime, rovr);
+  return;
+
+discard:
+  uipbuf_clear();
+}
+#else /* UIP_CONF_ROUTER */
+/*------------------------------------------------------------------*/
+void
+uip_nd6_reg_set_authority(uip_nd6_reg_authority_t authority)
+{
+}
+#endif /* UIP_CONF_ROUTER */
+#endif /* UIP_ND6_REGISTRATION */
 /*------------------------------------------------------------------*/
  /**
  * Neighbor Solicitation Processing
@@ -194,6 +667,9 @@ ns_input(void)
 
   /* Options processing */
   nd6_opt_llao = NULL;
+#if UIP_ND6_REGISTRATION
+  nd6_opt_aro = NULL;
+#endif /* UIP_ND6_REGISTRATION */
   nd6_opt_offset = UIP_ND6_NS_LEN;
   while(uip_l3_icmp_hdr_len + nd6_opt_offset + UIP_ND6_OPT_HDR_LEN < uip_len) {
 #if UIP_CONF_IPV6_CHECKS
@@ -247,6 +723,15 @@ ns_input(void)
       }
 #endif /*UIP_CONF_IPV6_CHECKS */
       break;
+#if UIP_ND6_REGISTRATION
+    case UIP_ND6_OPT_ARO:
+      if(uip_l3_icmp_hdr_len + nd6_opt_offset + UIP_ND6_OPT_ARO_LEN > uip_len) {
+        LOG_ERR("Insufficient data for NS ARO option\n");
+        goto discard;
+      }
+      nd6_opt_aro = ND6_OPT_ARO_BUF(nd6_opt_offset);
+      break;
+#endif /* UIP_ND6_REGISTRATION */
     default:
       LOG_WARN("ND option not supported in NS");
       break;
@@ -254,6 +739,16 @@ ns_input(void)
     nd6_opt_offset += (ND6_OPT_HDR_BUF(nd6_opt_offset)->len << 3);
   }
 
+#if UIP_ND6_REGISTRATION && UIP_CONF_ROUTER
+  /* Address registration (RFC 6775/8505) */
+  if(nd6_opt_aro != NULL) {
+    if(reg_ns_input()) {
+      return;
+    }
+    goto discard;
+  }
+#endif /* UIP_ND6_REGISTRATION && UIP_CONF_ROUTER */
+
   addr = uip_ds6_addr_lookup(&UIP_ND6_NS_BUF->tgtipaddr);
   if(addr != NULL) {
     if(uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
@@ -473,6 +968,12 @@ na_input(void)
   is_override =
     ((UIP_ND6_NA_BUF->flagsreserved & UIP_ND6_NA_FLAG_OVERRIDE));
 
+#if UIP_ND6_REGISTRATION
+  if(reg_na_input()) {
+    goto discard;
+  }
+#endif /* UIP_ND6_REGISTRATION */
+
 #if UIP_CONF_IPV6_CHECKS
   if((UIP_IP_BUF->ttl != UIP_ND6_HOP_LIMIT) ||
      (UIP_ICMP_BUF->icode != 0) ||
@@ -603,6 +1104,17 @@ discard:
   uipbuf_clear();
   return;
 }
+#elif UIP_ND6_REGISTRATION /* UIP_ND6_SEND_NS */
+/*------------------------------------------------------------------*/
+/* Without NUD and address resolution, NAs only matter as replies to our
+   registrations */
+static void
+na_input(void)
+{
+  UIP_STAT(++uip_stat.nd6.recv);
+  reg_na_input();
+  uipbuf_clear();
+}
 #endif /* UIP_ND6_SEND_NS */
 
 #if UIP_CONF_ROUTER
@@ -792,6 +1304,37 @@ uip_nd6_ra_output(uip_ipaddr_t * dest)
   }
 #endif /* UIP_ND6_RA_RDNSS */
 
+#if UIP_ND6_RA_6CO
+  {
+    struct sicslowpan_addr_context *context;
+    unsigned long lifetime;
+    uint8_t i;
+
+    for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+      context = sicslowpan_context_get(i);
+      if(context == NULL) {
+        continue;
+      }
+      lifetime = 0xffff;
+      if(!context->isinfinite) {
+        /* Round up so that the context does not expire early */
+        lifetime = MIN((stimer_remaining(&context->lifetime) + 59) / 60, 0xffff);
+      }
+      ND6_OPT_6CO_BUF(nd6_opt_offset)->type = UIP_ND6_OPT_6CO;
+      ND6_OPT_6CO_BUF(nd6_opt_offset)->len = UIP_ND6_OPT_6CO_LEN >> 3;
+      ND6_OPT_6CO_BUF(nd6_opt_offset)->context_len = 64;
+      ND6_OPT_6CO_BUF(nd6_opt_offset)->flags_cid =
+        (context->compress ? UIP_ND6_6CO_FLAG_C : 0) |
+        (context->number & UIP_ND6_6CO_CID_MASK);
+      ND6_OPT_6CO_BUF(nd6_opt_offset)->reserved = 0;
+      ND6_OPT_6CO_BUF(nd6_opt_offset)->lifetime = uip_htons(lifetime);
+      memcpy(ND6_OPT_6CO_BUF(nd6_opt_offset)->prefix, context->prefix, 8);
+      uip_len += UIP_ND6_OPT_6CO_LEN;
+      nd6_opt_offset += UIP_ND6_OPT_6CO_LEN;
+    }
+  }
+#endif /* UIP_ND6_RA_6CO */
+
   uipbuf_set_len_field(UIP_IP_BUF, uip_len - UIP_IPH_LEN);
 
   /*ICMP checksum */
@@ -809,6 +1352,84 @@ uip_nd6_ra_output(uip_ipaddr_t * dest)
 #endif /* UIP_ND6_SEND_RA */
 #endif /* UIP_CONF_ROUTER */
 
+#if UIP_ND6_RA_6CO
+/*---------------------------------------------------------------------------*/
+/* Learn the 6LoWPAN context of the 6CO option at nd6_opt_offset */
+static void
+ra_6co_option(void)
+{
+  LOG_DBG("Processing 6CO option\n");
+  if(uip_l3_icmp_hdr_len + nd6_opt_offset + UIP_ND6_OPT_6CO_LEN > uip_len) {
+    LOG_WARN("6CO option truncated\n");
+    return;
+  }
+  if(ND6_OPT_6CO_BUF(nd6_opt_offset)->len < UIP_ND6_OPT_6CO_LEN >> 3 ||
+     ND6_OPT_6CO_BUF(nd6_opt_offset)->context_len < 64) {
+    /* Only 64-bit contexts can be used by IPHC here */
+    LOG_WARN("6CO option with unsupported context length\n");
+    return;
+  }
+  sicslowpan_context_update(ND6_OPT_6CO_BUF(nd6_opt_offset)->flags_cid &
+                            UIP_ND6_6CO_CID_MASK,
+                            ND6_OPT_6CO_BUF(nd6_opt_offset)->prefix,
+                            (ND6_OPT_6CO_BUF(nd6_opt_offset)->flags_cid &
+                             UIP_ND6_6CO_FLAG_C) != 0,
+                            (uint32_t)uip_ntohs(ND6_OPT_6CO_BUF(nd6_opt_offset)->lifetime) * 60);
+}
+#endif /* UIP_ND6_RA_6CO */
+
+#if UIP_CONF_ROUTER && UIP_ND6_RA_6CO
+/*---------------------------------------------------------------------------*/
+/**
+ * Process a Router Advertisement on a router
+ *
+ * Routers only learn the 6LoWPAN contexts of the RAs of their default
+ * router, i.e. their RPL preferred parent. As they advertise all their
+ * contexts in their own RAs, contexts set on the border router flow down to
+ * every router of a mesh, which must decompress the packets it forwards,
+ * and never come back up.
+ */
+static void
+ra_6co_input(void)
+{
+  LOG_INFO("Received RA from ");
+  LOG_INFO_6ADDR(&UIP_IP_BUF->srcipaddr);
+  LOG_INFO_(" to ");
+  LOG_INFO_6ADDR(&UIP_IP_BUF->destipaddr);
+  LOG_INFO_("\n");
+  UIP_STAT(++uip_stat.nd6.recv);
+
+#if UIP_CONF_IPV6_CHECKS
+  if((UIP_IP_BUF->ttl != UIP_ND6_HOP_LIMIT) ||
+     (!uip_is_addr_linklocal(&UIP_IP_BUF->srcipaddr)) ||
+     (UIP_ICMP_BUF->icode != 0)) {
+    LOG_ERR("RA received is bad");
+    goto discard;
+  }
+#endif /*UIP_CONF_IPV6_CHECKS */
+
+  if(uip_ds6_defrt_lookup(&UIP_IP_BUF->srcipaddr) == NULL) {
+    LOG_INFO("RA not from a default router, ignoring its contexts\n");
+    goto discard;
+  }
+
+  nd6_opt_offset = UIP_ND6_RA_LEN;
+  while(uip_l3_icmp_hdr_len + nd6_opt_offset < uip_len) {
+    if(ND6_OPT_HDR_BUF(nd6_opt_offset)->len == 0) {
+      LOG_ERR("RA received is bad");
+      goto discard;
+    }
+    if(ND6_OPT_HDR_BUF(nd6_opt_offset)->type == UIP_ND6_OPT_6CO) {
+      ra_6co_option();
+    }
+    nd6_opt_offset += (ND6_OPT_HDR_BUF(nd6_opt_offset)->len << 3);
+  }
+
+discard:
+  uipbuf_clear();
+}
+#endif /* UIP_CONF_ROUTER && UIP_ND6_RA_6CO */
+
 #if !UIP_CONF_ROUTER
 /*---------------------------------------------------------------------------*/
 void
@@ -1039,6 +1660,11 @@ ra_input(void)
       }
       break;
 #endif /* UIP_ND6_RA_RDNSS */
+#if UIP_ND6_RA_6CO
+    case UIP_ND6_OPT_6CO:
+      ra_6co_option();
+      break;
+#endif /* UIP_ND6_RA_6CO */
     default:
       LOG_ERR("ND option not supported in RA\n");
       break;
@@ -1094,10 +1720,16 @@ discard:
 UIP_ICMP6_HANDLER(ns_input_handler, ICMP6_NS, UIP_ICMP6_HANDLER_CODE_ANY,
                   ns_input);
 #endif
-#if UIP_ND6_SEND_NS
+#if UIP_ND6_SEND_NS || UIP_ND6_REGISTRATION
 UIP_ICMP6_HANDLER(na_input_handler, ICMP6_NA, UIP_ICMP6_HANDLER_CODE_ANY,
                   na_input);
 #endif
+#if UIP_ND6_REGISTRATION && UIP_CONF_ROUTER
+UIP_ICMP6_HANDLER(dar_input_handler, ICMP6_DAR, UIP_ICMP6_HANDLER_CODE_ANY,
+                  dar_input);
+UIP_ICMP6_HANDLER(dac_input_handler, ICMP6_DAC, UIP_ICMP6_HANDLER_CODE_ANY,
+                  dac_input);
+#endif
 
 #if UIP_CONF_ROUTER && UIP_ND6_SEND_RA
 UIP_ICMP6_HANDLER(rs_input_handler, ICMP6_RS, UIP_ICMP6_HANDLER_CODE_ANY,
@@ -1107,6 +1739,9 @@ UIP_ICMP6_HANDLER(rs_input_handler, ICMP6_RS, UIP_ICMP6_HANDLER_CODE_ANY,
 #if !UIP_CONF_ROUTER
 UIP_ICMP6_HANDLER(ra_input_handler, ICMP6_RA, UIP_ICMP6_HANDLER_CODE_ANY,
                   ra_input);
+#elif UIP_ND6_RA_6CO
+UIP_ICMP6_HANDLER(ra_input_handler, ICMP6_RA, UIP_ICMP6_HANDLER_CODE_ANY,
+                  ra_6co_input);
 #endif
 /*---------------------------------------------------------------------------*/
 void
@@ -1117,19 +1752,26 @@ uip_nd6_init()
   uip_icmp6_register_input_handler(&ns_input_handler);
 #endif
 
-#if UIP_ND6_SEND_NS
+#if UIP_ND6_SEND_NS || UIP_ND6_REGISTRATION
   /*
-   * Only handle NAs if we are prepared to send out NSs. */
+   * Only handle NAs if we are prepared to send out NSs, or to register
+   * our addresses. */
   uip_icmp6_register_input_handler(&na_input_handler);
 #endif
 
+#if UIP_ND6_REGISTRATION && UIP_CONF_ROUTER
+  /* DARs are handled by the 6LBR, DACs by the 6LR */
+  uip_icmp6_register_input_handler(&dar_input_handler);
+  uip_icmp6_register_input_handler(&dac_input_handler);
+#endif
+
 #if UIP_CONF_ROUTER && UIP_ND6_SEND_RA
   /* Only accept RS if we are a router and happy to send out RAs */
   uip_icmp6_register_input_handler(&rs_input_handler);
 #endif
 
-#if !UIP_CONF_ROUTER
-  /* Only process RAs if we are not a router */
+#if !UIP_CONF_ROUTER || UIP_ND6_RA_6CO
+  /* Only process RAs if we are not a router, or to learn contexts */
   uip_icmp6_register_input_handler(&ra_input_handler);
 #endif
 }
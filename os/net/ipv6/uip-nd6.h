@@ -190,6 +190,47 @@ be added regardless of their reachability and liveness.  */
 #endif
 /** @} */
 
+/** \name RFC 6775 / RFC 8505 address registration */
+/** @{ */
+/* Register our addresses with the default router (EARO in unicast NS) and,
+   as a router, keep registered neighbors instead of resolving them with
+   multicast NS. Global addresses go through multihop DAD (DAR/DAC) with
+   the 6LBR, i.e. the routing root. */
+#ifndef UIP_CONF_ND6_REGISTRATION
+#define UIP_ND6_REGISTRATION            0
+#else
+#define UIP_ND6_REGISTRATION            UIP_CONF_ND6_REGISTRATION
+#endif
+/** \brief Requested registration lifetime, in units of 60 seconds */
+#ifndef UIP_CONF_ND6_REGISTRATION_LIFETIME
+#define UIP_ND6_REGISTRATION_LIFETIME   60
+#else
+#define UIP_ND6_REGISTRATION_LIFETIME   UIP_CONF_ND6_REGISTRATION_LIFETIME
+#endif
+/** \brief Seconds between registration attempts until one succeeds */
+#ifndef UIP_CONF_ND6_REGISTRATION_RETRANS
+#define UIP_ND6_REGISTRATION_RETRANS    10
+#else
+#define UIP_ND6_REGISTRATION_RETRANS    UIP_CONF_ND6_REGISTRATION_RETRANS
+#endif
+#define UIP_ND6_MULTIHOP_HOPLIMIT       64
+
+/** \brief (E)ARO and DAR/DAC status values */
+#define UIP_ND6_REG_STATUS_SUCCESS      0
+#define UIP_ND6_REG_STATUS_DUPLICATE    1
+#define UIP_ND6_REG_STATUS_CACHE_FULL   2
+/** @} */
+
+/** \name RFC 6775 6LoWPAN Context Option */
+/** @{ */
+/* Advertise and learn 6LoWPAN header compression contexts in RAs */
+#ifndef UIP_CONF_ND6_RA_6CO
+#define UIP_ND6_RA_6CO                  0
+#else
+#define UIP_ND6_RA_6CO                  UIP_CONF_ND6_RA_6CO
+#endif
+/** @} */
+
 
 /** \name ND6 option types */
 /** @{ */
@@ -200,6 +241,8 @@ be added regardless of their reachability and liveness.  */
 #define UIP_ND6_OPT_MTU                 5
 #define UIP_ND6_OPT_RDNSS               25
 #define UIP_ND6_OPT_DNSSL               31
+#define UIP_ND6_OPT_ARO                 33
+#define UIP_ND6_OPT_6CO                 34
 /** @} */
 
 /** \name ND6 option types */
@@ -224,6 +267,9 @@ be added regardless of their reachability and liveness.  */
 #define UIP_ND6_OPT_MTU_LEN            8
 #define UIP_ND6_OPT_RDNSS_LEN          1
 #define UIP_ND6_OPT_DNSSL_LEN          1
+#define UIP_ND6_OPT_6CO_LEN            16
+#define UIP_ND6_OPT_ARO_LEN            16
+#define UIP_ND6_DAR_LEN                28
 
 
 /* Length of TLLAO and SLLAO options, it is L2 dependant */
@@ -355,6 +401,45 @@ typedef struct uip_nd6_opt_dns {
   uip_ipaddr_t ip;
 } uip_nd6_opt_dns;
 
+/** \brief ND option Extended Address Registration (RFC 8505), 64-bit
+    ROVR */
+typedef struct uip_nd6_opt_aro {
+  uint8_t type;
+  uint8_t len;
+  uint8_t status;
+  uint8_t opaque;
+  uint8_t flags;
+  uint8_t tid;
+  uint16_t lifetime; /* in units of 60 seconds */
+  uint8_t rovr[8];
+} uip_nd6_opt_aro;
+
+#define UIP_ND6_ARO_FLAG_R              0x02
+#define UIP_ND6_ARO_FLAG_T              0x01
+
+/** \brief Duplicate Address Request/Confirmation (RFC 8505), 64-bit ROVR */
+typedef struct uip_nd6_dar {
+  uint8_t status;
+  uint8_t tid;
+  uint16_t lifetime;
+  uint8_t rovr[8];
+  uip_ipaddr_t regipaddr;
+} uip_nd6_dar;
+
+/** \brief ND option 6LoWPAN Context (RFC 6775), 64-bit prefix */
+typedef struct uip_nd6_opt_6co {
+  uint8_t type;
+  uint8_t len;
+  uint8_t context_len;
+  uint8_t flags_cid;
+  uint16_t reserved;
+  uint16_t lifetime; /* in units of 60 seconds */
+  uint8_t prefix[8];
+} uip_nd6_opt_6co;
+
+#define UIP_ND6_6CO_FLAG_C              0x10
+#define UIP_ND6_6CO_CID_MASK            0x0f
+
 /** \struct Redirected header option */
 typedef struct uip_nd6_opt_redirected_hdr {
   uint8_t type;
@@ -418,6 +503,36 @@ void uip_nd6_rs_output(void);
  * \brief Initialise the uIP ND core
  */
 void uip_nd6_init(void);
+
+#if UIP_ND6_REGISTRATION
+/**
+ * \brief Decides on the registration of an address, network-wide.
+ * \param addr The address to register
+ * \param rovr The 64-bit owner identifier of the registering node
+ * \param lifetime The requested lifetime, in units of 60 seconds, 0 to
+ * deregister
+ * \return A UIP_ND6_REG_STATUS_* value
+ */
+typedef uint8_t (* uip_nd6_reg_authority_t)(const uip_ipaddr_t *addr,
+                                            const uint8_t *rovr,
+                                            uint16_t lifetime);
+
+/**
+ * \brief Make this node the 6LBR, i.e. the node answering DARs
+ *
+ * Routers without an authority forward the registration of global
+ * addresses to the routing root in a DAR.
+ */
+void uip_nd6_reg_set_authority(uip_nd6_reg_authority_t authority);
+
+/**
+ * \brief Periodic processing of address registrations
+ *
+ * Expires registered neighbors, and (re)registers our own addresses with
+ * the default router. Sends at most one packet, placed in uip_buf.
+ */
+void uip_nd6_reg_periodic(void);
+#endif /* UIP_ND6_REGISTRATION */
 /** @} */
 
 
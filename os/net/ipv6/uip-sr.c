@@ -109,6 +109,29 @@ uip_sr_is_addr_reachable(void *graph, const uip_ipaddr_t *addr)
   return node != NULL && node == root_node;
 }
 /*---------------------------------------------------------------------------*/
+uip_sr_node_t *
+uip_sr_common_ancestor(uip_sr_node_t *a, uip_sr_node_t *b)
+{
+  int max_depth_a = UIP_SR_LINK_NUM;
+  int max_depth_b;
+  uip_sr_node_t *node;
+
+  /* For every ancestor of a (including a itself), closest first, check if
+   * it is also an ancestor of b. Depth is bounded in case of loops. */
+  while(a != NULL && max_depth_a > 0) {
+    max_depth_b = UIP_SR_LINK_NUM;
+    for(node = b; node != NULL && max_depth_b > 0; node = node->parent) {
+      if(node == a) {
+        return a;
+      }
+      max_depth_b--;
+    }
+    a = a->parent;
+    max_depth_a--;
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
 void
 uip_sr_expire_parent(void *graph, const uip_ipaddr_t *child, const uip_ipaddr_t *parent)
 {
@@ -248,6 +271,21 @@ uip_sr_free_all(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+void
+uip_sr_free_graph(void *graph)
+{
+  uip_sr_node_t *l;
+  uip_sr_node_t *next;
+  for(l = list_head(nodelist); l != NULL; l = next) {
+    next = list_item_next(l);
+    if(l->graph == graph) {
+      list_remove(nodelist, l);
+      memb_free(&nodememb, l);
+      num_nodes--;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 int
 uip_sr_link_snprint(char *buf, int buflen, uip_sr_node_t *link)
 {
@@ -162,6 +162,15 @@ uip_sr_node_t *uip_sr_get_node(void *graph, const uip_ipaddr_t *addr);
 */
 int uip_sr_is_addr_reachable(void *graph, const uip_ipaddr_t *addr);
 
+/**
+ * Finds the lowest common ancestor of two nodes of a source routing graph.
+ * A node counts as its own ancestor.
+ * \param a The first node
+ * \param b The second node
+ * \return The lowest common ancestor, NULL if there is none
+*/
+uip_sr_node_t *uip_sr_common_ancestor(uip_sr_node_t *a, uip_sr_node_t *b);
+
 /**
  * A function called periodically. Used to age the links (decrease lifetime
  * and expire links accordingly)
@@ -180,6 +189,13 @@ void uip_sr_init(void);
 */
 void uip_sr_free_all(void);
 
+/**
+ * Deallocate all nodes of a given graph
+ *
+ * \param graph The graph to be flushed
+*/
+void uip_sr_free_graph(void *graph);
+
 /**
 * Print a textual description of a source routing link
 *
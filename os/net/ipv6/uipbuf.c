@@ -248,6 +248,8 @@ uipbuf_init(void)
      configure its default */
   uipbuf_set_default_attr(UIPBUF_ATTR_LLSEC_LEVEL,
                           UIPBUF_ATTR_LLSEC_LEVEL_MAC_DEFAULT);
+  uipbuf_set_default_attr(UIPBUF_ATTR_RPL_INSTANCE,
+                          UIPBUF_ATTR_RPL_INSTANCE_NONE);
 }
 
 /*---------------------------------------------------------------------------*/
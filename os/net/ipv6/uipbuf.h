@@ -186,10 +186,17 @@ void uipbuf_init(void);
 #define UIPBUF_ATTR_FLAGS_6LOWPAN_NO_NHC_COMPRESSION      0x01
 /* Avoid using prefix compression on the packet (6LoWPAN) */
 #define UIPBUF_ATTR_FLAGS_6LOWPAN_NO_PREFIX_COMPRESSION   0x02
+/* uip_buf holds only the first fragment of a datagram that 6LoWPAN
+ * forwards without reassembling it: send it right away to a neighbor
+ * on the 6LoWPAN interface, or not at all */
+#define UIPBUF_ATTR_FLAGS_6LOWPAN_FIRST_FRAGMENT          0x04
 
 /* MAC will set the default for this packet */
 #define UIPBUF_ATTR_LLSEC_LEVEL_MAC_DEFAULT               0xffff
 
+/* No RPL instance requested, the routing protocol uses its default */
+#define UIPBUF_ATTR_RPL_INSTANCE_NONE                     0xffff
+
 /**
  * \brief The attributes defined for uipbuf attributes function.
  *
@@ -203,6 +210,7 @@ enum {
   UIPBUF_ATTR_FLAGS,   /**< Flags that can control lower layers.  see above. */
   UIPBUF_ATTR_RSSI, /**< Last packet's RSSI */
   UIPBUF_ATTR_LINK_QUALITY, /**< Last packet's LQI */
+  UIPBUF_ATTR_RPL_INSTANCE, /**< RPL instance to route the packet in */
   UIPBUF_ATTR_MAX
 };
 
@@ -367,6 +367,82 @@
 #define RPL_DEFAULT_INSTANCE	          0 /* Default of 0 for compression */
 #endif /* RPL_CONF_DEFAULT_INSTANCE */
 
+/*
+ * The maximum number of RPL instances a node can be part of at the same
+ * time, e.g., one instance running MRHOF for bulk traffic and one running
+ * OF0 for low-latency traffic. Every additional instance costs one
+ * rpl_instance_t and one rpl_nbr_t per neighbor. RPL_DEFAULT_INSTANCE is
+ * the primary instance: it provides the default route and is the one used
+ * for packets that do not select an instance through
+ * UIPBUF_ATTR_RPL_INSTANCE. Other instances are only joined in the
+ * remaining slots; with a single slot, the first instance heard is joined
+ * whatever its ID. Roots start additional instances with
+ * rpl_dag_root_start_instance(). At most 8.
+ */
+#ifdef RPL_CONF_MAX_INSTANCES
+#define RPL_MAX_INSTANCES RPL_CONF_MAX_INSTANCES
+#else
+#define RPL_MAX_INSTANCES 1
+#endif /* RPL_CONF_MAX_INSTANCES */
+
+/*
+ * Projected routes (P-DAO, RFC 9914). The root counts the peer-to-peer
+ * flows it forwards for the primary instance. Flows that reach
+ * RPL_PROJECTED_ROUTES_THRESHOLD packets within one
+ * RPL_PROJECTED_ROUTES_PERIOD get storing-mode state installed from their
+ * lowest common ancestor down to the destination, so that they no longer
+ * go through the root and do not need a source routing header.
+ * Must be enabled on the root and on all nodes.
+ */
+#ifdef RPL_CONF_WITH_PROJECTED_ROUTES
+#define RPL_WITH_PROJECTED_ROUTES RPL_CONF_WITH_PROJECTED_ROUTES
+#else
+#define RPL_WITH_PROJECTED_ROUTES 0
+#endif /* RPL_CONF_WITH_PROJECTED_ROUTES */
+
+/* The number of projected routes a node can store */
+#ifdef RPL_CONF_PROJECTED_ROUTES_NUM
+#define RPL_PROJECTED_ROUTES_NUM RPL_CONF_PROJECTED_ROUTES_NUM
+#else
+#define RPL_PROJECTED_ROUTES_NUM 4
+#endif /* RPL_CONF_PROJECTED_ROUTES_NUM */
+
+/* The number of flows tracked by the root */
+#ifdef RPL_CONF_PROJECTED_ROUTES_FLOWS
+#define RPL_PROJECTED_ROUTES_FLOWS RPL_CONF_PROJECTED_ROUTES_FLOWS
+#else
+#define RPL_PROJECTED_ROUTES_FLOWS 8
+#endif /* RPL_CONF_PROJECTED_ROUTES_FLOWS */
+
+/* Packets per period that make a flow eligible for a projected route */
+#ifdef RPL_CONF_PROJECTED_ROUTES_THRESHOLD
+#define RPL_PROJECTED_ROUTES_THRESHOLD RPL_CONF_PROJECTED_ROUTES_THRESHOLD
+#else
+#define RPL_PROJECTED_ROUTES_THRESHOLD 10
+#endif /* RPL_CONF_PROJECTED_ROUTES_THRESHOLD */
+
+/* Flow measurement period at the root, in seconds */
+#ifdef RPL_CONF_PROJECTED_ROUTES_PERIOD
+#define RPL_PROJECTED_ROUTES_PERIOD RPL_CONF_PROJECTED_ROUTES_PERIOD
+#else
+#define RPL_PROJECTED_ROUTES_PERIOD 30
+#endif /* RPL_CONF_PROJECTED_ROUTES_PERIOD */
+
+/* Lifetime of projected routes, in units of the DAG lifetime unit. The
+ * lifetime only runs down while the route is not used */
+#ifdef RPL_CONF_PROJECTED_ROUTES_LIFETIME
+#define RPL_PROJECTED_ROUTES_LIFETIME RPL_CONF_PROJECTED_ROUTES_LIFETIME
+#else
+#define RPL_PROJECTED_ROUTES_LIFETIME 5
+#endif /* RPL_CONF_PROJECTED_ROUTES_LIFETIME */
+
+/* The maximum number of hops of a projected segment */
+#ifdef RPL_CONF_PROJECTED_ROUTES_MAX_HOPS
+#define RPL_PROJECTED_ROUTES_MAX_HOPS RPL_CONF_PROJECTED_ROUTES_MAX_HOPS
+#else
+#define RPL_PROJECTED_ROUTES_MAX_HOPS 8
+#endif /* RPL_CONF_PROJECTED_ROUTES_MAX_HOPS */
+
 /* Set to have the root advertise a grounded DAG */
 #ifndef RPL_CONF_GROUNDED
 #define RPL_GROUNDED                    0
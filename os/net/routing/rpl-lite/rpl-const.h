@@ -112,9 +112,11 @@
 #define RPL_OPTION_SOLICITED_INFO        7
 #define RPL_OPTION_PREFIX_INFO           8
 #define RPL_OPTION_TARGET_DESC           9
+#define RPL_OPTION_SM_VIO                14  /* Storing-mode Via Information (RFC 9914) */
 
 #define RPL_DAO_K_FLAG                   0x80 /* DAO-ACK requested */
 #define RPL_DAO_D_FLAG                   0x40 /* DODAG ID present */
+#define RPL_DAO_P_FLAG                   0x20 /* Projected DAO (RFC 9914) */
 
 #define RPL_DAO_ACK_UNCONDITIONAL_ACCEPT 0
 #define RPL_DAO_ACK_ACCEPT               1   /* 1 - 127 is OK but not good */
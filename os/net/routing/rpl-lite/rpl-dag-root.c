@@ -49,6 +49,29 @@
 #define LOG_MODULE "RPL"
 #define LOG_LEVEL LOG_LEVEL_RPL
 
+#if RPL_WITH_PROJECTED_ROUTES
+
+/* The via addresses must fit in a single P-DAO option */
+#if RPL_PROJECTED_ROUTES_MAX_HOPS > 14
+#error "RPL_PROJECTED_ROUTES_MAX_HOPS must be at most 14"
+#endif
+
+/* A peer-to-peer flow forwarded by the root */
+struct projected_flow {
+  uip_ipaddr_t src;
+  uip_ipaddr_t dst;
+  /* Seconds before the flow may be projected again, 0 if not projected */
+  uint32_t lifetime;
+  /* Packets forwarded in the current period */
+  uint16_t count;
+  uint8_t used;
+};
+
+static struct projected_flow flows[RPL_PROJECTED_ROUTES_FLOWS];
+static struct ctimer flow_timer;
+
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
 /*---------------------------------------------------------------------------*/
 void
 rpl_dag_root_print_links(const char *str)
@@ -119,13 +142,146 @@ rpl_dag_root_set_prefix(uip_ipaddr_t *prefix, uip_ipaddr_t *iid)
   }
 }
 /*---------------------------------------------------------------------------*/
-int
-rpl_dag_root_start(void)
+#if RPL_WITH_PROJECTED_ROUTES
+static void
+project_flow(struct projected_flow *flow)
+{
+  uip_sr_node_t *path[RPL_PROJECTED_ROUTES_MAX_HOPS + 1];
+  uip_ipaddr_t via[RPL_PROJECTED_ROUTES_MAX_HOPS + 1];
+  uip_ipaddr_t dest;
+  uip_sr_node_t *src_node;
+  uip_sr_node_t *dst_node;
+  uip_sr_node_t *root_node;
+  uip_sr_node_t *lca;
+  uip_sr_node_t *node;
+  int hops;
+  int i;
+
+  src_node = uip_sr_get_node(rpl_curr_instance, &flow->src);
+  dst_node = uip_sr_get_node(rpl_curr_instance, &flow->dst);
+  root_node = uip_sr_get_node(rpl_curr_instance, &curr_instance.dag.dag_id);
+  lca = uip_sr_common_ancestor(src_node, dst_node);
+
+  if(lca == NULL || lca == root_node || lca == dst_node) {
+    /* The path through the root is already the shortest one */
+    return;
+  }
+
+  /* Collect the segment, from the destination up to the common ancestor */
+  hops = 0;
+  for(node = dst_node; node != lca; node = node->parent) {
+    if(hops == RPL_PROJECTED_ROUTES_MAX_HOPS) {
+      LOG_WARN("projected segment to ");
+      LOG_WARN_6ADDR(&flow->dst);
+      LOG_WARN_(" too long, skip\n");
+      return;
+    }
+    path[hops++] = node;
+  }
+  path[hops] = lca;
+
+  /* The via addresses go from ingress to egress */
+  for(i = 0; i <= hops; i++) {
+    NETSTACK_ROUTING.get_sr_node_ipaddr(&via[i], path[hops - i]);
+  }
+
+  LOG_INFO("projecting flow from ");
+  LOG_INFO_6ADDR(&flow->src);
+  LOG_INFO_(" to ");
+  LOG_INFO_6ADDR(&flow->dst);
+  LOG_INFO_(" (%u packets), %u hops from ", flow->count, hops);
+  LOG_INFO_6ADDR(&via[0]);
+  LOG_INFO_("\n");
+
+  /* Install state from the egress up to the ingress, so that the
+   * segment is complete by the time the ingress starts using it */
+  for(i = 1; i <= hops; i++) {
+    NETSTACK_ROUTING.get_sr_node_ipaddr(&dest, path[i]);
+    rpl_icmp6_pdao_output(&dest, &flow->dst, via, hops + 1,
+                          RPL_PROJECTED_ROUTES_LIFETIME);
+  }
+
+  flow->lifetime = RPL_LIFETIME(RPL_PROJECTED_ROUTES_LIFETIME);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_flow_timer(void *ptr)
+{
+  rpl_instance_t *prev;
+  struct projected_flow *flow;
+
+  prev = rpl_set_current_instance(&rpl_instances[0]);
+
+  if(rpl_dag_root_is_root()) {
+    for(flow = flows; flow < flows + RPL_PROJECTED_ROUTES_FLOWS; flow++) {
+      if(!flow->used) {
+        continue;
+      }
+      flow->lifetime = flow->lifetime > RPL_PROJECTED_ROUTES_PERIOD ?
+        flow->lifetime - RPL_PROJECTED_ROUTES_PERIOD : 0;
+      if(flow->lifetime == 0) {
+        if(flow->count >= RPL_PROJECTED_ROUTES_THRESHOLD) {
+          project_flow(flow);
+        } else if(flow->count == 0) {
+          /* Flow no longer seen at the root */
+          flow->used = 0;
+        }
+      }
+      flow->count = 0;
+    }
+    ctimer_reset(&flow_timer);
+  }
+
+  rpl_set_current_instance(prev);
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_dag_root_count_flow(const uip_ipaddr_t *src, const uip_ipaddr_t *dst)
+{
+  struct projected_flow *flow;
+  struct projected_flow *candidate = NULL;
+
+  /* Projected routes are installed for the primary instance only */
+  if(rpl_curr_instance != &rpl_instances[0]
+     || !rpl_is_addr_in_our_dag(dst)) {
+    return;
+  }
+
+  for(flow = flows; flow < flows + RPL_PROJECTED_ROUTES_FLOWS; flow++) {
+    if(!flow->used) {
+      if(candidate == NULL || candidate->used) {
+        candidate = flow;
+      }
+    } else if(uip_ipaddr_cmp(&flow->src, src) && uip_ipaddr_cmp(&flow->dst, dst)) {
+      if(flow->count < 0xffff) {
+        flow->count++;
+      }
+      return;
+    } else if(flow->lifetime == 0
+              && (candidate == NULL || (candidate->used && flow->count < candidate->count))) {
+      /* Replace the least active flow that is not projected */
+      candidate = flow;
+    }
+  }
+
+  if(candidate != NULL) {
+    uip_ipaddr_copy(&candidate->src, src);
+    uip_ipaddr_copy(&candidate->dst, dst);
+    candidate->lifetime = 0;
+    candidate->count = 1;
+    candidate->used = 1;
+  }
+}
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+/*---------------------------------------------------------------------------*/
+static int
+start_root(rpl_instance_t *instance, uint8_t instance_id, rpl_ocp_t ocp)
 {
   struct uip_ds6_addr *root_if;
   int i;
   uint8_t state;
   uip_ipaddr_t *ipaddr = NULL;
+  rpl_instance_t *prev;
 
   rpl_dag_root_set_prefix(NULL, NULL);
 
@@ -141,9 +297,11 @@ rpl_dag_root_start(void)
   root_if = uip_ds6_addr_lookup(ipaddr);
   if(ipaddr != NULL || root_if != NULL) {
 
-    rpl_dag_init_root(RPL_DEFAULT_INSTANCE, ipaddr,
+    prev = rpl_set_current_instance(instance);
+    rpl_dag_init_root(instance_id, ocp, ipaddr,
       (uip_ipaddr_t *)rpl_get_global_address(), 64, UIP_ND6_RA_FLAG_AUTONOMOUS);
     rpl_dag_update_state();
+    rpl_set_current_instance(prev);
 
     LOG_INFO("created a new RPL DAG\n");
     return 0;
@@ -154,6 +312,40 @@ rpl_dag_root_start(void)
 }
 /*---------------------------------------------------------------------------*/
 int
+rpl_dag_root_start(void)
+{
+  /* The default instance always runs in the primary slot */
+  if(start_root(&rpl_instances[0], RPL_DEFAULT_INSTANCE, RPL_OF_OCP) < 0) {
+    return -1;
+  }
+
+#if RPL_WITH_PROJECTED_ROUTES
+  memset(flows, 0, sizeof(flows));
+  ctimer_set(&flow_timer, RPL_PROJECTED_ROUTES_PERIOD * CLOCK_SECOND,
+             handle_flow_timer, NULL);
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+rpl_dag_root_start_instance(uint8_t instance_id, rpl_ocp_t ocp)
+{
+  rpl_instance_t *instance = rpl_get_instance(instance_id);
+
+  if(instance == NULL) {
+    instance = rpl_alloc_instance(instance_id);
+    if(instance == NULL) {
+      LOG_ERR("failed to create a new RPL DAG: no room for instance %u\n",
+              instance_id);
+      return -1;
+    }
+  }
+
+  return start_root(instance, instance_id, ocp);
+}
+/*---------------------------------------------------------------------------*/
+int
 rpl_dag_root_is_root(void)
 {
   return curr_instance.used && curr_instance.dag.rank == ROOT_RANK;
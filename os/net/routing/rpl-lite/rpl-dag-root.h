@@ -57,12 +57,35 @@ void rpl_dag_root_set_prefix(uip_ipaddr_t *prefix, uip_ipaddr_t *iid);
 */
 int rpl_dag_root_start(void);
 
+/**
+ * Set the node as root of a given instance and start a DAG. Used to run
+ * additional instances, e.g. with a different objective function.
+ *
+ * \param instance_id The instance ID
+ * \param ocp The objective code point of the instance's OF, which must
+ * be in RPL_SUPPORTED_OFS
+ * \return 0 in case of success, -1 otherwise
+*/
+int rpl_dag_root_start_instance(uint8_t instance_id, rpl_ocp_t ocp);
+
 /**
  * Tells whether we are DAG root or not
  *
  * \return 1 if we are dag root, 0 otherwise
 */
 int rpl_dag_root_is_root(void);
+
+#if RPL_WITH_PROJECTED_ROUTES
+/**
+ * Accounts for a packet forwarded by the root between two nodes of the
+ * primary instance. Frequent flows get a projected route.
+ *
+ * \param src The source address of the packet
+ * \param dst The destination address of the packet
+*/
+void rpl_dag_root_count_flow(const uip_ipaddr_t *src, const uip_ipaddr_t *dst);
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
 /**
  * Prints a summary of all routing links
  *
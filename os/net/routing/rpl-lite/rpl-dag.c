@@ -44,6 +44,7 @@
 
 #include "net/routing/rpl-lite/rpl.h"
 #include "net/ipv6/uip-sr.h"
+#include "net/ipv6/uip-ds6-route.h"
 #include "net/nbr-table.h"
 #include "net/link-stats.h"
 
@@ -59,7 +60,14 @@ static int process_dio_init_dag(rpl_dio_t *dio);
 
 /*---------------------------------------------------------------------------*/
 /* Allocate instance table. */
-rpl_instance_t curr_instance;
+rpl_instance_t rpl_instances[RPL_MAX_INSTANCES];
+rpl_instance_t *rpl_curr_instance = &rpl_instances[0];
+
+/*---------------------------------------------------------------------------*/
+#if RPL_WITH_PROJECTED_ROUTES
+/* Route state flag: the projected route was used since the last period */
+#define PROJECTED_ROUTE_USED 0x01
+#endif /* RPL_WITH_PROJECTED_ROUTES */
 
 /*---------------------------------------------------------------------------*/
 
@@ -85,6 +93,62 @@ rpl_dag_state_to_str(enum rpl_dag_state state)
   }
 }
 /*---------------------------------------------------------------------------*/
+rpl_instance_t *
+rpl_set_current_instance(rpl_instance_t *instance)
+{
+  rpl_instance_t *prev = rpl_curr_instance;
+  if(instance != NULL) {
+    rpl_curr_instance = instance;
+  }
+  return prev;
+}
+/*---------------------------------------------------------------------------*/
+rpl_instance_t *
+rpl_get_instance(uint8_t instance_id)
+{
+  int i;
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    if(rpl_instances[i].used && rpl_instances[i].instance_id == instance_id) {
+      return &rpl_instances[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+rpl_instance_t *
+rpl_alloc_instance(uint8_t instance_id)
+{
+  int i;
+
+  /* The primary slot is kept for the default instance, unless it is the
+     only one */
+  if(RPL_MAX_INSTANCES == 1 || instance_id == RPL_DEFAULT_INSTANCE) {
+    return rpl_instances[0].used ? NULL : &rpl_instances[0];
+  }
+  for(i = 1; i < RPL_MAX_INSTANCES; i++) {
+    if(!rpl_instances[i].used) {
+      return &rpl_instances[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Tells whether an instance other than the current one uses a given prefix */
+static int
+prefix_used_by_other_instance(const rpl_prefix_t *prefix)
+{
+  int i;
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    if(&rpl_instances[i] != rpl_curr_instance && rpl_instances[i].used
+       && rpl_instances[i].dag.prefix_info.length == prefix->length
+       && uip_ipaddr_prefixcmp(&rpl_instances[i].dag.prefix_info.prefix,
+                               &prefix->prefix, prefix->length)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 int
 rpl_dag_get_root_ipaddr(uip_ipaddr_t *ipaddr)
 {
@@ -113,13 +177,23 @@ rpl_dag_leave(void)
 
   /* Remove all neighbors, links and default route */
   rpl_neighbor_remove_all();
-  uip_sr_free_all();
+  uip_sr_free_graph(rpl_curr_instance);
+#if RPL_WITH_PROJECTED_ROUTES
+  /* Projected routes are installed for the primary instance only */
+  if(rpl_curr_instance == &rpl_instances[0]) {
+    uip_ds6_route_t *route;
+    while((route = uip_ds6_route_head()) != NULL) {
+      uip_ds6_route_rm(route);
+    }
+  }
+#endif /* RPL_WITH_PROJECTED_ROUTES */
 
   /* Stop all timers */
   rpl_timers_stop_dag_timers();
 
-  /* Remove autoconfigured address */
-  if((curr_instance.dag.prefix_info.flags & UIP_ND6_RA_FLAG_AUTONOMOUS)) {
+  /* Remove autoconfigured address, unless still in use by another instance */
+  if((curr_instance.dag.prefix_info.flags & UIP_ND6_RA_FLAG_AUTONOMOUS)
+     && !prefix_used_by_other_instance(&curr_instance.dag.prefix_info)) {
     rpl_reset_prefix(&curr_instance.dag.prefix_info);
   }
 
@@ -134,9 +208,40 @@ rpl_dag_poison_and_leave(void)
   rpl_timers_schedule_state_update();
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_PROJECTED_ROUTES
+static void
+projected_routes_periodic(unsigned seconds)
+{
+  uip_ds6_route_t *route;
+  uip_ds6_route_t *next;
+
+  /* Projected routes only age while they are not in use */
+  for(route = uip_ds6_route_head(); route != NULL; route = next) {
+    next = uip_ds6_route_next(route);
+    if(route->state.state_flags & PROJECTED_ROUTE_USED) {
+      route->state.state_flags &= ~PROJECTED_ROUTE_USED;
+    } else if(route->state.lifetime != RPL_ROUTE_INFINITE_LIFETIME) {
+      route->state.lifetime = route->state.lifetime > seconds ? route->state.lifetime - seconds : 0;
+      if(route->state.lifetime == 0) {
+        LOG_INFO("projected route to ");
+        LOG_INFO_6ADDR(&route->ipaddr);
+        LOG_INFO_(" expired\n");
+        uip_ds6_route_rm(route);
+      }
+    }
+  }
+}
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+/*---------------------------------------------------------------------------*/
 void
 rpl_dag_periodic(unsigned seconds)
 {
+#if RPL_WITH_PROJECTED_ROUTES
+  if(rpl_curr_instance == &rpl_instances[0]) {
+    projected_routes_periodic(seconds);
+  }
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
   if(curr_instance.used) {
     if(curr_instance.dag.lifetime != RPL_LIFETIME(RPL_INFINITE_LIFETIME)) {
       curr_instance.dag.lifetime =
@@ -164,13 +269,13 @@ rpl_is_addr_in_our_dag(const uip_ipaddr_t *addr)
 rpl_instance_t *
 rpl_get_default_instance(void)
 {
-  return curr_instance.used ? &curr_instance : NULL;
+  return rpl_instances[0].used ? &rpl_instances[0] : NULL;
 }
 /*---------------------------------------------------------------------------*/
 rpl_dag_t *
 rpl_get_any_dag(void)
 {
-  return curr_instance.used ? &curr_instance.dag : NULL;
+  return rpl_instances[0].used ? &rpl_instances[0].dag : NULL;
 }
 /*---------------------------------------------------------------------------*/
 static rpl_of_t *
@@ -294,7 +399,7 @@ rpl_dag_update_state(void)
     curr_instance.dag.rank = rpl_neighbor_rank_via_nbr(curr_instance.dag.preferred_parent);
 
     /* Update better_parent_since flag for each neighbor */
-    nbr = nbr_table_head(rpl_neighbors);
+    nbr = rpl_neighbor_head();
     while(nbr != NULL) {
       if(rpl_neighbor_rank_via_nbr(nbr) < curr_instance.dag.rank) {
         /* This neighbor would be a better parent than our current.
@@ -305,7 +410,7 @@ rpl_dag_update_state(void)
       } else {
         nbr->better_parent_since = 0; /* Not a better parent */
       }
-      nbr = nbr_table_next(rpl_neighbors, nbr);
+      nbr = rpl_neighbor_next(nbr);
     }
 
     if(old_parent == NULL || curr_instance.dag.rank < curr_instance.dag.lowest_rank) {
@@ -379,8 +484,7 @@ update_nbr_from_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
     }
 
     /* Add neighbor to RPL table */
-    nbr = nbr_table_add_lladdr(rpl_neighbors, (linkaddr_t *)lladdr,
-                             NBR_TABLE_REASON_RPL_DIO, dio);
+    nbr = rpl_neighbor_add(lladdr, NBR_TABLE_REASON_RPL_DIO, dio);
     if(nbr == NULL) {
       LOG_ERR("failed to add neighbor\n");
       return NULL;
@@ -599,10 +703,24 @@ process_dio_init_dag(rpl_dio_t *dio)
 void
 rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
 {
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
+
+  instance = rpl_get_instance(dio->instance_id);
+  if(instance == NULL) {
+    instance = rpl_alloc_instance(dio->instance_id);
+    if(instance == NULL) {
+      LOG_INFO("no room for instance %u, ignoring DIO\n", dio->instance_id);
+      return;
+    }
+  }
+  prev = rpl_set_current_instance(instance);
+
   if(!curr_instance.used && !rpl_dag_root_is_root()) {
     /* Attempt to init our DAG from this DIO */
     if(!process_dio_init_dag(dio)) {
       LOG_WARN("failed to init DAG\n");
+      rpl_set_current_instance(prev);
       return;
     }
   }
@@ -613,19 +731,36 @@ rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
     process_dio_from_current_dag(from, dio);
     rpl_dag_update_state();
   }
+
+  rpl_set_current_instance(prev);
 }
 /*---------------------------------------------------------------------------*/
 void
 rpl_process_dis(uip_ipaddr_t *from, int is_multicast)
 {
-  if(is_multicast) {
-    rpl_timers_dio_reset("Multicast DIS");
-  } else {
-    /* Add neighbor to cache and reply to the unicast DIS with a unicast DIO*/
-    if(rpl_icmp6_update_nbr_table(from, NBR_TABLE_REASON_RPL_DIS, NULL) != NULL) {
+  rpl_instance_t *prev;
+  int i;
+
+  if(!is_multicast) {
+    /* Add neighbor to cache, we reply to the unicast DIS with a unicast DIO */
+    if(rpl_icmp6_update_nbr_table(from, NBR_TABLE_REASON_RPL_DIS, NULL) == NULL) {
+      return;
+    }
+  }
+
+  /* A DIS solicits DIOs from all instances */
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    if(!rpl_instances[i].used) {
+      continue;
+    }
+    prev = rpl_set_current_instance(&rpl_instances[i]);
+    if(is_multicast) {
+      rpl_timers_dio_reset("Multicast DIS");
+    } else {
       LOG_INFO("unicast DIS, reply to sender\n");
       rpl_icmp6_dio_output(from);
     }
+    rpl_set_current_instance(prev);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -633,9 +768,9 @@ void
 rpl_process_dao(uip_ipaddr_t *from, rpl_dao_t *dao)
 {
   if(dao->lifetime == 0) {
-    uip_sr_expire_parent(NULL, from, &dao->parent_addr);
+    uip_sr_expire_parent(rpl_curr_instance, from, &dao->parent_addr);
   } else {
-    if(!uip_sr_update_node(NULL, from, &dao->parent_addr, RPL_LIFETIME(dao->lifetime))) {
+    if(!uip_sr_update_node(rpl_curr_instance, from, &dao->parent_addr, RPL_LIFETIME(dao->lifetime))) {
       LOG_ERR("failed to add link on incoming DAO\n");
       return;
     }
@@ -648,6 +783,85 @@ rpl_process_dao(uip_ipaddr_t *from, rpl_dao_t *dao)
 #endif /* RPL_WITH_DAO_ACK */
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_PROJECTED_ROUTES
+void
+rpl_process_pdao(uip_ipaddr_t *from, rpl_dao_t *dao)
+{
+  uip_ipaddr_t via;
+  uip_ipaddr_t nexthop;
+  uip_ds6_route_t *route;
+  int i;
+
+  if(rpl_curr_instance != &rpl_instances[0] || rpl_dag_root_is_root()
+     || !uip_ipaddr_cmp(from, &curr_instance.dag.dag_id)) {
+    LOG_WARN("P-DAO not from the root of the primary instance, discard\n");
+    return;
+  }
+
+  if(dao->prefixlen != 128) {
+    LOG_WARN("P-DAO target is not a host address, discard\n");
+    return;
+  }
+
+  /* Find ourselves in the segment, the following via address is our next hop */
+  for(i = 0; i + 1 < dao->via_count; i++) {
+    memcpy(&via, dao->via + i * sizeof(uip_ipaddr_t), sizeof(via));
+    if(uip_ds6_is_my_addr(&via)) {
+      break;
+    }
+  }
+  if(i + 1 >= dao->via_count) {
+    LOG_WARN("P-DAO segment does not include us, discard\n");
+    return;
+  }
+
+  /* Neighbors are known by their link-local address, which shares the
+   * interface identifier of the global address */
+  memcpy(&via, dao->via + (i + 1) * sizeof(uip_ipaddr_t), sizeof(via));
+  uip_ip6addr(&nexthop, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  memcpy(((unsigned char *)&nexthop) + 8, ((unsigned char *)&via) + 8, 8);
+
+  if(dao->lifetime == 0) {
+    route = uip_ds6_route_lookup(&dao->prefix);
+    if(route != NULL && route->length == dao->prefixlen) {
+      uip_ds6_route_rm(route);
+    }
+    return;
+  }
+
+  route = uip_ds6_route_add(&dao->prefix, dao->prefixlen, &nexthop);
+  if(route == NULL) {
+    LOG_ERR("failed to add projected route to ");
+    LOG_ERR_6ADDR(&dao->prefix);
+    LOG_ERR_("\n");
+    return;
+  }
+  route->state.lifetime = RPL_LIFETIME(dao->lifetime);
+
+  LOG_INFO("projected route to ");
+  LOG_INFO_6ADDR(&dao->prefix);
+  LOG_INFO_(" via ");
+  LOG_INFO_6ADDR(&nexthop);
+  LOG_INFO_(", lifetime %lu\n", (unsigned long)route->state.lifetime);
+}
+/*---------------------------------------------------------------------------*/
+uip_ds6_route_t *
+rpl_dag_use_projected_route(const uip_ipaddr_t *addr)
+{
+  uip_ds6_route_t *route;
+
+  if(rpl_curr_instance != &rpl_instances[0]) {
+    return NULL;
+  }
+
+  route = uip_ds6_route_lookup(addr);
+  if(route != NULL) {
+    route->state.state_flags |= PROJECTED_ROUTE_USED;
+  }
+  return route;
+}
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+/*---------------------------------------------------------------------------*/
 #if RPL_WITH_DAO_ACK
 void
 rpl_process_dao_ack(uint8_t sequence, uint8_t status)
@@ -710,7 +924,7 @@ rpl_process_hbh(rpl_nbr_t *sender, uint16_t sender_rank, int loop_detected, int
 }
 /*---------------------------------------------------------------------------*/
 void
-rpl_dag_init_root(uint8_t instance_id, uip_ipaddr_t *dag_id,
+rpl_dag_init_root(uint8_t instance_id, rpl_ocp_t ocp, uip_ipaddr_t *dag_id,
             uip_ipaddr_t *prefix, unsigned prefix_len, uint8_t prefix_flags)
 {
   uint8_t version = RPL_LOLLIPOP_INIT;
@@ -726,7 +940,9 @@ rpl_dag_init_root(uint8_t instance_id, uip_ipaddr_t *dag_id,
   }
 
   /* Init DAG and instance */
-  init_dag(instance_id, dag_id, RPL_OF_OCP, prefix, prefix_len, prefix_flags);
+  if(!init_dag(instance_id, dag_id, ocp, prefix, prefix_len, prefix_flags)) {
+    return;
+  }
 
   /* Instance */
   curr_instance.mop = RPL_MOP_DEFAULT;
@@ -761,7 +977,8 @@ rpl_dag_init_root(uint8_t instance_id, uip_ipaddr_t *dag_id,
 void
 rpl_dag_init(void)
 {
-  memset(&curr_instance, 0, sizeof(curr_instance));
+  memset(rpl_instances, 0, sizeof(rpl_instances));
+  rpl_curr_instance = &rpl_instances[0];
 }
 /*---------------------------------------------------------------------------*/
 /** @} */
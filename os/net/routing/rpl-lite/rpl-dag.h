@@ -106,28 +106,55 @@ void rpl_local_repair(const char *str);
 int rpl_is_addr_in_our_dag(const uip_ipaddr_t *addr);
 
 /**
- * Initializes DAG internal structure for a root node
+ * Initializes DAG internal structure for a root node, in the current instance
  *
  * \param instance_id The instance ID
+ * \param ocp The objective code point of the instance's OF
  * \param dag_id The DAG ID
  * \param prefix The prefix
  * \param prefix_len The prefix length
  * \param flags The prefix flags (from DIO)
 */
-void rpl_dag_init_root(uint8_t instance_id, uip_ipaddr_t *dag_id,
+void rpl_dag_init_root(uint8_t instance_id, rpl_ocp_t ocp, uip_ipaddr_t *dag_id,
   uip_ipaddr_t *prefix, unsigned prefix_len, uint8_t flags);
 
 /**
- * Returns pointer to the default instance (for compatibility with legagy RPL code)
+ * Selects the instance all subsequent RPL processing applies to. Callers
+ * must restore the previous instance when done.
  *
- * \return A pointer to the only supported instance
+ * \param instance The instance to select, one of rpl_instances
+ * \return The previously selected instance
+*/
+rpl_instance_t *rpl_set_current_instance(rpl_instance_t *instance);
+
+/**
+ * Returns the instance with a given ID, if we are part of it
+ *
+ * \param instance_id The instance ID
+ * \return A pointer to the instance, NULL if not found
+*/
+rpl_instance_t *rpl_get_instance(uint8_t instance_id);
+
+/**
+ * Returns a free instance slot for a given instance, if any. The primary
+ * slot only takes RPL_DEFAULT_INSTANCE, unless RPL_MAX_INSTANCES is 1.
+ *
+ * \param instance_id The instance ID
+ * \return A pointer to an unused instance, NULL if there is no room
+*/
+rpl_instance_t *rpl_alloc_instance(uint8_t instance_id);
+
+/**
+ * Returns pointer to the default (primary) instance
+ *
+ * \return A pointer to the primary instance, NULL if not in use
 */
 rpl_instance_t *rpl_get_default_instance(void);
 
 /**
  * Returns pointer to any DAG (for compatibility with legagy RPL code)
  *
- * \return A pointer to the only supported DAG
+ * \return A pointer to the DAG of the primary instance
 */
 rpl_dag_t *rpl_get_any_dag(void);
 
@@ -166,6 +193,26 @@ void rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio);
 */
 void rpl_process_dao(uip_ipaddr_t *from, rpl_dao_t *dao);
 
+#if RPL_WITH_PROJECTED_ROUTES
+/**
+ * Processes incoming projected DAO (P-DAO), i.e. installs or removes the
+ * route towards the P-DAO target
+ *
+ * \param from The IPv6 address of the originator
+ * \param dao A pointer to a parsed P-DAO
+*/
+void rpl_process_pdao(uip_ipaddr_t *from, rpl_dao_t *dao);
+
+/**
+ * Looks up the projected route towards an address, and marks it as used,
+ * which keeps it from expiring
+ *
+ * \param addr The destination address
+ * \return The projected route, NULL if none
+*/
+uip_ds6_route_t *rpl_dag_use_projected_route(const uip_ipaddr_t *addr);
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
 /**
  * Processes incoming DAO-ACK
  *
@@ -54,8 +54,49 @@
 #define LOG_LEVEL LOG_LEVEL_RPL
 
 /*---------------------------------------------------------------------------*/
-int
-rpl_ext_header_srh_get_next_hop(uip_ipaddr_t *ipaddr)
+/* Returns the instance the packet in uip_buf belongs to: the one from its
+ * RPL HBH option if any, else the one requested by the application through
+ * UIPBUF_ATTR_RPL_INSTANCE, else the current instance. */
+static rpl_instance_t *
+get_packet_instance(void)
+{
+  struct uip_ext_hdr_opt_rpl *rpl_opt = (struct uip_ext_hdr_opt_rpl *)(UIP_IP_PAYLOAD(2));
+  rpl_instance_t *instance = NULL;
+
+  if(UIP_IP_BUF->proto == UIP_PROTO_HBHO && rpl_opt->opt_type == UIP_EXT_HDR_OPT_RPL) {
+    instance = rpl_get_instance(rpl_opt->instance);
+  } else if(uipbuf_get_attr(UIPBUF_ATTR_RPL_INSTANCE) != UIPBUF_ATTR_RPL_INSTANCE_NONE) {
+    instance = rpl_get_instance(uipbuf_get_attr(UIPBUF_ATTR_RPL_INSTANCE));
+  }
+
+  return instance != NULL ? instance : rpl_curr_instance;
+}
+/*---------------------------------------------------------------------------*/
+/* Upward next hop for instances other than the primary one, which instead
+ * relies on the DS6 default route. */
+static int
+get_upward_next_hop(uip_ipaddr_t *ipaddr)
+{
+  uip_ipaddr_t *parent_ipaddr;
+
+  if(rpl_curr_instance == &rpl_instances[0]
+     || !curr_instance.used
+     || rpl_dag_root_is_root()
+     || uip_ds6_is_addr_onlink(&UIP_IP_BUF->destipaddr)) {
+    return 0;
+  }
+
+  parent_ipaddr = rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent);
+  if(parent_ipaddr == NULL) {
+    return 0;
+  }
+
+  uip_ipaddr_copy(ipaddr, parent_ipaddr);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+get_next_hop(uip_ipaddr_t *ipaddr)
 {
   struct uip_routing_hdr *rh_header;
   uip_sr_node_t *dest_node;
@@ -65,11 +106,11 @@ rpl_ext_header_srh_get_next_hop(uip_ipaddr_t *ipaddr)
   rh_header = (struct uip_routing_hdr *)uipbuf_search_header(uip_buf, uip_len, UIP_PROTO_ROUTING);
 
   if(!rpl_is_addr_in_our_dag(&UIP_IP_BUF->destipaddr)) {
-    return 0;
+    return get_upward_next_hop(ipaddr);
   }
 
-  root_node = uip_sr_get_node(NULL, &curr_instance.dag.dag_id);
-  dest_node = uip_sr_get_node(NULL, &UIP_IP_BUF->destipaddr);
+  root_node = uip_sr_get_node(rpl_curr_instance, &curr_instance.dag.dag_id);
+  dest_node = uip_sr_get_node(rpl_curr_instance, &UIP_IP_BUF->destipaddr);
 
   if((rh_header != NULL && rh_header->routing_type == RPL_RH_TYPE_SRH) ||
      (dest_node != NULL && root_node != NULL &&
@@ -84,7 +125,16 @@ rpl_ext_header_srh_get_next_hop(uip_ipaddr_t *ipaddr)
   }
 
   LOG_DBG("no SRH found\n");
-  return 0;
+  return get_upward_next_hop(ipaddr);
+}
+/*---------------------------------------------------------------------------*/
+int
+rpl_ext_header_srh_get_next_hop(uip_ipaddr_t *ipaddr)
+{
+  rpl_instance_t *prev = rpl_set_current_instance(get_packet_instance());
+  int ret = get_next_hop(ipaddr);
+  rpl_set_current_instance(prev);
+  return ret;
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -211,20 +261,20 @@ insert_srh_header(void)
     return 1;
   }
 
-  dest_node = uip_sr_get_node(NULL, &UIP_IP_BUF->destipaddr);
+  dest_node = uip_sr_get_node(rpl_curr_instance, &UIP_IP_BUF->destipaddr);
   if(dest_node == NULL) {
     /* The destination is not found, skip SRH insertion */
     LOG_INFO("SRH node not found, skip SRH insertion\n");
     return 1;
   }
 
-  root_node = uip_sr_get_node(NULL, &curr_instance.dag.dag_id);
+  root_node = uip_sr_get_node(rpl_curr_instance, &curr_instance.dag.dag_id);
   if(root_node == NULL) {
     LOG_ERR("SRH root node not found\n");
     return 0;
   }
 
-  if(!uip_sr_is_addr_reachable(NULL, &UIP_IP_BUF->destipaddr)) {
+  if(!uip_sr_is_addr_reachable(rpl_curr_instance, &UIP_IP_BUF->destipaddr)) {
     LOG_ERR("SRH no path found to destination\n");
     return 0;
   }
@@ -324,6 +374,9 @@ rpl_ext_header_hbh_update(uint8_t *ext_buf, int opt_offset)
   uint16_t sender_rank;
   uint8_t sender_closer;
   rpl_nbr_t *sender;
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
+  int ret;
   struct uip_hbho_hdr *hbh_hdr = (struct uip_hbho_hdr *)ext_buf;
   struct uip_ext_hdr_opt_rpl *rpl_opt = (struct uip_ext_hdr_opt_rpl *)(ext_buf + opt_offset);
 
@@ -335,7 +388,8 @@ rpl_ext_header_hbh_update(uint8_t *ext_buf, int opt_offset)
     return 0; /* Drop */
   }
 
-  if(!curr_instance.used || curr_instance.instance_id != rpl_opt->instance) {
+  instance = rpl_get_instance(rpl_opt->instance);
+  if(instance == NULL) {
     LOG_ERR("unknown instance: %u\n", rpl_opt->instance);
     return 0; /* Drop */
   }
@@ -345,9 +399,11 @@ rpl_ext_header_hbh_update(uint8_t *ext_buf, int opt_offset)
     return 0; /* Drop */
   }
 
+  prev = rpl_set_current_instance(instance);
+
   down = (rpl_opt->flags & RPL_HDR_OPT_DOWN) ? 1 : 0;
   sender_rank = UIP_HTONS(rpl_opt->senderrank);
-  sender = nbr_table_get_from_lladdr(rpl_neighbors, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  sender = rpl_neighbor_get_from_lladdr((uip_lladdr_t *)packetbuf_addr(PACKETBUF_ADDR_SENDER));
   rank_error_signaled = (rpl_opt->flags & RPL_HDR_OPT_RANK_ERR) ? 1 : 0;
   sender_closer = sender_rank < curr_instance.dag.rank;
   loop_detected = (down && !sender_closer) || (!down && sender_closer);
@@ -365,7 +421,9 @@ rpl_ext_header_hbh_update(uint8_t *ext_buf, int opt_offset)
     rpl_opt->flags |= RPL_HDR_OPT_RANK_ERR;
   }
 
-  return rpl_process_hbh(sender, sender_rank, loop_detected, rank_error_signaled);
+  ret = rpl_process_hbh(sender, sender_rank, loop_detected, rank_error_signaled);
+  rpl_set_current_instance(prev);
+  return ret;
 }
 /*---------------------------------------------------------------------------*/
 /* In-place update of the RPL HBH extension header, when already present
@@ -393,6 +451,16 @@ update_hbh_header(void)
     /* Update sender rank and instance, will update flags next */
     rpl_opt->senderrank = UIP_HTONS(curr_instance.dag.rank);
     rpl_opt->instance = curr_instance.instance_id;
+
+#if RPL_WITH_PROJECTED_ROUTES
+    /* Packets following a projected route go down the DODAG, all
+     * others go up towards the root */
+    if(rpl_dag_use_projected_route(&UIP_IP_BUF->destipaddr) != NULL) {
+      rpl_opt->flags |= RPL_HDR_OPT_DOWN;
+    } else {
+      rpl_opt->flags &= ~RPL_HDR_OPT_DOWN;
+    }
+#endif /* RPL_WITH_PROJECTED_ROUTES */
   }
 
   return 1;
@@ -438,8 +506,8 @@ insert_hbh_header(void)
   return update_hbh_header();
 }
 /*---------------------------------------------------------------------------*/
-int
-rpl_ext_header_update(void)
+static int
+update_ext_headers(void)
 {
   if(!curr_instance.used
       || uip_is_addr_linklocal(&UIP_IP_BUF->destipaddr)
@@ -451,6 +519,13 @@ rpl_ext_header_update(void)
     /* At the root, remove headers if any, and insert SRH or HBH
     * (SRH is inserted only if the destination is down the DODAG) */
     rpl_ext_header_remove();
+#if RPL_WITH_PROJECTED_ROUTES
+    /* Account for flows we forward within the DODAG */
+    if(!uip_ds6_is_my_addr(&UIP_IP_BUF->srcipaddr)
+       && rpl_is_addr_in_our_dag(&UIP_IP_BUF->srcipaddr)) {
+      rpl_dag_root_count_flow(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+    }
+#endif /* RPL_WITH_PROJECTED_ROUTES */
     /* Insert SRH (if needed) */
     return insert_srh_header();
   } else {
@@ -466,6 +541,15 @@ rpl_ext_header_update(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+int
+rpl_ext_header_update(void)
+{
+  rpl_instance_t *prev = rpl_set_current_instance(get_packet_instance());
+  int ret = update_ext_headers();
+  rpl_set_current_instance(prev);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
 bool
 rpl_ext_header_remove(void)
 {
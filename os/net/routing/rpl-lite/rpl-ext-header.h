@@ -45,7 +45,9 @@
 /********** Public functions **********/
 
 /**
-* Look for next hop from SRH of current uIP packet.
+* Look for next hop from SRH of current uIP packet. For packets of
+* instances other than the primary one, also returns the preferred parent
+* of that instance as upward next hop.
 *
 * \param ipaddr A pointer to the address where to store the next hop.
 * \return 1 if a next hop was found, 0 otherwise
@@ -131,7 +131,13 @@ rpl_icmp6_update_nbr_table(uip_ipaddr_t *from, nbr_table_reason_t reason, void *
 static void
 dis_input(void)
 {
-  if(!curr_instance.used) {
+  int i;
+  int in_instance = 0;
+
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    in_instance |= rpl_instances[i].used;
+  }
+  if(!in_instance) {
     LOG_WARN("dis_input: not in an instance yet, discard\n");
     goto discard;
   }
@@ -462,14 +468,19 @@ dao_input(void)
   int len;
   int i;
   uip_ipaddr_t from;
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
 
   memset(&dao, 0, sizeof(dao));
 
   dao.instance_id = UIP_ICMP_PAYLOAD[0];
-  if(!curr_instance.used || curr_instance.instance_id != dao.instance_id) {
+  instance = rpl_get_instance(dao.instance_id);
+  if(instance == NULL) {
     LOG_ERR("dao_input: unknown RPL instance %u, discard\n", dao.instance_id);
-    goto discard;
+    uipbuf_clear();
+    return;
   }
+  prev = rpl_set_current_instance(instance);
 
   uip_ipaddr_copy(&from, &UIP_IP_BUF->srcipaddr);
   memset(&dao.parent_addr, 0, 16);
@@ -521,9 +532,31 @@ dao_input(void)
           memcpy(&dao.parent_addr, buffer + i + 6, 16);
         }
         break;
+#if RPL_WITH_PROJECTED_ROUTES
+      case RPL_OPTION_SM_VIO:
+        /* Flags and segment ID are ignored, as is the segment sequence:
+         * the root only projects one segment per target. */
+        dao.lifetime = buffer[i + 5];
+        dao.via = buffer + i + 6;
+        dao.via_count = (len - 6) / sizeof(uip_ipaddr_t);
+        break;
+#endif /* RPL_WITH_PROJECTED_ROUTES */
     }
   }
 
+#if RPL_WITH_PROJECTED_ROUTES
+  if(dao.flags & RPL_DAO_P_FLAG) {
+    LOG_INFO("received a %sP-DAO from ", dao.lifetime == 0 ? "No-path " : "");
+    LOG_INFO_6ADDR(&UIP_IP_BUF->srcipaddr);
+    LOG_INFO_(", seqno %u, lifetime %u, target ", dao.sequence, dao.lifetime);
+    LOG_INFO_6ADDR(&dao.prefix);
+    LOG_INFO_(", %u via addresses\n", dao.via_count);
+
+    rpl_process_pdao(&from, &dao);
+    goto discard;
+  }
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
   /* Destination Advertisement Object */
   LOG_INFO("received a %sDAO from ", dao.lifetime == 0 ? "No-path " : "");
   LOG_INFO_6ADDR(&UIP_IP_BUF->srcipaddr);
@@ -536,6 +569,7 @@ dao_input(void)
   rpl_process_dao(&from, &dao);
 
   discard:
+    rpl_set_current_instance(prev);
     uipbuf_clear();
 }
 /*---------------------------------------------------------------------------*/
@@ -617,6 +651,64 @@ rpl_icmp6_dao_output(uint8_t lifetime)
   /* Send DAO to root (IPv6 address is DAG ID) */
   uip_icmp6_send(&curr_instance.dag.dag_id, ICMP6_RPL, RPL_CODE_DAO, pos);
 }
+#if RPL_WITH_PROJECTED_ROUTES
+/*---------------------------------------------------------------------------*/
+void
+rpl_icmp6_pdao_output(const uip_ipaddr_t *dest, const uip_ipaddr_t *target,
+                      const uip_ipaddr_t *via, uint8_t via_count,
+                      uint8_t lifetime)
+{
+  static uint8_t pdao_seqno = RPL_LOLLIPOP_INIT;
+  unsigned char *buffer;
+  uint8_t prefixlen;
+  int pos;
+
+  if(!curr_instance.used || via_count < 2) {
+    return;
+  }
+
+  RPL_LOLLIPOP_INCREMENT(pdao_seqno);
+
+  buffer = UIP_ICMP_PAYLOAD;
+  pos = 0;
+
+  buffer[pos++] = curr_instance.instance_id;
+  buffer[pos++] = RPL_DAO_P_FLAG | RPL_DAO_D_FLAG;
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = pdao_seqno;
+  memcpy(buffer + pos, &curr_instance.dag.dag_id, sizeof(curr_instance.dag.dag_id));
+  pos += sizeof(curr_instance.dag.dag_id);
+
+  /* create target subopt */
+  prefixlen = sizeof(*target) * CHAR_BIT;
+  buffer[pos++] = RPL_OPTION_TARGET;
+  buffer[pos++] = 2 + ((prefixlen + 7) / CHAR_BIT);
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = prefixlen;
+  memcpy(buffer + pos, target, (prefixlen + 7) / CHAR_BIT);
+  pos += ((prefixlen + 7) / CHAR_BIT);
+
+  /* Create a storing-mode via information sub-option. The via addresses
+   * are sent in full rather than in a compressed SRH-6LoRH */
+  buffer[pos++] = RPL_OPTION_SM_VIO;
+  buffer[pos++] = 4 + via_count * sizeof(uip_ipaddr_t);
+  buffer[pos++] = 0; /* flags - ignored */
+  buffer[pos++] = 0; /* segment ID - ignored */
+  buffer[pos++] = pdao_seqno; /* segment sequence */
+  buffer[pos++] = lifetime;
+  memcpy(buffer + pos, via, via_count * sizeof(uip_ipaddr_t));
+  pos += via_count * sizeof(uip_ipaddr_t);
+
+  LOG_INFO("sending a %sP-DAO seqno %u, lifetime %u, target ",
+         lifetime == 0 ? "No-path " : "", pdao_seqno, lifetime);
+  LOG_INFO_6ADDR(target);
+  LOG_INFO_(" to ");
+  LOG_INFO_6ADDR(dest);
+  LOG_INFO_(", %u via addresses\n", via_count);
+
+  uip_icmp6_send(dest, ICMP6_RPL, RPL_CODE_DAO, pos);
+}
+#endif /* RPL_WITH_PROJECTED_ROUTES */
 #if RPL_WITH_DAO_ACK
 /*---------------------------------------------------------------------------*/
 static void
@@ -626,6 +718,8 @@ dao_ack_input(void)
   uint8_t instance_id;
   uint8_t sequence;
   uint8_t status;
+  rpl_instance_t *instance;
+  rpl_instance_t *prev;
 
   buffer = UIP_ICMP_PAYLOAD;
 
@@ -633,10 +727,13 @@ dao_ack_input(void)
   sequence = buffer[2];
   status = buffer[3];
 
-  if(!curr_instance.used || curr_instance.instance_id != instance_id) {
+  instance = rpl_get_instance(instance_id);
+  if(instance == NULL) {
     LOG_ERR("dao_ack_input: unknown instance, discard\n");
-    goto discard;
+    uipbuf_clear();
+    return;
   }
+  prev = rpl_set_current_instance(instance);
 
   LOG_INFO("received a DAO-%s with seqno %d (%d %d) and status %d from ",
          status < RPL_DAO_ACK_UNABLE_TO_ACCEPT ? "ACK" : "NACK", sequence,
@@ -646,8 +743,8 @@ dao_ack_input(void)
 
   rpl_process_dao_ack(sequence, status);
 
-  discard:
-    uipbuf_clear();
+  rpl_set_current_instance(prev);
+  uipbuf_clear();
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -81,6 +81,11 @@ struct rpl_dao {
   uint8_t lifetime;
   uint8_t prefixlen;
   uint8_t flags;
+#if RPL_WITH_PROJECTED_ROUTES
+  /* Via addresses of a projected DAO, pointing into the packet buffer */
+  const uint8_t *via;
+  uint8_t via_count;
+#endif /* RPL_WITH_PROJECTED_ROUTES */
 };
 typedef struct rpl_dao rpl_dao_t;
 
@@ -120,6 +125,23 @@ void rpl_icmp6_dio_output(uip_ipaddr_t *uc_addr);
 */
 void rpl_icmp6_dao_output(uint8_t lifetime);
 
+#if RPL_WITH_PROJECTED_ROUTES
+/**
+ * Creates an ICMPv6 projected DAO (P-DAO) packet and sends it from the root
+ * to a node of a projected segment. The segment is carried in a
+ * storing-mode Via Information option.
+ *
+ * \param dest The global address of the node to install the route at
+ * \param target The target of the projected route
+ * \param via The global addresses of the segment, from ingress to egress
+ * \param via_count The number of addresses in via
+ * \param lifetime The route lifetime. Use 0 to remove the route
+*/
+void rpl_icmp6_pdao_output(const uip_ipaddr_t *dest, const uip_ipaddr_t *target,
+                           const uip_ipaddr_t *via, uint8_t via_count,
+                           uint8_t lifetime);
+#endif /* RPL_WITH_PROJECTED_ROUTES */
+
 /**
  * Creates an ICMPv6 DAO-ACK packet and sends it to the originator
  * of the ACK.
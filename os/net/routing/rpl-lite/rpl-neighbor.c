@@ -61,8 +61,88 @@ void RPL_CALLBACK_PARENT_SWITCH(rpl_nbr_t *old, rpl_nbr_t *new);
 static rpl_nbr_t * best_parent(int fresh_only);
 
 /*---------------------------------------------------------------------------*/
-/* Per-neighbor RPL information */
-NBR_TABLE_GLOBAL(rpl_nbr_t, rpl_neighbors);
+/* Per-neighbor RPL information. A single table serves all instances: each
+ * entry holds the neighbor's state in every instance slot, and tells which
+ * instances it is a neighbor, and a preferred parent, in. The rpl_nbr_t
+ * handed out are those of the current instance. */
+#if RPL_MAX_INSTANCES > 8
+#error "RPL_MAX_INSTANCES must not exceed 8"
+#endif /* RPL_MAX_INSTANCES > 8 */
+
+typedef struct rpl_nbr_entry {
+  rpl_nbr_t instances[RPL_MAX_INSTANCES];
+#if RPL_MAX_INSTANCES > 1
+  uint8_t member_of;            /* bit i set for slot i */
+  uint8_t parent_of;            /* bit i set for slot i */
+#endif /* RPL_MAX_INSTANCES > 1 */
+} rpl_nbr_entry_t;
+
+NBR_TABLE(rpl_nbr_entry_t, rpl_neighbors);
+
+#define CURR_SLOT (rpl_curr_instance - rpl_instances)
+#define CURR_BIT  (1 << CURR_SLOT)
+
+/*---------------------------------------------------------------------------*/
+static rpl_nbr_entry_t *
+entry_of(const rpl_nbr_t *nbr)
+{
+  return nbr != NULL ? (rpl_nbr_entry_t *)(nbr - CURR_SLOT) : NULL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+in_curr_instance(const rpl_nbr_entry_t *entry)
+{
+#if RPL_MAX_INSTANCES > 1
+  return (entry->member_of & CURR_BIT) != 0;
+#else /* RPL_MAX_INSTANCES > 1 */
+  return 1;
+#endif /* RPL_MAX_INSTANCES > 1 */
+}
+/*---------------------------------------------------------------------------*/
+/* The first neighbor of the current instance from a given entry on */
+static rpl_nbr_t *
+first_from(rpl_nbr_entry_t *entry)
+{
+  while(entry != NULL && !in_curr_instance(entry)) {
+    entry = nbr_table_next(rpl_neighbors, entry);
+  }
+  return entry != NULL ? &entry->instances[CURR_SLOT] : NULL;
+}
+/*---------------------------------------------------------------------------*/
+rpl_nbr_t *
+rpl_neighbor_head(void)
+{
+  return first_from(nbr_table_head(rpl_neighbors));
+}
+/*---------------------------------------------------------------------------*/
+rpl_nbr_t *
+rpl_neighbor_next(rpl_nbr_t *nbr)
+{
+  return first_from(nbr_table_next(rpl_neighbors, entry_of(nbr)));
+}
+/*---------------------------------------------------------------------------*/
+rpl_nbr_t *
+rpl_neighbor_add(const uip_lladdr_t *lladdr, nbr_table_reason_t reason,
+                 void *data)
+{
+  rpl_nbr_entry_t *entry;
+
+  entry = nbr_table_get_from_lladdr(rpl_neighbors, (const linkaddr_t *)lladdr);
+  if(entry == NULL) {
+    entry = nbr_table_add_lladdr(rpl_neighbors, (const linkaddr_t *)lladdr,
+                                 reason, data);
+    if(entry == NULL) {
+      return NULL;
+    }
+  } else {
+    /* Already a neighbor in another instance */
+    memset(&entry->instances[CURR_SLOT], 0, sizeof(rpl_nbr_t));
+  }
+#if RPL_MAX_INSTANCES > 1
+  entry->member_of |= CURR_BIT;
+#endif /* RPL_MAX_INSTANCES > 1 */
+  return &entry->instances[CURR_SLOT];
+}
 
 /*---------------------------------------------------------------------------*/
 static int
@@ -145,7 +225,7 @@ rpl_neighbor_print_list(const char *str)
   if(curr_instance.used) {
     int curr_dio_interval = curr_instance.dag.dio_intcurrent;
     int curr_rank = curr_instance.dag.rank;
-    rpl_nbr_t *nbr = nbr_table_head(rpl_neighbors);
+    rpl_nbr_t *nbr = rpl_neighbor_head();
 
     LOG_INFO("nbr: own state, addr ");
     LOG_INFO_6ADDR(rpl_get_global_address());
@@ -158,7 +238,7 @@ rpl_neighbor_print_list(const char *str)
       char buf[120];
       rpl_neighbor_snprint(buf, sizeof(buf), nbr);
       LOG_INFO("nbr: %s\n", buf);
-      nbr = nbr_table_next(rpl_neighbors, nbr);
+      nbr = rpl_neighbor_next(nbr);
     }
     LOG_INFO("nbr: end of list\n");
   }
@@ -168,10 +248,10 @@ int
 rpl_neighbor_count(void)
 {
   int count = 0;
-  rpl_nbr_t *nbr = nbr_table_head(rpl_neighbors);
-  for(nbr = nbr_table_head(rpl_neighbors);
+  rpl_nbr_t *nbr;
+  for(nbr = rpl_neighbor_head();
       nbr != NULL;
-      nbr = nbr_table_next(rpl_neighbors, nbr)) {
+      nbr = rpl_neighbor_next(nbr)) {
     count++;
   }
   return count;
@@ -191,7 +271,7 @@ rpl_get_ds6_nbr(rpl_nbr_t *nbr)
 #endif /* UIP_ND6_SEND_NS */
 /*---------------------------------------------------------------------------*/
 static void
-remove_neighbor(rpl_nbr_t *nbr)
+forget_neighbor(rpl_nbr_t *nbr)
 {
   /* Make sure we don't point to a removed neighbor. Note that we do not need
   to worry about preferred_parent here, as it is locked in the the table
@@ -205,14 +285,54 @@ remove_neighbor(rpl_nbr_t *nbr)
   if(nbr == curr_instance.dag.unicast_dio_target) {
     curr_instance.dag.unicast_dio_target = NULL;
   }
-  nbr_table_remove(rpl_neighbors, nbr);
   rpl_timers_schedule_state_update(); /* Updating from here is unsafe; postpone */
 }
 /*---------------------------------------------------------------------------*/
+/* Removes a neighbor from the current instance, and from the table once it
+ * is in no instance any more */
+static void
+remove_neighbor(rpl_nbr_t *nbr)
+{
+  rpl_nbr_entry_t *entry = entry_of(nbr);
+
+  forget_neighbor(nbr);
+#if RPL_MAX_INSTANCES > 1
+  entry->member_of &= ~CURR_BIT;
+  if(entry->member_of != 0) {
+    return;
+  }
+#endif /* RPL_MAX_INSTANCES > 1 */
+  nbr_table_remove(rpl_neighbors, entry);
+}
+/*---------------------------------------------------------------------------*/
+/* Neighbor table callback: the neighbor is gone from all instances */
+static void
+remove_entry(rpl_nbr_entry_t *entry)
+{
+  rpl_instance_t *prev;
+  int i;
+
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    prev = rpl_set_current_instance(&rpl_instances[i]);
+    if(in_curr_instance(entry)) {
+      forget_neighbor(&entry->instances[i]);
+    }
+    rpl_set_current_instance(prev);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static rpl_nbr_t *
+get_from_entry(rpl_nbr_entry_t *entry)
+{
+  return entry != NULL && in_curr_instance(entry)
+    ? &entry->instances[CURR_SLOT] : NULL;
+}
+/*---------------------------------------------------------------------------*/
 rpl_nbr_t *
 rpl_neighbor_get_from_lladdr(uip_lladdr_t *addr)
 {
-  return nbr_table_get_from_lladdr(rpl_neighbors, (linkaddr_t *)addr);
+  return get_from_entry(nbr_table_get_from_lladdr(rpl_neighbors,
+                                                  (linkaddr_t *)addr));
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -245,7 +365,7 @@ rpl_neighbor_rank_via_nbr(rpl_nbr_t *nbr)
 const linkaddr_t *
 rpl_neighbor_get_lladdr(rpl_nbr_t *nbr)
 {
-  return nbr_table_get_lladdr(rpl_neighbors, nbr);
+  return nbr_table_get_lladdr(rpl_neighbors, entry_of(nbr));
 }
 /*---------------------------------------------------------------------------*/
 uip_ipaddr_t *
@@ -275,6 +395,36 @@ rpl_neighbor_is_parent(rpl_nbr_t *nbr)
   return nbr != NULL && nbr->rank < curr_instance.dag.rank;
 }
 /*---------------------------------------------------------------------------*/
+static void
+lock_parent(rpl_nbr_t *nbr)
+{
+  rpl_nbr_entry_t *entry = entry_of(nbr);
+
+  if(entry != NULL) {
+#if RPL_MAX_INSTANCES > 1
+    entry->parent_of |= CURR_BIT;
+#endif /* RPL_MAX_INSTANCES > 1 */
+    nbr_table_lock(rpl_neighbors, entry);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+unlock_parent(rpl_nbr_t *nbr)
+{
+  rpl_nbr_entry_t *entry = entry_of(nbr);
+
+  if(entry != NULL) {
+#if RPL_MAX_INSTANCES > 1
+    entry->parent_of &= ~CURR_BIT;
+    if(entry->parent_of != 0) {
+      /* Still the preferred parent in another instance */
+      return;
+    }
+#endif /* RPL_MAX_INSTANCES > 1 */
+    nbr_table_unlock(rpl_neighbors, entry);
+  }
+}
+/*---------------------------------------------------------------------------*/
 void
 rpl_neighbor_set_preferred_parent(rpl_nbr_t *nbr)
 {
@@ -285,19 +435,23 @@ rpl_neighbor_set_preferred_parent(rpl_nbr_t *nbr)
     LOG_INFO_6ADDR(rpl_neighbor_get_ipaddr(nbr));
     LOG_INFO_("\n");
 
-#ifdef RPL_CALLBACK_PARENT_SWITCH
-    RPL_CALLBACK_PARENT_SWITCH(curr_instance.dag.preferred_parent, nbr);
-#endif /* RPL_CALLBACK_PARENT_SWITCH */
-
     /* Always keep the preferred parent locked, so it remains in the
      * neighbor table. */
-    nbr_table_unlock(rpl_neighbors, curr_instance.dag.preferred_parent);
-    nbr_table_lock(rpl_neighbors, nbr);
+    unlock_parent(curr_instance.dag.preferred_parent);
+    lock_parent(nbr);
 
-    /* Update DS6 default route. Use an infinite lifetime */
-    uip_ds6_defrt_rm(uip_ds6_defrt_lookup(
-      rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent)));
-    uip_ds6_defrt_add(rpl_neighbor_get_ipaddr(nbr), 0);
+    /* Only the primary instance drives the default route. Upward
+     * routing in other instances is done in rpl_ext_header_srh_get_next_hop */
+    if(rpl_curr_instance == &rpl_instances[0]) {
+#ifdef RPL_CALLBACK_PARENT_SWITCH
+      RPL_CALLBACK_PARENT_SWITCH(curr_instance.dag.preferred_parent, nbr);
+#endif /* RPL_CALLBACK_PARENT_SWITCH */
+
+      /* Update DS6 default route. Use an infinite lifetime */
+      uip_ds6_defrt_rm(uip_ds6_defrt_lookup(
+        rpl_neighbor_get_ipaddr(curr_instance.dag.preferred_parent)));
+      uip_ds6_defrt_add(rpl_neighbor_get_ipaddr(nbr), 0);
+    }
 
     curr_instance.dag.preferred_parent = nbr;
     curr_instance.dag.unprocessed_parent_switch = true;
@@ -317,10 +471,10 @@ rpl_neighbor_remove_all(void)
    * all actions necessary after losing the preferred parent */
   rpl_neighbor_set_preferred_parent(NULL);
 
-  nbr = nbr_table_head(rpl_neighbors);
+  nbr = rpl_neighbor_head();
   while(nbr != NULL) {
     remove_neighbor(nbr);
-    nbr = nbr_table_next(rpl_neighbors, nbr);
+    nbr = rpl_neighbor_next(nbr);
   }
 
   /* Update needed immediately. As we have lost the preferred parent this will
@@ -333,7 +487,8 @@ rpl_neighbor_get_from_ipaddr(uip_ipaddr_t *addr)
 {
   uip_ds6_nbr_t *ds6_nbr = uip_ds6_nbr_lookup(addr);
   const uip_lladdr_t *lladdr = uip_ds6_nbr_get_ll(ds6_nbr);
-  return nbr_table_get_from_lladdr(rpl_neighbors, (linkaddr_t *)lladdr);
+  return get_from_entry(nbr_table_get_from_lladdr(rpl_neighbors,
+                                                  (linkaddr_t *)lladdr));
 }
 /*---------------------------------------------------------------------------*/
 static rpl_nbr_t *
@@ -347,7 +502,7 @@ best_parent(int fresh_only)
   }
 
   /* Search for the best parent according to the OF */
-  for(nbr = nbr_table_head(rpl_neighbors); nbr != NULL; nbr = nbr_table_next(rpl_neighbors, nbr)) {
+  for(nbr = rpl_neighbor_head(); nbr != NULL; nbr = rpl_neighbor_next(nbr)) {
 
     if(!acceptable_rank(rpl_neighbor_rank_via_nbr(nbr))
       || !curr_instance.of->nbr_is_acceptable_parent(nbr)) {
@@ -441,6 +596,6 @@ rpl_neighbor_select_best(void)
 void
 rpl_neighbor_init(void)
 {
-  nbr_table_register(rpl_neighbors, (nbr_table_callback *)remove_neighbor);
+  nbr_table_register(rpl_neighbors, (nbr_table_callback *)remove_entry);
 }
 /** @} */
@@ -58,11 +58,12 @@
 /* Per-neighbor RPL information. According to RFC 6550, there exist three
  * types of neighbors:
  * - Candidate neighbor set: any neighbor, selected in an implementation
- * and OF-specific way. The nodes in rpl_neighbors constitute the candidate neighbor set.
+ * and OF-specific way. The neighbors of the current instance, from
+ * rpl_neighbor_head() and rpl_neighbor_next(), constitute the candidate neighbor set.
  * - Parent set: the subset of the candidate neighbor set with rank below our rank
  * - Preferred parent: one node of the parent set
+ * All instances share one neighbor table, with a rpl_nbr_t per instance.
  */
-NBR_TABLE_DECLARE(rpl_neighbors);
 
 /********** Public functions **********/
 
@@ -71,6 +72,33 @@ NBR_TABLE_DECLARE(rpl_neighbors);
 */
 void rpl_neighbor_init(void);
 
+/**
+ * Returns the first neighbor of the current instance
+ *
+ * \return The first neighbor, NULL if there is none
+*/
+rpl_nbr_t *rpl_neighbor_head(void);
+
+/**
+ * Returns the next neighbor of the current instance
+ *
+ * \param nbr The current neighbor
+ * \return The next neighbor, NULL if nbr was the last one
+*/
+rpl_nbr_t *rpl_neighbor_next(rpl_nbr_t *nbr);
+
+/**
+ * Adds a neighbor to the current instance
+ *
+ * \param lladdr The neighbor's link-layer address
+ * \param reason The reason for adding it, see nbr_table_add_lladdr
+ * \param data Data for the neighbor table's replacement policy
+ * \return The neighbor, with its RPL information cleared, NULL if the
+ * table had no room for it
+*/
+rpl_nbr_t *rpl_neighbor_add(const uip_lladdr_t *lladdr,
+                            nbr_table_reason_t reason, void *data);
+
 /**
  * Tells whether a neighbor is in the parent set.
  *
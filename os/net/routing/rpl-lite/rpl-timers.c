@@ -89,6 +89,28 @@ static struct ctimer periodic_timer; /* Not part of a DAG because used for gener
 /*---------------------------------------------------------------------------*/
 /*------------------------------- DIS -------------------------------------- */
 /*---------------------------------------------------------------------------*/
+/* DIS solicit DIOs of all instances. They are needed while we are part of
+   no instance, or of one where we are neither root nor have a parent. */
+static int
+dis_needed(void)
+{
+  int i;
+  int any_used = 0;
+
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    const rpl_instance_t *instance = &rpl_instances[i];
+    if(instance->used) {
+      any_used = 1;
+      if(instance->dag.rank != ROOT_RANK &&
+         (instance->dag.preferred_parent == NULL ||
+          instance->dag.rank == RPL_INFINITE_RANK)) {
+        return 1;
+      }
+    }
+  }
+  return !any_used;
+}
+/*---------------------------------------------------------------------------*/
 void
 rpl_timers_schedule_periodic_dis(void)
 {
@@ -101,10 +123,7 @@ rpl_timers_schedule_periodic_dis(void)
 static void
 handle_dis_timer(void *ptr)
 {
-  if(!rpl_dag_root_is_root() &&
-     (!curr_instance.used ||
-       curr_instance.dag.preferred_parent == NULL ||
-       curr_instance.dag.rank == RPL_INFINITE_RANK)) {
+  if(dis_needed()) {
     /* Send DIS and schedule next */
     rpl_icmp6_dis_output(NULL);
     rpl_timers_schedule_periodic_dis();
@@ -139,10 +158,12 @@ new_dio_interval(void)
   curr_instance.dag.dio_counter = 0;
 
   /* schedule the timer */
-  ctimer_set(&curr_instance.dag.dio_timer, ticks, &handle_dio_timer, NULL);
+  ctimer_set(&curr_instance.dag.dio_timer, ticks, &handle_dio_timer, rpl_curr_instance);
 
 #ifdef RPL_CALLBACK_NEW_DIO_INTERVAL
-  RPL_CALLBACK_NEW_DIO_INTERVAL((CLOCK_SECOND * 1UL << curr_instance.dag.dio_intcurrent) / 1000);
+  if(rpl_curr_instance == &rpl_instances[0]) {
+    RPL_CALLBACK_NEW_DIO_INTERVAL((CLOCK_SECOND * 1UL << curr_instance.dag.dio_intcurrent) / 1000);
+  }
 #endif /* RPL_CALLBACK_NEW_DIO_INTERVAL */
 }
 /*---------------------------------------------------------------------------*/
@@ -168,7 +189,10 @@ rpl_timers_dio_reset(const char *str)
 static void
 handle_dio_timer(void *ptr)
 {
+  rpl_instance_t *prev = rpl_set_current_instance(ptr);
+
   if(!rpl_dag_ready_to_advertise()) {
+    rpl_set_current_instance(prev);
     return; /* We will be scheduled again later */
   }
 
@@ -191,7 +215,7 @@ handle_dio_timer(void *ptr)
       rpl_icmp6_dio_output(NULL);
     }
     curr_instance.dag.dio_send = 0;
-    ctimer_set(&curr_instance.dag.dio_timer, curr_instance.dag.dio_next_delay, handle_dio_timer, NULL);
+    ctimer_set(&curr_instance.dag.dio_timer, curr_instance.dag.dio_next_delay, handle_dio_timer, rpl_curr_instance);
   } else {
     /* check if we need to double interval */
     if(curr_instance.dag.dio_intcurrent < curr_instance.dio_intmin + curr_instance.dio_intdoubl) {
@@ -199,6 +223,8 @@ handle_dio_timer(void *ptr)
     }
     new_dio_interval();
   }
+
+  rpl_set_current_instance(prev);
 }
 /*---------------------------------------------------------------------------*/
 /*------------------------------- Unicast DIO ------------------------------ */
@@ -210,17 +236,19 @@ rpl_timers_schedule_unicast_dio(rpl_nbr_t *target)
   if(curr_instance.used) {
     curr_instance.dag.unicast_dio_target = target;
     ctimer_set(&curr_instance.dag.unicast_dio_timer, 0,
-                  handle_unicast_dio_timer, NULL);
+                  handle_unicast_dio_timer, rpl_curr_instance);
   }
 }
 /*---------------------------------------------------------------------------*/
 static void
 handle_unicast_dio_timer(void *ptr)
 {
+  rpl_instance_t *prev = rpl_set_current_instance(ptr);
   uip_ipaddr_t *target_ipaddr = rpl_neighbor_get_ipaddr(curr_instance.dag.unicast_dio_target);
   if(target_ipaddr != NULL) {
     rpl_icmp6_dio_output(target_ipaddr);
   }
+  rpl_set_current_instance(prev);
 }
 /*---------------------------------------------------------------------------*/
 /*------------------------------- DAO -------------------------------------- */
@@ -231,7 +259,7 @@ static void
 schedule_dao_retransmission(void)
 {
   clock_time_t expiration_time = RPL_DAO_RETRANSMISSION_TIMEOUT / 2 + (random_rand() % (RPL_DAO_RETRANSMISSION_TIMEOUT));
-  ctimer_set(&curr_instance.dag.dao_timer, expiration_time, resend_dao, NULL);
+  ctimer_set(&curr_instance.dag.dao_timer, expiration_time, resend_dao, rpl_curr_instance);
 }
 #endif /* RPL_WITH_DAO_ACK */
 /*---------------------------------------------------------------------------*/
@@ -255,7 +283,7 @@ schedule_dao_refresh(void)
     }
 
     /* Schedule transmission */
-    ctimer_set(&curr_instance.dag.dao_timer, target_refresh, send_new_dao, NULL);
+    ctimer_set(&curr_instance.dag.dao_timer, target_refresh, send_new_dao, rpl_curr_instance);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -267,13 +295,15 @@ rpl_timers_schedule_dao(void)
     * only serves storing mode. Use simple delay instead, with the only purpose
     * to reduce congestion. */
     clock_time_t expiration_time = RPL_DAO_DELAY / 2 + (random_rand() % (RPL_DAO_DELAY));
-    ctimer_set(&curr_instance.dag.dao_timer, expiration_time, send_new_dao, NULL);
+    ctimer_set(&curr_instance.dag.dao_timer, expiration_time, send_new_dao, rpl_curr_instance);
   }
 }
 /*---------------------------------------------------------------------------*/
 static void
 send_new_dao(void *ptr)
 {
+  rpl_instance_t *prev = rpl_set_current_instance(ptr);
+
 #if RPL_WITH_DAO_ACK
   /* We are sending a new DAO here. Prepare retransmissions */
   curr_instance.dag.dao_transmissions = 1;
@@ -293,6 +323,8 @@ send_new_dao(void *ptr)
   RPL_LOLLIPOP_INCREMENT(curr_instance.dag.dao_last_seqno);
   /* Send a DAO with own prefix as target and default lifetime */
   rpl_icmp6_dao_output(curr_instance.default_lifetime);
+
+  rpl_set_current_instance(prev);
 }
 #if RPL_WITH_DAO_ACK
 /*---------------------------------------------------------------------------*/
@@ -305,15 +337,17 @@ rpl_timers_schedule_dao_ack(uip_ipaddr_t *target, uint16_t sequence)
   if(curr_instance.used) {
     uip_ipaddr_copy(&curr_instance.dag.dao_ack_target, target);
     curr_instance.dag.dao_ack_sequence = sequence;
-    ctimer_set(&curr_instance.dag.dao_ack_timer, 0, handle_dao_ack_timer, NULL);
+    ctimer_set(&curr_instance.dag.dao_ack_timer, 0, handle_dao_ack_timer, rpl_curr_instance);
   }
 }
 /*---------------------------------------------------------------------------*/
 static void
 handle_dao_ack_timer(void *ptr)
 {
+  rpl_instance_t *prev = rpl_set_current_instance(ptr);
   rpl_icmp6_dao_ack_output(&curr_instance.dag.dao_ack_target,
     curr_instance.dag.dao_ack_sequence, RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
+  rpl_set_current_instance(prev);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -327,6 +361,8 @@ rpl_timers_notify_dao_ack(void)
 static void
 resend_dao(void *ptr)
 {
+  rpl_instance_t *prev = rpl_set_current_instance(ptr);
+
   /* Increment transmission counter before sending */
   curr_instance.dag.dao_transmissions++;
   /* Send a DAO with own prefix as target and default lifetime */
@@ -338,8 +374,9 @@ resend_dao(void *ptr)
   } else {
     /* No more retransmissions. Perform local repair. */
     rpl_local_repair("DAO max rtx");
-    return;
   }
+
+  rpl_set_current_instance(prev);
 }
 #endif /* RPL_WITH_DAO_ACK */
 /*---------------------------------------------------------------------------*/
@@ -387,7 +424,7 @@ get_probing_target(void)
 
   if(random_rand() % 3 != 0) {
     /* Look for best non-fresh */
-    nbr = nbr_table_head(rpl_neighbors);
+    nbr = rpl_neighbor_head();
     while(nbr != NULL) {
       if(!rpl_neighbor_is_fresh(nbr)) {
         /* nbr needs probing */
@@ -398,11 +435,11 @@ get_probing_target(void)
           probing_target_rank = nbr_rank;
         }
       }
-      nbr = nbr_table_next(rpl_neighbors, nbr);
+      nbr = rpl_neighbor_next(nbr);
     }
   } else {
     /* Look for least recently updated non-fresh */
-    nbr = nbr_table_head(rpl_neighbors);
+    nbr = rpl_neighbor_head();
     while(nbr != NULL) {
       if(!rpl_neighbor_is_fresh(nbr)) {
         /* nbr needs probing */
@@ -415,7 +452,7 @@ get_probing_target(void)
           }
         }
       }
-      nbr = nbr_table_next(rpl_neighbors, nbr);
+      nbr = rpl_neighbor_next(nbr);
     }
   }
 
@@ -425,6 +462,7 @@ get_probing_target(void)
 static void
 handle_probing_timer(void *ptr)
 {
+  rpl_instance_t *prev = rpl_set_current_instance(ptr);
   rpl_nbr_t *probing_target = RPL_PROBING_SELECT_FUNC();
   uip_ipaddr_t *target_ipaddr = rpl_neighbor_get_ipaddr(probing_target);
 
@@ -448,6 +486,8 @@ handle_probing_timer(void *ptr)
 
   /* Schedule next probing */
   rpl_schedule_probing();
+
+  rpl_set_current_instance(prev);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -455,7 +495,7 @@ rpl_schedule_probing(void)
 {
   if(curr_instance.used) {
     ctimer_set(&curr_instance.dag.probing_timer, RPL_PROBING_DELAY_FUNC(),
-                  handle_probing_timer, NULL);
+                  handle_probing_timer, rpl_curr_instance);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -464,7 +504,7 @@ rpl_schedule_probing_now(void)
 {
   if(curr_instance.used) {
     ctimer_set(&curr_instance.dag.probing_timer,
-      random_rand() % (CLOCK_SECOND * 4), handle_probing_timer, NULL);
+      random_rand() % (CLOCK_SECOND * 4), handle_probing_timer, rpl_curr_instance);
   }
 }
 #endif /* RPL_WITH_PROBING */
@@ -474,9 +514,11 @@ rpl_schedule_probing_now(void)
 static void
 handle_leaving_timer(void *ptr)
 {
+  rpl_instance_t *prev = rpl_set_current_instance(ptr);
   if(curr_instance.used) {
     rpl_dag_leave();
   }
+  rpl_set_current_instance(prev);
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -494,7 +536,7 @@ rpl_timers_schedule_leaving(void)
 {
   if(curr_instance.used) {
     if(ctimer_expired(&curr_instance.dag.leave)) {
-      ctimer_set(&curr_instance.dag.leave, RPL_DELAY_BEFORE_LEAVING, handle_leaving_timer, NULL);
+      ctimer_set(&curr_instance.dag.leave, RPL_DELAY_BEFORE_LEAVING, handle_leaving_timer, rpl_curr_instance);
     }
   }
 }
@@ -511,23 +553,39 @@ rpl_timers_init(void)
 static void
 handle_periodic_timer(void *ptr)
 {
-  if(curr_instance.used) {
+  rpl_instance_t *prev;
+  int i;
+  int any_used = 0;
+
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    if(!rpl_instances[i].used) {
+      continue;
+    }
+    prev = rpl_set_current_instance(&rpl_instances[i]);
+
     rpl_dag_periodic(PERIODIC_DELAY_SECONDS);
-    uip_sr_periodic(PERIODIC_DELAY_SECONDS);
+    any_used = 1;
+
+    /* Useful because part of the state update is time-dependent, e.g.,
+    the meaning of last_advertised_rank changes with time */
+    rpl_dag_update_state();
+
+    if(LOG_INFO_ENABLED) {
+      rpl_neighbor_print_list("Periodic");
+    }
+
+    rpl_set_current_instance(prev);
   }
 
-  if(!curr_instance.used ||
-      curr_instance.dag.preferred_parent == NULL ||
-      curr_instance.dag.rank == RPL_INFINITE_RANK) {
-    rpl_timers_schedule_periodic_dis(); /* Schedule DIS if needed */
+  if(any_used) {
+    uip_sr_periodic(PERIODIC_DELAY_SECONDS);
   }
 
-  /* Useful because part of the state update is time-dependent, e.g.,
-  the meaning of last_advertised_rank changes with time */
-  rpl_dag_update_state();
+  if(dis_needed()) {
+    rpl_timers_schedule_periodic_dis();
+  }
 
   if(LOG_INFO_ENABLED) {
-    rpl_neighbor_print_list("Periodic");
     rpl_dag_root_print_links("Periodic");
   }
 
@@ -563,14 +621,16 @@ void
 rpl_timers_schedule_state_update(void)
 {
   if(curr_instance.used) {
-    ctimer_set(&curr_instance.dag.state_update, 0, handle_state_update, NULL);
+    ctimer_set(&curr_instance.dag.state_update, 0, handle_state_update, rpl_curr_instance);
   }
 }
 /*---------------------------------------------------------------------------*/
 static void
 handle_state_update(void *ptr)
 {
+  rpl_instance_t *prev = rpl_set_current_instance(ptr);
   rpl_dag_update_state();
+  rpl_set_current_instance(prev);
 }
 
 /** @}*/
@@ -96,23 +96,31 @@ rpl_get_global_address(void)
 void
 rpl_link_callback(const linkaddr_t *addr, int status, int numtx)
 {
-  if(curr_instance.used == 1 ) {
-    rpl_nbr_t *nbr = rpl_neighbor_get_from_lladdr((uip_lladdr_t *)addr);
-    if(nbr != NULL) {
-      /* If this is the neighbor we were probing urgently, mark urgent
-      probing as done */
+  rpl_instance_t *prev;
+  int i;
+
+  /* Link statistics are shared by all instances */
+  for(i = 0; i < RPL_MAX_INSTANCES; i++) {
+    prev = rpl_set_current_instance(&rpl_instances[i]);
+    if(curr_instance.used == 1 ) {
+      rpl_nbr_t *nbr = rpl_neighbor_get_from_lladdr((uip_lladdr_t *)addr);
+      if(nbr != NULL) {
+        /* If this is the neighbor we were probing urgently, mark urgent
+        probing as done */
 #if RPL_WITH_PROBING
-      if(curr_instance.dag.urgent_probing_target == nbr) {
-        curr_instance.dag.urgent_probing_target = NULL;
-      }
+        if(curr_instance.dag.urgent_probing_target == nbr) {
+          curr_instance.dag.urgent_probing_target = NULL;
+        }
 #endif
-      /* Link stats were updated, and we need to update our internal state.
-      Updating from here is unsafe; postpone */
-      LOG_INFO("packet sent to ");
-      LOG_INFO_LLADDR(addr);
-      LOG_INFO_(", status %u, tx %u, new link metric %u\n", status, numtx, rpl_neighbor_get_link_metric(nbr));
-      rpl_timers_schedule_state_update();
+        /* Link stats were updated, and we need to update our internal state.
+        Updating from here is unsafe; postpone */
+        LOG_INFO("packet sent to ");
+        LOG_INFO_LLADDR(addr);
+        LOG_INFO_(", status %u, tx %u, new link metric %u\n", status, numtx, rpl_neighbor_get_link_metric(nbr));
+        rpl_timers_schedule_state_update();
+      }
     }
+    rpl_set_current_instance(prev);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -211,7 +219,9 @@ static int
 get_sr_node_ipaddr(uip_ipaddr_t *addr, const uip_sr_node_t *node)
 {
   if(addr != NULL && node != NULL) {
-    memcpy(addr, &curr_instance.dag.dag_id, 8);
+    /* Source routing graphs are kept per instance */
+    const rpl_instance_t *instance = node->graph != NULL ? node->graph : rpl_curr_instance;
+    memcpy(addr, &instance->dag.dag_id, 8);
     memcpy(((unsigned char *)addr) + 8, &node->link_identifier, 8);
     return 1;
   } else {
@@ -60,8 +60,12 @@
 
 /********** Public symbols **********/
 
-/* The only instance */
-extern rpl_instance_t curr_instance;
+/* All instances. Slot 0 holds the primary instance */
+extern rpl_instance_t rpl_instances[RPL_MAX_INSTANCES];
+/* The instance currently being processed, see rpl_set_current_instance */
+extern rpl_instance_t *rpl_curr_instance;
+/* All RPL processing applies to the current instance */
+#define curr_instance (*rpl_curr_instance)
 /* The RPL multicast address (used for DIS and DIO) */
 extern uip_ipaddr_t rpl_multicast_addr;
 
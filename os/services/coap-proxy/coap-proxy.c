@@ -0,0 +1,647 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *      A caching CoAP forward proxy.
+ */
+
+/**
+ * \addtogroup coap
+ * @{
+ */
+
+#include "coap-proxy.h"
+#include "coap-transactions.h"
+#include "coap-separate.h"
+#include "coap-timer.h"
+#include "net/ipv6/uiplib.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+#include "lib/random.h"
+#include "sys/cc.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Log configuration */
+#include "coap-log.h"
+#define LOG_MODULE "coap-proxy"
+#define LOG_LEVEL  LOG_LEVEL_COAP
+
+#if !COAP_PROXY_OPTION_PROCESSING
+#error "The CoAP proxy needs COAP_PROXY_OPTION_PROCESSING"
+#endif
+
+typedef enum {
+  ENTRY_FETCHING, /* the upstream request is in flight */
+  ENTRY_SEPARATE, /* acknowledged upstream, the response follows later */
+  ENTRY_VALID     /* holds a response that can be served */
+} coap_proxy_entry_state_t;
+
+typedef struct coap_proxy_entry {
+  struct coap_proxy_entry *next;
+
+  /* the key, what GETs are matched by */
+  coap_endpoint_t endpoint;
+  char uri[COAP_PROXY_URI_LEN]; /* path and query, each NUL-terminated */
+  uint8_t query;                /* offset of the query in uri */
+  uint8_t method;
+  int32_t accept;               /* -1 if none */
+  uint32_t block2_num;
+  uint16_t block2_size;         /* 0 if the request had no Block2 */
+
+  uint8_t state;
+  uint16_t upstream_mid;
+  uint8_t upstream_token[COAP_TOKEN_LEN]; /* random, so it cannot be guessed */
+  coap_timer_t separate_timer;  /* bounds the wait for a separate response */
+
+  /* the response, or the payload of a request that is not a GET */
+  uint8_t code;
+  int32_t content_format;       /* -1 if none */
+  uint8_t etag_len;
+  uint8_t etag[COAP_ETAG_LEN];
+  uint64_t expires;
+  uint8_t has_block2;
+  uint8_t res_block2_more;
+  uint32_t res_block2_num;
+  uint16_t res_block2_size;
+  uint16_t payload_len;
+  uint8_t payload[COAP_MAX_CHUNK_SIZE];
+} coap_proxy_entry_t;
+
+/* A client that gets a separate response once the upstream one is in */
+typedef struct coap_proxy_waiter {
+  struct coap_proxy_waiter *next;
+  coap_proxy_entry_t *entry;
+  coap_separate_t request;
+} coap_proxy_waiter_t;
+
+MEMB(entries_memb, coap_proxy_entry_t, COAP_PROXY_CACHE_ENTRIES);
+/* most recently used first */
+LIST(entries);
+MEMB(waiters_memb, coap_proxy_waiter_t, COAP_PROXY_WAITERS);
+LIST(waiters);
+
+/* the entry a request maps to, before it is looked up */
+static coap_proxy_entry_t key;
+/*---------------------------------------------------------------------------*/
+static int
+known_scheme(const char *text)
+{
+  return strncmp(text, "coap://", 7) == 0
+    || strncmp(text, "coaps://", 8) == 0
+    || strncmp(text, "coap+tcp://", 11) == 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+set_uri(coap_proxy_entry_t *e, const char *path, size_t path_len,
+        const char *query, size_t query_len)
+{
+  if(path_len + query_len + 2 > sizeof(e->uri)) {
+    return 0;
+  }
+  memcpy(e->uri, path, path_len);
+  e->uri[path_len] = '\0';
+  e->query = path_len + 1;
+  memcpy(&e->uri[e->query], query, query_len);
+  e->uri[e->query + query_len] = '\0';
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Fills in the endpoint and URI from Proxy-Uri or Proxy-Scheme/Uri-Host */
+static int
+set_target(coap_proxy_entry_t *e, coap_message_t *request)
+{
+  char text[UIPLIB_IPV6_MAX_STR_LEN + 24];
+  const char *uri;
+  const char *scheme;
+  const char *host;
+  const char *path = NULL;
+  const char *query = NULL;
+  size_t path_len = 0;
+  size_t query_len = 0;
+  size_t len;
+  size_t host_len;
+  size_t i;
+  int n;
+
+  if((len = coap_get_header_proxy_uri(request, &uri)) > 0) {
+    /* scheme://authority/path?query */
+    for(i = 0; i + 3 <= len && memcmp(&uri[i], "://", 3) != 0; i++);
+    if(i + 3 > len) {
+      return 0;
+    }
+    for(i += 3; i < len && uri[i] != '/' && uri[i] != '?'; i++);
+    if(i >= sizeof(text)) {
+      return 0;
+    }
+    memcpy(text, uri, i);
+    n = i;
+    if(i < len && uri[i] == '/') {
+      path = &uri[++i];
+      for(; i < len && uri[i] != '?'; i++);
+      path_len = &uri[i] - path;
+    }
+    if(i < len) {
+      query = &uri[i + 1];
+      query_len = len - i - 1;
+    }
+  } else {
+    len = coap_get_header_proxy_scheme(request, &scheme);
+    host_len = coap_get_header_uri_host(request, &host);
+    if(host_len == 0) {
+      return 0;
+    }
+    n = snprintf(text, sizeof(text),
+                 host[0] == '[' ? "%.*s://%.*s" : "%.*s://[%.*s]",
+                 (int)len, scheme, (int)host_len, host);
+    if(n > 0 && n < sizeof(text) &&
+       coap_is_option(request, COAP_OPTION_URI_PORT)) {
+      n += snprintf(&text[n], sizeof(text) - n, ":%u", request->uri_port);
+    }
+    if(n <= 0 || n >= sizeof(text)) {
+      return 0;
+    }
+    path_len = coap_get_header_uri_path(request, &path);
+    query_len = coap_get_header_uri_query(request, &query);
+  }
+  text[n] = '\0';
+
+  if(!known_scheme(text) || !coap_endpoint_parse(text, n, &e->endpoint)) {
+    LOG_WARN("cannot proxy to %s\n", text);
+    return 0;
+  }
+  return set_uri(e, path, path_len, query, query_len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+set_key(coap_message_t *request)
+{
+  unsigned int accept;
+  const uint8_t *payload;
+
+  memset(&key, 0, sizeof(key));
+  if(!set_target(&key, request)) {
+    return 0;
+  }
+  key.method = request->code;
+  key.accept = coap_get_header_accept(request, &accept) ? accept : -1;
+  coap_get_header_block2(request, &key.block2_num, NULL, &key.block2_size,
+                         NULL);
+  key.content_format = -1;
+
+  if(request->code != COAP_GET) {
+    /* kept to build the upstream request */
+    key.payload_len = coap_get_payload(request, &payload);
+    if(key.payload_len > sizeof(key.payload)) {
+      return 0;
+    }
+    memcpy(key.payload, payload, key.payload_len);
+    if(coap_get_header_content_format(request, &accept)) {
+      key.content_format = accept;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static coap_proxy_entry_t *
+lookup(const coap_proxy_entry_t *k)
+{
+  coap_proxy_entry_t *e;
+
+  for(e = list_head(entries); e != NULL; e = e->next) {
+    if(e->method == COAP_GET
+       && e->accept == k->accept
+       && e->block2_num == k->block2_num
+       && e->block2_size == k->block2_size
+       && coap_endpoint_cmp(&e->endpoint, &k->endpoint)
+       && strcmp(e->uri, k->uri) == 0
+       && strcmp(&e->uri[e->query], &k->uri[k->query]) == 0) {
+      return e;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static coap_proxy_entry_t *
+new_entry(void)
+{
+  coap_proxy_entry_t *e;
+  coap_proxy_entry_t *victim = NULL;
+
+  e = memb_alloc(&entries_memb);
+  if(e == NULL) {
+    /* replace the least recently used response */
+    for(e = list_head(entries); e != NULL; e = e->next) {
+      if(e->state == ENTRY_VALID) {
+        victim = e;
+      }
+    }
+    if(victim == NULL) {
+      return NULL;
+    }
+    list_remove(entries, victim);
+    e = victim;
+  }
+  memcpy(e, &key, sizeof(key));
+  list_push(entries, e);
+  return e;
+}
+/*---------------------------------------------------------------------------*/
+static void
+free_entry(coap_proxy_entry_t *e)
+{
+  coap_timer_stop(&e->separate_timer);
+  list_remove(entries, e);
+  memb_free(&entries_memb, e);
+}
+/*---------------------------------------------------------------------------*/
+/* Unsafe requests that succeeded make cached GETs of the path stale */
+static void
+invalidate(const coap_proxy_entry_t *changed)
+{
+  coap_proxy_entry_t *e;
+  coap_proxy_entry_t *next;
+
+  for(e = list_head(entries); e != NULL; e = next) {
+    next = e->next;
+    if(e->state == ENTRY_VALID
+       && coap_endpoint_cmp(&e->endpoint, &changed->endpoint)
+       && strcmp(e->uri, changed->uri) == 0) {
+      free_entry(e);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+max_age(const coap_proxy_entry_t *e)
+{
+  uint64_t now = coap_timer_uptime();
+
+  return e->expires > now ? (e->expires - now + 999) / 1000 : 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_response(coap_message_t *response, coap_proxy_entry_t *e)
+{
+  if(e->content_format >= 0) {
+    coap_set_header_content_format(response, e->content_format);
+  }
+  if(e->etag_len) {
+    coap_set_header_etag(response, e->etag, e->etag_len);
+  }
+  if(e->method == COAP_GET) {
+    coap_set_header_max_age(response, max_age(e));
+  }
+  if(e->has_block2) {
+    coap_set_header_block2(response, e->res_block2_num, e->res_block2_more,
+                           e->res_block2_size);
+  }
+  coap_set_payload(response, e->payload, e->payload_len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+store(coap_proxy_entry_t *e, coap_message_t *response)
+{
+  unsigned int format;
+  const uint8_t *etag;
+  const uint8_t *payload;
+  uint32_t age;
+
+  e->code = response->code;
+  e->content_format = coap_get_header_content_format(response, &format)
+    ? format : -1;
+  e->etag_len = coap_get_header_etag(response, &etag);
+  memcpy(e->etag, etag, e->etag_len);
+  coap_get_header_max_age(response, &age);
+  e->expires = coap_timer_uptime() + (uint64_t)age * 1000;
+  e->has_block2 = coap_get_header_block2(response, &e->res_block2_num,
+                                         &e->res_block2_more,
+                                         &e->res_block2_size, NULL);
+  e->payload_len = coap_get_payload(response, &payload);
+  if(e->payload_len > sizeof(e->payload)) {
+    LOG_WARN("upstream payload of %u bytes truncated\n", e->payload_len);
+    e->payload_len = sizeof(e->payload);
+  }
+  memcpy(e->payload, payload, e->payload_len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+answer_waiters(coap_proxy_entry_t *e, uint8_t code)
+{
+  static coap_message_t response[1];
+  coap_proxy_waiter_t *w;
+  coap_proxy_waiter_t *next;
+  coap_transaction_t *t;
+
+  for(w = list_head(waiters); w != NULL; w = next) {
+    next = w->next;
+    if(w->entry != e) {
+      continue;
+    }
+    t = coap_new_transaction(w->request.mid, &w->request.endpoint);
+    if(t != NULL) {
+      coap_separate_resume(response, &w->request, code);
+      if(code == e->code) {
+        set_response(response, e);
+      }
+      t->message_len = coap_serialize_message(response, t->message);
+      coap_send_transaction(t);
+    } else {
+      LOG_WARN("no transaction to answer a waiting client\n");
+    }
+    list_remove(waiters, w);
+    memb_free(&waiters_memb, w);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void upstream_response(void *data, coap_message_t *response);
+/*---------------------------------------------------------------------------*/
+static void
+separate_timeout(coap_timer_t *timer)
+{
+  LOG_WARN("no separate response from upstream\n");
+  upstream_response(coap_timer_get_user_data(timer), NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+upstream_response(void *data, coap_message_t *response)
+{
+  coap_proxy_entry_t *e = data;
+  uint8_t code;
+  const uint8_t *etag;
+  uint32_t age;
+
+  if(response != NULL && response->code == 0
+     && response->type == COAP_TYPE_ACK) {
+    /* the response follows in a message of its own, with our token */
+    LOG_DBG("upstream response for /%s is separate\n", e->uri);
+    e->state = ENTRY_SEPARATE;
+    coap_timer_set_callback(&e->separate_timer, separate_timeout);
+    coap_timer_set_user_data(&e->separate_timer, e);
+    coap_timer_set(&e->separate_timer, COAP_PROXY_SEPARATE_TIMEOUT);
+    return;
+  }
+  coap_timer_stop(&e->separate_timer);
+
+  if(response == NULL) {
+    LOG_WARN("upstream request timed out\n");
+    code = GATEWAY_TIMEOUT_5_04;
+  } else if(response->code == 0) {
+    LOG_WARN("upstream request rejected\n");
+    code = BAD_GATEWAY_5_02;
+  } else if(response->code == VALID_2_03 && e->code == CONTENT_2_05) {
+    /* the stale response is still good */
+    coap_get_header_max_age(response, &age);
+    e->expires = coap_timer_uptime() + (uint64_t)age * 1000;
+    if(coap_get_header_etag(response, &etag) == e->etag_len) {
+      memcpy(e->etag, etag, e->etag_len);
+    }
+    code = CONTENT_2_05;
+  } else {
+    store(e, response);
+    code = response->code;
+  }
+
+  if(e->method == COAP_GET && code == CONTENT_2_05) {
+    e->state = ENTRY_VALID;
+    answer_waiters(e, code);
+    return;
+  }
+
+  answer_waiters(e, code);
+  if(e->method != COAP_GET && code >= CREATED_2_01 && code <= CHANGED_2_04) {
+    invalidate(e);
+  }
+  free_entry(e);
+}
+/*---------------------------------------------------------------------------*/
+static int
+fetch(coap_proxy_entry_t *e)
+{
+  static coap_message_t request[1];
+  coap_transaction_t *t;
+  int i;
+
+  e->upstream_mid = coap_get_mid();
+  coap_init_message(request, COAP_TYPE_CON, e->method, e->upstream_mid);
+  /* separate responses are matched by the token, which a forged response
+     that would poison the cache must not be able to guess */
+  for(i = 0; i < sizeof(e->upstream_token); i++) {
+    e->upstream_token[i] = random_rand() & 0xff;
+  }
+  coap_set_token(request, e->upstream_token, sizeof(e->upstream_token));
+
+  if(e->uri[0]) {
+    coap_set_header_uri_path(request, e->uri);
+  }
+  if(e->uri[e->query]) {
+    coap_set_header_uri_query(request, &e->uri[e->query]);
+  }
+  if(e->accept >= 0) {
+    coap_set_header_accept(request, e->accept);
+  }
+  if(e->block2_size) {
+    coap_set_header_block2(request, e->block2_num, 0, e->block2_size);
+  }
+  if(e->method == COAP_GET) {
+    if(e->code == CONTENT_2_05 && e->etag_len) {
+      /* revalidate the stale response */
+      coap_set_header_etag(request, e->etag, e->etag_len);
+    }
+  } else {
+    if(e->content_format >= 0) {
+      coap_set_header_content_format(request, e->content_format);
+    }
+    coap_set_payload(request, e->payload, e->payload_len);
+  }
+
+  t = coap_new_transaction(e->upstream_mid, &e->endpoint);
+  if(t == NULL) {
+    return 0;
+  }
+  t->callback = upstream_response;
+  t->callback_data = e;
+  t->message_len = coap_serialize_message(request, t->message);
+  if(t->message_len == 0) {
+    coap_clear_transaction(t);
+    return 0;
+  }
+  coap_send_transaction(t);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wait_for(coap_proxy_entry_t *e, coap_message_t *request)
+{
+  coap_proxy_waiter_t *w;
+
+  w = memb_alloc(&waiters_memb);
+  w->entry = e;
+  coap_separate_accept(request, &w->request);
+  list_add(waiters, w);
+}
+/*---------------------------------------------------------------------------*/
+static void
+serve(coap_proxy_entry_t *e, coap_message_t *request,
+      coap_message_t *response, int32_t *offset)
+{
+  const uint8_t *etag;
+  uint32_t block_offset;
+
+  list_remove(entries, e);
+  list_push(entries, e);
+
+  if(e->etag_len && coap_get_header_etag(request, &etag) == e->etag_len
+     && memcmp(etag, e->etag, e->etag_len) == 0) {
+    coap_set_status_code(response, VALID_2_03);
+    coap_set_header_etag(response, e->etag, e->etag_len);
+    coap_set_header_max_age(response, max_age(e));
+    return;
+  }
+
+  coap_set_status_code(response, e->code);
+  set_response(response, e);
+  if(coap_get_header_block2(request, NULL, NULL, NULL, &block_offset)) {
+    /* the payload is the requested block already, keep the engine from
+       cutting it out of a larger one */
+    *offset = e->has_block2 && e->res_block2_more
+      ? block_offset + e->payload_len : -1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static coap_handler_status_t
+proxy_handler(coap_message_t *request, coap_message_t *response,
+              uint8_t *buffer, uint16_t buffer_size, int32_t *offset)
+{
+  coap_proxy_entry_t *e = NULL;
+
+  if(!coap_is_option(request, COAP_OPTION_PROXY_URI)
+     && !coap_is_option(request, COAP_OPTION_PROXY_SCHEME)) {
+    return COAP_HANDLER_STATUS_CONTINUE;
+  }
+
+  /* observations are not relayed, the client gets a plain response */
+  coap_clear_option(request, COAP_OPTION_OBSERVE);
+
+  if(coap_is_option(request, COAP_OPTION_BLOCK1)) {
+    coap_set_status_code(response, NOT_IMPLEMENTED_5_01);
+    return COAP_HANDLER_STATUS_PROCESSED;
+  }
+  if(!set_key(request)) {
+    coap_set_status_code(response, PROXYING_NOT_SUPPORTED_5_05);
+    return COAP_HANDLER_STATUS_PROCESSED;
+  }
+
+  if(request->code == COAP_GET) {
+    e = lookup(&key);
+    if(e != NULL && e->state == ENTRY_VALID
+       && coap_timer_uptime() < e->expires) {
+      LOG_DBG("cache hit /%s\n", e->uri);
+      serve(e, request, response, offset);
+      return COAP_HANDLER_STATUS_PROCESSED;
+    }
+  }
+
+  if(memb_numfree(&waiters_memb) == 0) {
+    coap_set_status_code(response, SERVICE_UNAVAILABLE_5_03);
+    return COAP_HANDLER_STATUS_PROCESSED;
+  }
+
+  if(e != NULL && e->state != ENTRY_VALID) {
+    /* share the request already on its way */
+    LOG_DBG("joining upstream request for /%s\n", e->uri);
+    wait_for(e, request);
+    return COAP_HANDLER_STATUS_PROCESSED;
+  }
+
+  if(e == NULL) {
+    e = new_entry();
+    if(e == NULL) {
+      coap_set_status_code(response, SERVICE_UNAVAILABLE_5_03);
+      return COAP_HANDLER_STATUS_PROCESSED;
+    }
+  }
+  /* a stale entry keeps its response for revalidation */
+  e->state = ENTRY_FETCHING;
+
+  wait_for(e, request);
+  if(!fetch(e)) {
+    LOG_WARN("no transaction for the upstream request\n");
+    answer_waiters(e, SERVICE_UNAVAILABLE_5_03);
+    free_entry(e);
+  }
+  return COAP_HANDLER_STATUS_PROCESSED;
+}
+/*---------------------------------------------------------------------------*/
+COAP_HANDLER(proxy, proxy_handler);
+/*---------------------------------------------------------------------------*/
+int
+coap_proxy_handle_response(const coap_endpoint_t *src,
+                           coap_message_t *response)
+{
+  static coap_message_t ack[1];
+  uint8_t buffer[COAP_HEADER_LEN];
+  coap_proxy_entry_t *e;
+
+  if(response->token_len != COAP_TOKEN_LEN) {
+    return 0;
+  }
+  for(e = list_head(entries); e != NULL; e = e->next) {
+    if(e->state == ENTRY_SEPARATE
+       && memcmp(response->token, e->upstream_token, COAP_TOKEN_LEN) == 0
+       && coap_endpoint_cmp(&e->endpoint, src)) {
+      break;
+    }
+  }
+  if(e == NULL) {
+    return 0;
+  }
+
+  if(response->type == COAP_TYPE_CON) {
+    coap_init_message(ack, COAP_TYPE_ACK, 0, response->mid);
+    coap_sendto(src, buffer, coap_serialize_message(ack, buffer));
+  }
+  upstream_response(e, response);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+coap_proxy_init(void)
+{
+  memb_init(&entries_memb);
+  list_init(entries);
+  memb_init(&waiters_memb);
+  list_init(waiters);
+  coap_add_handler(&proxy);
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *      A caching CoAP forward proxy.
+ *
+ *      Requests carrying Proxy-Uri, or Proxy-Scheme with Uri-Host, are
+ *      forwarded to the server they name. Successful GET responses are
+ *      cached by URI, Accept and Block2 option until their Max-Age runs
+ *      out, revalidated with their ETag after that, and concurrent GETs
+ *      for the same entry share one upstream request. Clients waiting
+ *      for the upstream server are answered with separate responses.
+ */
+
+/**
+ * \addtogroup coap
+ * @{
+ */
+
+#ifndef COAP_PROXY_H_
+#define COAP_PROXY_H_
+
+#include "coap-engine.h"
+
+/* Cached responses and upstream requests in flight, together */
+#ifdef COAP_PROXY_CONF_CACHE_ENTRIES
+#define COAP_PROXY_CACHE_ENTRIES COAP_PROXY_CONF_CACHE_ENTRIES
+#else
+#define COAP_PROXY_CACHE_ENTRIES 4
+#endif /* COAP_PROXY_CACHE_ENTRIES */
+
+/* Clients that can wait for upstream responses at the same time */
+#ifdef COAP_PROXY_CONF_WAITERS
+#define COAP_PROXY_WAITERS COAP_PROXY_CONF_WAITERS
+#else
+#define COAP_PROXY_WAITERS 4
+#endif /* COAP_PROXY_WAITERS */
+
+/* Room for the path and query of a proxied URI */
+#ifdef COAP_PROXY_CONF_URI_LEN
+#define COAP_PROXY_URI_LEN COAP_PROXY_CONF_URI_LEN
+#else
+#define COAP_PROXY_URI_LEN 48
+#endif /* COAP_PROXY_URI_LEN */
+
+/* How long to wait for a separate response once upstream has sent its
+   empty ACK, in milliseconds */
+#ifdef COAP_PROXY_CONF_SEPARATE_TIMEOUT
+#define COAP_PROXY_SEPARATE_TIMEOUT COAP_PROXY_CONF_SEPARATE_TIMEOUT
+#else
+#define COAP_PROXY_SEPARATE_TIMEOUT 60000
+#endif /* COAP_PROXY_SEPARATE_TIMEOUT */
+
+/**
+ * \brief Registers the proxy with the CoAP engine
+ *
+ * Needs COAP_PROXY_OPTION_PROCESSING so that the engine parses the proxy
+ * options instead of rejecting them.
+ */
+void coap_proxy_init(void);
+
+/**
+ * \brief Matches a separate response from an upstream server by its token
+ * \param src The endpoint the response came from
+ * \param response The response, not matched to any transaction
+ * \return 1 if it answers a proxied request, 0 otherwise
+ *
+ * Called by the CoAP engine. CON responses are acknowledged.
+ */
+int coap_proxy_handle_response(const coap_endpoint_t *src,
+                               coap_message_t *response);
+
+#endif /* COAP_PROXY_H_ */
+/** @} */
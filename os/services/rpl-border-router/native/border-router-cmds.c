@@ -169,6 +169,23 @@ border_router_cmd_handler(const uint8_t *data, int len)
         LOG_DBG("Packet data report for sid:%d st:%d tx:%d\n",
                data[2], data[3], data[4]);
         packet_sent(data[2], data[3], data[4]);
+        slip_radio_credit(slip_input_radio(), 1);
+        return 1;
+      case 'B': {
+        /* Batched packet data reports */
+        int i;
+        for(i = 0; i < data[2] && 3 + 3 * i + 2 < len; i++) {
+          LOG_DBG("Packet data report for sid:%d st:%d tx:%d\n",
+                  data[3 + 3 * i], data[4 + 3 * i], data[5 + 3 * i]);
+          packet_sent(data[3 + 3 * i], data[4 + 3 * i], data[5 + 3 * i]);
+        }
+        slip_radio_credit(slip_input_radio(), i);
+        return 1;
+      }
+      case 'F':
+        if(len >= 4) {
+          slip_radio_flow_init(slip_input_radio(), data[2], data[3]);
+        }
         return 1;
       default:
       return 0;
@@ -40,6 +40,7 @@
 #include "net/packetbuf.h"
 #include "net/queuebuf.h"
 #include "net/netstack.h"
+#include "net/nbr-table.h"
 #include "packetutils.h"
 #include "border-router.h"
 #include <string.h>
@@ -53,6 +54,10 @@
 #define MAX_CALLBACKS 16
 static int callback_pos;
 
+/* A session still waiting for its TX report after this long is taken to
+   be lost, e.g. when a radio was reset, and its slot is reused */
+#define CALLBACK_TIMEOUT (10 * CLOCK_SECOND)
+
 /* a structure for calling back when packet data is coming back
    from radio... */
 struct tx_callback {
@@ -60,9 +65,16 @@ struct tx_callback {
   void *ptr;
   struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
   struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+  /* Radios yet to report, and the combined result so far */
+  uint8_t pending;
+  uint8_t status;
+  uint8_t tx;
+  clock_time_t time;
 };
 /*---------------------------------------------------------------------------*/
 static struct tx_callback callbacks[MAX_CALLBACKS];
+/* The radio each neighbor was last heard on, when serving several radios */
+NBR_TABLE(uint8_t, nbr_radio);
 /*---------------------------------------------------------------------------*/
 void
 init_sec(void)
@@ -84,30 +96,90 @@ packet_sent(uint8_t sessionid, uint8_t status, uint8_t tx)
   if(sessionid < MAX_CALLBACKS) {
     struct tx_callback *callback;
     callback = &callbacks[sessionid];
+    if(callback->pending == 0) {
+      LOG_WARN("TX report for idle session %d\n", sessionid);
+      return;
+    }
+    /* A broadcast sent on several radios succeeds if any of them did */
+    if(callback->status != MAC_TX_OK) {
+      callback->status = status;
+    }
+    if(tx > callback->tx) {
+      callback->tx = tx;
+    }
+    if(callback->pending > 1) {
+      callback->pending--;
+      return;
+    }
+    callback->pending = 0;
     packetbuf_clear();
     packetbuf_attr_copyfrom(callback->attrs, callback->addrs);
-    mac_call_sent_callback(callback->cback, callback->ptr, status, tx);
+    mac_call_sent_callback(callback->cback, callback->ptr,
+                           callback->status, callback->tx);
   } else {
     LOG_ERR("Session id to high (%d)\n", sessionid);
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Takes the next session slot that is not waiting for a TX report, or
+   returns -1 if all of them are */
 static int
 setup_callback(mac_callback_t sent, void *ptr)
 {
   struct tx_callback *callback;
-  int tmp = callback_pos;
-  callback = &callbacks[callback_pos];
-  callback->cback = sent;
-  callback->ptr = ptr;
-  packetbuf_attr_copyto(callback->attrs, callback->addrs);
-
-  callback_pos++;
-  if(callback_pos >= MAX_CALLBACKS) {
-    callback_pos = 0;
+  int i;
+  int tmp;
+
+  for(i = 0; i < MAX_CALLBACKS; i++) {
+    tmp = callback_pos;
+    callback = &callbacks[callback_pos];
+    callback_pos++;
+    if(callback_pos >= MAX_CALLBACKS) {
+      callback_pos = 0;
+    }
+    if(callback->pending == 0 ||
+       clock_time() - callback->time > CALLBACK_TIMEOUT) {
+      callback->cback = sent;
+      callback->ptr = ptr;
+      callback->pending = 0;
+      callback->status = MAC_TX_ERR;
+      callback->tx = 0;
+      callback->time = clock_time();
+      packetbuf_attr_copyto(callback->attrs, callback->addrs);
+      return tmp;
+    }
   }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Picks the radio for a unicast frame: the one the neighbor was last
+ * heard on, or else one derived from its address so that neighbors are
+ * spread over the radios. Returns -1 for broadcast, which goes out on
+ * every radio.
+ */
+static int
+select_radio(const linkaddr_t *dest)
+{
+  const uint8_t *radio;
+  unsigned hash;
+  int i;
 
-  return tmp;
+  if(slip_radio_count() <= 1) {
+    return 0;
+  }
+  if(linkaddr_cmp(dest, &linkaddr_null)) {
+    return -1;
+  }
+  radio = nbr_table_get_from_lladdr(nbr_radio, dest);
+  if(radio != NULL && *radio < slip_radio_count()) {
+    return *radio;
+  }
+  hash = 0;
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    hash = hash * 31 + dest->u8[i];
+  }
+  return hash % slip_radio_count();
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -116,7 +188,9 @@ send_packet(mac_callback_t sent, void *ptr)
   int size;
   /* 3 bytes per packet attribute is required for serialization */
   uint8_t buf[PACKETBUF_NUM_ATTRS * 3 + PACKETBUF_SIZE + 3];
-  uint8_t sid;
+  int sid;
+  int radio;
+  int queued;
 
   packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
 
@@ -142,7 +216,14 @@ send_packet(mac_callback_t sent, void *ptr)
       LOG_WARN("send failed, too large header\n");
       mac_call_sent_callback(sent, ptr, MAC_TX_ERR_FATAL, 1);
     } else {
+      radio = select_radio(packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
       sid = setup_callback(sent, ptr);
+      if(sid < 0) {
+        /* More frames in flight or held than sessions to report them */
+        LOG_WARN("send failed, no free session\n");
+        mac_call_sent_callback(sent, ptr, MAC_TX_ERR, 1);
+        return;
+      }
 
       buf[0] = '!';
       buf[1] = 'S';
@@ -151,7 +232,17 @@ send_packet(mac_callback_t sent, void *ptr)
       /* Copy packet data */
       memcpy(&buf[3 + size], packetbuf_hdrptr(), packetbuf_totlen());
 
-      write_to_slip(buf, packetbuf_totlen() + size + 3);
+      if(radio < 0) {
+        queued = write_to_slip(buf, packetbuf_totlen() + size + 3);
+      } else {
+        queued = write_to_slip_radio(radio, buf, packetbuf_totlen() + size + 3);
+      }
+      /* One report is expected from each radio that took the frame */
+      callbacks[sid].pending = queued;
+      if(queued == 0) {
+        LOG_WARN("send failed, radio queue full\n");
+        mac_call_sent_callback(sent, ptr, MAC_TX_ERR, 1);
+      }
     }
   }
 }
@@ -159,9 +250,20 @@ send_packet(mac_callback_t sent, void *ptr)
 static void
 packet_input(void)
 {
+  uint8_t *radio;
+
   if(NETSTACK_FRAMER.parse() < 0) {
     LOG_DBG("failed to parse %u\n", packetbuf_datalen());
   } else {
+    if(slip_radio_count() > 1) {
+      /* Send replies back over the radio the neighbor is heard on */
+      radio = nbr_table_add_lladdr(nbr_radio,
+                                   packetbuf_addr(PACKETBUF_ADDR_SENDER),
+                                   NBR_TABLE_REASON_MAC, NULL);
+      if(radio != NULL) {
+        *radio = slip_input_radio();
+      }
+    }
     NETSTACK_NETWORK.input();
   }
 }
@@ -189,6 +291,7 @@ static void
 init(void)
 {
   callback_pos = 0;
+  nbr_table_register(nbr_radio, NULL);
 }
 /*---------------------------------------------------------------------------*/
 const struct mac_driver border_router_mac_driver = {
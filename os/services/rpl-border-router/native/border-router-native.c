@@ -57,6 +57,7 @@
 
 extern long slip_sent;
 extern long slip_received;
+extern long slip_crc_errors;
 
 static uint8_t mac_set;
 
@@ -72,15 +73,34 @@ PROCESS(border_router_process, "Border router process");
 static void
 request_mac(void)
 {
-  write_to_slip((uint8_t *)"?M", 2);
+  /* The first radio provides the address for all of them */
+  write_to_slip_radio(0, (uint8_t *)"?M", 2);
+  /* Ask for flow control credits; older radios ignore this */
+  write_to_slip((uint8_t *)"?F", 2);
 }
 /*---------------------------------------------------------------------------*/
 void
 border_router_set_mac(const uint8_t *data)
 {
+  uint8_t buf[2 + sizeof(uip_lladdr.addr)];
+  int i;
+
+  if(slip_input_radio() != 0) {
+    /* Only the first radio's address is used */
+    return;
+  }
+
   memcpy(uip_lladdr.addr, data, sizeof(uip_lladdr.addr));
   linkaddr_set_node_addr((linkaddr_t *)uip_lladdr.addr);
 
+  /* Let the other radios receive frames sent to the same address */
+  buf[0] = '!';
+  buf[1] = 'M';
+  memcpy(&buf[2], data, sizeof(uip_lladdr.addr));
+  for(i = 1; i < slip_radio_count(); i++) {
+    write_to_slip_radio(i, buf, sizeof(buf));
+  }
+
   /* is this ok - should instead remove all addresses and
      add them back again - a bit messy... ?*/
   PROCESS_CONTEXT_BEGIN(&tcpip_process);
@@ -96,6 +116,7 @@ border_router_print_stat()
 {
   printf("bytes received over SLIP: %ld\n", slip_received);
   printf("bytes sent over SLIP: %ld\n", slip_sent);
+  printf("frames with bad CRC: %ld\n", slip_crc_errors);
 }
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(border_router_process, ev, data)
@@ -41,9 +41,21 @@
 #include "net/ipv6/uip.h"
 #include <stdio.h>
 
+/* Maximum number of slip-radios served by one border router */
+#ifdef SLIP_DEV_CONF_MAX_RADIOS
+#define SLIP_DEV_MAX_RADIOS SLIP_DEV_CONF_MAX_RADIOS
+#else
+#define SLIP_DEV_MAX_RADIOS 4
+#endif
+
 int border_router_cmd_handler(const uint8_t *data, int len);
 int slip_config_handle_arguments(int argc, char **argv);
-void write_to_slip(const uint8_t *buf, int len);
+int write_to_slip(const uint8_t *buf, int len);
+int write_to_slip_radio(int radio, const uint8_t *buf, int len);
+int slip_radio_count(void);
+int slip_input_radio(void);
+void slip_radio_flow_init(int radio, int credits, uint8_t caps);
+void slip_radio_credit(int radio, int n);
 
 void border_router_set_prefix_64(const uip_ipaddr_t *prefix_64);
 void border_router_set_mac(const uint8_t *data);
@@ -52,7 +64,7 @@ void border_router_print_stat(void);
 
 void tun_init(void);
 
-int slip_init(void);
+void slip_init(void);
 int slip_set_fd(int maxfd, fd_set *rset, fd_set *wset);
 void slip_handle_fd(fd_set *rset, fd_set *wset);
 
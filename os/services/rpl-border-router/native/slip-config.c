@@ -46,16 +46,20 @@
 #include <sys/ioctl.h>
 #include <err.h>
 #include "contiki.h"
+#include "border-router.h"
 
 int slip_config_verbose = 0;
 const char *slip_config_ipaddr;
 int slip_config_flowcontrol = 0;
 int slip_config_timestamp = 0;
-const char *slip_config_siodev = NULL;
+const char *slip_config_siodev[SLIP_DEV_MAX_RADIOS];
+int slip_config_siodev_count = 0;
 const char *slip_config_host = NULL;
-const char *slip_config_port = NULL;
+const char *slip_config_port[SLIP_DEV_MAX_RADIOS];
+int slip_config_port_count = 0;
 char slip_config_tundev[32] = { "" };
 uint16_t slip_config_basedelay = 0;
+int slip_config_crc = 0;
 
 #ifndef BAUDRATE
 #define BAUDRATE B115200
@@ -73,7 +77,7 @@ slip_config_handle_arguments(int argc, char **argv)
   slip_config_verbose = 0;
 
   prog = argv[0];
-  while((c = getopt(argc, argv, "B:H:D:Lhs:t:v::d::a:p:T")) != -1) {
+  while((c = getopt(argc, argv, "B:H:D:Lchs:t:v::d::a:p:T")) != -1) {
     switch(c) {
     case 'B':
       baudrate = atoi(optarg);
@@ -87,11 +91,18 @@ slip_config_handle_arguments(int argc, char **argv)
       slip_config_timestamp = 1;
       break;
 
+    case 'c':
+      slip_config_crc = 1;
+      break;
+
     case 's':
+      if(slip_config_siodev_count >= SLIP_DEV_MAX_RADIOS) {
+        errx(1, "at most %d serial devices", SLIP_DEV_MAX_RADIOS);
+      }
       if(strncmp("/dev/", optarg, 5) == 0) {
-        slip_config_siodev = optarg + 5;
+        slip_config_siodev[slip_config_siodev_count++] = optarg + 5;
       } else {
-        slip_config_siodev = optarg;
+        slip_config_siodev[slip_config_siodev_count++] = optarg;
       }
       break;
 
@@ -108,7 +119,10 @@ slip_config_handle_arguments(int argc, char **argv)
       break;
 
     case 'p':
-      slip_config_port = optarg;
+      if(slip_config_port_count >= SLIP_DEV_MAX_RADIOS) {
+        errx(1, "at most %d server ports", SLIP_DEV_MAX_RADIOS);
+      }
+      slip_config_port[slip_config_port_count++] = optarg;
       break;
 
     case 'd':
@@ -138,9 +152,12 @@ slip_config_handle_arguments(int argc, char **argv)
 #endif
       fprintf(stderr, " -H             Hardware CTS/RTS flow control (default disabled)\n");
       fprintf(stderr, " -L             Log output format (adds time stamps)\n");
+      fprintf(stderr, " -c             CRC-protected SLIP framing, if the radio supports it\n");
       fprintf(stderr, " -s siodev      Serial device (default /dev/ttyUSB0)\n");
+      fprintf(stderr, "                Repeat to serve up to %d radios\n", SLIP_DEV_MAX_RADIOS);
       fprintf(stderr, " -a host        Connect via TCP to server at <host>\n");
       fprintf(stderr, " -p port        Connect via TCP to server at <host>:<port>\n");
+      fprintf(stderr, "                Repeat to serve up to %d radios\n", SLIP_DEV_MAX_RADIOS);
       fprintf(stderr, " -t tundev      Name of interface (default tun0)\n");
 #ifdef __APPLE__
       fprintf(stderr, " -v level       Verbosity level\n");
@@ -167,7 +184,7 @@ slip_config_handle_arguments(int argc, char **argv)
   argv += optind - 1;
 
   if(argc != 2 && argc != 3) {
-    err(1, "usage: %s [-B baudrate] [-H] [-L] [-s siodev] [-t tundev] [-T] [-v verbosity] [-d delay] [-a serveraddress] [-p serverport] ipaddress", prog);
+    err(1, "usage: %s [-B baudrate] [-H] [-L] [-c] [-s siodev] [-t tundev] [-T] [-v verbosity] [-d delay] [-a serveraddress] [-p serverport] ipaddress", prog);
   }
   slip_config_ipaddr = argv[1];
 
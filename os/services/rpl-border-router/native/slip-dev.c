@@ -53,16 +53,21 @@
 
 #include "net/netstack.h"
 #include "net/packetbuf.h"
+#include "lib/crc16.h"
 #include "cmd.h"
+#include "border-router.h"
 #include "border-router-cmds.h"
 
 extern int slip_config_verbose;
 extern int slip_config_flowcontrol;
-extern const char *slip_config_siodev;
+extern const char *slip_config_siodev[];
+extern int slip_config_siodev_count;
 extern const char *slip_config_host;
-extern const char *slip_config_port;
+extern const char *slip_config_port[];
+extern int slip_config_port_count;
 extern uint16_t slip_config_basedelay;
 extern speed_t slip_config_b_rate;
+extern int slip_config_crc;
 
 #ifdef SLIP_DEV_CONF_SEND_DELAY
 #define SEND_DELAY SLIP_DEV_CONF_SEND_DELAY
@@ -70,15 +75,28 @@ extern speed_t slip_config_b_rate;
 #define SEND_DELAY 0
 #endif
 
-int devopen(const char *dev, int flags);
+#ifdef SLIP_DEV_CONF_READ_SIZE
+#define READ_SIZE SLIP_DEV_CONF_READ_SIZE
+#else
+#define READ_SIZE 4096
+#endif
+
+/* Data frames held back while a radio has no credits */
+#ifdef SLIP_DEV_CONF_HELD_FRAMES
+#define HELD_FRAMES SLIP_DEV_CONF_HELD_FRAMES
+#else
+#define HELD_FRAMES 16
+#endif
 
-static FILE *inslip;
+/* Largest !S frame, see border-router-mac.c */
+#define HELD_FRAME_SIZE (PACKETBUF_NUM_ATTRS * 3 + PACKETBUF_SIZE + 3)
+
+int devopen(const char *dev, int flags);
 
 /* for statistics */
 long slip_sent = 0;
 long slip_received = 0;
-
-int slipfd = 0;
+long slip_crc_errors = 0;
 
 #define PROGRESS(s) do { } while(0)
 
@@ -87,6 +105,37 @@ int slipfd = 0;
 #define SLIP_ESC_END 0334
 #define SLIP_ESC_ESC 0335
 
+#define DEBUG_LINE_MARKER '\r'
+
+/* One serial connection to a slip-radio */
+struct slip_radio {
+  int fd;
+  /* SLIP decoder state */
+  unsigned char inbuf[2048];
+  int inbufptr;
+  uint8_t inbuf_escaped;
+  /* Encoded packets waiting to be written */
+  unsigned char buf[2048];
+  int end, begin, packet_end;
+  struct timer send_delay_timer;
+  /* Credit-based flow control, -1 until the radio advertises credits */
+  int credits;
+  struct {
+    uint16_t len;
+    uint8_t data[HELD_FRAME_SIZE];
+  } held[HELD_FRAMES];
+  int held_first, held_count;
+  /* Frames to and from the radio carry a CRC-16 trailer */
+  uint8_t crc, crc_rx;
+};
+static struct slip_radio radios[SLIP_DEV_MAX_RADIOS];
+static int radio_count;
+/* The radio the frame currently being processed came from */
+static int input_radio;
+
+/* delay between slip packets */
+static clock_time_t send_delay = SEND_DELAY;
+
 /*---------------------------------------------------------------------------*/
 static void *
 get_in_addr(struct sockaddr *sa)
@@ -168,200 +217,297 @@ slip_packet_input(unsigned char *data, int len)
   NETSTACK_MAC.input();
 }
 /*---------------------------------------------------------------------------*/
-/*
- * Read from serial, when we have a packet call slip_packet_input. No output
- * buffering, input buffered by stdio.
- */
-void
-serial_input(FILE *inslip)
+int
+slip_radio_count(void)
 {
-  static unsigned char inbuf[2048];
-  static int inbufptr = 0;
-  int ret, i;
-  unsigned char c;
-
-#ifdef linux
-  ret = fread(&c, 1, 1, inslip);
-  if(ret == -1 || ret == 0) {
-    err(1, "serial_input: read");
-  }
-  goto after_fread;
-#endif
+  return radio_count;
+}
+/*---------------------------------------------------------------------------*/
+int
+slip_input_radio(void)
+{
+  return input_radio;
+}
+/*---------------------------------------------------------------------------*/
+static void
+frame_input(struct slip_radio *r)
+{
+  unsigned char *inbuf = r->inbuf;
+  int inbufptr = r->inbufptr;
+  int i;
 
-read_more:
-  if(inbufptr >= sizeof(inbuf)) {
-    fprintf(stderr, "*** dropping large %d byte packet\n", inbufptr);
-    inbufptr = 0;
-  }
-  ret = fread(&c, 1, 1, inslip);
-#ifdef linux
-after_fread:
-#endif
-  if(ret == -1) {
-    err(1, "serial_input: read");
-  }
-  if(ret == 0) {
-    clearerr(inslip);
+  if(inbufptr == 0) {
     return;
   }
-  slip_received++;
-  switch(c) {
-  case SLIP_END:
-    if(inbufptr > 0) {
-      if(inbuf[0] == '!') {
-        command_context = CMD_CONTEXT_RADIO;
-        cmd_input(inbuf, inbufptr);
-      } else if(inbuf[0] == '?') {
-#define DEBUG_LINE_MARKER '\r'
-      } else if(inbuf[0] == DEBUG_LINE_MARKER) {
-        fwrite(inbuf + 1, inbufptr - 1, 1, stdout);
-      } else if(is_sensible_string(inbuf, inbufptr)) {
-        if(slip_config_verbose == 1) {   /* strings already echoed below for verbose>1 */
-          fwrite(inbuf, inbufptr, 1, stdout);
-        }
-      } else {
-        if(slip_config_verbose > 2) {
-          printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
-          if(slip_config_verbose > 4) {
+  r->inbufptr = 0;
+  input_radio = r - radios;
+
+  /* Debug lines are written by the radio's putchar and carry no CRC */
+  if(r->crc_rx && inbuf[0] != DEBUG_LINE_MARKER) {
+    if(inbufptr < 3 || crc16_data(inbuf, inbufptr - 2, 0) !=
+       (inbuf[inbufptr - 2] | (inbuf[inbufptr - 1] << 8))) {
+      slip_crc_errors++;
+      if(slip_config_verbose > 0) {
+        fprintf(stderr, "*** dropping %d byte frame with bad CRC\n", inbufptr);
+      }
+      return;
+    }
+    inbufptr -= 2;
+  }
+
+  if(inbuf[0] == '!') {
+    command_context = CMD_CONTEXT_RADIO;
+    cmd_input(inbuf, inbufptr);
+  } else if(inbuf[0] == '?') {
+  } else if(inbuf[0] == DEBUG_LINE_MARKER) {
+    fwrite(inbuf + 1, inbufptr - 1, 1, stdout);
+  } else if(is_sensible_string(inbuf, inbufptr)) {
+    if(slip_config_verbose == 1) {   /* strings already echoed below for verbose>1 */
+      fwrite(inbuf, inbufptr, 1, stdout);
+    }
+  } else {
+    if(slip_config_verbose > 2) {
+      printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
+      if(slip_config_verbose > 4) {
 #if WIRESHARK_IMPORT_FORMAT
-            printf("0000");
-            for(i = 0; i < inbufptr; i++) {
-              printf(" %02x", inbuf[i]);
-            }
+        printf("0000");
+        for(i = 0; i < inbufptr; i++) {
+          printf(" %02x", inbuf[i]);
+        }
 #else
-            printf("         ");
-            for(i = 0; i < inbufptr; i++) {
-              printf("%02x", inbuf[i]);
-              if((i & 3) == 3) {
-                printf(" ");
-              }
-              if((i & 15) == 15) {
-                printf("\n         ");
-              }
-            }
-#endif
-            printf("\n");
+        printf("         ");
+        for(i = 0; i < inbufptr; i++) {
+          printf("%02x", inbuf[i]);
+          if((i & 3) == 3) {
+            printf(" ");
+          }
+          if((i & 15) == 15) {
+            printf("\n         ");
           }
         }
-        slip_packet_input(inbuf, inbufptr);
+#endif
+        printf("\n");
       }
-      inbufptr = 0;
     }
-    break;
+    slip_packet_input(inbuf, inbufptr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Appends one decoded byte to the frame, echoing text for verbose >= 2 */
+static void
+frame_append(struct slip_radio *r, unsigned char c)
+{
+  if(r->inbufptr >= sizeof(r->inbuf)) {
+    fprintf(stderr, "*** dropping large %d byte packet\n", r->inbufptr);
+    r->inbufptr = 0;
+  }
+  r->inbuf[r->inbufptr++] = c;
 
-  case SLIP_ESC:
-    if(fread(&c, 1, 1, inslip) != 1) {
-      clearerr(inslip);
-      /* Put ESC back and give up! */
-      ungetc(SLIP_ESC, inslip);
-      return;
+  /* Echo lines as they are received for verbose=2,3,5+ */
+  /* Echo all printable characters for verbose==4 */
+  if(slip_config_verbose == 4) {
+    if(c == 0 || c == '\r' || c == '\n' || c == '\t' || (c >= ' ' && c <= '~')) {
+      fwrite(&c, 1, 1, stdout);
     }
-
-    switch(c) {
-    case SLIP_ESC_END:
-      c = SLIP_END;
-      break;
-    case SLIP_ESC_ESC:
-      c = SLIP_ESC;
-      break;
+  } else if(slip_config_verbose >= 2) {
+    if(c == '\n' && is_sensible_string(r->inbuf, r->inbufptr)) {
+      fwrite(r->inbuf, r->inbufptr, 1, stdout);
+      r->inbufptr = 0;
     }
-    /* FALLTHROUGH */
-  default:
-    inbuf[inbufptr++] = c;
-
-    /* Echo lines as they are received for verbose=2,3,5+ */
-    /* Echo all printable characters for verbose==4 */
-    if(slip_config_verbose == 4) {
-      if(c == 0 || c == '\r' || c == '\n' || c == '\t' || (c >= ' ' && c <= '~')) {
-        fwrite(&c, 1, 1, stdout);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Decodes a block of SLIP data. Runs of plain bytes are located with
+ * memchr() and copied as a whole; only END and ESC are handled per byte.
+ * Decoder state is kept across calls, so frames and escape sequences
+ * may span several blocks.
+ */
+static void
+slip_decode(struct slip_radio *r, const unsigned char *p, int len)
+{
+  const unsigned char *end = p + len;
+  const unsigned char *frame_end = NULL;
+  const unsigned char *run_end;
+
+  while(p < end) {
+    if(r->inbuf_escaped) {
+      r->inbuf_escaped = 0;
+      if(*p == SLIP_ESC_END) {
+        frame_append(r, SLIP_END);
+      } else if(*p == SLIP_ESC_ESC) {
+        frame_append(r, SLIP_ESC);
+      } else {
+        frame_append(r, *p);
+      }
+      p++;
+    } else if(*p == SLIP_END) {
+      frame_input(r);
+      p++;
+    } else if(*p == SLIP_ESC) {
+      r->inbuf_escaped = 1;
+      p++;
+    } else {
+      if(frame_end == NULL || frame_end < p) {
+        frame_end = memchr(p, SLIP_END, end - p);
+        if(frame_end == NULL) {
+          frame_end = end;
+        }
       }
-    } else if(slip_config_verbose >= 2) {
-      if(c == '\n' && is_sensible_string(inbuf, inbufptr)) {
-        fwrite(inbuf, inbufptr, 1, stdout);
-        inbufptr = 0;
+      run_end = memchr(p, SLIP_ESC, frame_end - p);
+      if(run_end == NULL) {
+        run_end = frame_end;
+      }
+      if(slip_config_verbose >= 2 ||
+         r->inbufptr + (run_end - p) > sizeof(r->inbuf)) {
+        /* Echoing and oversized frames are handled a byte at a time */
+        while(p < run_end) {
+          frame_append(r, *p++);
+        }
+      } else {
+        memcpy(r->inbuf + r->inbufptr, p, run_end - p);
+        r->inbufptr += run_end - p;
+        p = run_end;
       }
     }
-    break;
   }
-
-  goto read_more;
 }
-unsigned char slip_buf[2048];
-int slip_end, slip_begin, slip_packet_end, slip_packet_count;
-static struct timer send_delay_timer;
-/* delay between slip packets */
-static clock_time_t send_delay = SEND_DELAY;
 /*---------------------------------------------------------------------------*/
+/*
+ * Read from serial, when we have a packet call slip_packet_input. Reads
+ * whatever is available in blocks of READ_SIZE bytes and delivers every
+ * complete frame in it, so a burst costs one wakeup rather than one
+ * syscall per byte.
+ */
 static void
-slip_send(int fd, unsigned char c)
+serial_input(struct slip_radio *r)
 {
-  if(slip_end >= sizeof(slip_buf)) {
+  static unsigned char rxbuf[READ_SIZE];
+  ssize_t ret;
+
+  do {
+    ret = read(r->fd, rxbuf, sizeof(rxbuf));
+    if(ret == -1) {
+      if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        return;
+      }
+      err(1, "serial_input: read");
+    }
+    if(ret == 0) {
+      /* Readable without data: the peer has gone away */
+      errx(1, "serial_input: end of file");
+    }
+    slip_received += ret;
+    slip_decode(r, rxbuf, ret);
+  } while(ret == sizeof(rxbuf));
+}
+/*---------------------------------------------------------------------------*/
+static void
+slip_send(struct slip_radio *r, unsigned char c)
+{
+  if(r->end >= sizeof(r->buf)) {
     err(1, "slip_send overflow");
   }
-  slip_buf[slip_end] = c;
-  slip_end++;
+  r->buf[r->end] = c;
+  r->end++;
   slip_sent++;
   if(c == SLIP_END) {
     /* Full packet received. */
-    slip_packet_count++;
-    if(slip_packet_end == 0) {
-      slip_packet_end = slip_end;
+    if(r->packet_end == 0) {
+      r->packet_end = r->end;
     }
   }
 }
 /*---------------------------------------------------------------------------*/
-int
-slip_empty()
+static int
+slip_empty(struct slip_radio *r)
 {
-  return slip_packet_end == 0;
+  return r->packet_end == 0;
 }
 /*---------------------------------------------------------------------------*/
-void
-slip_flushbuf(int fd)
+/*
+ * Writes queued packets to the serial line. Without a send delay, all
+ * complete packets go out in a single write; otherwise one packet is
+ * written per call so the delay can be applied in between.
+ */
+static void
+slip_flushbuf(struct slip_radio *r)
 {
+  const unsigned char *next;
   int n;
+  int flush_end;
 
-  if(slip_empty()) {
+  if(slip_empty(r)) {
     return;
   }
 
-  n = write(fd, slip_buf + slip_begin, slip_packet_end - slip_begin);
+  /* Every packet ends with SLIP_END, so end is a packet boundary */
+  flush_end = send_delay > 0 ? r->packet_end : r->end;
+  n = write(r->fd, r->buf + r->begin, flush_end - r->begin);
 
   if(n == -1 && errno != EAGAIN) {
     err(1, "slip_flushbuf write failed");
   } else if(n == -1) {
     PROGRESS("Q");		/* Outqueue is full! */
   } else {
-    slip_begin += n;
-    if(slip_begin == slip_packet_end) {
-      slip_packet_count--;
-      if(slip_end > slip_packet_end) {
-        memmove(slip_buf, slip_buf + slip_packet_end,
-               slip_end - slip_packet_end);
+    r->begin += n;
+    if(r->begin >= r->packet_end) {
+      if(r->end > r->begin) {
+        memmove(r->buf, r->buf + r->begin, r->end - r->begin);
       }
-      slip_end -= slip_packet_end;
-      slip_begin = slip_packet_end = 0;
-      if(slip_end > 0) {
+      r->end -= r->begin;
+      r->begin = r->packet_end = 0;
+      if(r->end > 0) {
         /* Find end of next slip packet */
-        for(n = 1; n < slip_end; n++) {
-          if(slip_buf[n] == SLIP_END) {
-            slip_packet_end = n + 1;
-            break;
-          }
+        next = memchr(r->buf, SLIP_END, r->end);
+        if(next != NULL) {
+          r->packet_end = next - r->buf + 1;
         }
         /* a delay between slip packets to avoid losing data */
         if(send_delay > 0) {
-          timer_set(&send_delay_timer, send_delay);
+          timer_set(&r->send_delay_timer, send_delay);
         }
       }
     }
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Encodes data straight into the output buffer, reserving the worst case */
 static void
-write_to_serial(int outfd, const uint8_t *inbuf, int len)
+slip_encode(struct slip_radio *r, const uint8_t *p, int len)
+{
+  unsigned char *out;
+  int i;
+
+  if(r->end + 2 * len + 1 > sizeof(r->buf)) {
+    err(1, "slip_send overflow");
+  }
+  out = r->buf + r->end;
+  for(i = 0; i < len; i++) {
+    switch(p[i]) {
+    case SLIP_END:
+      *out++ = SLIP_ESC;
+      *out++ = SLIP_ESC_END;
+      break;
+    case SLIP_ESC:
+      *out++ = SLIP_ESC;
+      *out++ = SLIP_ESC_ESC;
+      break;
+    default:
+      *out++ = p[i];
+      break;
+    }
+  }
+  slip_sent += out - (r->buf + r->end);
+  r->end = out - r->buf;
+}
+/*---------------------------------------------------------------------------*/
+static void
+write_to_serial(struct slip_radio *r, const uint8_t *inbuf, int len)
 {
   const uint8_t *p = inbuf;
+  uint8_t trailer[2];
+  uint16_t crc;
   int i;
 
   if(slip_config_verbose > 2) {
@@ -395,33 +541,122 @@ write_to_serial(int outfd, const uint8_t *inbuf, int len)
   /* It would be ``nice'' to send a SLIP_END here but it's not
    * really necessary.
    */
-  /* slip_send(outfd, SLIP_END); */
+  /* slip_send(r, SLIP_END); */
+
+  slip_encode(r, p, len);
+  if(r->crc) {
+    crc = crc16_data(p, len, 0);
+    trailer[0] = crc & 0xff;
+    trailer[1] = crc >> 8;
+    slip_encode(r, trailer, sizeof(trailer));
+  }
+  slip_send(r, SLIP_END);
+  PROGRESS("t");
+}
+/*---------------------------------------------------------------------------*/
+static int
+is_data_frame(const uint8_t *buf, int len)
+{
+  return len >= 2 && buf[0] == '!' && buf[1] == 'S';
+}
+/*---------------------------------------------------------------------------*/
+/* Sends held data frames for as long as the radio has credits */
+static void
+release_held(struct slip_radio *r)
+{
+  while(r->held_count > 0 && r->credits > 0) {
+    r->credits--;
+    write_to_serial(r, r->held[r->held_first].data,
+                    r->held[r->held_first].len);
+    r->held_first = (r->held_first + 1) % HELD_FRAMES;
+    r->held_count--;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * writes an 802.15.4 packet or a command to one slip-radio. Data frames
+ * are held back while the radio is out of credits. Returns 0 if the
+ * frame had to be dropped.
+ */
+int
+write_to_slip_radio(int radio, const uint8_t *buf, int len)
+{
+  struct slip_radio *r;
+  int i;
 
-  for(i = 0; i < len; i++) {
-    switch(p[i]) {
-    case SLIP_END:
-      slip_send(outfd, SLIP_ESC);
-      slip_send(outfd, SLIP_ESC_END);
-      break;
-    case SLIP_ESC:
-      slip_send(outfd, SLIP_ESC);
-      slip_send(outfd, SLIP_ESC_ESC);
-      break;
-    default:
-      slip_send(outfd, p[i]);
-      break;
+  if(radio < 0 || radio >= radio_count) {
+    return 0;
+  }
+  r = &radios[radio];
+  if(r->credits < 0 || !is_data_frame(buf, len)) {
+    write_to_serial(r, buf, len);
+    return 1;
+  }
+  if(r->credits > 0 && r->held_count == 0) {
+    r->credits--;
+    write_to_serial(r, buf, len);
+    return 1;
+  }
+  if(r->held_count == HELD_FRAMES || len > HELD_FRAME_SIZE) {
+    return 0;
+  }
+  i = (r->held_first + r->held_count) % HELD_FRAMES;
+  memcpy(r->held[i].data, buf, len);
+  r->held[i].len = len;
+  r->held_count++;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * writes an 802.15.4 packet or a command to all slip-radios. Returns the
+ * number of radios that took the frame.
+ */
+int
+write_to_slip(const uint8_t *buf, int len)
+{
+  int i;
+  int queued = 0;
+
+  for(i = 0; i < radio_count; i++) {
+    queued += write_to_slip_radio(i, buf, len);
+  }
+  return queued;
+}
+/*---------------------------------------------------------------------------*/
+void
+slip_radio_flow_init(int radio, int credits, uint8_t caps)
+{
+  struct slip_radio *r;
+  uint8_t enable[] = { '!', 'F', SLIP_RADIO_FLAG_CRC };
+
+  if(radio < 0 || radio >= radio_count) {
+    return;
+  }
+  r = &radios[radio];
+  if(r->credits >= 0) {
+    /* The radio acknowledged !F and sends CRCs from its next frame on */
+    if(r->crc && (caps & SLIP_RADIO_FLAG_CRC)) {
+      r->crc_rx = 1;
     }
+    return;
   }
-  slip_send(outfd, SLIP_END);
-  PROGRESS("t");
+  r->credits = credits;
+  if(slip_config_crc && (caps & SLIP_RADIO_FLAG_CRC)) {
+    /* The radio checks CRCs from the frame after this one on */
+    write_to_serial(r, enable, sizeof(enable));
+    r->crc = 1;
+  }
+  fprintf(stderr, "********SLIP radio %d: %d credits%s\n", radio, credits,
+          r->crc ? ", CRC framing" : "");
+  release_held(r);
 }
 /*---------------------------------------------------------------------------*/
-/* writes an 802.15.4 packet to slip-radio */
 void
-write_to_slip(const uint8_t *buf, int len)
+slip_radio_credit(int radio, int n)
 {
-  if(slipfd > 0) {
-    write_to_serial(slipfd, buf, len);
+  if(radio >= 0 && radio < radio_count && radios[radio].credits >= 0) {
+    radios[radio].credits += n;
+    release_held(&radios[radio]);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -469,8 +704,9 @@ stty_telos(int fd)
     err(1, "tcsetattr");
   }
 
+  /* Pseudo terminals have no modem control lines */
   i = TIOCM_DTR;
-  if(ioctl(fd, TIOCMBIS, &i) == -1) {
+  if(ioctl(fd, TIOCMBIS, &i) == -1 && errno != ENOTTY && errno != EINVAL) {
     err(1, "ioctl");
   }
 #endif
@@ -483,86 +719,116 @@ stty_telos(int fd)
   }
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * The callback is shared by all radio descriptors and may be invoked
+ * once per descriptor with the same sets, so each descriptor is cleared
+ * once it has been handled.
+ */
 static int
 set_fd(fd_set *rset, fd_set *wset)
 {
-  /* Anything to flush? */
-  if(!slip_empty() && (send_delay == 0 || timer_expired(&send_delay_timer))) {
-    FD_SET(slipfd, wset);
-  }
+  struct slip_radio *r;
 
-  FD_SET(slipfd, rset);	/* Read from slip ASAP! */
+  for(r = radios; r < radios + radio_count; r++) {
+    /* Anything to flush? */
+    if(!slip_empty(r) &&
+       (send_delay == 0 || timer_expired(&r->send_delay_timer))) {
+      FD_SET(r->fd, wset);
+    }
+
+    FD_SET(r->fd, rset);	/* Read from slip ASAP! */
+  }
   return 1;
 }
 /*---------------------------------------------------------------------------*/
 static void
 handle_fd(fd_set *rset, fd_set *wset)
 {
-  if(FD_ISSET(slipfd, rset)) {
-    serial_input(inslip);
-  }
+  struct slip_radio *r;
 
-  if(FD_ISSET(slipfd, wset)) {
-    slip_flushbuf(slipfd);
+  for(r = radios; r < radios + radio_count; r++) {
+    if(FD_ISSET(r->fd, rset)) {
+      FD_CLR(r->fd, rset);
+      serial_input(r);
+    }
+
+    if(FD_ISSET(r->fd, wset)) {
+      FD_CLR(r->fd, wset);
+      slip_flushbuf(r);
+    }
   }
 }
 /*---------------------------------------------------------------------------*/
 static const struct select_callback slip_callback = { set_fd, handle_fd };
 /*---------------------------------------------------------------------------*/
+static void
+radio_add(int fd)
+{
+  struct slip_radio *r = &radios[radio_count++];
+
+  r->fd = fd;
+  r->credits = -1;
+  timer_set(&r->send_delay_timer, 0);
+  if(select_set_callback(fd, &slip_callback) == 0) {
+    errx(1, "slip_init: descriptor %d out of range", fd);
+  }
+  slip_send(r, SLIP_END);
+}
+/*---------------------------------------------------------------------------*/
 void
 slip_init(void)
 {
+  int fd;
+  int i;
+
   setvbuf(stdout, NULL, _IOLBF, 0); /* Line buffered output. */
 
   if(slip_config_host != NULL) {
-    if(slip_config_port == NULL) {
-      slip_config_port = "60001";
+    if(slip_config_port_count == 0) {
+      slip_config_port[slip_config_port_count++] = "60001";
     }
-    slipfd = connect_to_server(slip_config_host, slip_config_port);
-    if(slipfd == -1) {
-      err(1, "can't connect to ``%s:%s''", slip_config_host, slip_config_port);
+    for(i = 0; i < slip_config_port_count; i++) {
+      fd = connect_to_server(slip_config_host, slip_config_port[i]);
+      if(fd == -1) {
+        err(1, "can't connect to ``%s:%s''", slip_config_host,
+            slip_config_port[i]);
+      }
+      radio_add(fd);
+      fprintf(stderr, "********SLIP opened to ``%s:%s''\n", slip_config_host,
+              slip_config_port[i]);
     }
-  } else if(slip_config_siodev != NULL) {
-    if(strcmp(slip_config_siodev, "null") == 0) {
+  } else if(slip_config_siodev_count > 0) {
+    if(strcmp(slip_config_siodev[0], "null") == 0) {
       /* Disable slip */
       return;
     }
-    slipfd = devopen(slip_config_siodev, O_RDWR | O_NONBLOCK);
-    if(slipfd == -1) {
-      err(1, "can't open siodev ``/dev/%s''", slip_config_siodev);
+    for(i = 0; i < slip_config_siodev_count; i++) {
+      fd = devopen(slip_config_siodev[i], O_RDWR | O_NONBLOCK);
+      if(fd == -1) {
+        err(1, "can't open siodev ``/dev/%s''", slip_config_siodev[i]);
+      }
+      fprintf(stderr, "********SLIP started on ``/dev/%s''\n",
+              slip_config_siodev[i]);
+      stty_telos(fd);
+      radio_add(fd);
     }
   } else {
     static const char *siodevs[] = {
       "ttyUSB0", "cuaU0", "ucom0" /* linux, fbsd6, fbsd5 */
     };
-    int i;
+    fd = -1;
     for(i = 0; i < 3; i++) {
-      slip_config_siodev = siodevs[i];
-      slipfd = devopen(slip_config_siodev, O_RDWR | O_NONBLOCK);
-      if(slipfd != -1) {
+      fd = devopen(siodevs[i], O_RDWR | O_NONBLOCK);
+      if(fd != -1) {
         break;
       }
     }
-    if(slipfd == -1) {
+    if(fd == -1) {
       err(1, "can't open siodev");
     }
-  }
-
-  select_set_callback(slipfd, &slip_callback);
-
-  if(slip_config_host != NULL) {
-    fprintf(stderr, "********SLIP opened to ``%s:%s''\n", slip_config_host,
-            slip_config_port);
-  } else {
-    fprintf(stderr, "********SLIP started on ``/dev/%s''\n", slip_config_siodev);
-    stty_telos(slipfd);
-  }
-
-  timer_set(&send_delay_timer, 0);
-  slip_send(slipfd, SLIP_END);
-  inslip = fdopen(slipfd, "r");
-  if(inslip == NULL) {
-    err(1, "slip_init: fdopen");
+    fprintf(stderr, "********SLIP started on ``/dev/%s''\n", siodevs[i]);
+    stty_telos(fd);
+    radio_add(fd);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -67,6 +67,43 @@
 #include "cmd.h"
 #include "border-router.h"
 
+/*
+ * Maximum number of packets read from the tun device per main loop
+ * wakeup, when no base delay is configured.
+ */
+#ifdef TUN_BRIDGE_CONF_READ_BATCH
+#define READ_BATCH TUN_BRIDGE_CONF_READ_BATCH
+#else
+#define READ_BATCH 16
+#endif
+
+/*
+ * With threads enabled, blocking tun reads and writes run on two worker
+ * threads that exchange packets with the Contiki core through
+ * single-producer single-consumer rings, so the core never waits on the
+ * tun device. Everything that touches uIP state stays on the core.
+ * Packets for the tun device that find the ring full are dropped.
+ * Enabled with TUN_BRIDGE_THREADS=1 on the make command line, which also
+ * links with pthreads.
+ */
+#ifdef TUN_BRIDGE_CONF_THREADS
+#define TUN_BRIDGE_THREADS TUN_BRIDGE_CONF_THREADS
+#else
+#define TUN_BRIDGE_THREADS 0
+#endif
+
+/* Packets per ring; a power of two up to 128 */
+#ifdef TUN_BRIDGE_CONF_RING_SIZE
+#define RING_SIZE TUN_BRIDGE_CONF_RING_SIZE
+#else
+#define RING_SIZE 64
+#endif
+
+#if TUN_BRIDGE_THREADS
+#include <pthread.h>
+#include "lib/ringbufindex.h"
+#endif /* TUN_BRIDGE_THREADS */
+
 extern const char *slip_config_ipaddr;
 extern char slip_config_tundev[32];
 extern uint16_t slip_config_basedelay;
@@ -197,6 +234,160 @@ tun_init()
 static uint16_t delaymsec = 0;
 static uint32_t delaystartsec, delaystartmsec;
 
+#if TUN_BRIDGE_THREADS
+struct tun_packet {
+  uint16_t len;
+  uint8_t data[UIP_BUFSIZE];
+};
+
+/*
+ * A packet ring between one producer and one consumer thread. The
+ * producer writes a byte to the pipe when the consumer may be waiting
+ * for it, at most once until the consumer acknowledges.
+ */
+struct tun_ring {
+  struct ringbufindex index;
+  struct tun_packet packets[RING_SIZE];
+  int notify[2];
+  int notify_pending;
+};
+
+static struct tun_ring rx_ring; /* tun to core */
+static struct tun_ring tx_ring; /* core to tun */
+static unsigned long tx_dropped;
+/*---------------------------------------------------------------------------*/
+static void
+ring_init(struct tun_ring *ring)
+{
+  ringbufindex_init(&ring->index, RING_SIZE);
+  if(pipe(ring->notify) == -1) {
+    err(1, "tun_init: pipe");
+  }
+  /* A full pipe already holds a wakeup */
+  fcntl(ring->notify[1], F_SETFL, O_NONBLOCK);
+}
+/*---------------------------------------------------------------------------*/
+static void
+ring_wake(struct tun_ring *ring)
+{
+  if(!__atomic_exchange_n(&ring->notify_pending, 1, __ATOMIC_SEQ_CST)) {
+    if(write(ring->notify[1], "", 1) == -1 && errno != EAGAIN) {
+      err(1, "tun ring: write");
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Consumes a wakeup; the ring must be checked for packets afterwards */
+static void
+ring_ack(struct tun_ring *ring)
+{
+  char c;
+
+  if(read(ring->notify[0], &c, 1) == -1 && errno != EINTR) {
+    err(1, "tun ring: read");
+  }
+  __atomic_store_n(&ring->notify_pending, 0, __ATOMIC_SEQ_CST);
+}
+/*---------------------------------------------------------------------------*/
+static int
+ring_put(struct tun_ring *ring, const uint8_t *data, int len)
+{
+  int i;
+
+  i = ringbufindex_peek_put(&ring->index);
+  if(i < 0) {
+    return 0;
+  }
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  memcpy(ring->packets[i].data, data, len);
+  ring->packets[i].len = len;
+  /* Publish the packet before the index */
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  ringbufindex_put(&ring->index);
+  ring_wake(ring);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static struct tun_packet *
+ring_peek(struct tun_ring *ring)
+{
+  int i;
+
+  i = ringbufindex_peek_get(&ring->index);
+  if(i < 0) {
+    return NULL;
+  }
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return &ring->packets[i];
+}
+/*---------------------------------------------------------------------------*/
+static void
+ring_release(struct tun_ring *ring)
+{
+  /* Done with the slot before handing it back */
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  ringbufindex_get(&ring->index);
+}
+/*---------------------------------------------------------------------------*/
+static void *
+rx_thread(void *arg)
+{
+  static uint8_t buf[UIP_BUFSIZE];
+  int size;
+
+  while(1) {
+    size = read(tunfd, buf, sizeof(buf));
+    if(size == -1) {
+      if(errno == EINTR) {
+        continue;
+      }
+      err(1, "tun_input: read");
+    }
+    /* When the core falls behind, leave the backlog in the tun queue */
+    while(size > 0 && !ring_put(&rx_ring, buf, size)) {
+      usleep(100);
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void *
+tx_thread(void *arg)
+{
+  struct tun_packet *packet;
+
+  while(1) {
+    ring_ack(&tx_ring);
+    while((packet = ring_peek(&tx_ring)) != NULL) {
+      if(write(tunfd, packet->data, packet->len) != packet->len) {
+        err(1, "serial_to_tun: write");
+      }
+      ring_release(&tx_ring);
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+start_threads(void)
+{
+  pthread_t thread;
+  sigset_t mask, old;
+
+  ring_init(&rx_ring);
+  ring_init(&tx_ring);
+
+  /* Leave signal handling, and thus cleanup, to the main thread */
+  sigfillset(&mask);
+  pthread_sigmask(SIG_BLOCK, &mask, &old);
+  if(pthread_create(&thread, NULL, rx_thread, NULL) != 0 ||
+     pthread_create(&thread, NULL, tx_thread, NULL) != 0) {
+    errx(1, "tun_init: failed to start threads");
+  }
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+}
+#endif /* TUN_BRIDGE_THREADS */
+
 /*---------------------------------------------------------------------------*/
 void
 tun_init()
@@ -213,7 +404,19 @@ tun_init()
     err(1, "tun_init: open");
   }
 
+#if TUN_BRIDGE_THREADS
+  start_threads();
+  if(select_set_callback(rx_ring.notify[0], &tun_select_callback) == 0) {
+    errx(1, "tun_init: descriptor %d out of range", rx_ring.notify[0]);
+  }
+#else /* TUN_BRIDGE_THREADS */
+  /* Non-blocking, so that a batched read stops when the queue is empty */
+  if(fcntl(tunfd, F_SETFL, fcntl(tunfd, F_GETFL) | O_NONBLOCK) == -1) {
+    err(1, "tun_init: fcntl");
+  }
+
   select_set_callback(tunfd, &tun_select_callback);
+#endif /* TUN_BRIDGE_THREADS */
 
   fprintf(stderr, "opened %s device ``/dev/%s''\n",
           "tun", slip_config_tundev);
@@ -229,10 +432,20 @@ static int
 tun_output(uint8_t *data, int len)
 {
   /* fprintf(stderr, "*** Writing to tun...%d\n", len); */
+#if TUN_BRIDGE_THREADS
+  /* Writing past the ring would overtake the packets queued in it, and
+     waiting for the writer thread would stall the core */
+  if(!ring_put(&tx_ring, data, len)) {
+    fprintf(stderr, "*** dropping %d byte packet, tun writer behind"
+            " (%lu dropped)\n", len, ++tx_dropped);
+    return -1;
+  }
+#else /* TUN_BRIDGE_THREADS */
   if(write(tunfd, data, len) != len) {
     err(1, "serial_to_tun: write");
     return -1;
   }
+#endif /* TUN_BRIDGE_THREADS */
   return 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -240,9 +453,24 @@ int
 tun_input(unsigned char *data, int maxlen)
 {
   int size;
+#if TUN_BRIDGE_THREADS
+  struct tun_packet *packet;
+
+  packet = ring_peek(&rx_ring);
+  if(packet == NULL) {
+    return 0;
+  }
+  size = MIN(packet->len, maxlen);
+  memcpy(data, packet->data, size);
+  ring_release(&rx_ring);
+#else /* TUN_BRIDGE_THREADS */
   if((size = read(tunfd, data, maxlen)) == -1) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      return 0;
+    }
     err(1, "tun_input: read");
   }
+#endif /* TUN_BRIDGE_THREADS */
   return size;
 }
 /*---------------------------------------------------------------------------*/
@@ -270,7 +498,11 @@ const struct uip_fallback_interface rpl_interface = {
 static int
 set_fd(fd_set *rset, fd_set *wset)
 {
+#if TUN_BRIDGE_THREADS
+  FD_SET(rx_ring.notify[0], rset);
+#else /* TUN_BRIDGE_THREADS */
   FD_SET(tunfd, rset);
+#endif /* TUN_BRIDGE_THREADS */
   return 1;
 }
 /*---------------------------------------------------------------------------*/
@@ -296,12 +528,30 @@ handle_fd(fd_set *rset, fd_set *wset)
 
   if(delaymsec == 0) {
     int size;
+    int i;
 
+#if TUN_BRIDGE_THREADS
+    if(FD_ISSET(rx_ring.notify[0], rset)) {
+      ring_ack(&rx_ring);
+#else /* TUN_BRIDGE_THREADS */
     if(FD_ISSET(tunfd, rset)) {
-      size = tun_input(uip_buf, sizeof(uip_buf));
-      /* printf("TUN data incoming read:%d\n", size); */
-      uip_len = size;
-      tcpip_input();
+#endif /* TUN_BRIDGE_THREADS */
+      /* Drain a burst at once unless packets are to be spaced out */
+      for(i = 0; i < (slip_config_basedelay ? 1 : READ_BATCH); i++) {
+        size = tun_input(uip_buf, sizeof(uip_buf));
+        /* printf("TUN data incoming read:%d\n", size); */
+        if(size <= 0) {
+          break;
+        }
+        uip_len = size;
+        tcpip_input();
+      }
+#if TUN_BRIDGE_THREADS
+      if(ring_peek(&rx_ring) != NULL) {
+        /* Come back for the rest of the burst */
+        ring_wake(&rx_ring);
+      }
+#endif /* TUN_BRIDGE_THREADS */
 
       if(slip_config_basedelay) {
         struct timeval tv;
@@ -33,6 +33,7 @@
 #include "contiki.h"
 #include "net/routing/routing.h"
 #include "rpl-border-router.h"
+#include <string.h>
 
 /* Log configuration */
 #include "sys/log.h"
@@ -41,6 +42,68 @@
 
 uint8_t prefix_set;
 
+#if UIP_ND6_REGISTRATION
+/* The addresses registered network-wide, as seen by the 6LBR */
+struct registration {
+  uip_ipaddr_t addr;
+  uint8_t rovr[8];
+  uint8_t used;
+  struct stimer lifetime;
+};
+static struct registration registrations[RPL_BORDER_ROUTER_REGISTRATIONS];
+
+/*---------------------------------------------------------------------------*/
+/* Answers the DARs of the 6LRs and the registrations made directly with
+   the border router */
+static uint8_t
+registration_check(const uip_ipaddr_t *addr, const uint8_t *rovr,
+                   uint16_t lifetime)
+{
+  struct registration *r;
+  struct registration *free_r = NULL;
+
+  for(r = registrations; r < registrations + RPL_BORDER_ROUTER_REGISTRATIONS;
+      r++) {
+    if(r->used && stimer_expired(&r->lifetime)) {
+      r->used = 0;
+    }
+    if(r->used && uip_ipaddr_cmp(&r->addr, addr)) {
+      if(memcmp(r->rovr, rovr, sizeof(r->rovr)) != 0) {
+        LOG_WARN("Duplicate address ");
+        LOG_WARN_6ADDR(addr);
+        LOG_WARN_("\n");
+        return UIP_ND6_REG_STATUS_DUPLICATE;
+      }
+      break;
+    }
+    if(!r->used && free_r == NULL) {
+      free_r = r;
+    }
+  }
+
+  if(r == registrations + RPL_BORDER_ROUTER_REGISTRATIONS) {
+    if(lifetime == 0) {
+      return UIP_ND6_REG_STATUS_SUCCESS;
+    }
+    if(free_r == NULL) {
+      LOG_WARN("Registration table full\n");
+      return UIP_ND6_REG_STATUS_CACHE_FULL;
+    }
+    r = free_r;
+  }
+
+  if(lifetime == 0) {
+    r->used = 0;
+  } else {
+    r->used = 1;
+    uip_ipaddr_copy(&r->addr, addr);
+    memcpy(r->rovr, rovr, sizeof(r->rovr));
+    stimer_set(&r->lifetime, (unsigned long)lifetime * 60);
+  }
+  return UIP_ND6_REG_STATUS_SUCCESS;
+}
+#endif /* UIP_ND6_REGISTRATION */
+
 /*---------------------------------------------------------------------------*/
 void
 print_local_addresses(void)
@@ -72,6 +135,9 @@ void
 rpl_border_router_init(void)
 {
   PROCESS_NAME(border_router_process);
+#if UIP_ND6_REGISTRATION
+  uip_nd6_reg_set_authority(registration_check);
+#endif /* UIP_ND6_REGISTRATION */
   process_start(&border_router_process, NULL);
 }
 /*---------------------------------------------------------------------------*/
@@ -34,6 +34,14 @@
 #include "net/ipv6/uip.h"
 #include "net/ipv6/uip-ds6.h"
 
+/* Size of the 6LBR address registration table (RFC 6775 multihop DAD),
+   used with UIP_CONF_ND6_REGISTRATION */
+#ifdef RPL_BORDER_ROUTER_CONF_REGISTRATIONS
+#define RPL_BORDER_ROUTER_REGISTRATIONS RPL_BORDER_ROUTER_CONF_REGISTRATIONS
+#else
+#define RPL_BORDER_ROUTER_REGISTRATIONS 32
+#endif
+
 extern uint8_t prefix_set;
 
 void rpl_border_router_init(void);
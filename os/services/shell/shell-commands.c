@@ -225,13 +225,13 @@ PT_THREAD(cmd_rpl_nbr(struct pt *pt, shell_output_func output, char *args))
   if(!curr_instance.used || rpl_neighbor_count() == 0) {
     SHELL_OUTPUT(output, "RPL neighbors: none\n");
   } else {
-    rpl_nbr_t *nbr = nbr_table_head(rpl_neighbors);
+    rpl_nbr_t *nbr = rpl_neighbor_head();
     SHELL_OUTPUT(output, "RPL neighbors:\n");
     while(nbr != NULL) {
       char buf[120];
       rpl_neighbor_snprint(buf, sizeof(buf), nbr);
       SHELL_OUTPUT(output, "%s\n", buf);
-      nbr = nbr_table_next(rpl_neighbors, nbr);
+      nbr = rpl_neighbor_next(nbr);
     }
   }
 
@@ -42,6 +42,16 @@
 
 #define CMD_TYPE_ERR 'E'
 
+/*
+ * slip-radio flow control and framing extensions. The host queries with
+ * ?F and the radio answers !F<credits><flags>, after which TX status is
+ * reported in batches as !B<n>(<sid><status><tx>)*n, each entry
+ * returning one credit. Sending !F<flags> to the radio enables flags;
+ * the radio acknowledges with !F<credits><flags> and applies them to the
+ * frames that follow.
+ */
+#define SLIP_RADIO_FLAG_CRC 0x01 /* CRC-16 trailer on every frame */
+
 typedef int (* cmd_handler_t)(const uint8_t *data, int len);
 
 #define CMD_HANDLERS(...) \
@@ -0,0 +1,9 @@
+#!/bin/bash
+
+# Fragments are forwarded through 6LoWPAN and CSMA, not tun6 and nullmac
+export TEST_PROTOCOL=sicslowpan
+export TEST_NAME=sicslowpan-vrb
+export TEST_DEFINES=SICSLOWPAN_CONF_FRAG_FORWARDING=1,NETSTACK_CONF_NETWORK=sicslowpan_driver
+export TEST_MAKEFLAGS=MAKE_MAC=MAKE_MAC_CSMA
+
+source packet-injector.sh
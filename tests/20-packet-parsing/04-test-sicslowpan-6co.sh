@@ -0,0 +1,8 @@
+#!/bin/bash
+
+# The 6LoWPAN network driver, not tun6, sets up the preconfigured context
+export TEST_PROTOCOL=sicslowpan
+export TEST_NAME=sicslowpan-6co
+export TEST_DEFINES=UIP_CONF_ND6_RA_6CO=1,SICSLOWPAN_CONF_COAP_RULES=2,SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS=4,NETSTACK_CONF_NETWORK=sicslowpan_driver
+
+source packet-injector.sh
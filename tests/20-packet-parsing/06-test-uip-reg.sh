@@ -0,0 +1,7 @@
+#!/bin/bash
+
+export TEST_PROTOCOL=uip
+export TEST_NAME=uip-reg
+export TEST_DEFINES=UIP_CONF_ND6_REGISTRATION=1,UIP_CONF_ND6_SEND_NA=1
+
+source packet-injector.sh
@@ -12,12 +12,16 @@ TIMEDOUT=0
 # Example code directory
 CODE_DIR=packet-injector
 CODE=packet-injector
-PACKET_DIR=$CODE_DIR/$TEST_PROTOCOL-data
+# Tests of optional features set TEST_NAME, and TEST_DEFINES and
+# TEST_MAKEFLAGS to build the injector with the features enabled
+TEST_NAME=${TEST_NAME:-$TEST_PROTOCOL}
+PACKET_DIR=$CODE_DIR/$TEST_NAME-data
 echo packet dir = $PACKET_DIR
 
 # Starting Contiki-NG native node
 echo "Starting native node"
-make -C $CODE_DIR TARGET=native > make.log 2> make.err
+make -C $CODE_DIR TARGET=native clean > /dev/null
+make -C $CODE_DIR TARGET=native DEFINES=$TEST_DEFINES $TEST_MAKEFLAGS > make.log 2> make.err
 
 for i in $PACKET_DIR/*
 do
@@ -48,10 +52,10 @@ if [ $((TIMEDOUT + FAILED)) -gt 0 ]; then
   echo "==== $CODE.log ====" ; cat $CODE.log;
   echo "==== $CODE.err ====" ; cat $CODE.err;
 
-  printf "%-32s TEST FAIL\n" "$CODE-$TEST_PROTOCOL" | tee $CODE.testlog;
+  printf "%-32s TEST FAIL\n" "$CODE-$TEST_NAME" | tee $CODE.testlog;
 else
   cp $CODE.log $CODE.testlog
-  printf "%-32s TEST OK\n" "$CODE-$TEST_PROTOCOL" | tee $CODE.testlog;
+  printf "%-32s TEST OK\n" "$CODE-$TEST_NAME" | tee $CODE.testlog;
 fi
 
 rm make.log
@@ -52,6 +52,9 @@
 #include <net/netstack.h>
 #include <net/packetbuf.h>
 #include <net/ipv6/sicslowpan.h>
+#include <net/ipv6/uip-ds6-nbr.h>
+#include <net/ipv6/uip-ds6-route.h>
+#include <net/ipv6/uip-nd6.h>
 #include <net/app-layer/coap/coap.h>
 #include <net/app-layer/coap/coap-engine.h>
 
@@ -67,6 +70,12 @@
 #define TEST_COAP_ENDPOINT "fdfd::100"
 #define TEST_COAP_PORT 8293
 
+/* The default router of the node, a 6LoWPAN neighbor */
+#define TEST_ROUTER "fe80::212:4b00:0:1"
+
+/* An address that the registration authority refuses */
+#define TEST_DUPLICATE "fd00::bad"
+
 typedef bool (*protocol_function_t)(char *, int);
 
 /*---------------------------------------------------------------------------*/
@@ -95,6 +104,74 @@ read_packet(const char *filename, char *buf, int max_len)
   return len;
 }
 /*---------------------------------------------------------------------------*/
+#if UIP_ND6_REGISTRATION
+static uint8_t
+test_reg_authority(const uip_ipaddr_t *addr, const uint8_t *rovr,
+                   uint16_t lifetime)
+{
+  uip_ipaddr_t duplicate;
+
+  uiplib_ipaddrconv(TEST_DUPLICATE, &duplicate);
+  return uip_ipaddr_cmp(addr, &duplicate) ?
+    UIP_ND6_REG_STATUS_DUPLICATE : UIP_ND6_REG_STATUS_SUCCESS;
+}
+#endif /* UIP_ND6_REGISTRATION */
+/*---------------------------------------------------------------------------*/
+/* State that lets the packets of optional features reach their code */
+static void
+setup_features(void)
+{
+#if SICSLOWPAN_CONF_FRAG_FORWARDING || UIP_ND6_RA_6CO || UIP_ND6_REGISTRATION
+  static const uip_lladdr_t router_lladdr = {
+    { 0x00, 0x12, 0x4b, 0x00, 0x00, 0x00, 0x00, 0x01 }
+  };
+  uip_ipaddr_t router;
+
+  /* A route to forward fragments to, and a router to learn contexts from
+     and to register with */
+  uiplib_ipaddrconv(TEST_ROUTER, &router);
+  uip_ds6_nbr_add(&router, &router_lladdr, 1, NBR_REACHABLE,
+                  NBR_TABLE_REASON_UNDEFINED, NULL);
+  uip_ds6_defrt_add(&router, 0);
+#endif /* SICSLOWPAN_CONF_FRAG_FORWARDING || UIP_ND6_RA_6CO || UIP_ND6_REGISTRATION */
+
+#if UIP_ND6_REGISTRATION
+  /* Answer DARs as a 6LBR, and have a registration with the router
+     pending. The NS that starts it is dropped */
+  uip_nd6_reg_set_authority(test_reg_authority);
+  uip_nd6_reg_periodic();
+  uipbuf_clear();
+#endif /* UIP_ND6_REGISTRATION */
+
+#if UIP_ND6_RA_6CO
+  {
+    uint8_t prefix[8] = { 0xfd, 0x01 };
+
+    /* Context 1 compresses, context 2 only decompresses */
+    sicslowpan_context_update(1, prefix, 1, 0xffffffff);
+    prefix[1] = 0x02;
+    sicslowpan_context_update(2, prefix, 0, 0xffffffff);
+  }
+#endif /* UIP_ND6_RA_6CO */
+
+#if SICSLOWPAN_COAP_RULES > 0
+  {
+    /* A GET of /test, and a NON 2.05 response with a payload */
+    static const struct sicslowpan_coap_rule get_rule = {
+      COAP_DEFAULT_PORT, 1, COAP_TYPE_CON, COAP_GET, 2,
+      5, { 0xb4, 't', 'e', 's', 't' }
+    };
+    static const struct sicslowpan_coap_rule content_rule = {
+      COAP_DEFAULT_PORT, 2, COAP_TYPE_NON, CONTENT_2_05, 0,
+      1, { 0xff }
+    };
+
+    sicslowpan_coap_rule_add(&get_rule);
+    sicslowpan_coap_rule_add(&content_rule);
+  }
+#endif /* SICSLOWPAN_COAP_RULES > 0 */
+}
+/*---------------------------------------------------------------------------*/
 static bool
 inject_coap_packet(char *data, int len)
 {
@@ -205,6 +282,8 @@ PROCESS_THREAD(packet_injector_process, ev, data)
     exit(EXIT_FAILURE);
   }
 
+  setup_features();
+
   LOG_INFO("Injecting a packet of %d bytes into %s\n", len, protocol_name);
 
   if(protocol_input(file_buf, len) == false) {
@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Launcher for native nodes on the shared-memory radio medium.
+ *
+ *         Creates the medium, starts the given firmware images built
+ *         with SHM_RADIO=1 as nodes 1..N and waits for them. Nodes run on
+ *         a common virtual clock, so e.g.
+ *
+ *           ./native-sim -t 86400 -o logs udp-server.native \
+ *             udp-client.native:99
+ *
+ *         simulates a 100-node network for one day as fast as the host
+ *         allows. Without -f every node hears every other node; a links
+ *         file lists "<from> <to> <prr percent>" per line instead.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "dev/shm-radio.h"
+/*---------------------------------------------------------------------------*/
+#define MAX_IMAGES 32
+
+static struct {
+  const char *path;
+  int count;
+} images[MAX_IMAGES];
+static int image_count;
+
+static char shm_path[64];
+static struct shm_radio_medium *medium;
+static pid_t *pids;
+/*---------------------------------------------------------------------------*/
+static void
+usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [options] firmware[:count] ...\n", prog);
+  fprintf(stderr, " -t seconds   Stop after this much virtual time (default: never)\n");
+  fprintf(stderr, " -d us        Radio latency in microseconds (default 1000)\n");
+  fprintf(stderr, " -l percent   Frame loss on every link (default 0)\n");
+  fprintf(stderr, " -f file      Links as <from> <to> <prr percent> lines\n");
+  fprintf(stderr, " -s seed      Seed for frame losses (default 1)\n");
+  fprintf(stderr, " -o dir       Write the output of node N to dir/node-N.log\n");
+  exit(EXIT_FAILURE);
+}
+/*---------------------------------------------------------------------------*/
+static void
+cleanup(void)
+{
+  if(shm_path[0] != '\0') {
+    shm_unlink(shm_path);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+terminate(int sig)
+{
+  int i;
+
+  for(i = 0; pids != NULL && i < medium->nodes; i++) {
+    if(pids[i] > 0) {
+      kill(pids[i], SIGTERM);
+    }
+  }
+  cleanup();
+  _exit(EXIT_FAILURE);
+}
+/*---------------------------------------------------------------------------*/
+static void
+load_links(const char *file)
+{
+  unsigned from, to, prr;
+  char line[128];
+  int lineno = 0;
+  FILE *f;
+
+  f = fopen(file, "r");
+  if(f == NULL) {
+    perror(file);
+    exit(EXIT_FAILURE);
+  }
+  while(fgets(line, sizeof(line), f) != NULL) {
+    lineno++;
+    if(line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0') {
+      continue;
+    }
+    if(sscanf(line, "%u %u %u", &from, &to, &prr) != 3 ||
+       from < 1 || from > medium->nodes || to < 1 || to > medium->nodes ||
+       prr > 100) {
+      fprintf(stderr, "%s:%d: bad link\n", file, lineno);
+      exit(EXIT_FAILURE);
+    }
+    *shm_radio_prr(medium, from - 1, to - 1) = prr;
+  }
+  fclose(f);
+}
+/*---------------------------------------------------------------------------*/
+static void
+create_medium(int nodes, uint32_t latency, uint32_t seed, uint64_t stop,
+              int loss, const char *links)
+{
+  pthread_mutexattr_t mattr;
+  pthread_condattr_t cattr;
+  struct shm_radio_node *n;
+  size_t size;
+  int fd;
+  int i, j;
+
+  size = shm_radio_size(nodes);
+  snprintf(shm_path, sizeof(shm_path), "/native-sim-%d", (int)getpid());
+  fd = shm_open(shm_path, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if(fd < 0) {
+    shm_path[0] = '\0';
+    perror("shm_open");
+    exit(EXIT_FAILURE);
+  }
+  atexit(cleanup);
+  if(ftruncate(fd, size) < 0) {
+    perror("ftruncate");
+    exit(EXIT_FAILURE);
+  }
+  medium = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if(medium == MAP_FAILED) {
+    perror("mmap");
+    exit(EXIT_FAILURE);
+  }
+
+  medium->nodes = nodes;
+  medium->latency = latency;
+  medium->seed = seed;
+  medium->stop = stop;
+
+  pthread_mutexattr_init(&mattr);
+  pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+  pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST);
+  pthread_mutex_init(&medium->lock, &mattr);
+  pthread_condattr_init(&cattr);
+  pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
+
+  for(i = 0; i < nodes; i++) {
+    n = shm_radio_node(medium, i);
+    pthread_cond_init(&n->cond, &cattr);
+    /* Nobody advances before every node is up and waiting */
+    n->state = SHM_RADIO_RUNNING;
+    n->key = 0;
+    n->heap_pos = i;
+    shm_radio_heap(medium)[i] = i;
+    for(j = 0; j < nodes; j++) {
+      *shm_radio_prr(medium, i, j) = links != NULL || i == j ? 0 : 100 - loss;
+    }
+  }
+  if(links != NULL) {
+    load_links(links);
+  }
+  medium->magic = SHM_RADIO_MAGIC;
+}
+/*---------------------------------------------------------------------------*/
+static pid_t
+start_node(int index, const char *path, const char *logdir)
+{
+  char buf[256];
+  pid_t pid;
+  int fd;
+
+  pid = fork();
+  if(pid != 0) {
+    return pid;
+  }
+
+  fd = open("/dev/null", O_RDONLY);
+  dup2(fd, STDIN_FILENO);
+  close(fd);
+  if(logdir != NULL) {
+    snprintf(buf, sizeof(buf), "%s/node-%d.log", logdir, index + 1);
+    fd = open(buf, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) {
+      perror(buf);
+      _exit(EXIT_FAILURE);
+    }
+    dup2(fd, STDOUT_FILENO);
+    dup2(fd, STDERR_FILENO);
+    close(fd);
+  }
+  setenv(SHM_RADIO_ENV_PATH, shm_path, 1);
+  snprintf(buf, sizeof(buf), "%d", index);
+  setenv(SHM_RADIO_ENV_NODE, buf, 1);
+  execl(path, path, (char *)NULL);
+  perror(path);
+  _exit(EXIT_FAILURE);
+}
+/*---------------------------------------------------------------------------*/
+/* Takes a node that died without leaving the medium out of the sync */
+static void
+node_exited(int index)
+{
+  struct shm_radio_node *n;
+  int i;
+
+  if(pthread_mutex_lock(&medium->lock) == EOWNERDEAD) {
+    pthread_mutex_consistent(&medium->lock);
+  }
+  if(shm_radio_node(medium, index)->state != SHM_RADIO_DONE) {
+    shm_radio_node(medium, index)->state = SHM_RADIO_DONE;
+    shm_radio_set_key(medium, index, VIRTUAL_TIME_NEVER);
+  }
+  for(i = 0; i < medium->nodes; i++) {
+    n = shm_radio_node(medium, i);
+    if(n->state == SHM_RADIO_WAITING) {
+      pthread_cond_signal(&n->cond);
+    }
+  }
+  pthread_mutex_unlock(&medium->lock);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  const char *logdir = NULL;
+  const char *links = NULL;
+  uint32_t latency = 1000;
+  uint32_t seed = 1;
+  uint64_t stop = VIRTUAL_TIME_NEVER;
+  unsigned long dropped = 0;
+  int failed = 0;
+  int loss = 0;
+  int nodes = 0;
+  int running;
+  int status;
+  char *colon;
+  pid_t pid;
+  int c, i, j;
+
+  while((c = getopt(argc, argv, "t:d:l:f:s:o:h")) != -1) {
+    switch(c) {
+    case 't':
+      stop = strtoull(optarg, NULL, 10) * VIRTUAL_TIME_SECOND;
+      break;
+    case 'd':
+      latency = strtoul(optarg, NULL, 10);
+      if(latency < 1) {
+        fprintf(stderr, "latency must be at least 1 us\n");
+        exit(EXIT_FAILURE);
+      }
+      break;
+    case 'l':
+      loss = atoi(optarg);
+      if(loss < 0 || loss > 100) {
+        usage(argv[0]);
+      }
+      break;
+    case 'f':
+      links = optarg;
+      break;
+    case 's':
+      seed = strtoul(optarg, NULL, 10);
+      break;
+    case 'o':
+      logdir = optarg;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+  if(optind == argc || argc - optind > MAX_IMAGES) {
+    usage(argv[0]);
+  }
+  for(i = optind; i < argc; i++) {
+    images[image_count].path = argv[i];
+    images[image_count].count = 1;
+    colon = strrchr(argv[i], ':');
+    if(colon != NULL) {
+      *colon = '\0';
+      images[image_count].count = atoi(colon + 1);
+      if(images[image_count].count < 1) {
+        usage(argv[0]);
+      }
+    }
+    nodes += images[image_count].count;
+    image_count++;
+  }
+
+  create_medium(nodes, latency, seed, stop, loss, links);
+  pids = calloc(nodes, sizeof(pid_t));
+  signal(SIGINT, terminate);
+  signal(SIGTERM, terminate);
+
+  nodes = 0;
+  for(i = 0; i < image_count; i++) {
+    for(j = 0; j < images[i].count; j++, nodes++) {
+      pids[nodes] = start_node(nodes, images[i].path, logdir);
+      if(pids[nodes] < 0) {
+        perror("fork");
+        terminate(SIGTERM);
+      }
+    }
+  }
+  fprintf(stderr, "native-sim: started %d nodes on %s\n", nodes, shm_path);
+
+  for(running = nodes; running > 0; running--) {
+    pid = wait(&status);
+    if(pid < 0) {
+      break;
+    }
+    for(i = 0; i < nodes && pids[i] != pid; i++);
+    if(i == nodes) {
+      running++;
+      continue;
+    }
+    pids[i] = 0;
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      fprintf(stderr, "native-sim: node %d failed (status 0x%x)\n",
+              i + 1, status);
+      failed++;
+    }
+    node_exited(i);
+  }
+
+  for(i = 0; i < nodes; i++) {
+    dropped += shm_radio_node(medium, i)->rx_dropped;
+  }
+  fprintf(stderr, "native-sim: %d nodes done, %d failed, %lu frames dropped"
+          " on full queues\n", nodes, failed, dropped);
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
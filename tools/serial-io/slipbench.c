@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2026, Contiki-NG contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         SLIP throughput benchmark over a pseudo terminal.
+ *
+ *         Creates a pty pair and, once the peer on the slave side has
+ *         written its first byte, pushes a burst of SLIP frames through
+ *         the master side as fast as the peer consumes them. Run the
+ *         native border router against the printed slave device, e.g.
+ *
+ *           ./slipbench -n 100000 -l 120 &
+ *           ./border-router.native -s pts/5 fd00::1/64
+ *
+ *         By default frames start with '?' so the border router decodes
+ *         and then discards them, which isolates the SLIP read path.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+/*---------------------------------------------------------------------------*/
+#define SLIP_END      0300
+#define SLIP_ESC      0333
+#define SLIP_ESC_END  0334
+#define SLIP_ESC_ESC  0335
+
+#define MAX_FRAME_LEN 1280
+/*---------------------------------------------------------------------------*/
+static int
+usage(int result)
+{
+  printf("Usage: slipbench [-n frames] [-l length] [-p]\n");
+  printf("       -n number of frames to send (default 10000)\n");
+  printf("       -l frame length before SLIP encoding (default 100)\n");
+  printf("       -p send frames as radio packets instead of ignored\n");
+  printf("          '?' requests\n");
+  return result;
+}
+/*---------------------------------------------------------------------------*/
+static int
+slip_encode(unsigned char *out, const unsigned char *in, int len)
+{
+  int i, n = 0;
+
+  for(i = 0; i < len; i++) {
+    if(in[i] == SLIP_END) {
+      out[n++] = SLIP_ESC;
+      out[n++] = SLIP_ESC_END;
+    } else if(in[i] == SLIP_ESC) {
+      out[n++] = SLIP_ESC;
+      out[n++] = SLIP_ESC_ESC;
+    } else {
+      out[n++] = in[i];
+    }
+  }
+  out[n++] = SLIP_END;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/*---------------------------------------------------------------------------*/
+static void
+drain(int fd)
+{
+  unsigned char buf[512];
+
+  /* Discard whatever the peer writes so it never blocks on us */
+  while(read(fd, buf, sizeof(buf)) > 0);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  static unsigned char frame[MAX_FRAME_LEN];
+  static unsigned char encoded[2 * MAX_FRAME_LEN + 1];
+  struct termios tty;
+  struct pollfd pfd;
+  long frames = 10000;
+  long sent = 0;
+  long long bytes = 0;
+  int len = 100;
+  int packets = 0;
+  int enc_len, enc_off;
+  int fd, opt, i, n;
+  double start, elapsed;
+
+  while((opt = getopt(argc, argv, "n:l:ph")) != -1) {
+    switch(opt) {
+    case 'n':
+      frames = atol(optarg);
+      break;
+    case 'l':
+      len = atoi(optarg);
+      break;
+    case 'p':
+      packets = 1;
+      break;
+    case 'h':
+      return usage(0);
+    default:
+      return usage(1);
+    }
+  }
+  if(frames <= 0 || len < 1 || len > MAX_FRAME_LEN) {
+    return usage(1);
+  }
+
+  fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if(fd == -1 || grantpt(fd) == -1 || unlockpt(fd) == -1) {
+    perror("slipbench: posix_openpt");
+    return 1;
+  }
+  if(tcgetattr(fd, &tty) == 0) {
+    cfmakeraw(&tty);
+    tcsetattr(fd, TCSANOW, &tty);
+  }
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+
+  /* Mix in bytes that need escaping to exercise the decoder */
+  for(i = 0; i < len; i++) {
+    frame[i] = (i % 16 == 15) ? SLIP_END : (i % 32 == 7) ? SLIP_ESC : 'A' + i % 26;
+  }
+  frame[0] = packets ? 0x41 : '?';
+  enc_len = slip_encode(encoded, frame, len);
+
+  printf("slipbench: slave device %s (pass \"%s\" to -s)\n",
+         ptsname(fd), ptsname(fd) + strlen("/dev/"));
+  printf("slipbench: waiting for the peer to open the device\n");
+  fflush(stdout);
+
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  while(poll(&pfd, 1, -1) != 1 || !(pfd.revents & POLLIN));
+  drain(fd);
+
+  start = now();
+  enc_off = 0;
+  while(sent < frames) {
+    pfd.events = POLLIN | POLLOUT;
+    if(poll(&pfd, 1, 1000) < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      perror("slipbench: poll");
+      return 1;
+    }
+    if(pfd.revents & POLLHUP) {
+      fprintf(stderr, "slipbench: peer closed after %ld frames\n", sent);
+      return 1;
+    }
+    if(pfd.revents & POLLIN) {
+      drain(fd);
+    }
+    if(pfd.revents & POLLOUT) {
+      /* Keep writing full frames until the pty buffer is full */
+      while(sent < frames) {
+        n = write(fd, encoded + enc_off, enc_len - enc_off);
+        if(n <= 0) {
+          break;
+        }
+        bytes += n;
+        enc_off += n;
+        if(enc_off == enc_len) {
+          enc_off = 0;
+          sent++;
+        }
+      }
+    }
+  }
+  elapsed = now() - start;
+
+  printf("slipbench: %ld frames, %lld bytes in %.3f s\n", sent, bytes, elapsed);
+  printf("slipbench: %.0f frames/s, %.2f Mbit/s\n",
+         sent / elapsed, bytes * 8 / elapsed / 1e6);
+
+  /* Hanging up discards unread input, so let the peer finish reading */
+  pfd.events = POLLIN;
+  while(poll(&pfd, 1, 1000) == 1 && !(pfd.revents & POLLHUP)) {
+    drain(fd);
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/